@@ -45,14 +45,29 @@ LIBRC_MATH_ROOT_ABS:= $(LOCAL_PATH)/../..
 LOCAL_SRC_FILES := \
   $(LIBRC_MATH_ROOT_ABS)/library/src/algebra_common.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/algebra.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/batch.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/eigen.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/expression.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/filter.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/fixed_matrix.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/gemm.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/iterative.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/kalman.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/kernels_neon.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/kernels_x86.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/matrix.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/matrix_view.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/other.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/polynomial.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/quaternion.c \
   $(LIBRC_MATH_ROOT_ABS)/library/src/ring_buffer.c \
-  $(LIBRC_MATH_ROOT_ABS)/library/src/vector.c
+  $(LIBRC_MATH_ROOT_ABS)/library/src/rls.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/single_precision.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/sparse.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/symmetric.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/thread_pool.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/vector.c \
+  $(LIBRC_MATH_ROOT_ABS)/library/src/workspace.c
 
 LOCAL_C_INCLUDES += \
   $(LIBRC_MATH_ROOT_ABS)/library/include
@@ -10,6 +10,18 @@
  *             used as a test to see if the compiled math library is using the
  *             CPU hardware vectorized floating point units.
  *
+ *             The library multiply is also compared against a straightforward
+ *             dot-product-per-element reference multiply to show the gain
+ *             from the cache-blocked kernel.
+ *
+ *             With -f the multiply, QR, and linear solve are repeated with the
+ *             single precision functions from rc_math/single_precision.h, and
+ *             the double solve is compared with the mixed precision one.
+ *
+ *             With -t the multiply, linear solve, and mat-vec are timed again
+ *             with the thread pool from rc_math/thread_pool.h at every size from
+ *             1 up to the given number of threads, printing a scaling curve.
+ *
  *
  * @author     James Strawson
  * @date       1/29/2018
@@ -40,6 +52,8 @@ static void __print_usage(void)
     printf("\n");
     printf("-d         use default matrix size (%dx%d)\n",DEFAULT_DIM,DEFAULT_DIM);
     printf("-s {size}  use custom matrix size\n");
+    printf("-f         also benchmark the single precision functions\n");
+    printf("-t {n}     also print thread pool scaling from 1 to n threads\n");
     printf("-h         print this help message\n");
     printf("\n");
 }
@@ -51,9 +65,180 @@ static uint64_t __nanos_thread_time(void)
     return ((uint64_t)ts.tv_sec*1000000000)+ts.tv_nsec;
 }
 
+// unblocked reference multiply, one dot product per element of C with the
+// column of B copied to sequential memory first
+static void __reference_multiply(rc_matrix_t A, rc_matrix_t B, rc_matrix_t* C)
+{
+    int i,j,k;
+    double sum;
+    double tmp[B.rows];
+    for(i=0;i<B.cols;i++){
+        for(j=0;j<B.rows;j++) tmp[j]=B.d[j][i];
+        for(j=0;j<A.rows;j++){
+            sum = 0.0;
+            for(k=0;k<B.rows;k++) sum+=A.d[j][k]*tmp[k];
+            C->d[j][i]=sum;
+        }
+    }
+    return;
+}
+
+// million floating point operations per second for 'reps' multiplies of two
+// dim x dim matrices taking 'us' microseconds. Both the multiplication and
+// addition count as operations, hence multiply by 2
+static double __mflops(int dim, int reps, int us)
+{
+    if(us<=0) return 0.0;
+    return (2.0*dim*dim*dim*reps)/(double)us;
+}
+
+// wall clock time, the thread time above only counts the calling thread
+static uint64_t __nanos_wall_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec*1000000000)+ts.tv_nsec;
+}
+
+// times multiply, solve, and mat-vec with 1 to max_threads threads in the pool
+static void __thread_scaling(int dim, int max_threads)
+{
+    int t, i, reps;
+    uint64_t t1, t2, t3, t4;
+    double mult_us, solve_us, mv_us, base_us = 0.0;
+    rc_matrix_t A = RC_MATRIX_INITIALIZER;
+    rc_matrix_t AA = RC_MATRIX_INITIALIZER;
+    rc_matrix_t B = RC_MATRIX_INITIALIZER;
+    rc_vector_t b = RC_VECTOR_INITIALIZER;
+    rc_vector_t x = RC_VECTOR_INITIALIZER;
+
+    rc_matrix_random(&A,dim,dim);
+    rc_matrix_random(&AA,dim,dim);
+    rc_vector_random(&b,dim);
+    // enough multiplies for roughly a second of single threaded work
+    reps = (int)(1e10/(2.0*dim*dim*dim));
+    if(reps<1) reps=1;
+    if(reps>1000) reps=1000;
+
+    printf("\nThread pool scaling, %dx%d, %d multiplies per point\n", dim, dim, reps);
+    printf("threads  multiply(us)    MFLOPS  speedup  solve(us)  mat-vec(us)\n");
+    for(t=1;t<=max_threads;t++){
+        if(rc_thread_pool_init(t)){
+            fprintf(stderr,"failed to start thread pool with %d threads\n", t);
+            break;
+        }
+        t1 = __nanos_wall_time();
+        for(i=0;i<reps;i++) rc_matrix_multiply(A, AA, &B);
+        t2 = __nanos_wall_time();
+        rc_algebra_lin_system_solve(A, b, &x);
+        t3 = __nanos_wall_time();
+        for(i=0;i<reps;i++) rc_matrix_times_col_vec(A, b, &x);
+        t4 = __nanos_wall_time();
+        mult_us  = (double)(t2-t1)/1000.0;
+        solve_us = (double)(t3-t2)/1000.0;
+        mv_us    = (double)(t4-t3)/1000.0/reps;
+        if(t==1) base_us = mult_us;
+        printf("%7d %13.0f %9.1f %7.2fx %10.0f %12.1f\n", t, mult_us,
+            __mflops(dim, reps, (int)mult_us), base_us/mult_us, solve_us, mv_us);
+    }
+    rc_thread_pool_cleanup();
+
+    rc_matrix_free(&A);
+    rc_matrix_free(&AA);
+    rc_matrix_free(&B);
+    rc_vector_free(&b);
+    rc_vector_free(&x);
+    return;
+}
+
+// repeats the main timings with the float family for comparison
+static void __float_benchmark(int dim, double double_mflops)
+{
+    int diff;
+    uint64_t t1, t2;
+    rc_matrix_t tmp = RC_MATRIX_INITIALIZER;
+    rc_vector_t tmpv = RC_VECTOR_INITIALIZER;
+    rc_vector_t xd = RC_VECTOR_INITIALIZER;
+    rc_mixed_info_t info;
+    rc_vectorf_t b = RC_VECTORF_INITIALIZER;
+    rc_vectorf_t x = RC_VECTORF_INITIALIZER;
+    rc_matrixf_t A = RC_MATRIXF_INITIALIZER;
+    rc_matrixf_t AA = RC_MATRIXF_INITIALIZER;
+    rc_matrixf_t B = RC_MATRIXF_INITIALIZER;
+    rc_matrixf_t Q = RC_MATRIXF_INITIALIZER;
+    rc_matrixf_t R = RC_MATRIXF_INITIALIZER;
+
+    printf("\nStarting single precision test\n");
+    rc_matrix_random(&tmp,dim,dim);
+    rc_matrixf_from_matrix(&A,tmp);
+    rc_matrix_random(&tmp,dim,dim);
+    rc_matrixf_from_matrix(&AA,tmp);
+    rc_vector_random(&tmpv,dim);
+    rc_vectorf_from_vector(&b,tmpv);
+
+    // QR
+    t1 = TIMER;
+    rc_algebraf_qr_decomp(A,&Q,&R);
+    t2 = TIMER;
+    diff = (int)((t2-t1-TIMER_DELAY)/(uint64_t)1000);
+    printf("%10dus Time to do float QR decomposition\n", diff);
+
+    // solve
+    t1 = TIMER;
+    rc_algebraf_lin_system_solve(A,b,&x);
+    t2 = TIMER;
+    diff = (int)((t2-t1-TIMER_DELAY)/(uint64_t)1000);
+    printf("%10dus Time to solve float linear system\n", diff);
+
+    // float LU refined to double accuracy, against the double solve
+    rc_matrix_random(&tmp,dim,dim);
+    rc_vector_random(&tmpv,dim);
+    t1 = TIMER;
+    rc_algebra_lin_system_solve(tmp,tmpv,&xd);
+    t2 = TIMER;
+    diff = (int)((t2-t1-TIMER_DELAY)/(uint64_t)1000);
+    printf("%10dus Time to solve double linear system\n", diff);
+    t1 = TIMER;
+    rc_algebra_lin_system_solve_mixed(tmp,tmpv,&xd,&info);
+    t2 = TIMER;
+    diff = (int)((t2-t1-TIMER_DELAY)/(uint64_t)1000);
+    printf("%10dus Time to solve mixed precision linear system\n", diff);
+    printf("     %d refinement steps, fallback %d, backward error %.2e\n",
+            info.iterations, info.fallback, info.residual);
+
+    // Multiply matrices 1000 times
+    rc_matrixf_alloc(&B,dim,dim);
+    t1 = TIMER;
+    for (int i=0;i<1000;i++){
+        rc_matrixf_multiply(A, AA, &B);
+    }
+    t2 = TIMER;
+    diff = (int)((t2-t1-TIMER_DELAY)/(uint64_t)1000);
+    printf("%10dus Time to multiply float matrices 1000 times\n", diff);
+    double mflops = __mflops(dim, 1000, diff);
+    printf("     %9.1f MFLOPS multiplying float matrices 1000 times\n", mflops);
+    if(double_mflops>0.0){
+        printf("     %9.2fx MFLOPS gain over double multiply\n", mflops/double_mflops);
+    }
+
+    rc_matrix_free(&tmp);
+    rc_vector_free(&tmpv);
+    rc_vector_free(&xd);
+    rc_vectorf_free(&b);
+    rc_vectorf_free(&x);
+    rc_matrixf_free(&A);
+    rc_matrixf_free(&AA);
+    rc_matrixf_free(&B);
+    rc_matrixf_free(&Q);
+    rc_matrixf_free(&R);
+    return;
+}
+
 int main(int argc, char *argv[])
 {
     int dim = 0;
+    int float_mode = 0;
+    int max_threads = 0;
     int c, diff;
     uint64_t t1, t2;
     rc_vector_t b = RC_VECTOR_INITIALIZER;
@@ -68,7 +253,7 @@ int main(int argc, char *argv[])
     rc_matrix_t R =  RC_MATRIX_INITIALIZER;
 
     // make sure user gave an argument
-    if(argc>3){
+    if(argc>6){
         printf("Too many arguments given.\n");
         __print_usage();
         return -1;
@@ -80,7 +265,7 @@ int main(int argc, char *argv[])
     }
     // parse arguments
     opterr = 0;
-    while ((c = getopt(argc, argv, "ds:h")) != -1){
+    while ((c = getopt(argc, argv, "ds:ft:h")) != -1){
         switch (c){
         case 'd': // default size option
             if(dim!=0){
@@ -103,6 +288,17 @@ int main(int argc, char *argv[])
                 return -1;
             }
             break;
+        case 'f':
+            float_mode = 1;
+            break;
+        case 't':
+            max_threads = atoi(optarg);
+            if(max_threads<1){
+                printf("number of threads must be >=1\n");
+                __print_usage();
+                return -1;
+            }
+            break;
         case 'h':
             __print_usage();
             return 0;
@@ -114,6 +310,7 @@ int main(int argc, char *argv[])
     }
 
     printf("Starting single-threaded test\n");
+    printf("using %s SIMD kernels\n", rc_algebra_simd_path_name(rc_algebra_get_simd_path()));
 
     // create a random nxn matrix for later use
     t1 = TIMER;
@@ -191,11 +388,25 @@ int main(int argc, char *argv[])
     diff = (int)((t2-t1-TIMER_DELAY)/(uint64_t)1000);
     printf("%10dus Time to multiply matrices 1000 times\n", diff);
 
-    // calculate floating pointer operations per second, both multiplication
-    // and addition count as operations, hence multiply by 2
-    uint64_t flops = ((uint64_t)2*dim*dim*dim*1000000000)/(diff);
-    double gflops = (double)flops/1000000000.0;
-    printf("     %7.3f GFLOPS multiplying matrices 1000 times\n", gflops);
+    double mflops = __mflops(dim, 1000, diff);
+    printf("     %9.1f MFLOPS multiplying matrices 1000 times\n", mflops);
+
+    // same thing with the unblocked reference multiply for comparison
+    t1 = TIMER;
+    for (int i=0;i<1000;i++){
+        __reference_multiply(A, AA, &B);
+    }
+    t2 = TIMER;
+    diff = (int)((t2-t1-TIMER_DELAY)/(uint64_t)1000);
+    printf("%10dus Time to multiply matrices 1000 times with reference\n", diff);
+    double ref_mflops = __mflops(dim, 1000, diff);
+    printf("     %9.1f MFLOPS multiplying matrices 1000 times with reference\n", ref_mflops);
+    if(ref_mflops>0.0){
+        printf("     %9.2fx MFLOPS gain over reference multiply\n", mflops/ref_mflops);
+    }
+
+    if(float_mode) __float_benchmark(dim, mflops);
+    if(max_threads) __thread_scaling(dim, max_threads);
 
     printf("DONE\n");
     //rc_set_cpu_freq(FREQ_ONDEMAND);
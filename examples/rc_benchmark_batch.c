@@ -0,0 +1,216 @@
+/**
+ * @file rc_benchmark_batch.c
+ * @example    rc_benchmark_batch
+ *
+ * @brief      Compares the batched small matrix functions in rc_math/batch.h
+ *             against calling the regular rc_matrix_t functions once per
+ *             matrix.
+ *
+ *             For 3x3 and 4x4 matrices this times multiply, mat-vec,
+ *             determinant, inverse, and linear solve across a batch of N
+ *             matrices both ways and prints the speedup along with the largest
+ *             difference between the two results. 6x6 runs everything but the
+ *             determinant and inverse, which stop at 4x4.
+ */
+
+#define __USE_POSIX199309
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdint.h>
+#include <getopt.h>
+#include <time.h>
+#include <math.h>
+#include <stdlib.h> // for atoi
+#include <rc_math.h>
+
+#define DEFAULT_N   4096
+#define MAX_N       1000000
+
+#define TIMER __nanos_thread_time()
+
+
+static void __print_usage(void)
+{
+    printf("\n");
+    printf("-n {count}  number of matrices per batch, default %d\n", DEFAULT_N);
+    printf("-h          print this help message\n");
+    printf("\n");
+}
+
+static uint64_t __nanos_thread_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ((uint64_t)ts.tv_sec*1000000000)+ts.tv_nsec;
+}
+
+static void __print_result(const char* name, uint64_t loop_ns, uint64_t batch_ns, double err)
+{
+    printf("%-12s %10dus loop %10dus batch %7.1fx   max diff %9.3e\n", name,
+        (int)(loop_ns/1000), (int)(batch_ns/1000),
+        batch_ns ? (double)loop_ns/(double)batch_ns : 0.0, err);
+}
+
+// largest difference between matrix k of batch B and matrix M
+static double __diff(rc_matrix_batch_t B, int k, rc_matrix_t M)
+{
+    int i,j;
+    double err = 0.0;
+    for(i=0;i<M.rows;i++){
+        for(j=0;j<M.cols;j++) err = fmax(err, fabs(RC_MATRIX_BATCH_AT(B,k,i,j)-M.d[i][j]));
+    }
+    return err;
+}
+
+
+static void __run(int n, int dim)
+{
+    int i,k;
+    uint64_t t1, t2, t3;
+    double err;
+    rc_matrix_t* A = malloc(n*sizeof(rc_matrix_t));
+    rc_matrix_t* B = malloc(n*sizeof(rc_matrix_t));
+    rc_matrix_t* C = malloc(n*sizeof(rc_matrix_t));
+    rc_vector_t* v = malloc(n*sizeof(rc_vector_t));
+    rc_vector_t* y = malloc(n*sizeof(rc_vector_t));
+    double* det = malloc(n*sizeof(double));
+    rc_vector_t bdet = RC_VECTOR_INITIALIZER;
+    rc_matrix_batch_t bA = RC_MATRIX_BATCH_INITIALIZER;
+    rc_matrix_batch_t bB = RC_MATRIX_BATCH_INITIALIZER;
+    rc_matrix_batch_t bC = RC_MATRIX_BATCH_INITIALIZER;
+    rc_matrix_batch_t bv = RC_MATRIX_BATCH_INITIALIZER;
+    rc_matrix_batch_t by = RC_MATRIX_BATCH_INITIALIZER;
+    rc_matrix_batch_t bx = RC_MATRIX_BATCH_INITIALIZER;
+
+    printf("\n%d %dx%d matrices\n", n, dim, dim);
+
+    rc_matrix_batch_alloc(&bA, n, dim, dim);
+    rc_matrix_batch_alloc(&bB, n, dim, dim);
+    rc_matrix_batch_alloc(&bv, n, dim, 1);
+    for(k=0;k<n;k++){
+        A[k] = rc_matrix_empty();
+        B[k] = rc_matrix_empty();
+        C[k] = rc_matrix_empty();
+        v[k] = rc_vector_empty();
+        y[k] = rc_vector_empty();
+        rc_matrix_random(&A[k],dim,dim);
+        rc_matrix_random(&B[k],dim,dim);
+        rc_vector_random(&v[k],dim);
+        rc_matrix_batch_set(&bA, k, A[k]);
+        rc_matrix_batch_set(&bB, k, B[k]);
+        for(i=0;i<dim;i++) RC_MATRIX_BATCH_AT(bv,k,i,0) = v[k].d[i];
+    }
+
+    // multiply
+    t1 = TIMER;
+    for(k=0;k<n;k++) rc_matrix_multiply(A[k],B[k],&C[k]);
+    t2 = TIMER;
+    rc_matrix_batch_multiply(bA, bB, &bC);
+    t3 = TIMER;
+    err = 0.0;
+    for(k=0;k<n;k++) err = fmax(err, __diff(bC,k,C[k]));
+    __print_result("multiply", t2-t1, t3-t2, err);
+
+    // mat-vec
+    t1 = TIMER;
+    for(k=0;k<n;k++) rc_matrix_times_col_vec(A[k],v[k],&y[k]);
+    t2 = TIMER;
+    rc_matrix_batch_times_col_vec(bA, bv, &by);
+    t3 = TIMER;
+    err = 0.0;
+    for(k=0;k<n;k++){
+        for(i=0;i<dim;i++) err = fmax(err, fabs(RC_MATRIX_BATCH_AT(by,k,i,0)-y[k].d[i]));
+    }
+    __print_result("mat-vec", t2-t1, t3-t2, err);
+
+    // linear solve A*x = v
+    t1 = TIMER;
+    for(k=0;k<n;k++) rc_algebra_lin_system_solve(A[k],v[k],&y[k]);
+    t2 = TIMER;
+    rc_matrix_batch_lin_system_solve(bA, bv, &bx);
+    t3 = TIMER;
+    err = 0.0;
+    for(k=0;k<n;k++){
+        for(i=0;i<dim;i++) err = fmax(err, fabs(RC_MATRIX_BATCH_AT(bx,k,i,0)-y[k].d[i]));
+    }
+    __print_result("solve", t2-t1, t3-t2, err);
+
+    if(dim>4) goto FREE;
+
+    // determinant
+    t1 = TIMER;
+    for(k=0;k<n;k++) det[k] = rc_matrix_determinant(A[k]);
+    t2 = TIMER;
+    rc_matrix_batch_determinant(bA, &bdet);
+    t3 = TIMER;
+    err = 0.0;
+    for(k=0;k<n;k++) err = fmax(err, fabs(bdet.d[k]-det[k]));
+    __print_result("determinant", t2-t1, t3-t2, err);
+
+    // inverse, random matrices are practically never singular
+    t1 = TIMER;
+    for(k=0;k<n;k++) rc_algebra_invert_matrix(A[k],&C[k]);
+    t2 = TIMER;
+    rc_matrix_batch_invert(bA, &bC);
+    t3 = TIMER;
+    err = 0.0;
+    for(k=0;k<n;k++) err = fmax(err, __diff(bC,k,C[k]));
+    __print_result("inverse", t2-t1, t3-t2, err);
+
+FREE:
+    for(k=0;k<n;k++){
+        rc_matrix_free(&A[k]);
+        rc_matrix_free(&B[k]);
+        rc_matrix_free(&C[k]);
+        rc_vector_free(&v[k]);
+        rc_vector_free(&y[k]);
+    }
+    free(A);
+    free(B);
+    free(C);
+    free(v);
+    free(y);
+    free(det);
+    rc_vector_free(&bdet);
+    rc_matrix_batch_free(&bA);
+    rc_matrix_batch_free(&bB);
+    rc_matrix_batch_free(&bC);
+    rc_matrix_batch_free(&bv);
+    rc_matrix_batch_free(&by);
+    rc_matrix_batch_free(&bx);
+    return;
+}
+
+
+int main(int argc, char *argv[])
+{
+    int c;
+    int n = DEFAULT_N;
+
+    while((c=getopt(argc, argv, "n:h"))!=-1){
+        switch(c){
+        case 'n':
+            n = atoi(optarg);
+            if(n<1 || n>MAX_N){
+                fprintf(stderr,"n must be between 1 and %d\n", MAX_N);
+                return -1;
+            }
+            break;
+        case 'h':
+            __print_usage();
+            return 0;
+        default:
+            __print_usage();
+            return -1;
+        }
+    }
+
+    printf("SIMD path: %s\n", rc_algebra_simd_path_name(rc_algebra_get_simd_path()));
+    __run(n, 3);
+    __run(n, 4);
+    __run(n, 6);
+
+    printf("\nDONE\n");
+    return 0;
+}
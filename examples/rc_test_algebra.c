@@ -8,6 +8,7 @@
  */
 
 #include <stdio.h>
+#include <math.h>
 #include <rc_math.h>
 
 #define DIM 3
@@ -25,6 +26,14 @@ int main()
     rc_vector_t b   = RC_VECTOR_INITIALIZER;
     rc_vector_t x   = RC_VECTOR_INITIALIZER;
     rc_vector_t y   = RC_VECTOR_INITIALIZER;
+    rc_vector_t vecs[2];
+    rc_vector_t outs[2] = {RC_VECTOR_INITIALIZER, RC_VECTOR_INITIALIZER};
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    rc_lu_t lu = RC_LU_INITIALIZER;
+    rc_mixed_info_t mixed;
+    rc_ellipsoid_fit_t fit;
+    double pt[3], u, v, px, py;
+    int i, j, sign;
 
     printf("Let's test some linear algebra functions....\n\n");
 
@@ -80,7 +89,161 @@ int main()
     rc_algebra_lin_system_solve_qr(A,b,&y);
     rc_vector_print(y);
 
+    // repeat with a preallocated workspace, nothing is malloc'd in here
+    printf("\nSame again with a %zu byte workspace\n", rc_algebra_workspace_size(DIM,DIM));
+    rc_workspace_alloc(&ws, rc_algebra_workspace_size(DIM,DIM));
+    printf("determinant of A: %8.6lf\n", rc_matrix_determinant_ws(A,&ws));
+    rc_algebra_invert_matrix_ws(A,&Ainv,&ws);
+    printf("Ainverse:\n");
+    rc_matrix_print(Ainv);
+    rc_algebra_lup_decomp_ws(A,&L,&U,&P,&ws);
+    printf("U:\n");
+    rc_matrix_print(U);
+    rc_algebra_qr_decomp_ws(A,&Q,&R,&ws);
+    printf("R:\n");
+    rc_matrix_print(R);
+    rc_algebra_lin_system_solve_ws(A,b,&x,&ws);
+    printf("x:\n");
+    rc_vector_print(x);
+    printf("workspace bytes still in use: %zu\n", ws.used);
+
+    // float LU refined to double precision
+    printf("\nMixed precision solution x to the equation Ax=b:\n");
+    rc_algebra_lin_system_solve_mixed_ws(A,b,&x,&mixed,&ws);
+    rc_vector_print(x);
+    printf("%d refinement steps, fallback %d, backward error %.2e\n",
+            mixed.iterations, mixed.fallback, mixed.residual);
+
+    // triangular solves with every column of P as a right hand side at once
+    printf("\nAinverse from the LUP factors, solving L*Y=P then U*X=Y:\n");
+    rc_algebra_solve_lower_triangular(L,P,&AA);
+    rc_algebra_solve_upper_triangular(U,AA,&AA);
+    rc_matrix_print(AA);
+
+    // A times several vectors in one pass over A
+    printf("\nb:\n");
+    rc_vector_print(b);
+    printf("A times [x b] in one call, first should be b:\n");
+    vecs[0] = x;
+    vecs[1] = b;
+    rc_matrix_times_col_vecs(A,vecs,outs,2);
+    rc_vector_print(outs[0]);
+    rc_vector_print(outs[1]);
+    rc_vector_free(&outs[0]);
+    rc_vector_free(&outs[1]);
+
+    // factor once and reuse it for everything else
+    printf("\nFrom one rc_lu_t factorization of A:\n");
+    rc_lu_factor(A,&lu);
+    printf("determinant:       %8.6lf\n", rc_lu_determinant(lu));
+    printf("log|determinant|:  %8.6lf", rc_lu_log_determinant(lu,&sign));
+    printf(" sign %d\n", sign);
+    printf("condition estimate:%8.3lf\n", rc_lu_condition(lu));
+    rc_lu_solve(lu,b,&x);
+    printf("x, same as above:\n");
+    rc_vector_print(x);
+    rc_lu_inverse(lu,&Ainv);
+    printf("Ainverse:\n");
+    rc_matrix_print(Ainv);
+    rc_lu_solve_matrix(lu,A,&AA);
+    printf("A\\A, should be identity:\n");
+    rc_matrix_print(AA);
+    rc_lu_free(&lu);
+
+    // symmetric positive definite A*A^T + I through its Cholesky factor
+    printf("\nCholesky factor C of S = A*A^T + I:\n");
+    rc_matrix_multiply_trans(A,0,A,1,&Q);
+    for(i=0;i<DIM;i++) Q.d[i][i] += 1.0;
+    rc_algebra_cholesky_decomp(Q,&L);
+    rc_matrix_print(L);
+    rc_matrix_multiply_trans(L,0,L,1,&AA);
+    printf("C*C^T, should be S:\n");
+    rc_matrix_print(AA);
+    rc_matrix_print(Q);
+    rc_algebra_cholesky_solve(L,b,&x);
+    rc_matrix_times_col_vec(Q,x,&y);
+    printf("S times the Cholesky solution of Sx=b, should be b:\n");
+    rc_vector_print(y);
+    rc_algebra_cholesky_inverse(L,&Ainv);
+    rc_matrix_multiply(Q,Ainv,&AA);
+    printf("S times its inverse from C:\n");
+    rc_matrix_print(AA);
+    rc_algebra_cholesky_update(&L,b);
+    rc_algebra_cholesky_downdate(&L,b);
+    printf("C after updating and downdating with b, should be unchanged:\n");
+    rc_matrix_print(L);
+
+    // eigenvalues of the symmetric S, then the SVD of A
+    printf("\nEigenvalues of S, smallest first:\n");
+    rc_algebra_eig_sym(Q,&x,&U);
+    rc_vector_print(x);
+    printf("eigenvectors V:\n");
+    rc_matrix_print(U);
+    rc_matrix_multiply(Q,U,&AA);
+    for(i=0;i<DIM;i++) for(j=0;j<DIM;j++) U.d[j][i] *= x.d[i];
+    rc_matrix_subtract_inplace(&AA,U);
+    printf("S*V - V*diag(eig), should be zero:\n");
+    rc_matrix_print(AA);
+
+    printf("\nSingular values of A, largest first:\n");
+    rc_algebra_svd(A,&U,&y,&R);
+    rc_vector_print(y);
+    for(i=0;i<DIM;i++) for(j=0;j<DIM;j++) U.d[j][i] *= y.d[i];
+    rc_matrix_multiply_trans(U,0,R,1,&AA);
+    printf("U*diag(s)*V^T, should be A:\n");
+    rc_matrix_print(AA);
+
+    // points on an ellipsoid with semi-axes 3,2,1 turned 30 degrees about z
+    // and centered at 1,2,3, added one at a time
+    printf("\nStreaming fit of a rotated ellipsoid, center 1 2 3, lengths 3 2 1:\n");
+    rc_ellipsoid_fit_init(&fit, RC_ELLIPSOID_ROTATED);
+    for(i=0;i<100;i++){
+        u = 2.0*M_PI*i/100.0;
+        v = M_PI*(i%10+0.5)/10.0;
+        px = 3.0*sin(v)*cos(u);
+        py = 2.0*sin(v)*sin(u);
+        pt[0] = 1.0 + cos(M_PI/6.0)*px - sin(M_PI/6.0)*py;
+        pt[1] = 2.0 + sin(M_PI/6.0)*px + cos(M_PI/6.0)*py;
+        pt[2] = 3.0 + cos(v);
+        rc_ellipsoid_fit_add_point(&fit, pt);
+    }
+    rc_ellipsoid_fit_solve(fit, &x, &y, &U);
+    printf("center:\n");
+    rc_vector_print(x);
+    printf("lengths:\n");
+    rc_vector_print(y);
+    printf("axes:\n");
+    rc_matrix_print(U);
+
+    // points on a tilted plane don't determine an ellipsoid in either mode
+    printf("\nFits of points on the plane z = 0.5x - 0.2y + 3, expect two errors:\n");
+    for(j=0;j<2;j++){
+        rc_ellipsoid_fit_init(&fit, j ? RC_ELLIPSOID_ROTATED : RC_ELLIPSOID_ALIGNED);
+        for(i=0;i<100;i++){
+            u = 2.0*M_PI*i/100.0;
+            pt[0] = 1.0 + (1.0+0.3*(i%7))*cos(u);
+            pt[1] = 2.0 + 2.0*(1.0+0.3*(i%7))*sin(u);
+            pt[2] = 0.5*pt[0] - 0.2*pt[1] + 3.0;
+            rc_ellipsoid_fit_add_point(&fit, pt);
+        }
+        printf("%s returned %d\n", j ? "rotated" : "aligned",
+                                rc_ellipsoid_fit_solve(fit, &x, &y, NULL));
+    }
+
+    // a 7x7 Hilbert matrix is too ill-conditioned for float factors to help
+    printf("\nMixed precision solve of a 7x7 Hilbert matrix, expect a fallback:\n");
+    rc_matrix_alloc(&Q,7,7);
+    for(i=0;i<7;i++){
+        for(j=0;j<7;j++) Q.d[i][j] = 1.0/(i+j+1);
+    }
+    rc_vector_ones(&y,7);
+    rc_algebra_lin_system_solve_mixed(Q,y,&x,&mixed);
+    rc_vector_print(x);
+    printf("%d refinement steps, fallback %d, backward error %.2e\n",
+            mixed.iterations, mixed.fallback, mixed.residual);
+
     // free memory
+    rc_workspace_free(&ws);
     rc_matrix_free(&A);
     rc_matrix_free(&Ainv);
     rc_matrix_free(&AA);
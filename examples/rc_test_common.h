@@ -0,0 +1,34 @@
+/**
+ * @file       rc_test_common.h
+ *
+ * @brief      Comparison helpers shared by the rc_test_* examples that check
+ *             a result against a reference computed another way.
+ */
+
+#ifndef RC_TEST_COMMON_H
+#define RC_TEST_COMMON_H
+
+#include <math.h>
+#include <rc_math.h>
+
+// largest absolute difference between two vectors of the same length
+static inline double __max_err_vector(rc_vector_t a, rc_vector_t b)
+{
+    int i;
+    double err = 0.0;
+    for(i=0;i<a.len;i++) err = fmax(err, fabs(a.d[i]-b.d[i]));
+    return err;
+}
+
+// largest absolute difference between two matrices of the same size
+static inline double __max_err_matrix(rc_matrix_t A, rc_matrix_t B)
+{
+    int i,j;
+    double err = 0.0;
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) err = fmax(err, fabs(A.d[i][j]-B.d[i][j]));
+    }
+    return err;
+}
+
+#endif // RC_TEST_COMMON_H
@@ -0,0 +1,120 @@
+/**
+ * @example    rc_test_expression.c
+ *
+ * @brief      Tests the deferred expressions in rc_math/expression.h against
+ *             the same arithmetic done one step at a time with temporaries
+ *             and prints the largest difference.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+#include "rc_test_common.h"
+
+#define ROWS    300 // more than one evaluation block
+#define COLS    40
+
+
+int main()
+{
+    rc_matrix_t F   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t G   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t A   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t B   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t C   = RC_MATRIX_INITIALIZER;
+    rc_vector_t x   = RC_VECTOR_INITIALIZER;
+    rc_vector_t u   = RC_VECTOR_INITIALIZER;
+    rc_vector_t w   = RC_VECTOR_INITIALIZER;
+    rc_vector_t t1  = RC_VECTOR_INITIALIZER;
+    rc_vector_t t2  = RC_VECTOR_INITIALIZER;
+    rc_vector_t ref = RC_VECTOR_INITIALIZER;
+    rc_vector_t out = RC_VECTOR_INITIALIZER;
+    rc_expr_t e     = RC_EXPR_INITIALIZER;
+
+    printf("Let's test some deferred expressions....\n\n");
+
+    rc_matrix_random(&F, ROWS, COLS);
+    rc_matrix_random(&G, ROWS, 3);
+    rc_vector_random(&x, COLS);
+    rc_vector_random(&u, 3);
+    rc_vector_random(&w, ROWS);
+
+    // F*x + G*u
+    rc_matrix_times_col_vec(F, x, &t1);
+    rc_matrix_times_col_vec(G, u, &t2);
+    rc_vector_sum(t1, t2, &ref);
+    rc_expr_add_times_col_vec(&e, 1.0, F, 0, x);
+    rc_expr_add_times_col_vec(&e, 1.0, G, 0, u);
+    rc_expr_eval_vector(e, &out);
+    printf("F*x + G*u               max error: %9.3e\n", __max_err_vector(ref,out));
+
+    // 0.5*(w - F*x)
+    rc_vector_subtract(w, t1, &ref);
+    rc_vector_times_scalar(&ref, 0.5);
+    rc_expr_clear(&e);
+    rc_expr_add_vector(&e, 1.0, w);
+    rc_expr_add_times_col_vec(&e, -1.0, F, 0, x);
+    rc_expr_scale(&e, 0.5);
+    rc_expr_eval_vector(e, &out);
+    printf("0.5*(w - F*x)           max error: %9.3e\n", __max_err_vector(ref,out));
+
+    // x - 2*F^T*w
+    rc_matrix_times_col_vec_trans(F, 1, w, &t1);
+    rc_vector_times_scalar(&t1, -2.0);
+    rc_vector_sum(x, t1, &ref);
+    rc_expr_clear(&e);
+    rc_expr_add_vector(&e, 1.0, x);
+    rc_expr_add_times_col_vec(&e, -2.0, F, 1, w);
+    rc_expr_eval_vector(e, &out);
+    printf("x - 2*F^T*w             max error: %9.3e\n", __max_err_vector(ref,out));
+
+    // w += G*u in place
+    rc_matrix_times_col_vec(G, u, &t2);
+    rc_vector_sum(w, t2, &ref);
+    rc_expr_clear(&e);
+    rc_expr_add_vector(&e, 1.0, w);
+    rc_expr_add_times_col_vec(&e, 1.0, G, 0, u);
+    rc_expr_eval_vector(e, &w);
+    printf("w += G*u in place       max error: %9.3e\n", __max_err_vector(ref,w));
+
+    // matrix 2*F - 3*A + B
+    rc_matrix_random(&A, ROWS, COLS);
+    rc_matrix_random(&B, ROWS, COLS);
+    rc_matrix_duplicate(F, &C);
+    rc_matrix_times_scalar(&C, 2.0);
+    rc_matrix_duplicate(A, &G);
+    rc_matrix_times_scalar(&G, -3.0);
+    rc_matrix_add_inplace(&C, G);
+    rc_matrix_add_inplace(&C, B);
+    rc_expr_clear(&e);
+    rc_expr_add_matrix(&e, 2.0, F);
+    rc_expr_add_matrix(&e, -3.0, A);
+    rc_expr_add_matrix(&e, 1.0, B);
+    rc_expr_eval_matrix(e, &B);
+    printf("2*F - 3*A + B into B    max error: %9.3e\n", __max_err_matrix(C,B));
+
+    // misuse is caught when recording or evaluating
+    printf("\nexpected errors:\n");
+    rc_expr_clear(&e);
+    rc_expr_add_vector(&e, 1.0, x);
+    rc_expr_add_vector(&e, 1.0, w);
+    rc_expr_clear(&e);
+    rc_expr_add_times_col_vec(&e, 1.0, F, 0, x);
+    rc_expr_eval_vector(e, &x);
+
+    rc_matrix_free(&F);
+    rc_matrix_free(&G);
+    rc_matrix_free(&A);
+    rc_matrix_free(&B);
+    rc_matrix_free(&C);
+    rc_vector_free(&x);
+    rc_vector_free(&u);
+    rc_vector_free(&w);
+    rc_vector_free(&t1);
+    rc_vector_free(&t2);
+    rc_vector_free(&ref);
+    rc_vector_free(&out);
+
+    printf("\nDONE\n");
+    return 0;
+}
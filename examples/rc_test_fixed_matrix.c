@@ -0,0 +1,108 @@
+/**
+ * @example    rc_test_fixed_matrix.c
+ *
+ * @brief      Tests the functions in rc_math/fixed_matrix.h against the general
+ *             rc_matrix_t versions.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+
+
+// largest absolute difference between a fixed size matrix and an rc_matrix_t
+static double __max_err(const double* fixed, rc_matrix_t M, int n)
+{
+    int i,j;
+    double err = 0.0;
+    for(i=0;i<n;i++){
+        for(j=0;j<n;j++){
+            if(fabs(fixed[(i*n)+j]-M.d[i][j])>err) err = fabs(fixed[(i*n)+j]-M.d[i][j]);
+        }
+    }
+    return err;
+}
+
+
+// largest absolute difference between a fixed size vector and an rc_vector_t
+static double __max_err_vec(const double* fixed, rc_vector_t v, int n)
+{
+    int i;
+    double err = 0.0;
+    for(i=0;i<n;i++){
+        if(fabs(fixed[i]-v.d[i])>err) err = fabs(fixed[i]-v.d[i]);
+    }
+    return err;
+}
+
+
+// runs each fixed size operation and the matching rc_matrix_t one on the same
+// random data, N is the size and T the fixed type
+#define TEST_SIZE(N, T, VT) do{\
+    T a, b, c;\
+    VT x, y;\
+    rc_matrix_t A = RC_MATRIX_INITIALIZER;\
+    rc_matrix_t B = RC_MATRIX_INITIALIZER;\
+    rc_matrix_t C = RC_MATRIX_INITIALIZER;\
+    rc_vector_t v = RC_VECTOR_INITIALIZER;\
+    rc_vector_t w = RC_VECTOR_INITIALIZER;\
+    rc_matrix_random(&A,N,N);\
+    rc_matrix_random(&B,N,N);\
+    rc_vector_random(&v,N);\
+    rc_mat##N##_from_matrix(A,&a);\
+    rc_mat##N##_from_matrix(B,&b);\
+    rc_vec##N##_from_vector(v,&x);\
+    printf("\n%dx%d\n", N, N);\
+    c = rc_mat##N##_multiply(a,b);\
+    rc_matrix_multiply(A,B,&C);\
+    printf("multiply error:    %g\n", __max_err(&c.d[0][0],C,N));\
+    c = rc_mat##N##_transpose(a);\
+    rc_matrix_transpose(A,&C);\
+    printf("transpose error:   %g\n", __max_err(&c.d[0][0],C,N));\
+    printf("determinant error: %g\n", fabs(rc_mat##N##_determinant(a)-rc_matrix_determinant(A)));\
+    rc_mat##N##_invert(a,&c);\
+    rc_algebra_invert_matrix(A,&C);\
+    printf("inverse error:     %g\n", __max_err(&c.d[0][0],C,N));\
+    y = rc_mat##N##_times_vec(a,x);\
+    rc_matrix_times_col_vec(A,v,&w);\
+    printf("mat-vec error:     %g\n", __max_err_vec(y.d,w,N));\
+    rc_mat##N##_to_matrix(c,&C);\
+    printf("round trip error:  %g\n", __max_err(&c.d[0][0],C,N));\
+    rc_matrix_free(&A);\
+    rc_matrix_free(&B);\
+    rc_matrix_free(&C);\
+    rc_vector_free(&v);\
+    rc_vector_free(&w);\
+}while(0)
+
+
+int main()
+{
+    rc_vec3_t a = {{1.0, 0.0, 0.0}};
+    rc_vec3_t b = {{0.0, 1.0, 0.0}};
+    rc_vec3_t c;
+    rc_mat3_t R;
+    double q[4] = {0.9238795, 0.0, 0.0, 0.3826834}; // 45 degrees about z
+    double q2[4];
+
+    printf("Let's test the fixed size matrix functions....\n");
+
+    TEST_SIZE(3, rc_mat3_t, rc_vec3_t);
+    TEST_SIZE(4, rc_mat4_t, rc_vec4_t);
+    TEST_SIZE(6, rc_mat6_t, rc_vec6_t);
+
+    printf("\n3 element vectors\n");
+    c = rc_vec3_cross(a,b);
+    printf("x cross y: %6.3f %6.3f %6.3f\n", c.d[0], c.d[1], c.d[2]);
+    printf("x dot y:   %6.3f\n", rc_vec3_dot(a,b));
+    printf("|x+y|:     %6.3f\n", rc_vec3_norm((rc_vec3_t){{1.0, 1.0, 0.0}}));
+
+    printf("\nquaternion to rotation and back\n");
+    rc_quaternion_to_rotation_mat3(q,&R);
+    rc_rotation_mat3_to_quaternion(R,q2);
+    printf("q:  %9.6f %9.6f %9.6f %9.6f\n", q[0], q[1], q[2], q[3]);
+    printf("q2: %9.6f %9.6f %9.6f %9.6f\n", q2[0], q2[1], q2[2], q2[3]);
+
+    printf("\nDONE\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * @example    rc_test_iterative.c
+ *
+ * @brief      Runs the iterative solvers in rc_math/iterative.h on a 2D
+ *             Laplacian and two variants of it, printing the iteration count
+ *             and residual of each and the difference from a direct solve.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+#include "rc_test_common.h"
+
+#define GRID    24      // grid points per side, n = GRID*GRID unknowns
+#define SHIFT   0.5     // subtracted from the diagonal to make it indefinite
+#define WIND    0.8     // upwind convection making it nonsymmetric
+
+
+// 5 point Laplacian on the grid minus shift on the diagonal, plus wind times
+// an upwind difference along x
+static void __laplacian(rc_sparse_t* S, double shift, double wind)
+{
+    int r, c, k, n;
+    int i[5*GRID*GRID], j[5*GRID*GRID];
+    double v[5*GRID*GRID];
+    n = 0;
+    for(r=0;r<GRID;r++){
+        for(c=0;c<GRID;c++){
+            k = r*GRID+c;
+            i[n] = k; j[n] = k; v[n++] = 4.0 - shift + wind;
+            if(c>0){      i[n] = k; j[n] = k-1;    v[n++] = -1.0 - wind; }
+            if(c<GRID-1){ i[n] = k; j[n] = k+1;    v[n++] = -1.0; }
+            if(r>0){      i[n] = k; j[n] = k-GRID; v[n++] = -1.0; }
+            if(r<GRID-1){ i[n] = k; j[n] = k+GRID; v[n++] = -1.0; }
+        }
+    }
+    rc_sparse_from_triplets(S, GRID*GRID, GRID*GRID, n, i, j, v, RC_SPARSE_CSR);
+    return;
+}
+
+
+// the plain Laplacian applied from the stencil without storing a matrix
+static int __stencil(rc_vector_t x, rc_vector_t* y, __attribute__((unused)) void* ctx)
+{
+    int r, c, k;
+    for(r=0;r<GRID;r++){
+        for(c=0;c<GRID;c++){
+            k = r*GRID+c;
+            y->d[k] = 4.0*x.d[k];
+            if(c>0)      y->d[k] -= x.d[k-1];
+            if(c<GRID-1) y->d[k] -= x.d[k+1];
+            if(r>0)      y->d[k] -= x.d[k-GRID];
+            if(r<GRID-1) y->d[k] -= x.d[k+GRID];
+        }
+    }
+    return 0;
+}
+
+
+static void __report(const char* name, int ret, rc_iterative_info_t info,
+                                    rc_vector_t x, rc_vector_t ref)
+{
+    printf("%-28s ret %2d  iterations %4d  residual %9.3e  error %9.3e\n",
+            name, ret, info.iterations, info.residual, __max_err_vector(x,ref));
+    return;
+}
+
+
+int main()
+{
+    int ret;
+    rc_sparse_t S  = RC_SPARSE_INITIALIZER;
+    rc_matrix_t A  = RC_MATRIX_INITIALIZER;
+    rc_vector_t b  = RC_VECTOR_INITIALIZER;
+    rc_vector_t x  = RC_VECTOR_INITIALIZER;
+    rc_vector_t ref = RC_VECTOR_INITIALIZER;
+    rc_precond_t M = RC_PRECOND_INITIALIZER;
+    rc_iterative_opts_t opts = RC_ITERATIVE_OPTS_DEFAULT;
+    rc_iterative_info_t info;
+    rc_linop_t op;
+
+    printf("Let's test the iterative solvers on %d unknowns....\n\n", GRID*GRID);
+    rc_vector_random(&b, GRID*GRID);
+
+    printf("symmetric positive definite:\n");
+    __laplacian(&S, 0.0, 0.0);
+    rc_sparse_to_matrix(S, &A);
+    rc_algebra_lin_system_solve(A, b, &ref);
+    op = rc_linop_sparse(&S);
+    ret = rc_iterative_cg(op, b, &x, NULL, opts, &info);
+    __report("cg", ret, info, x, ref);
+    rc_precond_jacobi_sparse(S, &M);
+    ret = rc_iterative_cg(op, b, &x, &M, opts, &info);
+    __report("cg jacobi", ret, info, x, ref);
+    rc_precond_ic0(S, &M);
+    ret = rc_iterative_cg(op, b, &x, &M, opts, &info);
+    __report("cg ic0", ret, info, x, ref);
+    ret = rc_iterative_minres(op, b, &x, &M, opts, &info);
+    __report("minres ic0", ret, info, x, ref);
+    ret = rc_iterative_gmres(op, b, &x, &M, opts, &info);
+    __report("gmres ic0", ret, info, x, ref);
+    ret = rc_iterative_cg((rc_linop_t){GRID*GRID, __stencil, NULL}, b, &x, &M, opts, &info);
+    __report("cg ic0 matrix-free", ret, info, x, ref);
+    opts.warm_start = 1;
+    ret = rc_iterative_cg(op, b, &x, &M, opts, &info);
+    __report("cg ic0 warm start", ret, info, x, ref);
+    opts.warm_start = 0;
+    opts.max_iter = 10;
+    ret = rc_iterative_cg(op, b, &x, NULL, opts, &info);
+    __report("cg, 10 iterations", ret, info, x, ref);
+    opts.max_iter = 1000;
+
+    printf("\nsymmetric indefinite:\n");
+    __laplacian(&S, SHIFT, 0.0);
+    rc_sparse_to_matrix(S, &A);
+    rc_algebra_lin_system_solve_qr(A, b, &ref);
+    op = rc_linop_matrix(&A);
+    ret = rc_iterative_minres(op, b, &x, NULL, opts, &info);
+    __report("minres dense", ret, info, x, ref);
+    opts.restart = GRID*GRID;
+    ret = rc_iterative_gmres(op, b, &x, NULL, opts, &info);
+    __report("gmres unrestarted dense", ret, info, x, ref);
+    opts.restart = 30;
+
+    printf("\nnonsymmetric:\n");
+    __laplacian(&S, 0.0, WIND);
+    rc_sparse_to_matrix(S, &A);
+    rc_algebra_lin_system_solve(A, b, &ref);
+    op = rc_linop_sparse(&S);
+    ret = rc_iterative_gmres(op, b, &x, NULL, opts, &info);
+    __report("gmres(30)", ret, info, x, ref);
+    rc_precond_jacobi(A, &M);
+    ret = rc_iterative_gmres(op, b, &x, &M, opts, &info);
+    __report("gmres(30) jacobi", ret, info, x, ref);
+    opts.restart = 100;
+    ret = rc_iterative_gmres(op, b, &x, &M, opts, &info);
+    __report("gmres(100) jacobi", ret, info, x, ref);
+
+    rc_sparse_free(&S);
+    rc_matrix_free(&A);
+    rc_vector_free(&b);
+    rc_vector_free(&x);
+    rc_vector_free(&ref);
+    rc_precond_free(&M);
+
+    printf("\nDONE\n");
+    return 0;
+}
@@ -14,6 +14,7 @@
 
 int main()
 {
+    int i,j;
     double det;
     rc_matrix_t A       = RC_MATRIX_INITIALIZER;
     rc_matrix_t A_dup   = RC_MATRIX_INITIALIZER;
@@ -187,6 +188,61 @@ int main()
     rc_matrix_right_multiply_inplace(&A_dup,B);
     rc_matrix_print(A_dup);
 
+    // symmetric sandwich product with the non-square A
+    printf("\nNew Random symmetric Matrix P:\n");
+    rc_matrix_random(&B,DIM,DIM);
+    rc_matrix_symmetrize(&B);
+    rc_matrix_print(B);
+
+    printf("\nsandwich C=A*P*A' computed with two multiplies and a transpose:\n");
+    rc_matrix_transpose(A,&B_dup);
+    rc_matrix_multiply_abc(A,B,B_dup,&C);
+    rc_matrix_print(C);
+
+    printf("\nsandwich C=A*P*A' computed with rc_matrix_sandwich:\n");
+    rc_matrix_sandwich(A,B,&C);
+    rc_matrix_print(C);
+
+    // out can't be Q since it is overwritten before Q is added
+    printf("\nrc_matrix_sandwich_add with out==Q, expect an error and -1:\n");
+    printf("returned %d\n", rc_matrix_sandwich_add(A,B,C,&C));
+
+    // transposed operands without making transposed copies
+    printf("\nA'*A computed with a transpose and a multiply:\n");
+    rc_matrix_transpose(A,&B_dup);
+    rc_matrix_multiply(B_dup,A,&C);
+    rc_matrix_print(C);
+
+    printf("\nA'*A computed with rc_matrix_multiply_trans:\n");
+    rc_matrix_multiply_trans(A,1,A,0,&C);
+    rc_matrix_print(C);
+
+    printf("\nA*A' computed with rc_matrix_multiply_trans:\n");
+    rc_matrix_multiply_trans(A,0,A,1,&C);
+    rc_matrix_print(C);
+
+    printf("\nNew Random Vector b:\n");
+    rc_vector_random(&b,DIM+2);
+    rc_vector_print(b);
+
+    printf("\nA'*b computed with a transpose:\n");
+    rc_matrix_times_col_vec(B_dup,b,&y);
+    rc_vector_print(y);
+
+    printf("\nA'*b computed with rc_matrix_times_col_vec_trans:\n");
+    rc_matrix_times_col_vec_trans(A,1,b,&y);
+    rc_vector_print(y);
+
+    // padded layout, each row starts on its own cache line
+    printf("\nA'*A with A copied into a padded matrix:\n");
+    rc_matrix_alloc_padded(&A_dup,A.rows,A.cols);
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) A_dup.d[i][j] = A.d[i][j];
+    }
+    printf("stride of padded copy: %d\n", A_dup.stride);
+    rc_matrix_multiply_trans(A_dup,1,A_dup,0,&C);
+    rc_matrix_print(C);
+
     printf("\nDONE\n");
     return 0;
 }
@@ -0,0 +1,123 @@
+/**
+ * @example    rc_test_matrix_view.c
+ *
+ * @brief      Tests the functions in rc_math/matrix_view.h
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+
+#define DIM 6
+
+
+// prints a view in the same format as rc_matrix_print
+static void __print_view(rc_matrix_view_t V)
+{
+    int i,j;
+    for(i=0;i<V.rows;i++){
+        for(j=0;j<V.cols;j++) printf("%7.4f  ", RC_MATRIX_VIEW_AT(V,i,j));
+        printf("\n");
+    }
+    return;
+}
+
+
+int main()
+{
+    int i,j;
+    double err;
+    double buf[4*4];
+    rc_matrix_t A   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t B   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t C   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t Ref = RC_MATRIX_INITIALIZER;
+    rc_vector_t y   = RC_VECTOR_INITIALIZER;
+    rc_matrix_view_t Av, A11, A12, A21, Bt, Cv, col, yv, Bv;
+
+    printf("Let's test some matrix view functions....\n\n");
+
+    rc_matrix_random(&A,DIM,DIM);
+    rc_matrix_random(&B,DIM,DIM);
+    rc_matrix_zeros(&C,DIM,DIM);
+    rc_vector_zeros(&y,DIM/2);
+    Av = rc_matrix_view(A);
+
+    printf("Random matrix A:\n");
+    rc_matrix_print(A);
+
+    // blocks of A
+    rc_matrix_view_block(Av, 0, 0, DIM/2, DIM/2, &A11);
+    rc_matrix_view_block(Av, 0, DIM/2, DIM/2, DIM/2, &A12);
+    rc_matrix_view_block(Av, DIM/2, 0, DIM/2, DIM/2, &A21);
+    printf("\nTop right block A12:\n");
+    __print_view(A12);
+
+    // transposed view of B
+    Bt = rc_matrix_view_transpose(rc_matrix_view(B));
+    printf("\nTranspose view of B:\n");
+    __print_view(Bt);
+
+    // multiply a block by a transposed block straight into a block of C
+    printf("\nC[3:6,0:3] = A12 * (B[0:3,3:6])'\n");
+    rc_matrix_view_block(rc_matrix_view(C), DIM/2, 0, DIM/2, DIM/2, &Cv);
+    rc_matrix_view_block(rc_matrix_view(B), 0, DIM/2, DIM/2, DIM/2, &Bv);
+    rc_matrix_view_multiply(A12, rc_matrix_view_transpose(Bv), Cv);
+    rc_matrix_print(C);
+    err = 0.0;
+    for(i=0;i<DIM/2;i++){
+        for(j=0;j<DIM/2;j++){
+            double sum = 0.0;
+            for(int k=0;k<DIM/2;k++) sum += A.d[i][k+(DIM/2)]*B.d[j][k+(DIM/2)];
+            if(fabs(sum-C.d[i+(DIM/2)][j])>err) err = fabs(sum-C.d[i+(DIM/2)][j]);
+        }
+    }
+    printf("max error: %g\n", err);
+
+    // add two blocks in place
+    printf("\nA11 += A21 in place\n");
+    rc_matrix_duplicate(A,&Ref);
+    rc_matrix_view_add(A11, A21, A11);
+    err = 0.0;
+    for(i=0;i<DIM/2;i++){
+        for(j=0;j<DIM/2;j++){
+            double e = fabs(A.d[i][j] - (Ref.d[i][j]+Ref.d[i+(DIM/2)][j]));
+            if(e>err) err = e;
+        }
+    }
+    printf("max error: %g\n", err);
+
+    // matrix times a column of another matrix
+    printf("\ny = A21 * B[0:3,5]\n");
+    rc_matrix_view_block(rc_matrix_view(B), 0, DIM-1, DIM/2, 1, &col);
+    yv = rc_matrix_view_of_vector(y);
+    rc_matrix_view_times_col_vec(A21, col, yv);
+    rc_vector_print(y);
+    err = 0.0;
+    for(i=0;i<DIM/2;i++){
+        double sum = 0.0;
+        for(j=0;j<DIM/2;j++) sum += A.d[i+(DIM/2)][j]*B.d[j][DIM-1];
+        if(fabs(sum-y.d[i])>err) err = fabs(sum-y.d[i]);
+    }
+    printf("max error: %g\n", err);
+
+    // view over a plain user buffer
+    printf("\nView over a user buffer, 2x2 block written with a copy\n");
+    for(i=0;i<16;i++) buf[i] = 0.0;
+    rc_matrix_view_from_array(buf, 4, 4, 4, &Cv);
+    rc_matrix_view_block(Cv, 1, 1, 2, 2, &Cv);
+    rc_matrix_view_block(Av, 0, 0, 2, 2, &A11);
+    rc_matrix_view_copy(A11, Cv);
+    for(i=0;i<4;i++){
+        for(j=0;j<4;j++) printf("%7.4f  ", buf[(i*4)+j]);
+        printf("\n");
+    }
+
+    rc_matrix_free(&A);
+    rc_matrix_free(&B);
+    rc_matrix_free(&C);
+    rc_matrix_free(&Ref);
+    rc_vector_free(&y);
+    printf("\nDONE\n");
+    return 0;
+}
@@ -0,0 +1,119 @@
+/**
+ * @example    rc_test_rls.c
+ *
+ * @brief      Tests the recursive least squares in rc_math/rls.h against
+ *             rc_algebra_lin_system_solve_qr run from scratch on the same
+ *             rows and prints the largest difference.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+#include "rc_test_common.h"
+
+#define PARAMS  5   // parameters in the model
+#define ROWS    200 // rows added
+#define WINDOW  40  // sliding window length
+#define LAMBDA  0.98
+
+
+// least-squares solution of rows first..last-1 of A and b, each row weighted
+// by lambda^(age/2) where the last row has age 0
+static void __batch_solve(rc_matrix_t A, rc_vector_t b, int first, int last,
+                                    double lambda, rc_vector_t* x)
+{
+    int i,j;
+    double w;
+    rc_matrix_t As = RC_MATRIX_INITIALIZER;
+    rc_vector_t bs = RC_VECTOR_INITIALIZER;
+    rc_matrix_alloc(&As, last-first, A.cols);
+    rc_vector_alloc(&bs, last-first);
+    for(i=first;i<last;i++){
+        w = pow(lambda, 0.5*(last-1-i));
+        for(j=0;j<A.cols;j++) As.d[i-first][j] = w*A.d[i][j];
+        bs.d[i-first] = w*b.d[i];
+    }
+    rc_algebra_lin_system_solve_qr(As, bs, x);
+    rc_matrix_free(&As);
+    rc_vector_free(&bs);
+    return;
+}
+
+
+int main()
+{
+    int i, j;
+    rc_matrix_t A   = RC_MATRIX_INITIALIZER;
+    rc_vector_t b   = RC_VECTOR_INITIALIZER;
+    rc_vector_t a   = RC_VECTOR_INITIALIZER;
+    rc_vector_t x   = RC_VECTOR_INITIALIZER;
+    rc_vector_t ref = RC_VECTOR_INITIALIZER;
+    rc_vector_t truth = RC_VECTOR_INITIALIZER;
+    rc_rls_t rls    = RC_RLS_INITIALIZER;
+    rc_rls_t fgt    = RC_RLS_INITIALIZER;
+    rc_rls_t win    = RC_RLS_INITIALIZER;
+    double err, err_fgt, err_win;
+
+    printf("Let's test recursive least squares....\n\n");
+
+    // noisy rows of a model whose parameters change halfway through
+    rc_matrix_random(&A, ROWS, PARAMS);
+    rc_vector_random(&b, ROWS);
+    rc_vector_random(&truth, PARAMS);
+    for(i=0;i<ROWS;i++){
+        if(i==ROWS/2) rc_vector_random(&truth, PARAMS);
+        b.d[i] *= 0.01;
+        for(j=0;j<PARAMS;j++) b.d[i] += truth.d[j]*A.d[i][j];
+    }
+
+    rc_rls_alloc(&rls, PARAMS, 1.0, 0);
+    rc_rls_alloc(&fgt, PARAMS, LAMBDA, 0);
+    rc_rls_alloc(&win, PARAMS, LAMBDA, WINDOW);
+    rc_vector_alloc(&a, PARAMS);
+
+    err = err_fgt = err_win = 0.0;
+    for(i=0;i<ROWS;i++){
+        for(j=0;j<PARAMS;j++) a.d[j] = A.d[i][j];
+        rc_rls_add_row(&rls, a, b.d[i]);
+        rc_rls_add_row(&fgt, a, b.d[i]);
+        rc_rls_add_row(&win, a, b.d[i]);
+        if(i<PARAMS) continue;
+
+        __batch_solve(A, b, 0, i+1, 1.0, &ref);
+        rc_rls_solve(rls, &x);
+        err = fmax(err, __max_err_vector(ref,x));
+
+        __batch_solve(A, b, 0, i+1, LAMBDA, &ref);
+        rc_rls_solve(fgt, &x);
+        err_fgt = fmax(err_fgt, __max_err_vector(ref,x));
+
+        __batch_solve(A, b, (i+1>WINDOW) ? i+1-WINDOW : 0, i+1, LAMBDA, &ref);
+        rc_rls_solve(win, &x);
+        err_win = fmax(err_win, __max_err_vector(ref,x));
+    }
+    printf("every row                 max error: %9.3e\n", err);
+    printf("forgetting factor %4.2f    max error: %9.3e\n", LAMBDA, err_fgt);
+    printf("window of %d rows         max error: %9.3e\n", WINDOW, err_win);
+
+    printf("\nparameters after the change:\n");
+    rc_vector_print(truth);
+    printf("estimate using every row:\n");
+    rc_rls_solve(rls, &x);
+    rc_vector_print(x);
+    printf("estimate with the window, residual %6.4f:\n", rc_rls_residual(win));
+    rc_rls_solve(win, &x);
+    rc_vector_print(x);
+
+    rc_matrix_free(&A);
+    rc_vector_free(&b);
+    rc_vector_free(&a);
+    rc_vector_free(&x);
+    rc_vector_free(&ref);
+    rc_vector_free(&truth);
+    rc_rls_free(&rls);
+    rc_rls_free(&fgt);
+    rc_rls_free(&win);
+
+    printf("\nDONE\n");
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * @example    rc_test_single_precision.c
+ *
+ * @brief      Tests the float functions in rc_math/single_precision.h against
+ *             their double counterparts and prints the largest difference.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+
+#define DIM     8
+#define STEPS   200
+
+
+// largest absolute difference between a float and double matrix
+static double __max_err_matrix(rc_matrixf_t Af, rc_matrix_t A)
+{
+    int i,j;
+    double err = 0.0;
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++){
+            err = fmax(err, fabs((double)Af.d[i][j]-A.d[i][j]));
+        }
+    }
+    return err;
+}
+
+
+// largest absolute difference between a float and double vector
+static double __max_err_vector(rc_vectorf_t vf, rc_vector_t v)
+{
+    int i;
+    double err = 0.0;
+    for(i=0;i<v.len;i++) err = fmax(err, fabs((double)vf.d[i]-v.d[i]));
+    return err;
+}
+
+
+int main()
+{
+    int i;
+    double err;
+    double q[4], v[3];
+    float qf[4], vf[3];
+    rc_matrix_t A   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t B   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t C   = RC_MATRIX_INITIALIZER;
+    rc_vector_t b   = RC_VECTOR_INITIALIZER;
+    rc_vector_t x   = RC_VECTOR_INITIALIZER;
+    rc_matrixf_t Af = RC_MATRIXF_INITIALIZER;
+    rc_matrixf_t Bf = RC_MATRIXF_INITIALIZER;
+    rc_matrixf_t Cf = RC_MATRIXF_INITIALIZER;
+    rc_vectorf_t bf = RC_VECTORF_INITIALIZER;
+    rc_vectorf_t xf = RC_VECTORF_INITIALIZER;
+    rc_filter_t  lp = RC_FILTER_INITIALIZER;
+    rc_filterf_t lpf = RC_FILTERF_INITIALIZER;
+
+    printf("Let's test some single precision functions....\n\n");
+
+    // diagonally dominant so both solves are well conditioned
+    rc_matrix_random(&A,DIM,DIM);
+    for(i=0;i<DIM;i++) A.d[i][i] += DIM;
+    rc_matrix_random(&B,DIM,DIM);
+    rc_vector_random(&b,DIM);
+    rc_matrixf_from_matrix(&Af,A);
+    rc_matrixf_from_matrix(&Bf,B);
+    rc_vectorf_from_vector(&bf,b);
+
+    // multiply
+    rc_matrix_multiply(A,B,&C);
+    rc_matrixf_multiply(Af,Bf,&Cf);
+    err = __max_err_matrix(Cf,C);
+    printf("multiply           max error: %9.3e\n", err);
+
+    // LU solve
+    rc_algebra_lin_system_solve(A,b,&x);
+    rc_algebraf_lin_system_solve(Af,bf,&xf);
+    err = __max_err_vector(xf,x);
+    printf("lin_system_solve   max error: %9.3e\n", err);
+
+    // QR solve
+    rc_algebra_lin_system_solve_qr(A,b,&x);
+    rc_algebraf_lin_system_solve_qr(Af,bf,&xf);
+    err = __max_err_vector(xf,x);
+    printf("lin_system_solve_qr max error: %9.3e\n", err);
+
+    // quaternion rotation of a vector
+    double tb[3] = {0.3, -0.2, 1.1};
+    float tbf[3] = {0.3f, -0.2f, 1.1f};
+    rc_quaternion_from_tb_array(tb,q);
+    rc_quaternionf_from_tb_array(tbf,qf);
+    v[0] = 1.0;  v[1] = 2.0;  v[2] = 3.0;
+    vf[0] = 1.0f; vf[1] = 2.0f; vf[2] = 3.0f;
+    rc_quaternion_rotate_vector_array(v,q);
+    rc_quaternionf_rotate_vector_array(vf,qf);
+    err = 0.0;
+    for(i=0;i<3;i++) err = fmax(err, fabs((double)vf[i]-v[i]));
+    printf("quaternion rotate  max error: %9.3e\n", err);
+
+    // filter designed in double then marched in float
+    rc_filter_butterworth_lowpass(&lp, 2, 0.01, 6.28);
+    rc_filterf_from_filter(&lpf, lp);
+    err = 0.0;
+    for(i=0;i<STEPS;i++){
+        double in = sin(0.1*i);
+        double out = rc_filter_march(&lp, in);
+        float outf = rc_filterf_march(&lpf, (float)in);
+        err = fmax(err, fabs((double)outf-out));
+    }
+    printf("butterworth march  max error: %9.3e\n", err);
+
+    rc_matrix_free(&A);
+    rc_matrix_free(&B);
+    rc_matrix_free(&C);
+    rc_vector_free(&b);
+    rc_vector_free(&x);
+    rc_matrixf_free(&Af);
+    rc_matrixf_free(&Bf);
+    rc_matrixf_free(&Cf);
+    rc_vectorf_free(&bf);
+    rc_vectorf_free(&xf);
+    rc_filter_free(&lp);
+    rc_filterf_free(&lpf);
+
+    printf("\nDONE\n");
+    return 0;
+}
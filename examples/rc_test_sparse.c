@@ -0,0 +1,175 @@
+/**
+ * @example    rc_test_sparse.c
+ *
+ * @brief      Tests the sparse matrix functions in rc_math/sparse.h against
+ *             the same operations on dense rc_matrix_t and prints the largest
+ *             difference, then runs a dense and a sparse EKF side by side.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+#include "rc_test_common.h"
+
+#define DIM     20  // states
+#define MEAS    8   // measurements
+#define STEPS   10  // filter steps
+
+
+// random rows x cols matrix with roughly one element in five nonzero
+static void __random_sparse(rc_matrix_t* A, int rows, int cols)
+{
+    int i,j;
+    rc_matrix_random(A,rows,cols);
+    for(i=0;i<rows;i++){
+        for(j=0;j<cols;j++) if(fabs(A->d[i][j])>0.2) A->d[i][j] = 0.0;
+    }
+    return;
+}
+
+
+int main()
+{
+    int i, f;
+    rc_matrix_t A   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t B   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t C   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t D   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t F   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t H   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t Q   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t R   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t Pi  = RC_MATRIX_INITIALIZER;
+    rc_vector_t v   = RC_VECTOR_INITIALIZER;
+    rc_vector_t x   = RC_VECTOR_INITIALIZER;
+    rc_vector_t y   = RC_VECTOR_INITIALIZER;
+    rc_vector_t h   = RC_VECTOR_INITIALIZER;
+    rc_sparse_t S   = RC_SPARSE_INITIALIZER;
+    rc_sparse_t T   = RC_SPARSE_INITIALIZER;
+    rc_sparse_t Fs  = RC_SPARSE_INITIALIZER;
+    rc_sparse_t Hs  = RC_SPARSE_INITIALIZER;
+    rc_kalman_t kf  = RC_KALMAN_INITIALIZER;
+    rc_kalman_t kfs = RC_KALMAN_INITIALIZER;
+    const char* name[] = {"CSR", "CSC"};
+
+    // triplets with a duplicate that gets summed
+    int    ti[] = {2,   0,   1,   2,   0};
+    int    tj[] = {2,   0,   1,   0,   0};
+    double tv[] = {1.0, 1.0, 2.0, 0.5, 0.5};
+
+    printf("Let's test some sparse matrix functions....\n\n");
+
+    rc_sparse_from_triplets(&S, 3, 3, 5, ti, tj, tv, RC_SPARSE_CSR);
+    printf("from triplets, (0,0) given twice:\n");
+    rc_sparse_print(S);
+    rc_sparse_to_matrix(S, &A);
+    rc_matrix_print(A);
+    printf("\n");
+
+    __random_sparse(&A, DIM, MEAS);
+    rc_matrix_random(&B, MEAS, 5);
+    rc_matrix_random(&D, 5, DIM);
+    rc_vector_random(&v, MEAS);
+
+    for(f=RC_SPARSE_CSR;f<=RC_SPARSE_CSC;f++){
+        rc_sparse_from_matrix(A, f, &S);
+        printf("%s %dx%d with %d nonzeros\n", name[f], S.rows, S.cols, S.nnz);
+
+        rc_sparse_to_matrix(S, &C);
+        printf("to and from dense         max error: %9.3e\n", __max_err_matrix(A,C));
+
+        rc_sparse_convert(S, !f, &T);
+        rc_sparse_to_matrix(T, &C);
+        printf("convert to %s            max error: %9.3e\n", name[!f], __max_err_matrix(A,C));
+
+        rc_matrix_times_col_vec(A, v, &x);
+        rc_sparse_times_col_vec(S, v, &y);
+        printf("times_col_vec             max error: %9.3e\n", __max_err_vector(x,y));
+
+        rc_matrix_times_col_vec_trans(A, 1, x, &v);
+        rc_sparse_times_col_vec_trans(S, 1, x, &y);
+        printf("times_col_vec_trans       max error: %9.3e\n", __max_err_vector(v,y));
+
+        rc_matrix_multiply(A, B, &C);
+        rc_sparse_multiply_dense(S, 0, B, &Q);
+        printf("S*B                       max error: %9.3e\n", __max_err_matrix(C,Q));
+
+        rc_matrix_multiply_trans(A, 1, D, 1, &C);
+        rc_matrix_transpose(D, &R);
+        rc_sparse_multiply_dense(S, 1, R, &Q);
+        printf("S^T*B                     max error: %9.3e\n", __max_err_matrix(C,Q));
+
+        rc_matrix_multiply(D, A, &C);
+        rc_sparse_dense_multiply(D, S, 0, &Q);
+        printf("B*S                       max error: %9.3e\n", __max_err_matrix(C,Q));
+
+        rc_matrix_multiply_trans(B, 1, A, 1, &C);
+        rc_matrix_transpose(B, &R);
+        rc_sparse_dense_multiply(R, S, 1, &Q);
+        printf("B*S^T                     max error: %9.3e\n\n", __max_err_matrix(C,Q));
+    }
+
+    // stable sparse F close to identity, sparse H, and the noise matrices
+    __random_sparse(&F, DIM, DIM);
+    rc_matrix_times_scalar(&F, 0.1);
+    for(i=0;i<DIM;i++) F.d[i][i] += 0.9;
+    __random_sparse(&H, MEAS, DIM);
+    for(i=0;i<MEAS;i++) H.d[i][i] = 1.0;
+    rc_matrix_identity(&Q, DIM);
+    rc_matrix_times_scalar(&Q, 0.01);
+    rc_matrix_identity(&R, MEAS);
+    rc_matrix_times_scalar(&R, 0.1);
+    rc_matrix_identity(&Pi, DIM);
+    rc_sparse_from_matrix(F, RC_SPARSE_CSR, &Fs);
+    rc_sparse_from_matrix(H, RC_SPARSE_CSC, &Hs);
+
+    rc_kalman_alloc_ekf(&kf, Q, R, Pi);
+    rc_kalman_alloc_ekf(&kfs, Q, R, Pi);
+    for(i=0;i<STEPS;i++){
+        rc_matrix_times_col_vec(F, kf.x_est, &x);
+        rc_matrix_times_col_vec(H, x, &h);
+        rc_vector_random(&y, MEAS);
+        rc_kalman_update_ekf(&kf, F, H, x, y, h);
+        rc_kalman_update_ekf_sparse(&kfs, Fs, Hs, x, y, h);
+    }
+    printf("EKF after %d steps, dense vs sparse F and H\n", STEPS);
+    printf("x_est                     max error: %9.3e\n", __max_err_vector(kf.x_est,kfs.x_est));
+    printf("P                         max error: %9.3e\n", __max_err_matrix(kf.P,kfs.P));
+
+    // the same comparison for the linear filter with no control input
+    rc_matrix_zeros(&B, DIM, 1);
+    rc_vector_zeros(&v, 1);
+    rc_kalman_alloc_lin(&kf, F, B, H, Q, R, Pi);
+    rc_kalman_alloc_lin_sparse(&kfs, Fs, B, Hs, Q, R, Pi);
+    for(i=0;i<STEPS;i++){
+        rc_vector_random(&y, MEAS);
+        rc_kalman_update_lin(&kf, v, y);
+        rc_kalman_update_lin(&kfs, v, y);
+    }
+    printf("\nlinear KF after %d steps, dense vs sparse F and H\n", STEPS);
+    printf("x_est                     max error: %9.3e\n", __max_err_vector(kf.x_est,kfs.x_est));
+    printf("P                         max error: %9.3e\n", __max_err_matrix(kf.P,kfs.P));
+
+    rc_matrix_free(&A);
+    rc_matrix_free(&B);
+    rc_matrix_free(&C);
+    rc_matrix_free(&D);
+    rc_matrix_free(&F);
+    rc_matrix_free(&H);
+    rc_matrix_free(&Q);
+    rc_matrix_free(&R);
+    rc_matrix_free(&Pi);
+    rc_vector_free(&v);
+    rc_vector_free(&x);
+    rc_vector_free(&y);
+    rc_vector_free(&h);
+    rc_sparse_free(&S);
+    rc_sparse_free(&T);
+    rc_sparse_free(&Fs);
+    rc_sparse_free(&Hs);
+    rc_kalman_free(&kf);
+    rc_kalman_free(&kfs);
+
+    printf("\nDONE\n");
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * @example    rc_test_symmetric.c
+ *
+ * @brief      Tests the packed symmetric functions in rc_math/symmetric.h
+ *             against the same operations on full rc_matrix_t and prints the
+ *             largest difference.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include <rc_math.h>
+#include "rc_test_common.h"
+
+#define DIM     12
+#define ROWS    7
+#define BIG     800     // too big for scratch on the default 8MB stack
+
+
+// largest absolute difference between a packed and a full matrix
+static double __max_err(rc_symmetric_t S, rc_matrix_t A)
+{
+    int i,j;
+    double err = 0.0;
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++){
+            err = fmax(err, fabs(rc_symmetric_get(S,i,j)-A.d[i][j]));
+        }
+    }
+    return err;
+}
+
+
+int main()
+{
+    int i;
+    rc_matrix_t A   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t F   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t P   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t Q   = RC_MATRIX_INITIALIZER;
+    rc_matrix_t C   = RC_MATRIX_INITIALIZER;
+    rc_vector_t b   = RC_VECTOR_INITIALIZER;
+    rc_vector_t x   = RC_VECTOR_INITIALIZER;
+    rc_vector_t y   = RC_VECTOR_INITIALIZER;
+    rc_symmetric_t Ps   = RC_SYMMETRIC_INITIALIZER;
+    rc_symmetric_t Qs   = RC_SYMMETRIC_INITIALIZER;
+    rc_symmetric_t Cs   = RC_SYMMETRIC_INITIALIZER;
+    rc_symmetric_t U    = RC_SYMMETRIC_INITIALIZER;
+
+    printf("Let's test some packed symmetric functions....\n\n");
+
+    // symmetric positive definite P = A*A' + I and symmetric Q
+    rc_matrix_random(&A,DIM,DIM);
+    rc_matrix_multiply_trans(A,0,A,1,&P);
+    for(i=0;i<DIM;i++) P.d[i][i] += 1.0;
+    rc_matrix_random(&Q,ROWS,ROWS);
+    rc_matrix_symmetrize(&Q);
+    rc_matrix_random(&F,ROWS,DIM);
+    rc_vector_random(&b,DIM);
+
+    rc_symmetric_from_matrix(P,&Ps);
+    rc_symmetric_from_matrix(Q,&Qs);
+    printf("packed %dx%d uses %d doubles instead of %d\n\n", DIM, DIM,
+                                    RC_SYMMETRIC_SIZE(DIM), DIM*DIM);
+
+    printf("pack and unpack      max error: %9.3e\n", __max_err(Ps,P));
+
+    // add and scale
+    rc_symmetric_add(Ps,Ps,&Cs);
+    rc_symmetric_times_scalar(&Cs,0.25);
+    rc_matrix_duplicate(P,&C);
+    rc_matrix_times_scalar(&C,0.5);
+    printf("add and scale        max error: %9.3e\n", __max_err(Cs,C));
+
+    // mat-vec
+    rc_matrix_times_col_vec(P,b,&x);
+    rc_symmetric_times_col_vec(Ps,b,&y);
+    printf("times_col_vec        max error: %9.3e\n", __max_err_vector(x,y));
+
+    // sandwich with the non-square F
+    rc_matrix_sandwich_add(F,P,Q,&C);
+    rc_symmetric_sandwich_add(F,Ps,Qs,&Cs);
+    printf("sandwich_add         max error: %9.3e\n", __max_err(Cs,C));
+    rc_symmetric_duplicate(Qs,&U);
+    rc_symmetric_sandwich_add(F,Ps,U,&U);
+    printf("sandwich_add in Q    max error: %9.3e\n", __max_err(U,C));
+    rc_matrix_sandwich(F,P,&C);
+    rc_symmetric_sandwich(F,Ps,&Cs);
+    printf("sandwich             max error: %9.3e\n", __max_err(Cs,C));
+
+    // sandwich large enough that stack scratch would have overflowed
+    rc_matrix_random(&F,BIG,BIG);
+    rc_matrix_multiply_trans(F,0,F,1,&A);
+    rc_symmetric_from_matrix(A,&Cs);
+    rc_matrix_sandwich(F,A,&C);
+    rc_symmetric_sandwich(F,Cs,&U);
+    printf("sandwich %dx%d      max rel error: %9.3e\n", BIG, BIG,
+                            __max_err(U,C)/fabs(C.d[0][0]));
+
+    // cholesky factor and solve
+    rc_algebra_lin_system_solve(P,b,&x);
+    rc_symmetric_cholesky(Ps,&U);
+    rc_symmetric_cholesky_solve(U,b,&y);
+    printf("cholesky solve       max error: %9.3e\n", __max_err_vector(x,y));
+
+    rc_matrix_free(&A);
+    rc_matrix_free(&F);
+    rc_matrix_free(&P);
+    rc_matrix_free(&Q);
+    rc_matrix_free(&C);
+    rc_vector_free(&b);
+    rc_vector_free(&x);
+    rc_vector_free(&y);
+    rc_symmetric_free(&Ps);
+    rc_symmetric_free(&Qs);
+    rc_symmetric_free(&Cs);
+    rc_symmetric_free(&U);
+
+    printf("\nDONE\n");
+    return 0;
+}
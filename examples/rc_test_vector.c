@@ -19,6 +19,7 @@ int main()
     int i;
     rc_vector_t a = RC_VECTOR_INITIALIZER;
     rc_vector_t b = RC_VECTOR_INITIALIZER;
+    rc_vector_stats_t stats;
 
     printf("Testing vector functions\n\n");
 
@@ -80,6 +81,16 @@ int main()
     // mean
     printf("%7f mean\n", rc_vector_mean(a));
 
+    // all of the above in one pass
+    rc_vector_stats(a, RC_VECTOR_STATS_ALL, &stats);
+    printf("\nSame results from rc_vector_stats in one pass:\n");
+    printf("%7f Vector 1-norm\n", stats.norm1);
+    printf("%7f Vector 2-norm\n", stats.norm2);
+    printf("%7f Vector Max at position %d\n", stats.max, stats.max_index);
+    printf("%7f Vector Min at position %d\n", stats.min, stats.min_index);
+    printf("%7f standard deviation\n", stats.std_dev);
+    printf("%7f mean\n", stats.mean);
+
     // cleanup
     rc_vector_free(&a);
     rc_vector_free(&b);
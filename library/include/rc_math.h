@@ -17,16 +17,27 @@
 #endif
 
 #include <rc_math/algebra.h>
+#include <rc_math/batch.h>
+#include <rc_math/expression.h>
 #include <rc_math/filter.h>
+#include <rc_math/fixed_matrix.h>
+#include <rc_math/iterative.h>
 #include <rc_math/kalman.h>
 #include <rc_math/matrix.h>
+#include <rc_math/matrix_view.h>
 #include <rc_math/other.h>
 #include <rc_math/polynomial.h>
 #include <rc_math/quaternion.h>
 #include <rc_math/ring_buffer.h>
+#include <rc_math/rls.h>
+#include <rc_math/single_precision.h>
+#include <rc_math/sparse.h>
+#include <rc_math/symmetric.h>
+#include <rc_math/thread_pool.h>
 #include <rc_math/timestamp_filter.h>
 #include <rc_math/timed_ringbuf.h>
 #include <rc_math/timed3_ringbuf.h>
 #include <rc_math/vector.h>
+#include <rc_math/workspace.h>
 
 #endif // RC_MATH_H
@@ -17,6 +17,74 @@ extern "C" {
 
 #include <rc_math/matrix.h>
 
+/**
+ * @name       SIMD kernel paths
+ *
+ * The innermost dot product, AXPY, scale, and matrix multiply kernels used by
+ * the vector, matrix, and algebra functions have hand-written versions for
+ * several instruction sets. The fastest one supported by the running CPU is
+ * chosen once when the library is loaded so one build of the library runs
+ * well on every generation of x86-64 and on aarch64.
+ */
+///@{
+#define RC_SIMD_GENERIC     0   ///< plain C, whatever the compiler produces
+#define RC_SIMD_SSE2        1   ///< x86 SSE2
+#define RC_SIMD_AVX2        2   ///< x86 AVX2 with FMA3
+#define RC_SIMD_AVX512      3   ///< x86 AVX-512F
+#define RC_SIMD_NEON        4   ///< aarch64 Advanced SIMD
+///@}
+
+/**
+ * @brief      Returns which SIMD kernel path is currently in use.
+ *
+ * @return     One of the RC_SIMD_* values.
+ */
+int rc_algebra_get_simd_path(void);
+
+/**
+ * @brief      Returns a human readable name for a SIMD kernel path.
+ *
+ * @param[in]  path  One of the RC_SIMD_* values
+ *
+ * @return     Name of the path such as "avx2", or "unknown" for an invalid
+ * path.
+ */
+const char* rc_algebra_simd_path_name(int path);
+
+/**
+ * @brief      Forces the library to use a specific SIMD kernel path.
+ *
+ * This is mainly useful for benchmarking and for checking results between
+ * paths. The automatically detected path is already the fastest available so
+ * normal users do not need to call this. It is not thread safe, call it before
+ * any other thread starts using the library.
+ *
+ * @param[in]  path  One of the RC_SIMD_* values
+ *
+ * @return     0 on success, -1 if the path is invalid or not supported by this
+ * CPU, in which case the current path is left unchanged.
+ */
+int rc_algebra_set_simd_path(int path);
+
+/**
+ * @brief      Returns the number of bytes of workspace the _ws functions need
+ * for a matrix of the given size.
+ *
+ * The result is enough for any of rc_algebra_lup_decomp_ws,
+ * rc_algebra_qr_decomp_ws, rc_algebra_invert_matrix_ws,
+ * rc_algebra_lin_system_solve_ws, rc_algebra_lin_system_solve_mixed_ws,
+ * rc_algebra_eig_sym_ws, rc_algebra_svd_ws, and rc_matrix_determinant_ws on
+ * a matrix of up to rows x cols. Pass it to rc_workspace_alloc, see workspace.h.
+ * It does not cover the packing buffers of the blocked multiply, which are
+ * still malloced for matrices bigger than 64x64, see workspace.h.
+ *
+ * @param[in]  rows  number of rows of the largest matrix to be used
+ * @param[in]  cols  number of columns of the largest matrix to be used
+ *
+ * @return     size in bytes
+ */
+size_t rc_algebra_workspace_size(int rows, int cols);
+
 /**
  * @brief      Performs LUP decomposition on matrix A with partial pivoting.
  *
@@ -33,14 +101,30 @@ extern "C" {
  */
 int rc_algebra_lup_decomp(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matrix_t* P);
 
+/**
+ * @brief      Same as rc_algebra_lup_decomp but takes its temporaries from a
+ * workspace. L, U, and P are only reallocated if they are the wrong size.
+ *
+ * @param[in]  A     input matrix
+ * @param[out] L     lower triangular
+ * @param[out] U     upper triangular
+ * @param[out] P     permutation matrix
+ * @param      ws    workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_lup_decomp_ws(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matrix_t* P, rc_workspace_t* ws);
+
 /**
  * @brief      Calculate the QR decomposition of matrix A.
  *
- * Uses householder reflection method. Matrix A remains untouched and the
- * original contents of Q&R (if any) are freed and resized appropriately.
+ * Uses householder reflection method, blocked so that most of the work is
+ * done by matrix multiplies. Matrix A remains untouched and the original
+ * contents of Q&R (if any) are freed and resized appropriately. Forming Q
+ * is as much work again as finding R, pass NULL for Q if only R is needed.
  *
  * @param[in]  A     input matrix
- * @param[out] Q     orthogonal matrix output
+ * @param[out] Q     orthogonal matrix output, or NULL to skip it
  * @param[out] R     upper triangular matrix output
  *
  * @return     Returns 0 on success or -1 on failure.
@@ -48,11 +132,25 @@ int rc_algebra_lup_decomp(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matr
 int rc_algebra_qr_decomp(rc_matrix_t A, rc_matrix_t* Q, rc_matrix_t* R);
 
 /**
- * @brief      Inverts matrix A via LUP decomposition method.
+ * @brief      Same as rc_algebra_qr_decomp but takes its temporaries from a
+ * workspace. Q and R are only reallocated if they are the wrong size.
+ *
+ * @param[in]  A     input matrix
+ * @param[out] Q     orthogonal matrix output, or NULL to skip it
+ * @param[out] R     upper triangular matrix output
+ * @param      ws    workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_qr_decomp_ws(rc_matrix_t A, rc_matrix_t* Q, rc_matrix_t* R, rc_workspace_t* ws);
+
+/**
+ * @brief      Inverts matrix A via LU decomposition with partial pivoting.
  *
  * Places the result in matrix Ainv. Any existing memory allocated for Ainv is
  * freed if necessary and its contents are overwritten. Returns -1 if matrix is
- * not invertible.
+ * not invertible. To also solve with A or find its determinant, factor it
+ * once with rc_lu_factor instead.
  *
  * @param[in]  A     input matrix
  * @param[out] Ainv  resulting inverted matrix
@@ -61,6 +159,18 @@ int rc_algebra_qr_decomp(rc_matrix_t A, rc_matrix_t* Q, rc_matrix_t* R);
  */
 int rc_algebra_invert_matrix(rc_matrix_t A, rc_matrix_t* Ainv);
 
+/**
+ * @brief      Same as rc_algebra_invert_matrix but takes its temporaries from a
+ * workspace. Ainv is only reallocated if it is the wrong size.
+ *
+ * @param[in]  A     input matrix
+ * @param[out] Ainv  resulting inverted matrix
+ * @param      ws    workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_invert_matrix_ws(rc_matrix_t A, rc_matrix_t* Ainv, rc_workspace_t* ws);
+
 /**
  * @brief      Inverts matrix A in place.
  *
@@ -72,6 +182,267 @@ int rc_algebra_invert_matrix(rc_matrix_t A, rc_matrix_t* Ainv);
  */
 int rc_algebra_invert_matrix_inplace(rc_matrix_t* A);
 
+/**
+ * @brief      Reusable LU factorization with partial pivoting, P*A = L*U.
+ *
+ * rc_lu_factor factors A once, in place in LU, after which the determinant,
+ * log-determinant, a condition number estimate, solutions for any number of
+ * right hand sides, and the inverse all come from the same factorization
+ * instead of each starting over from A. L has a unit diagonal which is not
+ * stored, its strictly lower triangle shares LU with U. Rows k and piv[k] were
+ * swapped in turn for k=0 to n-1. Refactoring a matrix of the same size
+ * reuses the memory.
+ */
+typedef struct rc_lu_t{
+    rc_matrix_t LU;     ///< L below the diagonal, U on and above it
+    int* piv;           ///< row swap sequence, length n
+    double* work;       ///< scratch for the condition estimate, length n
+    int n;              ///< size of the factored matrix
+    int sign;           ///< sign of the permutation, 1 or -1
+    double anorm;       ///< 1-norm of the factored matrix
+    int singular;       ///< 1 if a pivot is negligible next to the zero tolerance
+    int initialized;    ///< 1 once memory has been allocated
+} rc_lu_t;
+
+#define RC_LU_INITIALIZER {\
+    .LU = RC_MATRIX_INITIALIZER,\
+    .piv = NULL,\
+    .work = NULL,\
+    .n = 0,\
+    .sign = 1,\
+    .anorm = 0.0,\
+    .singular = 0,\
+    .initialized = 0}
+
+/**
+ * @brief      Returns an rc_lu_t with no allocated memory and the
+ * initialized flag set to 0.
+ *
+ * @return     empty rc_lu_t
+ */
+rc_lu_t rc_lu_empty(void);
+
+/**
+ * @brief      Frees the memory of an LU factorization and zeros out the
+ * struct.
+ *
+ * @param      lu    pointer to factorization
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_lu_free(rc_lu_t* lu);
+
+/**
+ * @brief      Factors square matrix A into lu.
+ *
+ * The trailing submatrix updates are done in blocks with the matrix multiply
+ * kernels, so this is much faster than rc_algebra_lup_decomp for large A. A
+ * singular A is not an error: it is factored anyway and lu->singular is set,
+ * which is the case when a pivot is no larger than the zero tolerance times
+ * the largest element of A. The determinant functions still work on it while
+ * the solves and the inverse refuse it.
+ *
+ * @param[in]  A     square matrix, left untouched
+ * @param      lu    factorization, allocated as needed
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_lu_factor(rc_matrix_t A, rc_lu_t* lu);
+
+/**
+ * @brief      Determinant of the factored matrix, the product of the pivots.
+ *
+ * @param[in]  lu    factorization
+ *
+ * @return     The determinant or -1.0 on error.
+ */
+double rc_lu_determinant(rc_lu_t lu);
+
+/**
+ * @brief      Natural log of the absolute value of the determinant.
+ *
+ * Unlike rc_lu_determinant this does not overflow or underflow for large
+ * matrices.
+ *
+ * @param[in]  lu    factorization
+ * @param[out] sign  sign of the determinant, 1, -1, or 0 if a pivot is
+ * exactly zero
+ *
+ * @return     log|det(A)|, -INFINITY if a pivot is exactly zero, or NAN on
+ * error.
+ */
+double rc_lu_log_determinant(rc_lu_t lu, int* sign);
+
+/**
+ * @brief      Estimates the 1-norm condition number |A|_1*|inv(A)|_1.
+ *
+ * Uses the Hager/Higham estimator which needs only a handful of solves with
+ * the existing factorization rather than forming the inverse. The estimate is
+ * a lower bound that is almost always within a small factor of the true
+ * value.
+ *
+ * @param[in]  lu    factorization
+ *
+ * @return     The estimate, INFINITY if the matrix is singular, or -1.0 on
+ * error.
+ */
+double rc_lu_condition(rc_lu_t lu);
+
+/**
+ * @brief      Solves Ax=b with the factorization of A.
+ *
+ * @param[in]  lu    factorization of A
+ * @param[in]  b     right hand side
+ * @param[out] x     solution, allocated as needed, may be b
+ *
+ * @return     Returns 0 on success or -1 on failure or if A is singular.
+ */
+int rc_lu_solve(rc_lu_t lu, rc_vector_t b, rc_vector_t* x);
+
+/**
+ * @brief      Solves AX=B for every column of B at once with the
+ * factorization of A.
+ *
+ * @param[in]  lu    factorization of A
+ * @param[in]  B     right hand sides, one per column
+ * @param[out] X     solution, same size as B, allocated as needed, may be B
+ *
+ * @return     Returns 0 on success or -1 on failure or if A is singular.
+ */
+int rc_lu_solve_matrix(rc_lu_t lu, rc_matrix_t B, rc_matrix_t* X);
+
+/**
+ * @brief      Forms the inverse of A from its factorization.
+ *
+ * @param[in]  lu    factorization of A
+ * @param[out] Ainv  inverse, allocated as needed
+ *
+ * @return     Returns 0 on success or -1 on failure or if A is singular.
+ */
+int rc_lu_inverse(rc_lu_t lu, rc_matrix_t* Ainv);
+
+/**
+ * @brief      Cholesky decomposition A = L*L^T of a symmetric positive
+ * definite matrix.
+ *
+ * Only the lower triangle of A is read. This takes about half the work of an
+ * LU decomposition and needs no pivoting, so it is the method of choice for
+ * covariance matrices. L is resized as needed and may be A.
+ *
+ * @param[in]  A     symmetric positive definite matrix
+ * @param[out] L     lower triangular factor, zero above the diagonal
+ *
+ * @return     Returns 0 on success or -1 on failure or if A is not positive
+ * definite.
+ */
+int rc_algebra_cholesky_decomp(rc_matrix_t A, rc_matrix_t* L);
+
+/**
+ * @brief      Same as rc_algebra_cholesky_decomp but overwrites A with L.
+ *
+ * @param      A     symmetric positive definite matrix, replaced by L. Its
+ * contents are undefined if A turns out not to be positive definite.
+ *
+ * @return     Returns 0 on success or -1 on failure or if A is not positive
+ * definite.
+ */
+int rc_algebra_cholesky_decomp_inplace(rc_matrix_t* A);
+
+/**
+ * @brief      Updates the Cholesky factor L of A to that of A + x*x^T.
+ *
+ * Takes O(n^2) operations instead of the O(n^3) of factoring again.
+ *
+ * @param      L     Cholesky factor, updated in place
+ * @param[in]  x     update vector, left untouched
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_cholesky_update(rc_matrix_t* L, rc_vector_t x);
+
+/**
+ * @brief      Downdates the Cholesky factor L of A to that of A - x*x^T.
+ *
+ * Takes O(n^2) operations instead of the O(n^3) of factoring again. L is left
+ * untouched and -1 returned if A - x*x^T would not be positive definite.
+ *
+ * @param      L     Cholesky factor, downdated in place
+ * @param[in]  x     downdate vector, left untouched
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_cholesky_downdate(rc_matrix_t* L, rc_vector_t x);
+
+/**
+ * @brief      Solves Ax=b given the Cholesky factor L of A.
+ *
+ * @param[in]  L     Cholesky factor of A from rc_algebra_cholesky_decomp
+ * @param[in]  b     right hand side
+ * @param[out] x     solution, allocated as needed, may be b
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_cholesky_solve(rc_matrix_t L, rc_vector_t b, rc_vector_t* x);
+
+/**
+ * @brief      Solves AX=B for every column of B at once given the Cholesky
+ * factor L of A.
+ *
+ * @param[in]  L     Cholesky factor of A from rc_algebra_cholesky_decomp
+ * @param[in]  B     right hand sides, one per column
+ * @param[out] X     solution, same size as B, allocated as needed, may be B
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_cholesky_solve_matrix(rc_matrix_t L, rc_matrix_t B, rc_matrix_t* X);
+
+/**
+ * @brief      Forms the inverse of A given its Cholesky factor L.
+ *
+ * Prefer rc_algebra_cholesky_solve_matrix when the inverse is only going to
+ * be multiplied by something, it is cheaper and more accurate.
+ *
+ * @param[in]  L     Cholesky factor of A from rc_algebra_cholesky_decomp
+ * @param[out] Ainv  symmetric inverse of A, allocated as needed
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_cholesky_inverse(rc_matrix_t L, rc_matrix_t* Ainv);
+
+/**
+ * @brief      Solves L*X = B for X with L lower triangular, for every column of
+ * B at once.
+ *
+ * Only the lower triangle and diagonal of L are read. Rows are solved in
+ * blocks so most of the work is one matrix multiply per block rather than a
+ * separate forward substitution for each column of B. X is resized as needed
+ * and may be B to solve in place.
+ *
+ * @param[in]  L     square lower triangular matrix
+ * @param[in]  B     right hand sides, one per column, with L.rows rows
+ * @param[out] X     solution, same size as B
+ *
+ * @return     Returns 0 on success or -1 on failure or if the diagonal of L
+ * has an entry smaller than the zero tolerance.
+ */
+int rc_algebra_solve_lower_triangular(rc_matrix_t L, rc_matrix_t B, rc_matrix_t* X);
+
+/**
+ * @brief      Solves U*X = B for X with U upper triangular, for every column of
+ * B at once.
+ *
+ * Same as rc_algebra_solve_lower_triangular but back substitutes from the
+ * last row up. Only the upper triangle and diagonal of U are read.
+ *
+ * @param[in]  U     square upper triangular matrix
+ * @param[in]  B     right hand sides, one per column, with U.rows rows
+ * @param[out] X     solution, same size as B, may be B
+ *
+ * @return     Returns 0 on success or -1 on failure or if the diagonal of U
+ * has an entry smaller than the zero tolerance.
+ */
+int rc_algebra_solve_upper_triangular(rc_matrix_t U, rc_matrix_t B, rc_matrix_t* X);
+
 /**
  * @brief      Solves Ax=b for given matrix A and vector b.
  *
@@ -86,20 +457,88 @@ int rc_algebra_invert_matrix_inplace(rc_matrix_t* A);
  */
 int rc_algebra_lin_system_solve(rc_matrix_t A, rc_vector_t b, rc_vector_t* x);
 
+/**
+ * @brief      Same as rc_algebra_lin_system_solve but takes its temporaries
+ * from a workspace. x is only reallocated if it is the wrong size.
+ *
+ * @param[in]  A     matrix A
+ * @param[in]  b     column vector b
+ * @param[out] x     solution column vector
+ * @param      ws    workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_lin_system_solve_ws(rc_matrix_t A, rc_vector_t b, rc_vector_t* x, rc_workspace_t* ws);
+
+/**
+ * @brief      What rc_algebra_lin_system_solve_mixed did.
+ */
+typedef struct rc_mixed_info_t{
+    int iterations;     ///< refinement steps taken after the first float solve
+    int fallback;       ///< 1 if refinement stalled and a double LU was used
+    double residual;    ///< backward error |b-A*x| / (|A|*|x|) in the infinity norm
+} rc_mixed_info_t;
+
+/**
+ * @brief      Solves Ax=b for square A by factoring in single precision and
+ * refining the solution to double precision.
+ *
+ * The LU factorization, which is nearly all of the work, is done in float,
+ * which moves half as much memory and fits twice as many elements in each
+ * SIMD register as double. The solution from it is then improved by iterative
+ * refinement: the residual r = b - A*x is computed in double, the correction
+ * is solved with the float factors, and x is updated in double. Each step
+ * gains roughly the digits float has left over the condition number of A, so
+ * a well-conditioned system reaches full double accuracy in two or three
+ * steps. Refinement stops once the backward error is at the level of double
+ * rounding. If instead the residual stops shrinking, which happens when A is
+ * too badly conditioned for float, or A does not fit in float at all, the
+ * system is solved again with a double LU so the answer is always as good as
+ * rc_algebra_lin_system_solve.
+ *
+ * @param[in]  A     square matrix A
+ * @param[in]  b     column vector b
+ * @param[out] x     solution column vector
+ * @param[out] info  refinement steps taken and whether the fallback ran, may
+ * be NULL
+ *
+ * @return     Returns 0 on success or -1 on failure, including when A is
+ * singular in double precision too.
+ */
+int rc_algebra_lin_system_solve_mixed(rc_matrix_t A, rc_vector_t b, rc_vector_t* x, rc_mixed_info_t* info);
+
+/**
+ * @brief      Same as rc_algebra_lin_system_solve_mixed but takes its
+ * temporaries from a workspace. x is only reallocated if it is the wrong size.
+ *
+ * @param[in]  A     square matrix A
+ * @param[in]  b     column vector b
+ * @param[out] x     solution column vector
+ * @param[out] info  refinement steps taken and whether the fallback ran, may
+ * be NULL
+ * @param      ws    workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_lin_system_solve_mixed_ws(rc_matrix_t A, rc_vector_t b, rc_vector_t* x,
+                                rc_mixed_info_t* info, rc_workspace_t* ws);
+
 /**
  * @brief      Sets the zero tolerance for detecting singular matrices.
  *
- * When inverting matrices or solving a linear system, this library first checks
- * that the determinant of the matrix is non-zero. Due to the rounding errors
- * that come from float-point math, we cannot check if the determinant is
- * exactly zero. Instead, it is checked to be smaller in magnitude than the
- * zero-tolerance.
+ * When inverting matrices or solving a linear system, this library checks
+ * that the matrix is not singular. Due to the rounding errors that come from
+ * float-point math, we cannot check if a pivot is exactly zero. Instead, the
+ * pivots of an LU factorization are checked to be larger in magnitude than the
+ * zero-tolerance times the largest element of the matrix, so the test does not
+ * depend on how the matrix is scaled.
  *
  * The default value is 10^-8 but it can be changed here if the user is dealing
  * with unusually small or large floating point values.
  *
  * This only effects the operation of rc_algebra_invert_matrix,
- * rc_algebra_invert_matrix_inplace, and rc_algebra_lin_system_solve.
+ * rc_algebra_invert_matrix_inplace, rc_algebra_lin_system_solve, and
+ * rc_lu_factor.
  *
  * @param[in]  tol   The zero-tolerance
  */
@@ -109,7 +548,10 @@ void rc_algebra_set_zero_tolerance(double tol);
  * @brief      Finds a least-squares solution to the system Ax=b for non-square
  * A using QR decomposition method.
  *
- * Places the solution in x.
+ * Places the solution in x. A must have at least as many rows as columns. Q
+ * is never formed, its transpose is applied to b directly from the
+ * Householder reflectors, so the cost grows only linearly with the number of
+ * rows of a tall A.
  *
  * @param[in]  A     matrix A
  * @param[in]  b     column vector b
@@ -119,6 +561,75 @@ void rc_algebra_set_zero_tolerance(double tol);
  */
 int rc_algebra_lin_system_solve_qr(rc_matrix_t A, rc_vector_t b, rc_vector_t* x);
 
+/**
+ * @brief      Eigenvalues and eigenvectors of a symmetric matrix.
+ *
+ * A is reduced to tridiagonal form with Householder reflections which is then
+ * diagonalized with implicit QL iterations, O(n^3) overall. Only the upper
+ * triangle of A is read. The eigenvalues are placed in evals in ascending
+ * order and the columns of evecs are the matching orthonormal eigenvectors so
+ * that A*evecs = evecs*diag(evals). Pass NULL for evecs if only the
+ * eigenvalues are needed, which skips most of the work.
+ *
+ * For a covariance matrix the eigenvectors are the principal axes and the
+ * square roots of the eigenvalues the standard deviations along them.
+ *
+ * @param[in]  A      symmetric input matrix
+ * @param[out] evals  eigenvalues, smallest first
+ * @param[out] evecs  eigenvectors as columns, or NULL to skip them
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_eig_sym(rc_matrix_t A, rc_vector_t* evals, rc_matrix_t* evecs);
+
+/**
+ * @brief      Same as rc_algebra_eig_sym but takes its temporaries from a
+ * workspace so nothing is allocated once evals and evecs are the right size.
+ *
+ * @param[in]  A      symmetric input matrix
+ * @param[out] evals  eigenvalues, smallest first
+ * @param[out] evecs  eigenvectors as columns, or NULL to skip them
+ * @param      ws     workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_eig_sym_ws(rc_matrix_t A, rc_vector_t* evals, rc_matrix_t* evecs, rc_workspace_t* ws);
+
+/**
+ * @brief      Thin singular value decomposition A = U*diag(S)*V^T.
+ *
+ * Uses one-sided Jacobi rotations, which find even the small singular values
+ * to high relative accuracy. For an m x n matrix A with k = min(m,n), U is
+ * m x k, S has length k and is sorted largest first, and V is n x k. The
+ * columns of U and V are orthonormal, except that when A is rank deficient
+ * the columns of U (tall A) or V (wide A) belonging to singular values that
+ * are exactly zero are left zero. Either of U and V may be NULL if not needed.
+ *
+ * The 2-norm condition number of A is S[0]/S[k-1].
+ *
+ * @param[in]  A     input matrix
+ * @param[out] U     left singular vectors as columns, or NULL
+ * @param[out] S     singular values, largest first
+ * @param[out] V     right singular vectors as columns, or NULL
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_svd(rc_matrix_t A, rc_matrix_t* U, rc_vector_t* S, rc_matrix_t* V);
+
+/**
+ * @brief      Same as rc_algebra_svd but takes its temporaries from a
+ * workspace so nothing is allocated once U, S, and V are the right size.
+ *
+ * @param[in]  A     input matrix
+ * @param[out] U     left singular vectors as columns, or NULL
+ * @param[out] S     singular values, largest first
+ * @param[out] V     right singular vectors as columns, or NULL
+ * @param      ws    workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_algebra_svd_ws(rc_matrix_t A, rc_matrix_t* U, rc_vector_t* S, rc_matrix_t* V, rc_workspace_t* ws);
+
 /**
  * @brief      Fits an ellipsoid to a set of points in 3D space.
  *
@@ -131,6 +642,8 @@ int rc_algebra_lin_system_solve_qr(rc_matrix_t A, rc_vector_t b, rc_vector_t* x)
  * Each row must contain the x,y&z components of each individual point to be
  * fit. If only 6 rows are provided, the resulting ellipsoid will be an exact
  * fit. Otherwise the result is a least-squares fit to the over-defined dataset.
+ * To fit points as they arrive without storing them, or to fit an ellipsoid
+ * with rotated axes, see rc_ellipsoid_fit_t.
  *
  * The final x,y,z position of the centroid will be placed in vector 'center'
  * and the lengths or radius from the centroid to the surface along each axis
@@ -144,6 +657,110 @@ int rc_algebra_lin_system_solve_qr(rc_matrix_t A, rc_vector_t b, rc_vector_t* x)
  */
 int rc_algebra_fit_ellipsoid(rc_matrix_t points, rc_vector_t* center, rc_vector_t* lengths);
 
+/**
+ * @brief      Ellipsoid fit models for rc_ellipsoid_fit_t.
+ *
+ * RC_ELLIPSOID_ALIGNED fits the same 6 parameter ellipsoid as
+ * rc_algebra_fit_ellipsoid, with its axes along x, y, and z.
+ * RC_ELLIPSOID_ROTATED fits a general 9 parameter ellipsoid whose axes may
+ * point in any direction, as needed for soft-iron magnetometer calibration.
+ */
+#define RC_ELLIPSOID_ALIGNED        0
+#define RC_ELLIPSOID_ROTATED        1
+#define RC_ELLIPSOID_MAX_PARAMS     9
+
+/**
+ * @brief      Streaming least-squares ellipsoid fit.
+ *
+ * Every point gives one row phi(p)*f = 1 of the least-squares system solved by
+ * rc_algebra_fit_ellipsoid, where phi(p) holds the quadratic and linear terms
+ * of the model. Instead of keeping the rows, each one is folded into the
+ * upper triangular R factor of the system as it arrives with a few Givens
+ * rotations, so memory stays fixed however many points are added, adding a
+ * point costs O(1), and the fit can be read out at any time. Working with R
+ * rather than the normal equations keeps the accuracy of the QR solve.
+ *
+ * An rc_ellipsoid_fit_t holds no dynamic memory, it lives on the stack or in
+ * a struct and never needs freeing.
+ *
+ * @code{.c}
+ * rc_ellipsoid_fit_t fit;
+ * rc_ellipsoid_fit_init(&fit, RC_ELLIPSOID_ROTATED);
+ * while(running){
+ *     read_mag(p);
+ *     rc_ellipsoid_fit_add_point(&fit, p);
+ * }
+ * rc_ellipsoid_fit_solve(fit, &center, &lengths, &axes);
+ * @endcode
+ */
+typedef struct rc_ellipsoid_fit_t{
+    int mode;       ///< RC_ELLIPSOID_ALIGNED or RC_ELLIPSOID_ROTATED
+    int n;          ///< number of model parameters, 6 or 9
+    long count;     ///< number of points added so far
+    /// R factor of [phi 1], upper triangle of the leading n+1 x n+1 block
+    double R[RC_ELLIPSOID_MAX_PARAMS+1][RC_ELLIPSOID_MAX_PARAMS+1];
+    int initialized;///< 1 once rc_ellipsoid_fit_init has been called
+} rc_ellipsoid_fit_t;
+
+#define RC_ELLIPSOID_FIT_INITIALIZER {\
+    .mode = RC_ELLIPSOID_ALIGNED,\
+    .n = 0,\
+    .count = 0,\
+    .initialized = 0}
+
+/**
+ * @brief      Starts a new fit with no points, or clears an existing one.
+ *
+ * @param      fit   fit to initialize
+ * @param[in]  mode  RC_ELLIPSOID_ALIGNED or RC_ELLIPSOID_ROTATED
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_ellipsoid_fit_init(rc_ellipsoid_fit_t* fit, int mode);
+
+/**
+ * @brief      Folds one x,y,z point into the fit.
+ *
+ * @param      fit   initialized fit
+ * @param[in]  p     point
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_ellipsoid_fit_add_point(rc_ellipsoid_fit_t* fit, const double p[3]);
+
+/**
+ * @brief      Folds every row of a p x 3 matrix of points into the fit.
+ *
+ * @param      fit   initialized fit
+ * @param[in]  pts   points, one per row
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_ellipsoid_fit_add_points(rc_ellipsoid_fit_t* fit, rc_matrix_t pts);
+
+/**
+ * @brief      Solves for the ellipsoid best fitting the points so far.
+ *
+ * The fit is not changed so more points can be added afterwards. At least as
+ * many points as model parameters are needed, and they must not all lie on a
+ * simpler surface such as a plane. Fails if the best fitting quadric is not
+ * an ellipsoid.
+ *
+ * lengths are the semi-axis lengths and the matching columns of axes are the
+ * unit vectors along them. In RC_ELLIPSOID_ALIGNED mode the lengths are along
+ * x, y, and z and axes is the identity, the same result as
+ * rc_algebra_fit_ellipsoid. In RC_ELLIPSOID_ROTATED mode they are sorted
+ * longest first.
+ *
+ * @param[in]  fit      fit with enough points
+ * @param[out] center   center of the ellipsoid
+ * @param[out] lengths  semi-axis lengths
+ * @param[out] axes     directions of the axes as columns, or NULL
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_ellipsoid_fit_solve(rc_ellipsoid_fit_t fit, rc_vector_t* center, rc_vector_t* lengths, rc_matrix_t* axes);
+
 
 #ifdef  __cplusplus
 }
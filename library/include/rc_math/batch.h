@@ -0,0 +1,215 @@
+/**
+ * @headerfile batch.h <rc_math/batch.h>
+ *
+ * @brief      Batches of many small matrices of one size stored
+ *             structure-of-arrays so one call works on all of them at once.
+ *
+ * An rc_matrix_batch_t holds n matrices of size rows x cols. Rather than
+ * storing each matrix contiguously, element (i,j) of every matrix in the batch
+ * is stored next to each other in its own plane of n doubles. An operation
+ * such as a multiply then becomes a handful of loops over whole planes which
+ * the compiler turns into SIMD instructions working on several matrices per
+ * instruction, with none of the per-call checking and allocation overhead of
+ * running rc_matrix_multiply thousands of times.
+ *
+ * The inner loops are built for the baseline target and for AVX2 and AVX-512
+ * where gcc supports function multiversioning. The best one for the running
+ * CPU is picked at load time. Elsewhere only the baseline version is built.
+ *
+ * A column vector is a batch with cols==1, so a batch of vectors uses the same
+ * type and the same functions.
+ *
+ * Semantics otherwise match rc_matrix_t: outputs are allocated or resized as
+ * needed and functions return 0 on success or -1 on failure after printing an
+ * error message.
+ *
+ * @code{.c}
+ * // rotate N feature points by their own rotation matrices
+ * rc_matrix_batch_t R = RC_MATRIX_BATCH_INITIALIZER;
+ * rc_matrix_batch_t p = RC_MATRIX_BATCH_INITIALIZER;
+ * rc_matrix_batch_t out = RC_MATRIX_BATCH_INITIALIZER;
+ * rc_matrix_batch_alloc(&R, N, 3, 3);
+ * rc_matrix_batch_alloc(&p, N, 3, 1);
+ * for(k=0;k<N;k++) RC_MATRIX_BATCH_AT(R,k,0,0) = ...;
+ * rc_matrix_batch_times_col_vec(R, p, &out);
+ * @endcode
+ *
+ * @addtogroup Batch
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_BATCH_H
+#define RC_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+
+/**
+ * @brief      n matrices of the same size in structure-of-arrays layout.
+ */
+typedef struct rc_matrix_batch_t{
+    int n;          ///< number of matrices in the batch
+    int rows;       ///< number of rows in each matrix
+    int cols;       ///< number of columns in each matrix
+    double* d;      ///< rows*cols planes of n doubles each
+    int initialized;///< set to 1 once memory has been allocated
+} rc_matrix_batch_t;
+
+#define RC_MATRIX_BATCH_INITIALIZER {\
+    .n = 0,\
+    .rows = 0,\
+    .cols = 0,\
+    .d = NULL,\
+    .initialized = 0}
+
+/**
+ * @brief      Largest system rc_matrix_batch_lin_system_solve takes.
+ */
+#define RC_MATRIX_BATCH_SOLVE_MAX_DIM   32
+
+/**
+ * @brief      Element (i,j) of matrix k in batch B as an lvalue.
+ */
+#define RC_MATRIX_BATCH_AT(B,k,i,j) \
+    ((B).d[((((i)*(B).cols)+(j))*(B).n)+(k)])
+
+/**
+ * @brief      Returns an rc_matrix_batch_t with no allocated memory and the
+ * initialized flag set to 0.
+ *
+ * @return     empty batch
+ */
+rc_matrix_batch_t rc_matrix_batch_empty(void);
+
+/**
+ * @brief      Allocates memory for n matrices of size rows x cols.
+ *
+ * Like rc_matrix_alloc this does nothing if B is already the right size and
+ * otherwise frees any old memory first. The contents are not initialized.
+ *
+ * @param      B     pointer to the batch to allocate
+ * @param[in]  n     number of matrices
+ * @param[in]  rows  rows in each matrix
+ * @param[in]  cols  columns in each matrix
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_alloc(rc_matrix_batch_t* B, int n, int rows, int cols);
+
+/**
+ * @brief      Same as rc_matrix_batch_alloc but fills every matrix with zeros.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_zeros(rc_matrix_batch_t* B, int n, int rows, int cols);
+
+/**
+ * @brief      Frees the memory of a batch and returns it to an empty state.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_free(rc_matrix_batch_t* B);
+
+/**
+ * @brief      Copies matrix A into slot k of batch B.
+ *
+ * B must already be allocated with the same size as A.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_set(rc_matrix_batch_t* B, int k, rc_matrix_t A);
+
+/**
+ * @brief      Copies slot k of batch B out into matrix A, allocating A as
+ * needed.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_get(rc_matrix_batch_t B, int k, rc_matrix_t* A);
+
+/**
+ * @brief      Multiplies every pair C[k] = A[k]*B[k].
+ *
+ * A and B must hold the same number of matrices with A.cols == B.rows. C is
+ * allocated as needed and must not be A or B.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_multiply(rc_matrix_batch_t A, rc_matrix_batch_t B, rc_matrix_batch_t* C);
+
+/**
+ * @brief      Multiplies every matrix by its own column vector, c[k] =
+ * A[k]*v[k].
+ *
+ * v must be a batch of A.cols x 1 vectors. c is allocated as a batch of
+ * A.rows x 1 vectors and must not be A or v.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_times_col_vec(rc_matrix_batch_t A, rc_matrix_batch_t v, rc_matrix_batch_t* c);
+
+/**
+ * @brief      Determinant of every matrix in a batch of square matrices up to
+ * 4x4.
+ *
+ * @param[in]  A     batch of 1x1 to 4x4 square matrices
+ * @param[out] det   vector of A.n determinants, allocated as needed
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_batch_determinant(rc_matrix_batch_t A, rc_vector_t* det);
+
+/**
+ * @brief      Inverts every matrix in a batch of square matrices up to 4x4.
+ *
+ * Uses the closed form adjugate/determinant so every matrix takes the same
+ * path. Matrices whose determinant is within the zero tolerance of 0 are
+ * written as all zeros, the rest of the batch is still inverted and -1 is
+ * returned so the caller knows to look.
+ *
+ * @param[in]  A     batch of 1x1 to 4x4 square matrices
+ * @param[out] Ainv  inverses, allocated as needed, must not be A
+ *
+ * @return     0 on success, -1 on failure or if any matrix was singular.
+ */
+int rc_matrix_batch_invert(rc_matrix_batch_t A, rc_matrix_batch_t* Ainv);
+
+/**
+ * @brief      Solves every system A[k]*x[k] = b[k] for x[k].
+ *
+ * Gaussian elimination with partial pivoting, the same method as
+ * rc_algebra_lin_system_solve, run on all of the systems together. Every lane
+ * takes the same steps and row swaps are done as selects, so the inner loops
+ * vectorize across the batch even though each system picks its own pivots.
+ * The only memory used is a fixed block on the stack so nothing is allocated
+ * once x has the right size. With rc_thread_pool_init() large batches are
+ * split across the pool.
+ *
+ * Systems with a pivot within the zero tolerance of 0 get x[k] set to all
+ * zeros, the rest are still solved and -1 is returned so the caller knows to
+ * look.
+ *
+ * @param[in]  A     batch of square matrices, at most
+ * RC_MATRIX_BATCH_SOLVE_MAX_DIM rows each
+ * @param[in]  b     batch of A.rows x 1 right hand sides
+ * @param[out] x     batch of A.rows x 1 solutions, allocated as needed, may
+ * be b to solve in place
+ *
+ * @return     0 on success, -1 on failure or if any system was singular.
+ */
+int rc_matrix_batch_lin_system_solve(rc_matrix_batch_t A, rc_matrix_batch_t b, rc_matrix_batch_t* x);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_BATCH_H
+
+/** @} end group Batch */
@@ -0,0 +1,166 @@
+/**
+ * @headerfile expression.h <rc_math/expression.h>
+ *
+ * @brief      Deferred linear combinations of vectors, matrices, and
+ *             matrix-vector products, evaluated in one fused pass.
+ *
+ * Chaining the regular functions, for example rc_matrix_times_col_vec twice
+ * followed by rc_vector_sum, allocates a temporary for every intermediate
+ * result and makes a separate pass over memory for each step. An rc_expr_t
+ * instead records the terms of
+ *
+ *     out = s1*term1 + s2*term2 + ...
+ *
+ * where each term is a vector, a matrix, or op(A)*v, and rc_expr_eval_vector
+ * or rc_expr_eval_matrix then computes the whole sum straight into the
+ * destination. The output is produced in cache-sized blocks so every input is
+ * read once and the output written once, with no intermediate storage.
+ *
+ * Add and subtract are recorded with a coefficient of 1 or -1, and
+ * rc_expr_scale scales everything recorded so far. Recording only copies the
+ * small rc_vector_t and rc_matrix_t structs, not their data, so the inputs
+ * must stay allocated and unchanged until the expression is evaluated. An
+ * rc_expr_t holds no dynamic memory, it lives on the stack and never needs
+ * freeing.
+ *
+ * @code{.c}
+ * // x_pre = F*x + G*u without temporaries
+ * rc_expr_t e = RC_EXPR_INITIALIZER;
+ * rc_expr_add_times_col_vec(&e, 1.0, F, 0, x);
+ * rc_expr_add_times_col_vec(&e, 1.0, G, 0, u);
+ * rc_expr_eval_vector(e, &x_pre);
+ * @endcode
+ *
+ * @addtogroup Expression
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_EXPRESSION_H
+#define RC_EXPRESSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+
+/**
+ * Maximum number of terms one expression can hold.
+ */
+#define RC_EXPR_MAX_TERMS   8
+
+/**
+ * @brief      One recorded term, s*v, s*A, or s*op(A)*v.
+ */
+typedef struct rc_expr_term_t{
+    int type;       ///< which kind of term, internal
+    double s;       ///< coefficient
+    rc_matrix_t A;  ///< matrix for matrix and matrix-vector terms
+    int trans;      ///< 1 if the matrix-vector term uses A^T
+    rc_vector_t v;  ///< vector for vector and matrix-vector terms
+} rc_expr_term_t;
+
+/**
+ * @brief      A recorded expression. Results are vectors when the terms are
+ * vectors or matrix-vector products and matrices when the terms are matrices.
+ */
+typedef struct rc_expr_t{
+    int n;          ///< number of terms recorded
+    int rows;       ///< rows of the result, or length for a vector result
+    int cols;       ///< columns of the result, 0 for a vector result
+    rc_expr_term_t t[RC_EXPR_MAX_TERMS]; ///< the terms
+} rc_expr_t;
+
+#define RC_EXPR_INITIALIZER {\
+    .n = 0,\
+    .rows = 0,\
+    .cols = 0}
+
+/**
+ * @brief      Removes all terms so the expression can be reused.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_expr_clear(rc_expr_t* e);
+
+/**
+ * @brief      Records e += s*v.
+ *
+ * @param      e     expression
+ * @param[in]  s     coefficient, -1 to subtract
+ * @param[in]  v     vector with the same length as the other terms
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_expr_add_vector(rc_expr_t* e, double s, rc_vector_t v);
+
+/**
+ * @brief      Records e += s*op(A)*v.
+ *
+ * @param      e     expression
+ * @param[in]  s     coefficient, -1 to subtract
+ * @param[in]  A     matrix
+ * @param[in]  ta    nonzero to use A^T
+ * @param[in]  v     vector, must not be the output of the evaluation
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_expr_add_times_col_vec(rc_expr_t* e, double s, rc_matrix_t A, int ta, rc_vector_t v);
+
+/**
+ * @brief      Records e += s*A.
+ *
+ * @param      e     expression
+ * @param[in]  s     coefficient, -1 to subtract
+ * @param[in]  A     matrix with the same size as the other terms
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_expr_add_matrix(rc_expr_t* e, double s, rc_matrix_t A);
+
+/**
+ * @brief      Scales everything recorded so far, e = s*e.
+ *
+ * This only changes the stored coefficients, nothing is computed.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_expr_scale(rc_expr_t* e, double s);
+
+/**
+ * @brief      Evaluates a vector expression into out in one fused pass.
+ *
+ * out may be one of the plain vector terms, for example to compute x += A*v
+ * in place, but not the vector of a matrix-vector term since that is read in
+ * full for every element of the output.
+ *
+ * @param[in]  e     expression made of vector and matrix-vector terms
+ * @param[out] out   result, allocated as needed
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_expr_eval_vector(rc_expr_t e, rc_vector_t* out);
+
+/**
+ * @brief      Evaluates a matrix expression into out in one fused pass.
+ *
+ * out may be any of the terms.
+ *
+ * @param[in]  e     expression made of matrix terms
+ * @param[out] out   result, allocated as needed
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_expr_eval_matrix(rc_expr_t e, rc_matrix_t* out);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_EXPRESSION_H
+
+/** @} end group Expression */
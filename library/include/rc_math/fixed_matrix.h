@@ -0,0 +1,231 @@
+/**
+ * @headerfile fixed_matrix.h <rc_math/fixed_matrix.h>
+ *
+ * @brief      Fixed-size 3x3, 4x4, and 6x6 matrices and matching vectors.
+ *
+ * rc_matrix_t and rc_vector_t are sized at runtime and live on the heap which
+ * is wasteful for the small rotations and filters that run every loop of an
+ * attitude controller. The types here hold their data inline so they can be
+ * declared on the stack, copied with '=', and passed around by value without
+ * ever calling malloc. The operations are written out for their exact size so
+ * the compiler can keep everything in registers.
+ *
+ * Use the *_from_matrix and *_to_matrix functions to move between these and
+ * the general rc_matrix_t and rc_vector_t types when a larger algorithm needs
+ * them.
+ *
+ * @code{.c}
+ * rc_mat3_t R = rc_mat3_identity();
+ * rc_vec3_t v = {{1.0, 2.0, 3.0}};
+ * v = rc_mat3_times_vec(R, v);
+ * @endcode
+ *
+ * @addtogroup Fixed_Matrix
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_FIXED_MATRIX_H
+#define RC_FIXED_MATRIX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+
+/** @brief 3 element vector stored inline */
+typedef struct rc_vec3_t{
+    double d[3];    ///< vector contents
+} rc_vec3_t;
+
+/** @brief 4 element vector stored inline */
+typedef struct rc_vec4_t{
+    double d[4];    ///< vector contents
+} rc_vec4_t;
+
+/** @brief 6 element vector stored inline */
+typedef struct rc_vec6_t{
+    double d[6];    ///< vector contents
+} rc_vec6_t;
+
+/** @brief 3x3 matrix stored inline, access as A.d[row][col] */
+typedef struct rc_mat3_t{
+    double d[3][3]; ///< matrix contents, row-major
+} rc_mat3_t;
+
+/** @brief 4x4 matrix stored inline, access as A.d[row][col] */
+typedef struct rc_mat4_t{
+    double d[4][4]; ///< matrix contents, row-major
+} rc_mat4_t;
+
+/** @brief 6x6 matrix stored inline, access as A.d[row][col] */
+typedef struct rc_mat6_t{
+    double d[6][6]; ///< matrix contents, row-major
+} rc_mat6_t;
+
+
+/**
+ * @name       3 element vectors
+ */
+///@{
+
+/**
+ * @brief      Returns the dot product of vectors a and b.
+ */
+double rc_vec3_dot(rc_vec3_t a, rc_vec3_t b);
+
+/**
+ * @brief      Returns the cross product a x b.
+ */
+rc_vec3_t rc_vec3_cross(rc_vec3_t a, rc_vec3_t b);
+
+/**
+ * @brief      Returns the Euclidean length of vector v.
+ */
+double rc_vec3_norm(rc_vec3_t v);
+
+/**
+ * @brief      Copies the contents of an rc_vector_t of length 3 into out.
+ *
+ * @param[in]  v     input vector, must have length 3
+ * @param[out] out   fixed size copy
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_vec3_from_vector(rc_vector_t v, rc_vec3_t* out);
+
+/**
+ * @brief      Copies v into an rc_vector_t, allocating it if necessary.
+ *
+ * @param[in]  v     input vector
+ * @param[out] out   general vector, resized to length 3 if necessary
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_vec3_to_vector(rc_vec3_t v, rc_vector_t* out);
+
+/** @brief same as rc_vec3_from_vector for length 4 */
+int rc_vec4_from_vector(rc_vector_t v, rc_vec4_t* out);
+/** @brief same as rc_vec3_to_vector for length 4 */
+int rc_vec4_to_vector(rc_vec4_t v, rc_vector_t* out);
+/** @brief same as rc_vec3_from_vector for length 6 */
+int rc_vec6_from_vector(rc_vector_t v, rc_vec6_t* out);
+/** @brief same as rc_vec3_to_vector for length 6 */
+int rc_vec6_to_vector(rc_vec6_t v, rc_vector_t* out);
+
+///@}
+
+
+/**
+ * @name       3x3 matrices
+ */
+///@{
+
+/**
+ * @brief      Returns a 3x3 identity matrix.
+ */
+rc_mat3_t rc_mat3_identity(void);
+
+/**
+ * @brief      Returns the matrix product A*B.
+ */
+rc_mat3_t rc_mat3_multiply(rc_mat3_t A, rc_mat3_t B);
+
+/**
+ * @brief      Returns the transpose of A.
+ */
+rc_mat3_t rc_mat3_transpose(rc_mat3_t A);
+
+/**
+ * @brief      Returns the determinant of A.
+ */
+double rc_mat3_determinant(rc_mat3_t A);
+
+/**
+ * @brief      Inverts A with the closed form adjugate method.
+ *
+ * Like rc_algebra_invert_matrix this fails if the magnitude of the determinant
+ * is below the zero tolerance set with rc_algebra_set_zero_tolerance.
+ *
+ * @param[in]  A     matrix to invert
+ * @param[out] Ainv  inverse of A, untouched on failure
+ *
+ * @return     0 on success, -1 if A is singular.
+ */
+int rc_mat3_invert(rc_mat3_t A, rc_mat3_t* Ainv);
+
+/**
+ * @brief      Returns the matrix-vector product A*v.
+ */
+rc_vec3_t rc_mat3_times_vec(rc_mat3_t A, rc_vec3_t v);
+
+/**
+ * @brief      Copies the contents of a 3x3 rc_matrix_t into out.
+ *
+ * @param[in]  A     input matrix, must be 3x3
+ * @param[out] out   fixed size copy
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_mat3_from_matrix(rc_matrix_t A, rc_mat3_t* out);
+
+/**
+ * @brief      Copies A into an rc_matrix_t, allocating it if necessary.
+ *
+ * @param[in]  A     input matrix
+ * @param[out] out   general matrix, resized to 3x3 if necessary
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_mat3_to_matrix(rc_mat3_t A, rc_matrix_t* out);
+
+///@}
+
+
+/**
+ * @name       4x4 matrices
+ *
+ * Same as the 3x3 versions. The inverse uses the closed form cofactor
+ * expansion.
+ */
+///@{
+rc_mat4_t rc_mat4_identity(void);
+rc_mat4_t rc_mat4_multiply(rc_mat4_t A, rc_mat4_t B);
+rc_mat4_t rc_mat4_transpose(rc_mat4_t A);
+double rc_mat4_determinant(rc_mat4_t A);
+int rc_mat4_invert(rc_mat4_t A, rc_mat4_t* Ainv);
+rc_vec4_t rc_mat4_times_vec(rc_mat4_t A, rc_vec4_t v);
+int rc_mat4_from_matrix(rc_matrix_t A, rc_mat4_t* out);
+int rc_mat4_to_matrix(rc_mat4_t A, rc_matrix_t* out);
+///@}
+
+
+/**
+ * @name       6x6 matrices
+ *
+ * Same as the 3x3 versions. Closed forms get unwieldy at this size so the
+ * determinant and inverse use Gaussian elimination with partial pivoting on a
+ * copy held on the stack.
+ */
+///@{
+rc_mat6_t rc_mat6_identity(void);
+rc_mat6_t rc_mat6_multiply(rc_mat6_t A, rc_mat6_t B);
+rc_mat6_t rc_mat6_transpose(rc_mat6_t A);
+double rc_mat6_determinant(rc_mat6_t A);
+int rc_mat6_invert(rc_mat6_t A, rc_mat6_t* Ainv);
+rc_vec6_t rc_mat6_times_vec(rc_mat6_t A, rc_vec6_t v);
+int rc_mat6_from_matrix(rc_matrix_t A, rc_mat6_t* out);
+int rc_mat6_to_matrix(rc_mat6_t A, rc_matrix_t* out);
+///@}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_FIXED_MATRIX_H
+
+/** @} end group Fixed_Matrix */
@@ -0,0 +1,244 @@
+/**
+ * @headerfile iterative.h <rc_math/iterative.h>
+ *
+ * @brief      Preconditioned iterative solvers for large linear systems.
+ *
+ * rc_algebra_lin_system_solve factors A, which costs O(n^3) time and O(n^2)
+ * memory. The Krylov solvers here only ever multiply A by a vector, so each
+ * iteration costs one mat-vec plus a few vectorized dot products and axpys,
+ * A can be sparse, and A never has to be formed at all when a function that
+ * applies it is available.
+ *
+ * - rc_iterative_cg: conjugate gradient, for symmetric positive definite A.
+ * - rc_iterative_minres: MINRES, for symmetric A that may be indefinite.
+ * - rc_iterative_gmres: restarted GMRES, for any nonsingular A.
+ *
+ * A is described by an rc_linop_t, either made from an rc_matrix_t or
+ * rc_sparse_t with rc_linop_matrix or rc_linop_sparse or filled in with a
+ * user callback. A preconditioner M, an approximation of inv(A) that is cheap
+ * to apply, usually cuts the number of iterations a lot. Jacobi divides by
+ * the diagonal of A, incomplete Cholesky is a Cholesky factorization of a
+ * sparse SPD matrix that drops all fill-in. CG and MINRES need M to be
+ * symmetric positive definite, which both of these are.
+ *
+ * The solvers start from zero, or from the contents of x when warm_start is
+ * set in the options, and stop once |b - A*x| <= tol*|b|. They return 0 when
+ * converged, 1 if max_iter was reached first with x holding the last iterate,
+ * and -1 on error.
+ *
+ * @code{.c}
+ * rc_precond_t M = RC_PRECOND_INITIALIZER;
+ * rc_iterative_opts_t opts = RC_ITERATIVE_OPTS_DEFAULT;
+ * rc_iterative_info_t info;
+ * rc_precond_ic0(S, &M);
+ * rc_iterative_cg(rc_linop_sparse(&S), b, &x, &M, opts, &info);
+ * printf("%d iterations, residual %g\n", info.iterations, info.residual);
+ * @endcode
+ *
+ * @addtogroup Iterative
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_ITERATIVE_H
+#define RC_ITERATIVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+#include <rc_math/sparse.h>
+
+/**
+ * @brief      Computes y = A*x for a linear operator.
+ *
+ * x and y have the length n of the operator and y is already allocated, the
+ * function must write into y->d and not reallocate it.
+ *
+ * @return     0 on success, -1 on failure, which aborts the solver.
+ */
+typedef int (*rc_linop_fn_t)(rc_vector_t x, rc_vector_t* y, void* ctx);
+
+/**
+ * @brief      A square linear operator, y = A*x.
+ */
+typedef struct rc_linop_t{
+    int n;              ///< size of the operator
+    rc_linop_fn_t fn;   ///< applies the operator
+    void* ctx;          ///< passed to fn
+} rc_linop_t;
+
+/**
+ * @brief      Operator that multiplies by a square matrix.
+ *
+ * Only the pointer is kept, A must stay allocated while the operator is used.
+ *
+ * @param[in]  A     square matrix
+ *
+ * @return     the operator, with n set to 0 if A is not square
+ */
+rc_linop_t rc_linop_matrix(rc_matrix_t* A);
+
+/**
+ * @brief      Operator that multiplies by a square sparse matrix.
+ *
+ * Only the pointer is kept, S must stay allocated while the operator is used.
+ *
+ * @param[in]  S     square sparse matrix in either format
+ *
+ * @return     the operator, with n set to 0 if S is not square
+ */
+rc_linop_t rc_linop_sparse(rc_sparse_t* S);
+
+#define RC_PRECOND_NONE     0   ///< M = I
+#define RC_PRECOND_JACOBI   1   ///< M = inv(diag(A))
+#define RC_PRECOND_IC0      2   ///< M = inv(L*L^T) with no fill-in
+
+/**
+ * @brief      A preconditioner built by one of the rc_precond_ functions.
+ */
+typedef struct rc_precond_t{
+    int type;           ///< one of RC_PRECOND_*
+    int n;              ///< size
+    rc_vector_t dinv;   ///< inverse of the diagonal for Jacobi
+    rc_sparse_t L;      ///< lower triangular factor for IC0, CSR
+    int initialized;    ///< set to 1 once built
+} rc_precond_t;
+
+#define RC_PRECOND_INITIALIZER {\
+    .type = RC_PRECOND_NONE,\
+    .n = 0,\
+    .dinv = RC_VECTOR_INITIALIZER,\
+    .L = RC_SPARSE_INITIALIZER,\
+    .initialized = 0}
+
+/**
+ * @brief      Jacobi preconditioner from the diagonal of a dense matrix.
+ *
+ * @param[in]  A     square matrix with no zeros on its diagonal
+ * @param[out] M     preconditioner, previous contents are freed
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_precond_jacobi(rc_matrix_t A, rc_precond_t* M);
+
+/**
+ * @brief      Jacobi preconditioner from the diagonal of a sparse matrix.
+ *
+ * @param[in]  S     square sparse matrix with no zeros on its diagonal
+ * @param[out] M     preconditioner, previous contents are freed
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_precond_jacobi_sparse(rc_sparse_t S, rc_precond_t* M);
+
+/**
+ * @brief      Zero fill-in incomplete Cholesky preconditioner of a sparse
+ * symmetric positive definite matrix.
+ *
+ * L has nonzeros only where the lower triangle of S does. S must hold both
+ * triangles and only the lower one is read. Incomplete factorizations can
+ * break down even for SPD matrices, in which case the diagonal is increased
+ * by a small multiple of itself and the factorization tried again.
+ *
+ * @param[in]  S     symmetric positive definite sparse matrix
+ * @param[out] M     preconditioner, previous contents are freed
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_precond_ic0(rc_sparse_t S, rc_precond_t* M);
+
+/**
+ * @brief      Frees a preconditioner and zeros out the struct.
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_precond_free(rc_precond_t* M);
+
+/**
+ * @brief      Options shared by the iterative solvers.
+ */
+typedef struct rc_iterative_opts_t{
+    double tol;         ///< stop once |b - A*x| <= tol*|b|
+    int max_iter;       ///< most mat-vecs with A to spend
+    int restart;        ///< GMRES restart length
+    int warm_start;     ///< 1 to start from the contents of x instead of zero
+} rc_iterative_opts_t;
+
+#define RC_ITERATIVE_OPTS_DEFAULT {\
+    .tol = 1e-10,\
+    .max_iter = 1000,\
+    .restart = 30,\
+    .warm_start = 0}
+
+/**
+ * @brief      What an iterative solve did.
+ */
+typedef struct rc_iterative_info_t{
+    int iterations;     ///< iterations taken, one mat-vec with A each
+    double residual;    ///< final |b - A*x|/|b|
+    int converged;      ///< 1 if the tolerance was met
+} rc_iterative_info_t;
+
+/**
+ * @brief      Solves A*x = b for symmetric positive definite A with
+ * preconditioned conjugate gradients.
+ *
+ * @param[in]  A     operator
+ * @param[in]  b     right hand side
+ * @param      x     solution, also the starting guess with warm_start
+ * @param[in]  M     preconditioner or NULL for none
+ * @param[in]  opts  options, see RC_ITERATIVE_OPTS_DEFAULT
+ * @param[out] info  iteration count and residual, or NULL
+ *
+ * @return     0 if converged, 1 if not within max_iter, -1 on error
+ */
+int rc_iterative_cg(rc_linop_t A, rc_vector_t b, rc_vector_t* x, rc_precond_t* M,
+                                rc_iterative_opts_t opts, rc_iterative_info_t* info);
+
+/**
+ * @brief      Solves A*x = b for symmetric, possibly indefinite, A with
+ * preconditioned MINRES.
+ *
+ * @param[in]  A     operator
+ * @param[in]  b     right hand side
+ * @param      x     solution, also the starting guess with warm_start
+ * @param[in]  M     symmetric positive definite preconditioner or NULL
+ * @param[in]  opts  options, see RC_ITERATIVE_OPTS_DEFAULT
+ * @param[out] info  iteration count and residual, or NULL
+ *
+ * @return     0 if converged, 1 if not within max_iter, -1 on error
+ */
+int rc_iterative_minres(rc_linop_t A, rc_vector_t b, rc_vector_t* x, rc_precond_t* M,
+                                rc_iterative_opts_t opts, rc_iterative_info_t* info);
+
+/**
+ * @brief      Solves A*x = b for general nonsingular A with right
+ * preconditioned GMRES, restarted every opts.restart iterations.
+ *
+ * Memory grows with restart*n, a longer restart converges in fewer
+ * iterations but each one costs more.
+ *
+ * @param[in]  A     operator
+ * @param[in]  b     right hand side
+ * @param      x     solution, also the starting guess with warm_start
+ * @param[in]  M     preconditioner or NULL for none
+ * @param[in]  opts  options, see RC_ITERATIVE_OPTS_DEFAULT
+ * @param[out] info  iteration count and residual, or NULL
+ *
+ * @return     0 if converged, 1 if not within max_iter, -1 on error
+ */
+int rc_iterative_gmres(rc_linop_t A, rc_vector_t b, rc_vector_t* x, rc_precond_t* M,
+                                rc_iterative_opts_t opts, rc_iterative_info_t* info);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_ITERATIVE_H
+
+/** @} end group Iterative */
@@ -74,6 +74,7 @@ extern "C" {
 #include <stdint.h>
 #include <rc_math/vector.h>
 #include <rc_math/matrix.h>
+#include <rc_math/sparse.h>
 
 
 /*
@@ -85,6 +86,8 @@ typedef struct rc_kalman_t {
     rc_matrix_t F;      ///< undriven state-transition model
     rc_matrix_t G;      ///< control input model
     rc_matrix_t H;      ///< observation-model
+    rc_sparse_t Fs;     ///< sparse F from rc_kalman_alloc_lin_sparse, used instead of F
+    rc_sparse_t Hs;     ///< sparse H from rc_kalman_alloc_lin_sparse, used instead of H
     ///@}
 
     /** @name Covariance Matrices */
@@ -112,6 +115,8 @@ typedef struct rc_kalman_t {
     .F = RC_MATRIX_INITIALIZER,\
     .G = RC_MATRIX_INITIALIZER,\
     .H = RC_MATRIX_INITIALIZER,\
+    .Fs = RC_SPARSE_INITIALIZER,\
+    .Hs = RC_SPARSE_INITIALIZER,\
     .Q = RC_MATRIX_INITIALIZER,\
     .R = RC_MATRIX_INITIALIZER,\
     .P = RC_MATRIX_INITIALIZER,\
@@ -164,6 +169,26 @@ int rc_kalman_alloc_lin(rc_kalman_t* kf, rc_matrix_t F, rc_matrix_t G, rc_matrix
  */
 int rc_kalman_alloc_ekf(rc_kalman_t* kf, rc_matrix_t Q, rc_matrix_t R, rc_matrix_t Pi);
 
+/**
+ * @brief      Same as rc_kalman_alloc_lin but with sparse F and H.
+ *
+ * For large models whose state transition and observation matrices are
+ * mostly zeros. rc_kalman_update_lin then does every product involving F or H
+ * with the sparse kernels in sparse.h, so their cost scales with the number of
+ * nonzeros instead of the full size of the matrices.
+ *
+ * @param      kf    pointer to struct to be allocated
+ * @param[in]  F     undriven state-transition model, CSR or CSC
+ * @param[in]  G     control input model
+ * @param[in]  H     observation model, CSR or CSC
+ * @param[in]  Q     Process noise covariance, can be updated later
+ * @param[in]  R     Measurement noise covariance, can be updated later
+ * @param[in]  Pi    Initial P matrix
+ *
+ * @return     0 on success, -1 on failure
+ */
+int rc_kalman_alloc_lin_sparse(rc_kalman_t* kf, rc_sparse_t F, rc_matrix_t G, rc_sparse_t H, rc_matrix_t Q, rc_matrix_t R, rc_matrix_t Pi);
+
 
 /**
  * @brief      Frees the memory allocated by a kalman filter's matrices and
@@ -244,6 +269,24 @@ int rc_kalman_update_lin(rc_kalman_t* kf, rc_vector_t u, rc_vector_t y);
 int rc_kalman_update_ekf(rc_kalman_t* kf, rc_matrix_t F, rc_matrix_t H, rc_vector_t x_pre,  rc_vector_t y, rc_vector_t h);
 
 
+/**
+ * @brief      Same as rc_kalman_update_ekf but with sparse Jacobians F and H.
+ *
+ * F*P*F^T, P*H^T, H*(P*H^T) and H*P are computed with the sparse kernels in
+ * sparse.h. Unlike rc_kalman_update_ekf the Jacobians are not copied into kf.
+ *
+ * @param      kf     pointer to struct to be updated
+ * @param[in]  F      Jacobian of state transition matrix linearized at x_pre
+ * @param[in]  H      Jacobian of observation matrix linearized at x_pre
+ * @param[in]  x_pre  predicted state
+ * @param[in]  y      new sensor data
+ * @param[in]  h      Ideal estimate of y, usually h=H*x_pre.
+ *
+ * @return     0 on success, -1 on failure
+ */
+int rc_kalman_update_ekf_sparse(rc_kalman_t* kf, rc_sparse_t F, rc_sparse_t H, rc_vector_t x_pre, rc_vector_t y, rc_vector_t h);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,6 +18,7 @@ extern "C" {
 #endif
 
 #include <rc_math/vector.h>
+#include <rc_math/workspace.h>
 
 /**
  * @brief      Struct containing the state of a matrix and a pointer to
@@ -28,10 +29,17 @@ extern "C" {
  * matrix.d[row][col] = new_value; // set value in the matrix
  * value = matrix.d[row][col];     // get value from the matrix
  * @endcode
+ *
+ * The row pointers and the data share one allocation and the data starts on a
+ * RC_MATRIX_ALIGN byte boundary. Row i starts at d[0]+i*stride. stride equals
+ * cols for matrices from rc_matrix_alloc so the data is one contiguous block,
+ * while rc_matrix_alloc_padded rounds it up so every row starts on its own
+ * cache line.
  */
 typedef struct rc_matrix_t{
     int rows;   ///< number of rows in the matrix
     int cols;   ///< number of columns in the matrix
+    int stride; ///< distance in elements between the starts of two rows, >=cols
     double** d; ///< pointer to allocated 2d array
     int initialized;///< set to 1 once memory has been allocated
 } rc_matrix_t;
@@ -39,9 +47,16 @@ typedef struct rc_matrix_t{
 #define RC_MATRIX_INITIALIZER {\
     .rows = 0,\
     .cols = 0,\
+    .stride = 0,\
     .d = NULL,\
     .initialized = 0}
 
+/**
+ * @brief      Alignment in bytes of the data of every matrix and vector
+ * allocated by the library, one cache line.
+ */
+#define RC_MATRIX_ALIGN 64
+
 /**
  * @brief      Returns an rc_matrix_t with no allocated memory and the
  * initialized flag set to 0.
@@ -63,10 +78,12 @@ rc_matrix_t rc_matrix_empty(void);
  * preserved. If A is uninitialized or of the wrong size then any existing
  * memory is freed and new memory is allocated, helping to prevent accidental
  * memory leaks. The contents of the new matrix is not guaranteed to be anything
- * in particular as the memory is allocated with malloc. Will only be
+ * in particular. Will only be
  * unsuccessful if rows&cols are invalid or there is insufficient memory
  * available.
  *
+ * Newly allocated matrices are unpadded, stride==cols.
+ *
  * @param      A     Pointer to user's matrix struct
  * @param[in]  rows  number of rows
  * @param[in]  cols  number of columns
@@ -75,6 +92,24 @@ rc_matrix_t rc_matrix_empty(void);
  */
 int rc_matrix_alloc(rc_matrix_t* A, int rows, int cols);
 
+/**
+ * @brief      Same as rc_matrix_alloc but pads each row out to a multiple of
+ * RC_MATRIX_ALIGN bytes so every row starts on a cache line.
+ *
+ * This helps large matrices whose rows would otherwise straddle cache lines in
+ * the multiply and mat-vec kernels. The padding is zeroed and never read as
+ * part of the matrix. Since rows are no longer back to back, code that walks
+ * d[0] as one rows*cols block must step by stride instead. Functions that
+ * later resize A with rc_matrix_alloc give it an unpadded layout again.
+ *
+ * @param      A     Pointer to user's matrix struct
+ * @param[in]  rows  number of rows
+ * @param[in]  cols  number of columns
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_alloc_padded(rc_matrix_t* A, int rows, int cols);
+
 /**
  * @brief      Frees the memory allocated for a matrix A
  *
@@ -91,8 +126,8 @@ int rc_matrix_free(rc_matrix_t* A);
 
 /**
  * @brief      Resizes matrix A and allocates memory for a matrix with specified rows &
-* columns. The new memory is pre-filled with zeros using calloc. Any existing memory
-* allocated for A is freed if necessary to avoid memory leaks.
+* columns. The memory is filled with zeros. Any existing memory allocated for A is
+* freed if necessary to avoid memory leaks.
  *
  * @param      A     Pointer to user's matrix struct
  * @param[in]  rows  number of rows
@@ -246,6 +281,24 @@ int rc_matrix_times_scalar(rc_matrix_t* A, double s);
  */
 int rc_matrix_multiply(rc_matrix_t A, rc_matrix_t B, rc_matrix_t* C);
 
+/**
+ * @brief      Multiplies op(A)*op(B)=C where op() optionally transposes its
+ * argument.
+ *
+ * Transposed operands are read in their existing layout so no transposed copy
+ * is ever made. For example with ta=0 and tb=1 this computes P*H^T straight
+ * from P and H. C is resized as needed and must not be A or B.
+ *
+ * @param[in]  A     first input
+ * @param[in]  ta    nonzero to use A^T in place of A
+ * @param[in]  B     second input
+ * @param[in]  tb    nonzero to use B^T in place of B
+ * @param[out] C     result
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_matrix_multiply_trans(rc_matrix_t A, int ta, rc_matrix_t B, int tb, rc_matrix_t* C);
+
 /**
  * @brief      Multiplies A*B and puts the result back in the place of B.
  *
@@ -266,20 +319,24 @@ int rc_matrix_left_multiply_inplace(rc_matrix_t A, rc_matrix_t* B);
  * A is resized and its original contents are freed if necessary to avoid memory
  * leaks.
  *
- * @param[in]  A     first input
- * @param[in]  B     second input
- * @param[in]  C     third input
- * @param[out] out   result
+ * @param      A     left matrix in the multiplication and holder of result
+ * @param[in]  B     right matrix in the multiplication
  *
  * @return     Returns 0 on success or -1 on failure.
  */
 int rc_matrix_right_multiply_inplace(rc_matrix_t* A, rc_matrix_t B);
 
 /**
- * @brief      Multiplies A*B*c and puts the result in matrix out
+ * @brief      Multiplies A*B*C and puts the result in matrix out
  *
- * @param      A     left matrix in the multiplication and holder of result
- * @param[in]  B     right matrix in the multiplication
+ * The product is evaluated as either (A*B)*C or A*(B*C), whichever requires
+ * fewer floating point operations for the given dimensions. out is resized and
+ * its original contents are freed if necessary to avoid memory leaks.
+ *
+ * @param[in]  A     first input
+ * @param[in]  B     second input
+ * @param[in]  C     third input
+ * @param[out] out   result
  *
  * @return     Returns 0 on success or -1 on failure.
  */
@@ -369,6 +426,41 @@ int rc_matrix_transpose_inplace(rc_matrix_t* A);
  */
 int rc_matrix_times_col_vec(rc_matrix_t A, rc_vector_t v, rc_vector_t* c);
 
+/**
+ * @brief      Multiplies op(A) times column vector v where op() optionally
+ * transposes A.
+ *
+ * With ta nonzero this computes A^T*v by walking the rows of A in memory order
+ * without making a transposed copy. c is resized as needed and must not be v.
+ *
+ * @param[in]  A     input matrix
+ * @param[in]  ta    nonzero to use A^T in place of A
+ * @param[in]  v     input vector
+ * @param[out] c     output vector
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_matrix_times_col_vec_trans(rc_matrix_t A, int ta, rc_vector_t v, rc_vector_t* c);
+
+/**
+ * @brief      Multiplies matrix A times k column vectors in one pass over A,
+ * c[n] = A*v[n] for n = 0 to k-1.
+ *
+ * Calling rc_matrix_times_col_vec k times streams A through the cache k times.
+ * Here each row of A is loaded once and used for every vector, which is much
+ * faster when A is large and several vectors are available at once. Any
+ * existing data in the outputs is freed if necessary and they are resized
+ * appropriately.
+ *
+ * @param[in]  A     input matrix
+ * @param[in]  v     array of k input vectors, each of length A.cols
+ * @param[out] c     array of k output vectors, none of which may be an input
+ * @param[in]  k     number of vectors
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_matrix_times_col_vecs(rc_matrix_t A, rc_vector_t* v, rc_vector_t* c, int k);
+
 /**
  * @brief      Multiplies matrix A times column vector v and places the result
  * back in column vector v.
@@ -419,6 +511,18 @@ int rc_matrix_outer_product(rc_vector_t v1, rc_vector_t v2, rc_matrix_t* A);
  */
 double rc_matrix_determinant(rc_matrix_t A);
 
+/**
+ * @brief      Same as rc_matrix_determinant but takes its temporary copy of A
+ * from a workspace instead of allocating it.
+ *
+ * @param[in]  A     input matrix
+ * @param      ws    workspace, see rc_algebra_workspace_size()
+ *
+ * @return     Returns the determinant or prints error message and returns -1.0f
+ * of error.
+ */
+double rc_matrix_determinant_ws(rc_matrix_t A, rc_workspace_t* ws);
+
 /**
  * @brief      Symmetrizes a square matrix
  *
@@ -430,6 +534,39 @@ double rc_matrix_determinant(rc_matrix_t A);
  */
 int rc_matrix_symmetrize(rc_matrix_t* P);
 
+/**
+ * @brief      Calculates the symmetric sandwich product out = A*P*A^T.
+ *
+ * This is the covariance propagation step of a Kalman filter. P must be
+ * square and is assumed to be symmetric. Only the upper triangle of the result
+ * is calculated, directly from rows of A*P and rows of A without forming A^T,
+ * and then mirrored so out is exactly symmetric. This replaces a multiply,
+ * transpose, second multiply, and rc_matrix_symmetrize.
+ *
+ * @param[in]  A     m x n matrix
+ * @param[in]  P     n x n symmetric matrix
+ * @param[out] out   m x m result, resized as needed, must not be A or P
+ *
+ * @return     0 on success, -1 on failure
+ */
+int rc_matrix_sandwich(rc_matrix_t A, rc_matrix_t P, rc_matrix_t* out);
+
+/**
+ * @brief      Same as rc_matrix_sandwich but also adds Q, out = A*P*A^T + Q.
+ *
+ * Q must be m x m. Its symmetric part (Q+Q^T)/2 is added so the result matches
+ * adding Q and then calling rc_matrix_symmetrize.
+ *
+ * @param[in]  A     m x n matrix
+ * @param[in]  P     n x n symmetric matrix
+ * @param[in]  Q     m x m matrix to add, typically process noise
+ * @param[out] out   m x m result, resized as needed, must not be A, P, or Q.
+ * To update Q in place use rc_matrix_sandwich into a temporary and add it.
+ *
+ * @return     0 on success, -1 on failure
+ */
+int rc_matrix_sandwich_add(rc_matrix_t A, rc_matrix_t P, rc_matrix_t Q, rc_matrix_t* out);
+
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,195 @@
+/**
+ * @headerfile matrix_view.h <rc_math/matrix_view.h>
+ *
+ * @brief      Zero-copy views of blocks, rows, columns, and transposes of
+ *             existing matrix storage.
+ *
+ * An rc_matrix_view_t does not own any memory. It describes a rows x cols
+ * window into some row-major storage: a pointer to the top left element and a
+ * leading dimension 'ld', the number of doubles between the start of one row
+ * of the storage and the next. A view can also be flagged as transposed in
+ * which case element (i,j) of the view is element (j,i) of the storage.
+ *
+ * Views can be taken of an rc_matrix_t or of any user buffer and then narrowed
+ * down with rc_matrix_view_block or flipped with rc_matrix_view_transpose
+ * without copying anything. Writing through a view writes straight into the
+ * underlying matrix so block algorithms can work on partitions in place.
+ *
+ * A view is only valid as long as the storage it points to. Reallocating or
+ * freeing the matrix it came from leaves the view dangling.
+ *
+ * @code{.c}
+ * // P12 = P[0:3, 3:6] of a 6x6 covariance, updated in place
+ * rc_matrix_view_t P12;
+ * rc_matrix_view_block(rc_matrix_view(P), 0, 3, 3, 3, &P12);
+ * rc_matrix_view_multiply(A, P12, T);
+ * @endcode
+ *
+ * @addtogroup Matrix_View
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_MATRIX_VIEW_H
+#define RC_MATRIX_VIEW_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+
+/**
+ * @brief      A strided, possibly transposed window into matrix storage.
+ */
+typedef struct rc_matrix_view_t{
+    double* d;  ///< pointer to the storage element at view position (0,0)
+    int rows;   ///< number of rows of the view
+    int cols;   ///< number of columns of the view
+    int ld;     ///< doubles between consecutive rows of the underlying storage
+    int trans;  ///< 1 if the view is the transpose of the storage, 0 otherwise
+} rc_matrix_view_t;
+
+/**
+ * @brief      Element (i,j) of view V as an lvalue.
+ */
+#define RC_MATRIX_VIEW_AT(V,i,j) \
+    ((V).d[(V).trans ? (((j)*(V).ld)+(i)) : (((i)*(V).ld)+(j))])
+
+/**
+ * @brief      Returns a view of all of matrix A.
+ *
+ * A must stay allocated and not be resized while the view is in use.
+ *
+ * @param[in]  A     matrix to view
+ *
+ * @return     The view, or a view with 0 rows and cols if A is uninitialized.
+ */
+rc_matrix_view_t rc_matrix_view(rc_matrix_t A);
+
+/**
+ * @brief      Returns a view of vector v as a len x 1 column.
+ *
+ * @param[in]  v     vector to view
+ *
+ * @return     The view, or a view with 0 rows and cols if v is uninitialized.
+ */
+rc_matrix_view_t rc_matrix_view_of_vector(rc_vector_t v);
+
+/**
+ * @brief      Makes a view over a user-provided row-major buffer.
+ *
+ * Unlike rc_matrix_from_array nothing is copied, the view reads and writes
+ * the buffer directly.
+ *
+ * @param[in]  ptr   pointer to the first element
+ * @param[in]  rows  number of rows
+ * @param[in]  cols  number of columns
+ * @param[in]  ld    doubles between the start of consecutive rows, >= cols
+ * @param[out] V     resulting view
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_view_from_array(double* ptr, int rows, int cols, int ld, rc_matrix_view_t* V);
+
+/**
+ * @brief      Narrows a view down to a rows x cols block starting at (row,col).
+ *
+ * Works on any view including transposed ones and other blocks.
+ *
+ * @param[in]  V     view to take the block of
+ * @param[in]  row   first row of the block
+ * @param[in]  col   first column of the block
+ * @param[in]  rows  number of rows in the block
+ * @param[in]  cols  number of columns in the block
+ * @param[out] out   resulting view
+ *
+ * @return     0 on success, -1 if the block does not fit inside V.
+ */
+int rc_matrix_view_block(rc_matrix_view_t V, int row, int col, int rows, int cols, rc_matrix_view_t* out);
+
+/**
+ * @brief      Narrows a view down to 'rows' whole rows starting at 'row'.
+ *
+ * @return     0 on success, -1 if the rows do not fit inside V.
+ */
+int rc_matrix_view_rows(rc_matrix_view_t V, int row, int rows, rc_matrix_view_t* out);
+
+/**
+ * @brief      Narrows a view down to column 'col', as a rows x 1 view.
+ *
+ * @return     0 on success, -1 if the column does not exist.
+ */
+int rc_matrix_view_col(rc_matrix_view_t V, int col, rc_matrix_view_t* out);
+
+/**
+ * @brief      Returns the transpose of a view, nothing is moved in memory.
+ */
+rc_matrix_view_t rc_matrix_view_transpose(rc_matrix_view_t V);
+
+/**
+ * @brief      Copies the contents of view src into view dst.
+ *
+ * Both must be the same size. They may be transposed relative to each other
+ * but must not overlap.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_view_copy(rc_matrix_view_t src, rc_matrix_view_t dst);
+
+/**
+ * @brief      Multiplies views A*B and writes the result into view C.
+ *
+ * C must already be the right size and must not overlap A or B. Uses the same
+ * blocked kernel as rc_matrix_multiply and reads transposed views in place.
+ *
+ * @param[in]  A     left view
+ * @param[in]  B     right view
+ * @param[out] C     result view
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_view_multiply(rc_matrix_view_t A, rc_matrix_view_t B, rc_matrix_view_t C);
+
+/**
+ * @brief      Same as rc_matrix_view_multiply but accumulates C = alpha*A*B +
+ * beta*C.
+ *
+ * When beta is 0 the original contents of C are never read.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_view_multiply_accumulate(double alpha, rc_matrix_view_t A, rc_matrix_view_t B,
+                                        double beta, rc_matrix_view_t C);
+
+/**
+ * @brief      Adds views A+B element by element into view C.
+ *
+ * All three must be the same size. C may be the exact same view as A or B to
+ * add in place but must not otherwise overlap them.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_view_add(rc_matrix_view_t A, rc_matrix_view_t B, rc_matrix_view_t C);
+
+/**
+ * @brief      Multiplies view A by vector view x and writes the result into
+ * vector view y.
+ *
+ * x and y may be either column (n x 1) or row (1 x n) views, for example
+ * columns of another matrix. y must not overlap A or x.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_view_times_col_vec(rc_matrix_view_t A, rc_matrix_view_t x, rc_matrix_view_t y);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_MATRIX_VIEW_H
+
+/** @} end group Matrix_View */
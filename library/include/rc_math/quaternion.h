@@ -26,6 +26,7 @@ extern "C" {
 
 #include <rc_math/vector.h>
 #include <rc_math/matrix.h>
+#include <rc_math/fixed_matrix.h>
 
 /**
  * @brief      Returns the length of a quaternion vector by finding its 2-norm.
@@ -316,6 +317,32 @@ int rc_quaternion_to_rotation_matrix(rc_vector_t q, rc_matrix_t* R);
  */
 int rc_rotation_to_quaternion(rc_matrix_t R, rc_vector_t* q);
 
+/**
+ * @brief      Converts a normalized quaternion to a fixed-size 3x3 rotation
+ * matrix.
+ *
+ * Same as rc_quaternion_to_rotation_matrix but nothing is allocated so it is
+ * safe to use in fast loops.
+ *
+ * @param[in]  q     The quarternion in form of an array of length 4
+ * @param[out] R     output 3x3 rotation matrix
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_quaternion_to_rotation_mat3(double q[4], rc_mat3_t* R);
+
+/**
+ * @brief      Converts a fixed-size 3x3 rotation matrix to quaternion form
+ *
+ * Same as rc_rotation_to_quaternion but nothing is allocated.
+ *
+ * @param[in]  R     3x3 rotation matrix
+ * @param[out] q     output quaternion as an array of length 4
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_rotation_mat3_to_quaternion(rc_mat3_t R, double q[4]);
+
 /**
  * @brief      Spherical linear interpolation between two quaternions
  *
@@ -0,0 +1,166 @@
+/**
+ * @headerfile rls.h <rc_math/rls.h>
+ *
+ * @brief      Recursive least squares by updating a QR factorization.
+ *
+ * An rc_rls_t solves the least-squares problem min |A*x - b| for a system
+ * whose rows a^T*x = b arrive one at a time. Instead of keeping A and b and
+ * refactoring with rc_algebra_lin_system_solve_qr after every row, it keeps
+ * only the upper triangular R factor of the augmented matrix [A b] and folds
+ * each new row into it with n+1 Givens rotations, so adding a row costs
+ * O(n^2) for n parameters no matter how many rows came before. The solution
+ * is read out at any time with one O(n^2) back substitution. Working on R
+ * rather than on the normal equations or the covariance of classic RLS keeps
+ * the accuracy of a QR solve.
+ *
+ * Two ways of following a model that changes over time are available and may
+ * be combined:
+ *
+ * - Exponential forgetting with factor lambda in (0,1] weighs a row added k
+ *   steps ago by lambda^k. R is scaled by sqrt(lambda) before each new row.
+ * - A sliding window keeps only the last 'window' rows. Once the window is
+ *   full the oldest row is removed from R with hyperbolic rotations, a
+ *   downdate, before the new one is added. The rows in the window are stored
+ *   for this, and should a downdate ever be too badly conditioned to trust, R
+ *   is rebuilt from them instead.
+ *
+ * ```C
+ * rc_rls_t rls = rc_rls_empty();
+ * rc_rls_alloc(&rls, 3, 0.99, 0);
+ * while(running){
+ *      fill in regressor a and measurement b;
+ *      rc_rls_add_row(&rls, a, b);
+ *      rc_rls_solve(rls, &x);
+ * }
+ * rc_rls_free(&rls);
+ * ```
+ *
+ * @addtogroup RLS
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_RLS_H
+#define RC_RLS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+
+/**
+ * @brief      State of a recursive least-squares fit.
+ */
+typedef struct rc_rls_t{
+    rc_matrix_t R;      ///< upper triangular factor of the weighted [A b], n+1 x n+1
+    rc_matrix_t rows;   ///< rows [a b] in the sliding window, unused without one
+    rc_vector_t tmp;    ///< scratch row, length n+1
+    int n;              ///< number of parameters
+    double lambda;      ///< forgetting factor, 1 for none
+    int window;         ///< number of rows kept, 0 to keep all of them
+    int head;           ///< index in rows of the oldest row in the window
+    int count;          ///< number of rows in the window
+    uint64_t step;      ///< rows added since the last reset
+    int initialized;    ///< 1 once memory has been allocated
+} rc_rls_t;
+
+#define RC_RLS_INITIALIZER {\
+    .R = RC_MATRIX_INITIALIZER,\
+    .rows = RC_MATRIX_INITIALIZER,\
+    .tmp = RC_VECTOR_INITIALIZER,\
+    .n = 0,\
+    .lambda = 1.0,\
+    .window = 0,\
+    .head = 0,\
+    .count = 0,\
+    .step = 0,\
+    .initialized = 0}
+
+/**
+ * @brief      Returns an rc_rls_t with no allocated memory and the
+ * initialized flag set to 0.
+ *
+ * @return     empty rc_rls_t
+ */
+rc_rls_t rc_rls_empty(void);
+
+/**
+ * @brief      Allocates memory for a fit of n parameters and resets it.
+ *
+ * @param      rls     fit to allocate
+ * @param[in]  n       number of parameters, the length of each row a
+ * @param[in]  lambda  forgetting factor in (0,1], 1 to weigh all rows equally
+ * @param[in]  window  number of most recent rows to fit, 0 for no limit
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_rls_alloc(rc_rls_t* rls, int n, double lambda, int window);
+
+/**
+ * @brief      Frees the memory of a fit and zeros out the struct.
+ *
+ * @param      rls   fit to free
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_rls_free(rc_rls_t* rls);
+
+/**
+ * @brief      Removes every row from the fit, keeping its settings.
+ *
+ * @param      rls   fit to reset
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_rls_reset(rc_rls_t* rls);
+
+/**
+ * @brief      Adds the row a^T*x = b to the fit.
+ *
+ * With a full sliding window the oldest row is dropped first.
+ *
+ * @param      rls   fit
+ * @param[in]  a     regressor, length n
+ * @param[in]  b     measurement
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_rls_add_row(rc_rls_t* rls, rc_vector_t a, double b);
+
+/**
+ * @brief      Least-squares solution for the rows added so far.
+ *
+ * Fails until the rows in the fit determine x, which takes at least n
+ * linearly independent rows. The fit is not changed.
+ *
+ * @param[in]  rls   fit
+ * @param[out] x     solution, length n
+ *
+ * @return     Returns 0 on success or -1 on failure.
+ */
+int rc_rls_solve(rc_rls_t rls, rc_vector_t* x);
+
+/**
+ * @brief      Weighted root sum of squares of the residuals A*x - b at the
+ * current solution.
+ *
+ * This is the last diagonal element of R so it costs nothing to read.
+ *
+ * @param[in]  rls   fit
+ *
+ * @return     residual norm, or -1 on error
+ */
+double rc_rls_residual(rc_rls_t rls);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_RLS_H
+
+/** @} end group RLS */
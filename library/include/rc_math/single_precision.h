@@ -0,0 +1,335 @@
+/**
+ * @headerfile single_precision.h <rc_math/single_precision.h>
+ *
+ * @brief      Single-precision versions of the core vector, matrix, linear
+ *             algebra, quaternion, ring buffer, and filter functions.
+ *
+ * Every function here behaves exactly like the double precision function of
+ * the same name without the 'f', for example rc_matrixf_multiply is
+ * rc_matrix_multiply for rc_matrixf_t. They are compiled from the same source
+ * as the double versions so the two cannot drift apart, see the documentation
+ * of the double versions for details.
+ *
+ * Floats fit twice as many values in each SIMD register and halve the memory
+ * traffic so this family is the faster choice when single precision is enough,
+ * for example running small filters and estimators on an ARM flight board. The
+ * zero tolerance set with rc_algebra_set_zero_tolerance applies to both
+ * families and may need raising for float work.
+ *
+ * Filters are still designed in double precision with the rc_filter_*
+ * functions and then converted with rc_filterf_from_filter to run in float.
+ *
+ * @code{.c}
+ * rc_matrixf_t A = RC_MATRIXF_INITIALIZER;
+ * rc_vectorf_t b = RC_VECTORF_INITIALIZER;
+ * rc_vectorf_t x = RC_VECTORF_INITIALIZER;
+ * rc_matrixf_from_matrix(&A, A_double);
+ * rc_vectorf_from_vector(&b, b_double);
+ * rc_algebraf_lin_system_solve(A, b, &x);
+ * @endcode
+ *
+ * @addtogroup Single_Precision
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_SINGLE_PRECISION_H
+#define RC_SINGLE_PRECISION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <rc_math/vector.h>
+#include <rc_math/matrix.h>
+#include <rc_math/filter.h>
+#include <rc_math/workspace.h>
+
+
+/**
+ * @brief      Single-precision version of rc_vector_t.
+ */
+typedef struct rc_vectorf_t{
+    int len;    ///< number of elements in the vector
+    float* d;   ///< pointer to dynamically allocated data
+    int initialized;///< initialization flag
+} rc_vectorf_t;
+
+#define RC_VECTORF_INITIALIZER {\
+    .len = 0,\
+    .d = NULL,\
+    .initialized = 0}
+
+
+/**
+ * @brief      Single-precision version of rc_matrix_t.
+ */
+typedef struct rc_matrixf_t{
+    int rows;   ///< number of rows in the matrix
+    int cols;   ///< number of columns in the matrix
+    int stride; ///< distance in elements between the starts of two rows, >=cols
+    float** d;  ///< pointer to allocated 2d array
+    int initialized;///< set to 1 once memory has been allocated
+} rc_matrixf_t;
+
+#define RC_MATRIXF_INITIALIZER {\
+    .rows = 0,\
+    .cols = 0,\
+    .stride = 0,\
+    .d = NULL,\
+    .initialized = 0}
+
+
+/**
+ * @brief      Single-precision version of rc_ringbuf_t.
+ */
+typedef struct rc_ringbuff_t{
+    float* d;   ///< pointer to dynamically allocated data
+    int size;   ///< number of elements the buffer can hold
+    int index;  ///< index of the most recently added value
+    int initialized;///< flag indicating if memory has been allocated for the buffer
+} rc_ringbuff_t;
+
+#define RC_RINGBUFF_INITIALIZER {\
+    .d = NULL,\
+    .size = 0,\
+    .index = 0,\
+    .initialized = 0}
+
+
+/**
+ * @brief      Single-precision version of rc_filter_t.
+ */
+typedef struct rc_filterf_t{
+    /** @name transfer function properties */
+    ///@{
+    int order;      ///< transfer function order
+    float dt;       ///< timestep in seconds
+    float gain;     ///< Additional gain multiplier, defaults to 1.0
+    rc_vectorf_t num;   ///< numerator coefficients
+    rc_vectorf_t den;   ///< denominator coefficients
+    ///@}
+
+    /** @name saturation settings */
+    ///@{
+    int sat_en;     ///< set to 1 by enable_saturation()
+    float sat_min;  ///< lower saturation limit
+    float sat_max;  ///< upper saturation limit
+    int sat_flag;   ///< 1 if saturated on the last step
+    ///@}
+
+    /** @name soft start settings */
+    ///@{
+    int ss_en;      ///< set to 1 by enbale_soft_start()
+    float ss_steps; ///< steps before full output allowed
+    ///@}
+
+    /** @name dynamically allocated ring buffers */
+    ///@{
+    rc_ringbuff_t in_buf;
+    rc_ringbuff_t out_buf;
+    ///@}
+
+    /** @name other */
+    ///@{
+    float newest_input; ///< shortcut for the most recent input
+    float newest_output;///< shortcut for the most recent output
+    uint64_t step;      ///< steps since last reset
+    int initialized;    ///< initialization flag
+    ///@}
+} rc_filterf_t;
+
+#define RC_FILTERF_INITIALIZER {\
+    .order          = 0,\
+    .dt             = 0.0f,\
+    .gain           = 1.0f,\
+    .num            = RC_VECTORF_INITIALIZER,\
+    .den            = RC_VECTORF_INITIALIZER,\
+    .sat_en         = 0,\
+    .sat_min        = 0.0f,\
+    .sat_max        = 0.0f,\
+    .sat_flag       = 0,\
+    .ss_en          = 0,\
+    .ss_steps       = 0,\
+    .in_buf         = RC_RINGBUFF_INITIALIZER,\
+    .out_buf        = RC_RINGBUFF_INITIALIZER,\
+    .newest_input   = 0.0f,\
+    .newest_output  = 0.0f,\
+    .step           = 0,\
+    .initialized    = 0}
+
+
+/** @name conversion to and from double precision */
+///@{
+
+/**
+ * @brief      Copies double vector v into float vector out, allocating out as
+ * necessary.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_vectorf_from_vector(rc_vectorf_t* out, rc_vector_t v);
+
+/**
+ * @brief      Copies float vector v into double vector out, allocating out as
+ * necessary.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_vector_from_vectorf(rc_vector_t* out, rc_vectorf_t v);
+
+/**
+ * @brief      Copies double matrix A into float matrix out, allocating out as
+ * necessary.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrixf_from_matrix(rc_matrixf_t* out, rc_matrix_t A);
+
+/**
+ * @brief      Copies float matrix A into double matrix out, allocating out as
+ * necessary.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_matrix_from_matrixf(rc_matrix_t* out, rc_matrixf_t A);
+
+/**
+ * @brief      Makes a float filter with the coefficients, gain, saturation,
+ * and soft start settings of a filter designed in double precision.
+ *
+ * The new filter starts from a reset state.
+ *
+ * @param[out] f       float filter to allocate
+ * @param[in]  design  filter made with any of the rc_filter_* functions
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_filterf_from_filter(rc_filterf_t* f, rc_filter_t design);
+
+///@}
+
+
+/** @name vectors, see vector.h */
+///@{
+rc_vectorf_t rc_vectorf_empty(void);
+int   rc_vectorf_alloc(rc_vectorf_t* v, int length);
+int   rc_vectorf_free(rc_vectorf_t* v);
+int   rc_vectorf_zeros(rc_vectorf_t* v, int length);
+int   rc_vectorf_ones(rc_vectorf_t* v, int length);
+int   rc_vectorf_from_array(rc_vectorf_t* v, float* ptr, int length);
+int   rc_vectorf_duplicate(rc_vectorf_t a, rc_vectorf_t* b);
+int   rc_vectorf_print(rc_vectorf_t v);
+int   rc_vectorf_print_sci(rc_vectorf_t v);
+int   rc_vectorf_zero_out(rc_vectorf_t* v);
+int   rc_vectorf_times_scalar(rc_vectorf_t* v, float s);
+float rc_vectorf_norm(rc_vectorf_t v, float p);
+float rc_vectorf_dot_product(rc_vectorf_t v1, rc_vectorf_t v2);
+int   rc_vectorf_cross_product(rc_vectorf_t v1, rc_vectorf_t v2, rc_vectorf_t* p);
+int   rc_vectorf_sum(rc_vectorf_t v1, rc_vectorf_t v2, rc_vectorf_t* s);
+int   rc_vectorf_sum_inplace(rc_vectorf_t* v1, rc_vectorf_t v2);
+int   rc_vectorf_subtract(rc_vectorf_t v1, rc_vectorf_t v2, rc_vectorf_t* s);
+///@}
+
+
+/** @name matrices, see matrix.h */
+///@{
+rc_matrixf_t rc_matrixf_empty(void);
+int rc_matrixf_alloc(rc_matrixf_t* A, int rows, int cols);
+int rc_matrixf_alloc_padded(rc_matrixf_t* A, int rows, int cols);
+int rc_matrixf_free(rc_matrixf_t* A);
+int rc_matrixf_zeros(rc_matrixf_t* A, int rows, int cols);
+int rc_matrixf_identity(rc_matrixf_t* A, int dim);
+int rc_matrixf_duplicate(rc_matrixf_t A, rc_matrixf_t* B);
+int rc_matrixf_print(rc_matrixf_t A);
+int rc_matrixf_print_sci(rc_matrixf_t A);
+int rc_matrixf_zero_out(rc_matrixf_t* A);
+int rc_matrixf_times_scalar(rc_matrixf_t* A, float s);
+int rc_matrixf_multiply(rc_matrixf_t A, rc_matrixf_t B, rc_matrixf_t* C);
+int rc_matrixf_multiply_trans(rc_matrixf_t A, int ta, rc_matrixf_t B, int tb, rc_matrixf_t* C);
+int rc_matrixf_left_multiply_inplace(rc_matrixf_t A, rc_matrixf_t* B);
+int rc_matrixf_right_multiply_inplace(rc_matrixf_t* A, rc_matrixf_t B);
+int rc_matrixf_add(rc_matrixf_t A, rc_matrixf_t B, rc_matrixf_t* C);
+int rc_matrixf_add_inplace(rc_matrixf_t* A, rc_matrixf_t B);
+int rc_matrixf_subtract_inplace(rc_matrixf_t* A, rc_matrixf_t B);
+int rc_matrixf_transpose(rc_matrixf_t A, rc_matrixf_t* T);
+int rc_matrixf_times_col_vec(rc_matrixf_t A, rc_vectorf_t v, rc_vectorf_t* c);
+int rc_matrixf_times_col_vec_trans(rc_matrixf_t A, int ta, rc_vectorf_t v, rc_vectorf_t* c);
+int rc_matrixf_times_col_vecs(rc_matrixf_t A, rc_vectorf_t* v, rc_vectorf_t* c, int k);
+int rc_matrixf_row_vec_times_matrix(rc_vectorf_t v, rc_matrixf_t A, rc_vectorf_t* c);
+///@}
+
+
+/** @name linear algebra, see algebra.h
+ *
+ * Workspaces sized with rc_algebra_workspace_size are big enough for the
+ * float functions too.
+ */
+///@{
+int rc_algebraf_qr_decomp(rc_matrixf_t A, rc_matrixf_t* Q, rc_matrixf_t* R);
+int rc_algebraf_qr_decomp_ws(rc_matrixf_t A, rc_matrixf_t* Q, rc_matrixf_t* R, rc_workspace_t* ws);
+int rc_algebraf_solve_lower_triangular(rc_matrixf_t L, rc_matrixf_t B, rc_matrixf_t* X);
+int rc_algebraf_solve_upper_triangular(rc_matrixf_t U, rc_matrixf_t B, rc_matrixf_t* X);
+int rc_algebraf_lin_system_solve(rc_matrixf_t A, rc_vectorf_t b, rc_vectorf_t* x);
+int rc_algebraf_lin_system_solve_ws(rc_matrixf_t A, rc_vectorf_t b, rc_vectorf_t* x, rc_workspace_t* ws);
+int rc_algebraf_lin_system_solve_qr(rc_matrixf_t A, rc_vectorf_t b, rc_vectorf_t* x);
+///@}
+
+
+/** @name quaternion arrays [Wijk], see quaternion.h */
+///@{
+float rc_quaternionf_norm_array(float q[4]);
+int rc_quaternionf_normalize_array(float q[4]);
+int rc_quaternionf_to_tb_array(float q[4], float tb[3]);
+int rc_quaternionf_from_tb_array(float tb[3], float q[4]);
+int rc_quaternionf_conjugate_array(float q[4], float c[4]);
+int rc_quaternionf_conjugate_array_inplace(float q[4]);
+int rc_quaternionf_multiply_array(float a[4], float b[4], float c[4]);
+int rc_quaternionf_left_multiply_inplace_array(float a[4], float b[4]);
+int rc_quaternionf_right_multiply_inplace_array(float a[4], float b[4]);
+int rc_quaternionf_rotate_array(float p[4], float q[4]);
+int rc_quaternionf_rotate_vector_array(float v[3], float q[4]);
+///@}
+
+
+/** @name ring buffers, see ring_buffer.h */
+///@{
+rc_ringbuff_t rc_ringbuff_empty(void);
+int   rc_ringbuff_alloc(rc_ringbuff_t* buf, int size);
+int   rc_ringbuff_free(rc_ringbuff_t* buf);
+int   rc_ringbuff_reset(rc_ringbuff_t* buf);
+int   rc_ringbuff_insert(rc_ringbuff_t* buf, float val);
+float rc_ringbuff_get_value(rc_ringbuff_t* buf, int position);
+float rc_ringbuff_std_dev(rc_ringbuff_t buf);
+///@}
+
+
+/** @name filters, see filter.h */
+///@{
+rc_filterf_t rc_filterf_empty(void);
+int   rc_filterf_alloc(rc_filterf_t* f, rc_vectorf_t num, rc_vectorf_t den, float dt);
+int   rc_filterf_alloc_from_arrays(rc_filterf_t* f, float dt, float* num, int numlen,
+                                                        float* den, int denlen);
+int   rc_filterf_duplicate(rc_filterf_t* f, rc_filterf_t old);
+int   rc_filterf_free(rc_filterf_t* f);
+float rc_filterf_march(rc_filterf_t* f, float new_input);
+int   rc_filterf_reset(rc_filterf_t* f);
+int   rc_filterf_enable_saturation(rc_filterf_t* f, float min, float max);
+int   rc_filterf_get_saturation_flag(rc_filterf_t* f);
+int   rc_filterf_enable_soft_start(rc_filterf_t* f, float seconds);
+float rc_filterf_previous_input(rc_filterf_t* f, int steps);
+float rc_filterf_previous_output(rc_filterf_t* f, int steps);
+int   rc_filterf_prefill_inputs(rc_filterf_t* f, float in);
+int   rc_filterf_prefill_outputs(rc_filterf_t* f, float out);
+///@}
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_SINGLE_PRECISION_H
+
+/** @} end group Single_Precision */
@@ -0,0 +1,210 @@
+/**
+ * @headerfile sparse.h <rc_math/sparse.h>
+ *
+ * @brief      Sparse matrices in compressed sparse row (CSR) or compressed
+ *             sparse column (CSC) form.
+ *
+ * Jacobians of large EKF models and many measurement models are mostly zeros.
+ * An rc_sparse_t stores only the nonzero values so products with it cost time
+ * proportional to the number of nonzeros instead of rows*cols.
+ *
+ * In CSR form the nonzeros are stored row by row. Row i occupies entries
+ * ptr[i] through ptr[i+1]-1 of idx and val, where idx holds the column of
+ * each value. CSC is the same with the roles of rows and columns swapped. Within
+ * each row (or column) the indices are sorted and unique. Either form works
+ * with every function here, and every product can use the matrix or its
+ * transpose, so pick whichever form is easiest to build.
+ *
+ * Semantics otherwise match rc_matrix_t: outputs are allocated or resized as
+ * needed and functions return 0 on success or -1 on failure after printing an
+ * error message.
+ *
+ * @code{.c}
+ * // 3x3 H with 4 nonzeros
+ * int    i[] = {0,   1,   2,   2};
+ * int    j[] = {0,   1,   0,   2};
+ * double v[] = {1.0, 2.0, 0.5, 1.0};
+ * rc_sparse_t H = RC_SPARSE_INITIALIZER;
+ * rc_sparse_from_triplets(&H, 3, 3, 4, i, j, v, RC_SPARSE_CSR);
+ * rc_sparse_times_col_vec(H, x, &y); // y = H*x
+ * @endcode
+ *
+ * @addtogroup Sparse
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_SPARSE_H
+#define RC_SPARSE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+
+#define RC_SPARSE_CSR   0   ///< compressed sparse row
+#define RC_SPARSE_CSC   1   ///< compressed sparse column
+
+/**
+ * @brief      Sparse matrix in CSR or CSC form.
+ */
+typedef struct rc_sparse_t{
+    int rows;       ///< number of rows
+    int cols;       ///< number of columns
+    int nnz;        ///< number of stored nonzeros
+    int format;     ///< RC_SPARSE_CSR or RC_SPARSE_CSC
+    int* ptr;       ///< rows+1 (CSR) or cols+1 (CSC) offsets into idx and val
+    int* idx;       ///< column (CSR) or row (CSC) of each nonzero
+    double* val;    ///< nonzero values
+    int initialized;///< set to 1 once memory has been allocated
+} rc_sparse_t;
+
+#define RC_SPARSE_INITIALIZER {\
+    .rows = 0,\
+    .cols = 0,\
+    .nnz = 0,\
+    .format = RC_SPARSE_CSR,\
+    .ptr = NULL,\
+    .idx = NULL,\
+    .val = NULL,\
+    .initialized = 0}
+
+/**
+ * @brief      Returns an rc_sparse_t with no allocated memory and the
+ * initialized flag set to 0.
+ *
+ * @return     empty sparse matrix
+ */
+rc_sparse_t rc_sparse_empty(void);
+
+/**
+ * @brief      Frees the memory of S and returns it to an empty state.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_free(rc_sparse_t* S);
+
+/**
+ * @brief      Builds a sparse matrix from (row, column, value) triplets.
+ *
+ * Triplets may come in any order. Values given more than once for the same
+ * position are added together, which is handy when assembling a Jacobian from
+ * several terms. Explicit zeros are kept.
+ *
+ * @param      S       pointer to the sparse matrix to fill, any old memory is
+ * freed
+ * @param[in]  rows    number of rows
+ * @param[in]  cols    number of columns
+ * @param[in]  n       number of triplets, may be 0 for an all zero matrix
+ * @param[in]  i       row of each triplet
+ * @param[in]  j       column of each triplet
+ * @param[in]  val     value of each triplet
+ * @param[in]  format  RC_SPARSE_CSR or RC_SPARSE_CSC
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_from_triplets(rc_sparse_t* S, int rows, int cols, int n, const int* i,
+                                const int* j, const double* val, int format);
+
+/**
+ * @brief      Builds a sparse matrix from the nonzero elements of A.
+ *
+ * @param[in]  A       dense input matrix
+ * @param[in]  format  RC_SPARSE_CSR or RC_SPARSE_CSC
+ * @param[out] S       sparse result, any old memory is freed
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_from_matrix(rc_matrix_t A, int format, rc_sparse_t* S);
+
+/**
+ * @brief      Expands S into a dense rc_matrix_t.
+ *
+ * @param[in]  S     sparse input
+ * @param[out] A     dense rows x cols result, allocated as needed
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_to_matrix(rc_sparse_t S, rc_matrix_t* A);
+
+/**
+ * @brief      Copies S into out in the requested format.
+ *
+ * Converting between CSR and CSC is a counting sort of the nonzeros and takes
+ * time proportional to nnz plus the dimensions.
+ *
+ * @param[in]  S       sparse input
+ * @param[in]  format  RC_SPARSE_CSR or RC_SPARSE_CSC
+ * @param[out] out     result, any old memory is freed, must not be S
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_convert(rc_sparse_t S, int format, rc_sparse_t* out);
+
+/**
+ * @brief      Prints the nonzeros of S to stdout, one per line.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_print(rc_sparse_t S);
+
+/**
+ * @brief      Sparse matrix times vector, c = op(S)*v.
+ *
+ * @param[in]  S     sparse input
+ * @param[in]  ts    nonzero to use the transpose of S
+ * @param[in]  v     input vector
+ * @param[out] c     output vector, allocated as needed, must not be v
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_times_col_vec_trans(rc_sparse_t S, int ts, rc_vector_t v, rc_vector_t* c);
+
+/**
+ * @brief      Sparse matrix times vector, c = S*v. Same as
+ * rc_sparse_times_col_vec_trans with ts=0.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_times_col_vec(rc_sparse_t S, rc_vector_t v, rc_vector_t* c);
+
+/**
+ * @brief      Sparse times dense matrix product, C = op(S)*B.
+ *
+ * Each nonzero adds a scaled row of B to a row of C with the vectorized AXPY
+ * kernel, so the cost is nnz times the width of B.
+ *
+ * @param[in]  S     sparse left operand
+ * @param[in]  ts    nonzero to use the transpose of S
+ * @param[in]  B     dense right operand
+ * @param[out] C     dense result, allocated as needed, must not be B
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_multiply_dense(rc_sparse_t S, int ts, rc_matrix_t B, rc_matrix_t* C);
+
+/**
+ * @brief      Dense times sparse matrix product, C = A*op(S).
+ *
+ * This is the form needed for P*H^T in a Kalman filter.
+ *
+ * @param[in]  A     dense left operand
+ * @param[in]  S     sparse right operand
+ * @param[in]  ts    nonzero to use the transpose of S
+ * @param[out] C     dense result, allocated as needed, must not be A
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_sparse_dense_multiply(rc_matrix_t A, rc_sparse_t S, int ts, rc_matrix_t* C);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_SPARSE_H
+
+/** @} end group Sparse */
@@ -0,0 +1,271 @@
+/**
+ * @headerfile symmetric.h <rc_math/symmetric.h>
+ *
+ * @brief      Symmetric matrices such as covariances stored packed, upper
+ *             triangle only.
+ *
+ * An rc_symmetric_t of size n keeps only the n*(n+1)/2 elements on and above
+ * the diagonal, row by row: row i holds elements (i,i) through (i,n-1) next to
+ * each other. This nearly halves the memory and the memory traffic of a full
+ * rc_matrix_t, and since each off-diagonal element is only stored once the
+ * matrix can never become unsymmetric through rounding, so no
+ * rc_matrix_symmetrize pass is needed.
+ *
+ * The Cholesky factor of a packed matrix is upper triangular and is stored in
+ * an rc_symmetric_t with the same packed layout, ready for
+ * rc_symmetric_cholesky_solve.
+ *
+ * Semantics otherwise match rc_matrix_t: outputs are allocated or resized as
+ * needed and functions return 0 on success or -1 on failure after printing an
+ * error message.
+ *
+ * @code{.c}
+ * rc_symmetric_t P = RC_SYMMETRIC_INITIALIZER;
+ * rc_symmetric_t Q = RC_SYMMETRIC_INITIALIZER;
+ * rc_symmetric_t newP = RC_SYMMETRIC_INITIALIZER;
+ * rc_symmetric_from_matrix(P_full, &P);
+ * rc_symmetric_from_matrix(Q_full, &Q);
+ * rc_symmetric_sandwich_add(F, P, Q, &newP); // newP = F*P*F^T + Q
+ * @endcode
+ *
+ * @addtogroup Symmetric
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_SYMMETRIC_H
+#define RC_SYMMETRIC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <rc_math/matrix.h>
+#include <rc_math/vector.h>
+
+/**
+ * @brief      Packed upper triangle of an n x n symmetric matrix.
+ */
+typedef struct rc_symmetric_t{
+    int n;          ///< number of rows and columns
+    double* d;      ///< n*(n+1)/2 packed elements, upper triangle row by row
+    int initialized;///< set to 1 once memory has been allocated
+} rc_symmetric_t;
+
+#define RC_SYMMETRIC_INITIALIZER {\
+    .n = 0,\
+    .d = NULL,\
+    .initialized = 0}
+
+/**
+ * @brief      Number of doubles used to store an n x n symmetric matrix.
+ */
+#define RC_SYMMETRIC_SIZE(n) (((n)*((n)+1))/2)
+
+/**
+ * @brief      Index into the packed array of element (i,j) with i<=j.
+ */
+#define RC_SYMMETRIC_INDEX(n,i,j) ((((i)*(2*(n)-(i)-1))/2)+(j))
+
+/**
+ * @brief      Element (i,j) of S as an lvalue, i must be <= j.
+ */
+#define RC_SYMMETRIC_AT(S,i,j) ((S).d[RC_SYMMETRIC_INDEX((S).n,i,j)])
+
+/**
+ * @brief      Returns an rc_symmetric_t with no allocated memory and the
+ * initialized flag set to 0.
+ *
+ * @return     empty symmetric matrix
+ */
+rc_symmetric_t rc_symmetric_empty(void);
+
+/**
+ * @brief      Allocates memory for an n x n symmetric matrix.
+ *
+ * Like rc_matrix_alloc this does nothing if S is already the right size and
+ * otherwise frees any old memory first. The contents are not initialized.
+ *
+ * @param      S     pointer to the matrix to allocate
+ * @param[in]  n     number of rows and columns
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_alloc(rc_symmetric_t* S, int n);
+
+/**
+ * @brief      Same as rc_symmetric_alloc but fills the matrix with zeros.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_zeros(rc_symmetric_t* S, int n);
+
+/**
+ * @brief      Allocates S as the n x n identity matrix.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_identity(rc_symmetric_t* S, int n);
+
+/**
+ * @brief      Frees the memory of S and returns it to an empty state.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_free(rc_symmetric_t* S);
+
+/**
+ * @brief      Copies A into B, allocating B as needed.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_duplicate(rc_symmetric_t A, rc_symmetric_t* B);
+
+/**
+ * @brief      Packs a square rc_matrix_t into S.
+ *
+ * Each stored element is the average of A(i,j) and A(j,i) so S is the
+ * symmetric part of A even if A had drifted slightly unsymmetric.
+ *
+ * @param[in]  A     square input matrix
+ * @param[out] S     packed result, allocated as needed
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_from_matrix(rc_matrix_t A, rc_symmetric_t* S);
+
+/**
+ * @brief      Unpacks S into a full rc_matrix_t with both triangles filled in.
+ *
+ * @param[in]  S     packed input
+ * @param[out] A     full n x n result, allocated as needed
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_to_matrix(rc_symmetric_t S, rc_matrix_t* A);
+
+/**
+ * @brief      Reads element (i,j) of S in either order.
+ *
+ * @return     the element, or 0 after printing an error if S is not
+ * initialized or (i,j) is out of bounds.
+ */
+double rc_symmetric_get(rc_symmetric_t S, int i, int j);
+
+/**
+ * @brief      Sets element (i,j) and with it (j,i) of S.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_set(rc_symmetric_t* S, int i, int j, double val);
+
+/**
+ * @brief      Prints S to stdout as a full matrix.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_print(rc_symmetric_t S);
+
+/**
+ * @brief      Adds A+B and places the result in C.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_add(rc_symmetric_t A, rc_symmetric_t B, rc_symmetric_t* C);
+
+/**
+ * @brief      Adds B to A in place, A = A+B.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_add_inplace(rc_symmetric_t* A, rc_symmetric_t B);
+
+/**
+ * @brief      Multiplies every element of S by scalar s.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_times_scalar(rc_symmetric_t* S, double s);
+
+/**
+ * @brief      Multiplies S times column vector v and places the result in c.
+ *
+ * Each packed row is used twice, once as a row and once as the matching
+ * column, so S is read from memory only once.
+ *
+ * @param[in]  S     symmetric input matrix
+ * @param[in]  v     input vector of length S.n
+ * @param[out] c     output vector, allocated as needed, must not be v
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_times_col_vec(rc_symmetric_t S, rc_vector_t v, rc_vector_t* c);
+
+/**
+ * @brief      Computes out = A*P*A^T for symmetric P.
+ *
+ * Like rc_matrix_sandwich only the upper triangle of the result is computed
+ * and it goes straight into packed storage. P is never unpacked in full, only
+ * a panel of its columns at a time, so the scratch memory is A*P plus one
+ * panel.
+ *
+ * @param[in]  A     m x n input matrix
+ * @param[in]  P     n x n symmetric input
+ * @param[out] out   m x m symmetric result, allocated as needed, must not be P
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_sandwich(rc_matrix_t A, rc_symmetric_t P, rc_symmetric_t* out);
+
+/**
+ * @brief      Computes out = A*P*A^T + Q for symmetric P and Q.
+ *
+ * This is the covariance prediction step of a Kalman filter.
+ *
+ * @param[in]  A     m x n input matrix
+ * @param[in]  P     n x n symmetric input
+ * @param[in]  Q     m x m symmetric input
+ * @param[out] out   m x m symmetric result, allocated as needed, must not be P.
+ * It may be Q.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_sandwich_add(rc_matrix_t A, rc_symmetric_t P, rc_symmetric_t Q, rc_symmetric_t* out);
+
+/**
+ * @brief      Cholesky factorization A = U^T*U of a symmetric positive definite
+ * matrix.
+ *
+ * The upper triangular factor U is written in the same packed layout, so U
+ * uses the rc_symmetric_t type but only its upper triangle has meaning. Use it
+ * with rc_symmetric_cholesky_solve.
+ *
+ * @param[in]  A     symmetric positive definite input
+ * @param[out] U     packed upper triangular factor, allocated as needed, may be
+ * A to factor in place
+ *
+ * @return     0 on success, -1 on failure or if A is not positive definite.
+ */
+int rc_symmetric_cholesky(rc_symmetric_t A, rc_symmetric_t* U);
+
+/**
+ * @brief      Solves A*x = b given the Cholesky factor U of A from
+ * rc_symmetric_cholesky.
+ *
+ * @param[in]  U     packed upper triangular Cholesky factor of A
+ * @param[in]  b     right hand side of length U.n
+ * @param[out] x     solution, allocated as needed, may be b
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_symmetric_cholesky_solve(rc_symmetric_t U, rc_vector_t b, rc_vector_t* x);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_SYMMETRIC_H
+
+/** @} end group Symmetric */
@@ -0,0 +1,76 @@
+/**
+ * @headerfile thread_pool.h <rc_math/thread_pool.h>
+ *
+ * @brief      Optional pool of worker threads for large matrix operations.
+ *
+ * By default everything in the library runs on the calling thread. After
+ * rc_thread_pool_init() the matrix multiply (and everything built on it),
+ * matrix times vector, the elimination step of rc_algebra_lin_system_solve,
+ * and rc_matrix_batch_lin_system_solve split their work across the pool once
+ * the matrices or batches are big enough for it to pay off. Small matrices like the ones in
+ * a Kalman filter always stay on the calling thread so real-time loops are
+ * not affected.
+ *
+ * The pool is created once and its threads sleep between jobs. Only one
+ * library call uses the pool at a time. If a second thread calls into the
+ * library while the pool is busy, that call simply runs on its own thread.
+ *
+ * @code{.c}
+ * rc_thread_pool_init(0); // one thread per online CPU
+ * rc_matrix_multiply(A, B, &C);
+ * rc_thread_pool_cleanup();
+ * @endcode
+ *
+ * @addtogroup Thread_Pool
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_THREAD_POOL_H
+#define RC_THREAD_POOL_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief      Starts the thread pool.
+ *
+ * The calling thread always takes part in the work so threads-1 workers are
+ * started. If the pool is already running it is stopped and restarted with
+ * the new size.
+ *
+ * @param[in]  threads  total number of threads to use including the caller, 0
+ * for one per online CPU, 1 to run everything on the calling thread
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_thread_pool_init(int threads);
+
+/**
+ * @brief      Stops and joins all worker threads.
+ *
+ * Safe to call when the pool is not running. Must not be called while
+ * another thread is inside a library call that uses the pool.
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_thread_pool_cleanup(void);
+
+/**
+ * @brief      Gets the number of threads work is split across.
+ *
+ * @return     total thread count including the caller, 1 if the pool is not
+ * running
+ */
+int rc_thread_pool_get_threads(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_THREAD_POOL_H
+
+/** @} end group Thread_Pool */
@@ -26,6 +26,7 @@ extern "C" {
 #include <stdint.h>
 #include <pthread.h>
 #include <rc_math/matrix.h>
+#include <rc_math/fixed_matrix.h>
 
 
 typedef struct rc_timed3_ringbuf_t {
@@ -259,6 +260,25 @@ int rc_timed3_ringbuf_integrate_gyro_3d(rc_timed3_ringbuf_t* buf, \
 							int64_t t_start, int64_t t_end, rc_matrix_t* out);
 
 
+/**
+ * @brief      Same as rc_timed3_ringbuf_integrate_gyro_3d but writes to a
+ *             fixed-size rc_mat3_t so nothing is allocated. Prefer this one
+ *             in high-rate loops.
+ *
+ * @param[in]  buf      The buffer
+ * @param[in]  t_start  start time nanoseconds
+ * @param[in]  t_end    end time nanoseconds
+ * @param[out] out      resulting 3x3 rotation matrix, identity if the buffer
+ *                      does not cover the requested period
+ *
+ * @return     0 on success, -2 if the buffer does not contain data old enough,
+ *             -3 if the buffer does not contain data new enough. -1 on other
+ *             error.
+ */
+int rc_timed3_ringbuf_integrate_gyro_mat3(rc_timed3_ringbuf_t* buf, \
+							int64_t t_start, int64_t t_end, rc_mat3_t* out);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -82,9 +82,9 @@ rc_vector_t rc_vector_empty(void);
  * memory is freed and new memory is allocated, helping to prevent accidental
  * memory leaks.
  *
- * The contents of the new vector is not guaranteed to be anything in particular
- * as it is allocated with malloc. Use rc_vector_zeros or rc_vector_ones if you
- * require known starting values.
+ * The contents of the new vector is not guaranteed to be anything in particular.
+ * Use rc_vector_zeros or rc_vector_ones if you require known starting values.
+ * The data starts on a 64 byte cache line boundary.
  *
  * Returns 0 if successful, otherwise returns -1. Will only be unsuccessful if
  * length is invalid or there is insufficient memory available.
@@ -114,9 +114,9 @@ int rc_vector_free(rc_vector_t* v);
 /**
  * @brief      Resizes vector v and fills with zeros.
  *
- * uses calloc to allocate new memory. Any existing memory allocated for v is
- * freed if necessary to avoid memory leaks. It is not necessary to call
- * rc_alloc_vector before this.
+ * Memory is reused if v is already the right length, otherwise any existing
+ * memory allocated for v is freed to avoid memory leaks. It is not necessary to
+ * call rc_alloc_vector before this.
  *
  * @param      v       Pointer to user's rc_vector_t struct
  * @param[in]  length  Length of vector to allocate memory for
@@ -314,6 +314,62 @@ double rc_vector_std_dev(rc_vector_t v);
  */
 double rc_vector_mean(rc_vector_t v);
 
+/**
+ * @brief      Results of rc_vector_stats. Fields that were not requested are
+ * left at 0 and their indices at -1.
+ */
+typedef struct rc_vector_stats_t{
+    double mean;    ///< average of all values
+    double std_dev; ///< sample standard deviation, same as rc_vector_std_dev
+    double norm1;   ///< sum of absolute values
+    double norm2;   ///< square root of the sum of squares
+    double max;     ///< largest value
+    double min;     ///< smallest value
+    int max_index;  ///< index of the first occurrence of max
+    int min_index;  ///< index of the first occurrence of min
+} rc_vector_stats_t;
+
+/**
+ * @name       rc_vector_stats flags
+ *
+ * OR these together to pick which results rc_vector_stats computes. Anything
+ * not requested is skipped inside the kernel as well.
+ */
+///@{
+#define RC_VECTOR_STATS_MEAN    0x01    ///< mean
+#define RC_VECTOR_STATS_STD_DEV 0x02    ///< std_dev, also computes the mean
+#define RC_VECTOR_STATS_NORM    0x04    ///< norm1 and norm2
+#define RC_VECTOR_STATS_MAX     0x08    ///< max and max_index
+#define RC_VECTOR_STATS_MIN     0x10    ///< min and min_index
+#define RC_VECTOR_STATS_ALL     0x1F    ///< everything
+///@}
+
+/**
+ * @brief      Computes the mean, standard deviation, 1 and 2 norms, max, and
+ * min of v in a single pass over the data.
+ *
+ * Calling rc_vector_mean, rc_vector_std_dev, rc_vector_norm, rc_vector_max and
+ * rc_vector_min separately reads a long vector from memory six times, this
+ * reads it once. The vector is processed in cache-sized blocks with the SIMD
+ * kernel selected at load time. Each block's variance is taken about the
+ * running mean of the blocks before it and the blocks are then merged
+ * pairwise, which keeps the standard deviation accurate even when the mean is
+ * much larger than the spread, as with raw sensor telemetry.
+ *
+ * @code{.c}
+ * rc_vector_stats_t s;
+ * rc_vector_stats(v, RC_VECTOR_STATS_MEAN|RC_VECTOR_STATS_STD_DEV, &s);
+ * @endcode
+ *
+ * @param[in]  v      User's vector struct
+ * @param[in]  flags  which results to compute, any combination of
+ * RC_VECTOR_STATS_* or RC_VECTOR_STATS_ALL
+ * @param[out] s      results
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_vector_stats(rc_vector_t v, int flags, rc_vector_stats_t* s);
+
 /**
  * @brief      Populates vector p with the projection of vector v onto e.
  *
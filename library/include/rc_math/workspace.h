@@ -0,0 +1,118 @@
+/**
+ * @headerfile workspace.h <rc_math/workspace.h>
+ *
+ * @brief      Caller-owned scratch memory for the algebra functions.
+ *
+ * Functions like rc_algebra_invert_matrix need several temporary matrices and
+ * normally malloc and free them on every call. Each of those functions has a
+ * _ws variant that instead carves its temporaries out of an rc_workspace_t
+ * provided by the caller. Allocate the workspace once at startup, sized with
+ * rc_algebra_workspace_size(), and reuse it every loop so the loop never calls
+ * malloc. Once the output matrices have been used once and are the right size
+ * they are not reallocated either.
+ *
+ * The _ws functions give back everything they take from the workspace before
+ * returning so the same workspace can be passed to any number of calls in a
+ * row without resetting it. A workspace must not be shared between threads.
+ *
+ * The blocked matrix multiply used inside the QR, inverse, determinant, and
+ * mixed precision _ws functions is the exception. It packs its operands into
+ * a buffer on the stack for matrices up to 64x64 but mallocs that buffer for
+ * anything larger, and so does every task when the thread pool splits a large
+ * multiply. The loop above is only completely malloc free up to that size.
+ *
+ * @code{.c}
+ * rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+ * rc_workspace_alloc(&ws, rc_algebra_workspace_size(6,6));
+ * while(running){
+ *     rc_algebra_invert_matrix_ws(A, &Ainv, &ws);
+ *     ...
+ * }
+ * rc_workspace_free(&ws);
+ * @endcode
+ *
+ * @addtogroup Workspace
+ * @ingroup    Math
+ * @{
+ */
+
+
+#ifndef RC_WORKSPACE_H
+#define RC_WORKSPACE_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h> // for size_t
+
+/**
+ * @brief      Struct containing the state of a workspace and a pointer to its
+ * dynamically allocated memory.
+ */
+typedef struct rc_workspace_t{
+    void* d;        ///< pointer to dynamically allocated memory
+    size_t size;    ///< total number of bytes available
+    size_t used;    ///< number of bytes currently handed out
+    int initialized;///< set to 1 once memory has been allocated
+} rc_workspace_t;
+
+#define RC_WORKSPACE_INITIALIZER {\
+    .d = NULL,\
+    .size = 0,\
+    .used = 0,\
+    .initialized = 0}
+
+/**
+ * @brief      Returns an rc_workspace_t with no allocated memory and the
+ * initialized flag set to 0.
+ *
+ * @return     Returns an empty rc_workspace_t
+ */
+rc_workspace_t rc_workspace_empty(void);
+
+/**
+ * @brief      Allocates at least 'bytes' of memory for a workspace.
+ *
+ * If the workspace is already allocated and at least this big no new memory
+ * is allocated, it is only reset as with rc_workspace_reset so all of it is
+ * available again. Otherwise any existing memory is freed and new memory is
+ * allocated. The memory is aligned to a 64 byte cache line.
+ *
+ * @param      ws     Pointer to user's workspace struct
+ * @param[in]  bytes  number of bytes, usually from rc_algebra_workspace_size()
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_workspace_alloc(rc_workspace_t* ws, size_t bytes);
+
+/**
+ * @brief      Frees the memory allocated for a workspace.
+ *
+ * @param      ws    Pointer to user's workspace struct
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_workspace_free(rc_workspace_t* ws);
+
+/**
+ * @brief      Marks all the memory in a workspace as unused again.
+ *
+ * The _ws functions already clean up after themselves so this is only needed
+ * to recover after an error, or when the workspace is also used for the
+ * caller's own temporaries.
+ *
+ * @param      ws    Pointer to user's workspace struct
+ *
+ * @return     0 on success, -1 on failure.
+ */
+int rc_workspace_reset(rc_workspace_t* ws);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RC_WORKSPACE_H
+
+/** @} end group Workspace */
@@ -12,12 +12,12 @@
 #include <stdlib.h> // for malloc,calloc,free
 #include <math.h>   // for sqrt, pow, etc
 #include <string.h> // for memcpy
-#include <alloca.h> // for alloca
 
 #include <rc_math/vector.h>
 #include <rc_math/matrix.h>
 #include <rc_math/algebra.h>
 #include "algebra_common.h"
+#include "precision.h"
 
 
 #define DEFAULT_ZERO_TOLERANCE 1e-8 // consider v to be zero if fabs(v)<ZERO_TOLERANCE
@@ -26,206 +26,88 @@
 double zero_tolerance=DEFAULT_ZERO_TOLERANCE;
 
 
-// used by QR decomposition
-static int __householder_reflection(int step, rc_matrix_t* Q, rc_matrix_t* R)
-{
-    int i,j,k;
-    double norm, tau, taui, dot;
-    int n = R->rows-step;
-    int Rrows = R->rows;
-    // p is the index of A defining the top left corner of the operation
-    // p=q=0 if x is same size as A',
-    int p=R->rows-n;
-    // x will hold each column of R from diag down at each step
-    double x[n];
-    // H will be the ever-shrinking householder matrix
-    //NEW_STACK_MATRIX(H,R->rows-step,R->rows-step);
-    double H[n][n];
-    // tmp is a duplicate of the the subset of A to be operated on when
-    // left-multiplying R
-    double tmp[R->cols-p][R->rows-p];
-    // duplicate pf the subset of Q to be operated on when right-multiplying R
-    double tmp2[Q->rows][n];
-    // allocate memory for a column of tmp2
-    double col[n];
-    // q is the number of columns of Q left untouched because H is smaller
-    int q = Q->cols-n;
-
-
-    ////////////////////////////////////////////////////////////////////////
-    // get the ever-shrinking householder reflection for that column
-    ////////////////////////////////////////////////////////////////////////
-
-    // take col of R from diag down
-    for(j=step;j<Rrows;j++) x[j-step]=R->d[j][step];
-
-    // find norm of x
-    norm = 0.0;
-    for(i=0;i<n;i++) norm += x[i]*x[i];
-    norm=sqrt(norm);
-
-    // set sign of norm to opposite of the pivot to avoid loss of significance
-    if(x[0]>=0.0){
-        x[0]=(x[0]+norm);
-        norm = -norm;
-    }
-    else x[0]=(x[0]-norm);
-
-
-    // pre-calculate matrix multiplication coefficient tau
-    // doing this on one line causes a compiler optimization error :-/
-    dot = __vectorized_square_accumulate(x,n);
-    tau = -2.0/dot;
-
-    // fill in diagonal and upper triangle of H
-    for(i=0;i<n;i++){
-        taui = tau*x[i];
-        // H=I-(2/norm(x))vv' so add 1 on the diagonal
-        H[i][i] = 1.0 + taui*x[i];
-        for(j=i+1;j<n;j++){
-            H[i][j] = taui*x[j];
-        }
-    }
-
-    // copy to lower triangle
-    for(i=1;i<n;i++){
-        for(j=0;j<i;j++){
-            H[i][j] = H[j][i];
-        }
-    }
+// QR and the linear solvers are shared with the float API, see
+// single_precision.c
+#include "algebra_template.h"
 
-    ////////////////////////////////////////////////////////////////////////
-    // left multiply R
-    ////////////////////////////////////////////////////////////////////////
 
-    // Copy Section of R to be operated on
-    // store it in transpose form so memory access later is contiguous
-    for(i=0;i<R->rows-p;i++){
-        for(j=0;j<R->cols-p;j++){
-            tmp[j][i]=R->d[i+p][j+p];
-        }
-    }
-    // go through the rows of R starting from the first row that requires
-    // modifying. as H shrinks, only the lower rows need modifying
-    for(i=0;i<(R->rows-p);i++){
-        // we know first column of R will be mostly zeros, so fill in zeros
-        // or known norm where possible. we use p to
-        if(i==0)    R->d[i+p][p]=norm;
-        else        R->d[i+p][p]=0.0;
-        // do multiplication for the rest of the columns
-        // A has already been transposed so don't transpose each column
-        for(j=1;j<(R->cols-p);j++){
-            R->d[i+p][j+p]=__vectorized_mult_accumulate(H[i],tmp[j],n);
-        }
-    }
-
-    ////////////////////////////////////////////////////////////////////////
-    // right multiply Q by H
-    ////////////////////////////////////////////////////////////////////////
+size_t rc_algebra_workspace_size(int rows, int cols)
+{
+    size_t n, k, lup, qr, svd, mixed, ret;
+    if(rows<1) rows=1;
+    if(cols<1) cols=1;
+    n = (rows>cols) ? rows : cols;
+    k = (rows>cols) ? cols : rows;
+    // L, U, and the duplicate inside the LUP plus the pivot arrays
+    lup = WS_MATRIX_BYTES(n,n) + WS_VECTOR_BYTES(n) + __ws_round(n*sizeof(int));
+    qr  = __ws_round(QR_SCRATCH((size_t)rows,(size_t)cols)*sizeof(double));
+    // rows being orthogonalized, rotations, lengths, and order, see eigen.c
+    svd = WS_MATRIX_BYTES(k,n) + WS_MATRIX_BYTES(k,k) + WS_VECTOR_BYTES(k) + __ws_round(k*sizeof(int));
+    // float LU, correction, residual, and pivots of the mixed precision solve
+    mixed = __ws_round(n*sizeof(float*)) + __ws_round(n*n*sizeof(float)) + __ws_round(n*sizeof(float))
+            + WS_VECTOR_BYTES(n) + __ws_round(n*sizeof(int));
+    // everything else, including the in-place LU behind the inverse and the
+    // determinant and the symmetric eigensolver, needs less than one of these
+    ret = (lup>qr) ? lup : qr;
+    ret = (ret>svd) ? ret : svd;
+    return (ret>mixed) ? ret : mixed;
+}
 
-    // duplicate the subset of Q to be operated on
-    for(i=0;i<Q->rows;i++){
-        for(j=0;j<n;j++)    tmp2[i][j]=Q->d[i][j+q];
-    }
 
-    // do the multiplication, overwriting A left q columns of A remain untouched
-    for(j=0;j<(Q->cols-q);j++){
-        // put column of x in sequential memory slot
-        for(k=0;k<n;k++) col[k]=H[k][j];
-        // now go down the i'th column of A
-        // H is hermetian so don't bother transposing its columns
-        for(i=0;i<Q->rows;i++){
-            Q->d[i][j+q]=__vectorized_mult_accumulate(tmp2[i],col,n);
-        }
+// largest magnitude of any element of the n x n matrix A
+static double __max_abs(rc_matrix_t A)
+{
+    int i,j;
+    double max = 0.0;
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) if(fabs(A.d[i][j])>max) max = fabs(A.d[i][j]);
     }
-
-    return 0;
+    return max;
 }
 
-int rc_algebra_qr_decomp(rc_matrix_t A, rc_matrix_t* Q, rc_matrix_t* R)
-{
-    int i,steps;
-
-    // Sanity Checks
-    if(unlikely(!A.initialized)){
-        fprintf(stderr,"ERROR in rc_algebra_qr_decomp, matrix not initialized yet\n");
-        return -1;
-    }
-    // start R as A
-    if(unlikely(rc_matrix_duplicate(A,R))){
-        fprintf(stderr,"ERROR in rc_algebra_qr_decomp, failed to duplicate A\n");
-        return -1;
-    }
-    // start R as square identity
-    rc_matrix_identity(Q,A.rows);
-    // find out how many householder reflections are necessary
-    if(A.rows==A.cols) steps=A.cols-1;  // square
-    else if(A.rows>A.cols) steps=A.cols;    // tall
-    else steps=A.rows-1;            // wide
 
-    // iterate through columns of A doing householder reflection to zero
-    // the entries below the diagonal
-    for(i=0;i<steps;i++){
-        if(__householder_reflection(i,Q,R)==-1) return -1;
+// A is singular to working precision when a pivot of its LU is negligible
+// next to the largest element of A itself
+static int __lu_singular(double* lu, int n, int ld, double amax)
+{
+    int i;
+    for(i=0;i<n;i++){
+        if(fabs(lu[(i*ld)+i]) <= zero_tolerance*amax) return 1;
     }
     return 0;
 }
 
-int rc_algebra_lup_decomp(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matrix_t* P)
+
+/*
+ * LUP decomposition of square A into already allocated m x m matrices L and U
+ * with the row permutation written to perm so that row i of P*A is row perm[i]
+ * of A. L and U are fully overwritten.
+ */
+static int __lup(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, int* perm, rc_workspace_t* ws)
 {
     int i,j,k,m,index,tmpint;
     double s1, s2;
-    int* ptmp;
-    void* rowtmp;
-    rc_matrix_t Adup = RC_MATRIX_INITIALIZER;
-    // sanity checks
-    if(unlikely(!A.initialized)){
-        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, matrix not initialized yet\n");
-        return -1;
-    }
-    if(unlikely(A.cols!=A.rows)){
-        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, matrix is not square\n");
-        return -1;
-    }
-    // allocate some memory!
+    double* rowtmp;
+    rc_matrix_t Adup;
+    size_t mark = ws->used;
+
     m = A.cols;
-    if(unlikely(rc_matrix_duplicate(A, &Adup))){
-        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, failed to duplicate A\n");
-        return -1;
-    }
-    if(unlikely(rc_matrix_identity(L,m))){
-        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, failed to allocate identity matrix\n");
-        rc_matrix_free(&Adup);
-        return -1;
-    }
-    if(unlikely(rc_matrix_alloc(U,m,m))){
-        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, failed to allocate U\n");
-        rc_matrix_free(&Adup);
-        rc_matrix_free(L);
-        return -1;
-    }
-    if(unlikely(rc_matrix_zeros(P,m,m))){
-        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, failed to allocate matrix of zeros\n");
-        rc_matrix_free(&Adup);
-        rc_matrix_free(L);
-        rc_matrix_free(U);
+    // duplicate A and take a row of A as tmp holder while pivoting
+    if(unlikely(__ws_matrix(ws,&Adup,m,m))){
+        ws->used = mark;
         return -1;
     }
-    // represent P as an array of positions 0 through (m-1) for fast pivoting
-    // also alloc memory for a row of A as tmp holder while pivoting
-    ptmp = alloca(m*sizeof(int));
-    rowtmp = alloca(m*sizeof(double));
-    if(unlikely(ptmp==NULL || rowtmp==NULL)){
-        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, alloca failed, stack overflow\n");
-        rc_matrix_free(&Adup);
-        rc_matrix_free(L);
-        rc_matrix_free(U);
-        rc_matrix_free(P);
+    rowtmp = __ws_push(ws, m*sizeof(double));
+    if(unlikely(rowtmp==NULL)){
+        ws->used = mark;
         return -1;
     }
-    // make ptmp where each value contains the column position of the 1 in it's
+    for(i=0;i<m;i++) memcpy(Adup.d[i],A.d[i],m*sizeof(double));
+    __set_identity(L);
+    memset(U->d[0], 0, (size_t)m*U->stride*sizeof(double));
+    // make perm where each value contains the column position of the 1 in it's
     // initial identity matrix form
-    for(i=0;i<m;i++) ptmp[i]=i;
+    for(i=0;i<m;i++) perm[i]=i;
     // now do the pivoting
     for(i=0;i<m-1;i++){
         index = i;
@@ -233,18 +115,16 @@ int rc_algebra_lup_decomp(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matr
             if(fabs(A.d[j][i])>=fabs(A.d[index][i]))    index=j;
         }
         if(index!=i){
-            // swap rows in ptmp
-            tmpint = ptmp[index];
-            ptmp[index]=ptmp[i];
-            ptmp[i]=tmpint;
+            // swap rows in perm
+            tmpint = perm[index];
+            perm[index]=perm[i];
+            perm[i]=tmpint;
             // swap rows of A
             memcpy(rowtmp,Adup.d[index],m*sizeof(double));
             memcpy(Adup.d[index],Adup.d[i],m*sizeof(double));
             memcpy(Adup.d[i],rowtmp,m*sizeof(double));
         }
     }
-    // construct P from ptmp
-    for(i=0;i<m;i++) P->d[i][ptmp[i]]=1.0;
     // now do normal LU
     for(i=0;i<m;i++){
         for(j=0;j<m;j++){
@@ -256,18 +136,84 @@ int rc_algebra_lup_decomp(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matr
             if(i>=j) L->d[i][j] = (Adup.d[i][j]-s2)/U->d[j][j];
         }
     }
-    rc_matrix_free(&Adup);
+    ws->used = mark;
+    return 0;
+}
+
+
+int rc_algebra_lup_decomp(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matrix_t* P)
+{
+    int ret;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(rc_workspace_alloc(&ws, rc_algebra_workspace_size(A.rows,A.cols)))){
+        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, failed to allocate workspace\n");
+        return -1;
+    }
+    ret = rc_algebra_lup_decomp_ws(A,L,U,P,&ws);
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+int rc_algebra_lup_decomp_ws(rc_matrix_t A, rc_matrix_t* L, rc_matrix_t* U, rc_matrix_t* P, rc_workspace_t* ws)
+{
+    int i,m;
+    int* perm;
+    size_t mark;
+    // sanity checks
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, matrix not initialized yet\n");
+        return -1;
+    }
+    if(unlikely(A.cols!=A.rows)){
+        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, matrix is not square\n");
+        return -1;
+    }
+    if(unlikely(ws==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, received NULL workspace\n");
+        return -1;
+    }
+    // outputs are only reallocated if they are the wrong size
+    m = A.cols;
+    if(unlikely(rc_matrix_alloc(L,m,m) || rc_matrix_alloc(U,m,m) || rc_matrix_alloc(P,m,m))){
+        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, failed to allocate output\n");
+        return -1;
+    }
+    mark = ws->used;
+    perm = __ws_push(ws, m*sizeof(int));
+    if(unlikely(perm==NULL || __lup(A,L,U,perm,ws))){
+        fprintf(stderr,"ERROR in rc_algebra_lup_decomp, workspace too small\n");
+        ws->used = mark;
+        return -1;
+    }
+    // construct P from perm
+    memset(P->d[0], 0, (size_t)m*P->stride*sizeof(double));
+    for(i=0;i<m;i++) P->d[i][perm[i]]=1.0;
+    ws->used = mark;
     return 0;
 }
 
+
 int rc_algebra_invert_matrix(rc_matrix_t A, rc_matrix_t* Ainv)
 {
-    int i,j,k;
-    rc_matrix_t L = RC_MATRIX_INITIALIZER;
-    rc_matrix_t U = RC_MATRIX_INITIALIZER;
-    rc_matrix_t P = RC_MATRIX_INITIALIZER;
-    rc_matrix_t D = RC_MATRIX_INITIALIZER;
-    rc_matrix_t tmp = RC_MATRIX_INITIALIZER;
+    int ret;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(rc_workspace_alloc(&ws, rc_algebra_workspace_size(A.rows,A.cols)))){
+        fprintf(stderr,"ERROR in rc_matrix_inverse, failed to allocate workspace\n");
+        return -1;
+    }
+    ret = rc_algebra_invert_matrix_ws(A,Ainv,&ws);
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+int rc_algebra_invert_matrix_ws(rc_matrix_t A, rc_matrix_t* Ainv, rc_workspace_t* ws)
+{
+    int i,n,sign;
+    int* ipiv;
+    size_t mark;
+    rc_matrix_t LU;
     // sanity checks
     if(unlikely(!A.initialized)){
         fprintf(stderr,"ERROR in rc_matrix_inverse, matrix uninitialized\n");
@@ -277,58 +223,46 @@ int rc_algebra_invert_matrix(rc_matrix_t A, rc_matrix_t* Ainv)
         fprintf(stderr,"ERROR in rc_matrix_inverse, nonsquare matrix\n");
         return -1;
     }
-    if(fabs(rc_matrix_determinant(A)) < zero_tolerance){
-        fprintf(stderr,"ERROR in rc_matrix_inverse, matrix is singular\n");
+    if(unlikely(ws==NULL)){
+        fprintf(stderr,"ERROR in rc_matrix_inverse, received NULL workspace\n");
         return -1;
     }
-    // allocate memory
-    if(unlikely(rc_matrix_identity(&D,A.cols))){
-        fprintf(stderr,"ERROR in rc_matrix_inverse, failed to alloc identity\n");
+    // factor a copy of A in the workspace, before touching Ainv in case it
+    // is A itself
+    mark = ws->used;
+    n = A.cols;
+    ipiv = __ws_push(ws, n*sizeof(int));
+    if(unlikely(ipiv==NULL || __ws_matrix(ws,&LU,n,n))){
+        fprintf(stderr,"ERROR in rc_matrix_inverse, workspace too small\n");
+        ws->used = mark;
         return -1;
     }
-    if(unlikely(rc_matrix_alloc(&tmp,A.rows,A.rows))){
-        fprintf(stderr,"ERROR in rc_matrix_inverse, failed to alloc matrix\n");
-        rc_matrix_free(&D);
+    for(i=0;i<n;i++) memcpy(LU.d[i],A.d[i],n*sizeof(double));
+    if(unlikely(__lu_inplace(LU.d[0], n, LU.stride, ipiv, &sign))){
+        fprintf(stderr,"ERROR in rc_matrix_inverse, failed to LU decomp\n");
+        ws->used = mark;
         return -1;
     }
-    // do LUP
-    if(unlikely(rc_algebra_lup_decomp(A,&L,&U,&P))){
-        fprintf(stderr,"ERROR in rc_matrix_inverse, failed to LUP decomp\n");
-        rc_matrix_free(&D);
-        rc_matrix_free(&tmp);
+    if(__lu_singular(LU.d[0], n, LU.stride, __max_abs(A))){
+        fprintf(stderr,"ERROR in rc_matrix_inverse, matrix is singular\n");
+        ws->used = mark;
         return -1;
     }
-    // solve for Inv
-    for(j=0;j<A.cols;j++){
-        for(i=0;i<A.cols;i++){
-            for(k=0;k<i;k++){
-                D.d[i][j] -= L.d[i][k] * D.d[k][j];
-            }
-        }
-        // backwards.. last to first
-        for(i=A.cols-1;i>=0;i--){
-            tmp.d[i][j] = D.d[i][j];
-            for(k=i+1;k<A.cols;k++){
-                tmp.d[i][j] -= U.d[i][k] * tmp.d[k][j];
-            }
-            tmp.d[i][j] = tmp.d[i][j] / U.d[i][i];
-        }
+    if(unlikely(rc_matrix_alloc(Ainv,n,n))){
+        fprintf(stderr,"ERROR in rc_matrix_inverse, failed to alloc matrix\n");
+        ws->used = mark;
+        return -1;
     }
-    // free up some memory
-    rc_matrix_free(&L);
-    rc_matrix_free(&U);
-    rc_matrix_free(&D);
-    // use i as new return value
-    i=0;
-    // multiply by permutation matrix
-    if(unlikely(rc_matrix_multiply(tmp, P, Ainv))){
-        fprintf(stderr,"ERROR in rc_matrix_inverse, failed to multiply matrix\n");
-        i=-1;
+    // solve A*X = I for all n columns of I at once
+    memset(Ainv->d[0], 0, (size_t)n*Ainv->stride*sizeof(double));
+    for(i=0;i<n;i++) Ainv->d[i][i] = 1.0;
+    if(unlikely(__lu_apply(LU.d[0], n, LU.stride, ipiv, Ainv->d[0], n, Ainv->stride))){
+        fprintf(stderr,"ERROR in rc_matrix_inverse, triangular solve failed\n");
+        ws->used = mark;
+        return -1;
     }
-    // free allocation
-    rc_matrix_free(&tmp);
-    rc_matrix_free(&P);
-    return i;
+    ws->used = mark;
+    return 0;
 }
 
 
@@ -346,154 +280,723 @@ int rc_algebra_invert_matrix_inplace(rc_matrix_t* A)
 }
 
 
-int rc_algebra_lin_system_solve(rc_matrix_t A, rc_vector_t b, rc_vector_t* x)
+rc_lu_t rc_lu_empty(void)
+{
+    rc_lu_t out = RC_LU_INITIALIZER;
+    return out;
+}
+
+
+int rc_lu_free(rc_lu_t* lu)
+{
+    rc_lu_t new = RC_LU_INITIALIZER;
+    if(unlikely(lu==NULL)){
+        fprintf(stderr,"ERROR in rc_lu_free, received NULL pointer\n");
+        return -1;
+    }
+    if(lu->initialized){
+        rc_matrix_free(&lu->LU);
+        free(lu->piv);
+        free(lu->work);
+    }
+    *lu = new;
+    return 0;
+}
+
+
+int rc_lu_factor(rc_matrix_t A, rc_lu_t* lu)
+{
+    int i,j,n;
+    double amax;
+    // sanity checks
+    if(unlikely(lu==NULL)){
+        fprintf(stderr,"ERROR in rc_lu_factor, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_lu_factor, matrix not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=A.cols)){
+        fprintf(stderr,"ERROR in rc_lu_factor, matrix is not square\n");
+        return -1;
+    }
+    // storage is kept between factorizations of the same size
+    n = A.rows;
+    if(!lu->initialized || lu->n!=n){
+        rc_lu_free(lu);
+        lu->piv = (int*)malloc(n*sizeof(int));
+        lu->work = (double*)malloc(n*sizeof(double));
+        if(unlikely(lu->piv==NULL || lu->work==NULL || rc_matrix_alloc(&lu->LU,n,n))){
+            fprintf(stderr,"ERROR in rc_lu_factor, failed to allocate memory\n");
+            free(lu->piv);
+            free(lu->work);
+            rc_matrix_free(&lu->LU);
+            *lu = rc_lu_empty();
+            return -1;
+        }
+        lu->n = n;
+        lu->initialized = 1;
+    }
+    // copy A in, finding its 1-norm for the condition estimate on the way
+    memset(lu->work, 0, n*sizeof(double));
+    for(i=0;i<n;i++){
+        memcpy(lu->LU.d[i],A.d[i],n*sizeof(double));
+        for(j=0;j<n;j++) lu->work[j] += fabs(A.d[i][j]);
+    }
+    lu->anorm = 0.0;
+    for(j=0;j<n;j++) if(lu->work[j]>lu->anorm) lu->anorm = lu->work[j];
+    amax = __max_abs(A);
+    if(unlikely(__lu_inplace(lu->LU.d[0], n, lu->LU.stride, lu->piv, &lu->sign))){
+        fprintf(stderr,"ERROR in rc_lu_factor, failed to LU decomp\n");
+        return -1;
+    }
+    lu->singular = __lu_singular(lu->LU.d[0], n, lu->LU.stride, amax);
+    return 0;
+}
+
+
+double rc_lu_determinant(rc_lu_t lu)
+{
+    int i;
+    double det;
+    if(unlikely(!lu.initialized)){
+        fprintf(stderr,"ERROR in rc_lu_determinant, factorization not initialized\n");
+        return -1.0;
+    }
+    det = (double)lu.sign;
+    for(i=0;i<lu.n;i++) det *= lu.LU.d[i][i];
+    return det;
+}
+
+
+double rc_lu_log_determinant(rc_lu_t lu, int* sign)
+{
+    int i;
+    double logdet = 0.0;
+    if(unlikely(!lu.initialized || sign==NULL)){
+        fprintf(stderr,"ERROR in rc_lu_log_determinant, factorization not initialized or NULL sign\n");
+        return NAN;
+    }
+    *sign = lu.sign;
+    for(i=0;i<lu.n;i++){
+        if(lu.LU.d[i][i]==0.0){
+            *sign = 0;
+            return -INFINITY;
+        }
+        if(lu.LU.d[i][i]<0.0) *sign = -*sign;
+        logdet += log(fabs(lu.LU.d[i][i]));
+    }
+    return logdet;
+}
+
+
+// overwrites x with inv(A)^T*x, the transposed counterpart of __lu_apply
+static void __lu_apply_trans(rc_lu_t lu, double* x)
+{
+    int i;
+    double tmp;
+    // U^T is lower triangular, go forward a row of U at a time
+    for(i=0;i<lu.n;i++){
+        x[i] /= lu.LU.d[i][i];
+        __vectorized_axpy(-x[i], &lu.LU.d[i][i+1], &x[i+1], lu.n-i-1);
+    }
+    // L^T is unit upper triangular, go backward a row of L at a time
+    for(i=lu.n-1;i>0;i--) __vectorized_axpy(-x[i], lu.LU.d[i], x, i);
+    // undo the row swaps in reverse order
+    for(i=lu.n-1;i>=0;i--){
+        tmp = x[i];
+        x[i] = x[lu.piv[i]];
+        x[lu.piv[i]] = tmp;
+    }
+    return;
+}
+
+
+/*
+ * Hager's estimate of the 1-norm of inv(A) as refined by Higham: a few steps
+ * of gradient ascent on |inv(A)*x|_1 over the unit 1-norm ball, each costing
+ * one solve with A and one with A^T, followed by one extra solve with an
+ * alternating test vector that catches the cases where the ascent stalls.
+ */
+double rc_lu_condition(rc_lu_t lu)
+{
+    int i,j,it,jlast,n;
+    double est, e, *x;
+    if(unlikely(!lu.initialized)){
+        fprintf(stderr,"ERROR in rc_lu_condition, factorization not initialized\n");
+        return -1.0;
+    }
+    if(lu.singular) return INFINITY;
+    n = lu.n;
+    x = lu.work;
+    for(i=0;i<n;i++) x[i] = 1.0/n;
+    est = 0.0;
+    jlast = -1;
+    for(it=0;it<5;it++){
+        if(unlikely(__lu_apply(lu.LU.d[0], n, lu.LU.stride, lu.piv, x, 1, 1))) return -1.0;
+        e = 0.0;
+        for(i=0;i<n;i++) e += fabs(x[i]);
+        if(it>0 && e<=est) break;
+        est = e;
+        for(i=0;i<n;i++) x[i] = (x[i]>=0.0) ? 1.0 : -1.0;
+        __lu_apply_trans(lu, x);
+        j = 0;
+        for(i=1;i<n;i++) if(fabs(x[i])>fabs(x[j])) j = i;
+        if(j==jlast) break;
+        jlast = j;
+        memset(x, 0, n*sizeof(double));
+        x[j] = 1.0;
+    }
+    for(i=0;i<n;i++) x[i] = ((i%2) ? -1.0 : 1.0) * (1.0 + (n>1 ? (double)i/(n-1) : 0.0));
+    if(unlikely(__lu_apply(lu.LU.d[0], n, lu.LU.stride, lu.piv, x, 1, 1))) return -1.0;
+    e = 0.0;
+    for(i=0;i<n;i++) e += fabs(x[i]);
+    e = 2.0*e/(3.0*n);
+    if(e>est) est = e;
+    return lu.anorm*est;
+}
+
+
+// shared checks for the solves and the inverse
+static int __lu_check(rc_lu_t lu, int rows, const char* name)
+{
+    if(unlikely(!lu.initialized)){
+        fprintf(stderr,"ERROR in %s, factorization not initialized\n", name);
+        return -1;
+    }
+    if(unlikely(rows!=lu.n)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", name);
+        return -1;
+    }
+    if(unlikely(lu.singular)){
+        fprintf(stderr,"ERROR in %s, matrix is singular\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+
+int rc_lu_solve(rc_lu_t lu, rc_vector_t b, rc_vector_t* x)
+{
+    if(unlikely(!b.initialized || x==NULL)){
+        fprintf(stderr,"ERROR in rc_lu_solve, vector not initialized or NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(__lu_check(lu, b.len, "rc_lu_solve"))) return -1;
+    // nothing to copy when solving in place
+    if(x->d!=b.d && unlikely(rc_vector_duplicate(b,x))){
+        fprintf(stderr,"ERROR in rc_lu_solve, failed to allocate x\n");
+        return -1;
+    }
+    if(unlikely(__lu_apply(lu.LU.d[0], lu.n, lu.LU.stride, lu.piv, x->d, 1, 1))){
+        fprintf(stderr,"ERROR in rc_lu_solve, triangular solve failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+int rc_lu_solve_matrix(rc_lu_t lu, rc_matrix_t B, rc_matrix_t* X)
+{
+    if(unlikely(!B.initialized || X==NULL)){
+        fprintf(stderr,"ERROR in rc_lu_solve_matrix, matrix not initialized or NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(__lu_check(lu, B.rows, "rc_lu_solve_matrix"))) return -1;
+    if(unlikely(rc_matrix_duplicate(B,X))){
+        fprintf(stderr,"ERROR in rc_lu_solve_matrix, failed to allocate X\n");
+        return -1;
+    }
+    if(unlikely(__lu_apply(lu.LU.d[0], lu.n, lu.LU.stride, lu.piv, X->d[0], B.cols, X->stride))){
+        fprintf(stderr,"ERROR in rc_lu_solve_matrix, triangular solve failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+int rc_lu_inverse(rc_lu_t lu, rc_matrix_t* Ainv)
+{
+    if(unlikely(Ainv==NULL)){
+        fprintf(stderr,"ERROR in rc_lu_inverse, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(__lu_check(lu, lu.n, "rc_lu_inverse"))) return -1;
+    if(unlikely(rc_matrix_identity(Ainv, lu.n))){
+        fprintf(stderr,"ERROR in rc_lu_inverse, failed to allocate Ainv\n");
+        return -1;
+    }
+    if(unlikely(__lu_apply(lu.LU.d[0], lu.n, lu.LU.stride, lu.piv, Ainv->d[0], lu.n, Ainv->stride))){
+        fprintf(stderr,"ERROR in rc_lu_inverse, triangular solve failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+// most refinement steps before giving up on float, the same limit as LAPACK's
+// dsgesv uses
+#define MIXED_MAX_ITER  30
+
+// refinement has stalled once a step shrinks the residual by less than this
+#define MIXED_STALL     0.5
+
+
+// r = b - A*x in double, returns the infinity norm of r
+static double __residual_inf(rc_matrix_t A, rc_vector_t b, double* x, double* r)
 {
-    /*Thank you to Henry Guennadi Levkin for open sourcing this routine, it's
-    * adapted here and includes better detection of unsolvable systems.
-    */
-    double fMaxElem, fAcc;
-    int nDim,i,j,k,m;
-    rc_matrix_t Atemp = RC_MATRIX_INITIALIZER;
-    rc_vector_t btemp = RC_VECTOR_INITIALIZER;
+    int i;
+    double rnorm = 0.0;
+    for(i=0;i<A.rows;i++){
+        r[i] = b.d[i] - __vectorized_mult_accumulate(A.d[i], x, A.cols);
+        if(fabs(r[i])>rnorm) rnorm = fabs(r[i]);
+    }
+    return rnorm;
+}
+
+
+int rc_algebra_lin_system_solve_mixed(rc_matrix_t A, rc_vector_t b, rc_vector_t* x, rc_mixed_info_t* info)
+{
+    int ret;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed, matrix not initialized yet\n");
+        return -1;
+    }
+    if(unlikely(rc_workspace_alloc(&ws, rc_algebra_workspace_size(A.rows,A.cols)))){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed, failed to allocate workspace\n");
+        return -1;
+    }
+    ret = rc_algebra_lin_system_solve_mixed_ws(A,b,x,info,&ws);
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+int rc_algebra_lin_system_solve_mixed_ws(rc_matrix_t A, rc_vector_t b, rc_vector_t* x,
+                                rc_mixed_info_t* info, rc_workspace_t* ws)
+{
+    int i,j,n,it,sign,fallback;
+    int* ipiv;
+    size_t mark;
+    double anorm, amax, rnorm, rprev, xnorm;
+    rc_matrixf_t LU = RC_MATRIXF_INITIALIZER;
+    rc_vectorf_t c = RC_VECTORF_INITIALIZER;
+    rc_matrix_t LUd = RC_MATRIX_INITIALIZER;
+    rc_vector_t r = RC_VECTOR_INITIALIZER;
+
     // sanity checks
-    if(!A.initialized || !b.initialized){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve, matrix or vector uninitialized\n");
+    if(unlikely(!A.initialized || !b.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, matrix or vector not initialized yet\n");
         return -1;
     }
-    if(A.cols != b.len){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve, dimension mismatch\n");
+    if(unlikely(A.rows!=A.cols || A.cols!=b.len)){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, dimension mismatch\n");
         return -1;
     }
-    // alloc memory for x
-    nDim = A.cols;
-    if(unlikely(rc_vector_alloc(x,nDim))){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve, failed to alloc vector\n");
+    if(unlikely(x==NULL || ws==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, received NULL pointer\n");
         return -1;
     }
-    // duplicate user arguments so we don't have to modify them
-    if(unlikely(rc_matrix_duplicate(A, &Atemp))){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve, failed to duplicate matrix\n");
-        rc_vector_free(x);
+    if(unlikely(x->initialized && x->d==b.d)){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, x must not be b\n");
         return -1;
     }
-    if(unlikely(rc_vector_duplicate(b, &btemp))){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve, failed to duplicate vector\n");
-        rc_vector_free(x);
-        rc_matrix_free(&Atemp);
+    n = A.rows;
+    if(unlikely(rc_vector_alloc(x,n))){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, failed to alloc vector\n");
         return -1;
     }
-    // gaussian elemination
-    for(k=0;k<(nDim-1);k++){ // base row of matrix
-        // search of line with max element
-        fMaxElem=fabs(Atemp.d[k][k]);
-        m=k;
-        for(i=k+1;i<nDim;i++){
-            if(fMaxElem<fabs(Atemp.d[i][k])){
-                fMaxElem=Atemp.d[i][k];
-                m=i;
-            }
+    mark = ws->used;
+    ipiv = NULL;
+    if(unlikely(__ws_matrixf(ws,&LU,n,n) || __ws_vectorf(ws,&c,n) || __ws_vector(ws,&r,n) ||
+                (ipiv = __ws_push(ws,n*sizeof(int)))==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, workspace too small\n");
+        ws->used = mark;
+        return -1;
+    }
+
+    anorm = 0.0;
+    for(i=0;i<n;i++){
+        rnorm = 0.0;
+        for(j=0;j<n;j++) rnorm += fabs(A.d[i][j]);
+        if(rnorm>anorm) anorm = rnorm;
+    }
+    amax = __max_abs(A);
+    it = 0;
+    fallback = 1;
+    rnorm = xnorm = 0.0;
+
+    // factor in float unless A overflows it, a pivot lost to float rounding
+    // means the factors are no use for refinement either
+    if(amax<=(double)FLT_MAX){
+        for(i=0;i<n;i++){
+            for(j=0;j<n;j++) LU.d[i][j] = (float)A.d[i][j];
+        }
+        if(unlikely(__lu_inplacef(LU.d[0], n, LU.stride, ipiv, &sign))){
+            fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, failed to LU decomp\n");
+            ws->used = mark;
+            return -1;
+        }
+        fallback = 0;
+        for(i=0;i<n;i++){
+            if(!((double)fabsf(LU.d[i][i])>(double)FLT_EPSILON*amax)) fallback = 1;
         }
-        // permutation of base line (index k) and max element line(index m)
-        if(m!=k){
-            for(i=k;i<nDim;i++){
-                fAcc=Atemp.d[k][i];
-                Atemp.d[k][i]=Atemp.d[m][i];
-                Atemp.d[m][i]=fAcc;
+    }
+
+    // x starts at 0 so the first pass is the plain float solve, then each
+    // pass solves for the correction to x from the double residual
+    if(!fallback){
+        memset(x->d, 0, n*sizeof(double));
+        memcpy(r.d, b.d, n*sizeof(double));
+        rprev = HUGE_VAL;
+        for(;;){
+            for(i=0;i<n;i++) c.d[i] = (float)r.d[i];
+            if(unlikely(__lu_applyf(LU.d[0], n, LU.stride, ipiv, c.d, 1, 1))){
+                fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, triangular solve failed\n");
+                ws->used = mark;
+                return -1;
             }
-            fAcc=btemp.d[k];
-            btemp.d[k]=btemp.d[m];
-            btemp.d[m]=fAcc;
+            xnorm = 0.0;
+            for(i=0;i<n;i++){
+                x->d[i] += (double)c.d[i];
+                if(fabs(x->d[i])>xnorm) xnorm = fabs(x->d[i]);
+            }
+            rnorm = __residual_inf(A, b, x->d, r.d);
+            if(rnorm<=xnorm*anorm*DBL_EPSILON*sqrt((double)n)) break;
+            if(it==MIXED_MAX_ITER || !(rnorm<=MIXED_STALL*rprev)){
+                fallback = 1;
+                break;
+            }
+            rprev = rnorm;
+            it++;
         }
-        // check if we got 0 on the diagonal indicating matrix isn't full rank
-        if(unlikely(fabs(Atemp.d[k][k])<zero_tolerance)){
-            fprintf(stderr,"ERROR in rc_algebra_lin_system_solve, matrix not full rank\n");
-            rc_matrix_free(&Atemp);
-            rc_vector_free(&btemp);
-            rc_vector_free(x);
+    }
+
+    // start over in double, reusing the workspace the float solve had
+    if(fallback){
+        ws->used = mark;
+        if(unlikely(__ws_matrix(ws,&LUd,n,n) || __ws_vector(ws,&r,n) ||
+                    (ipiv = __ws_push(ws,n*sizeof(int)))==NULL)){
+            fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, workspace too small\n");
+            ws->used = mark;
+            return -1;
+        }
+        for(i=0;i<n;i++) memcpy(LUd.d[i], A.d[i], n*sizeof(double));
+        if(unlikely(__lu_inplace(LUd.d[0], n, LUd.stride, ipiv, &sign))){
+            fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, failed to LU decomp\n");
+            ws->used = mark;
+            return -1;
+        }
+        if(unlikely(__lu_singular(LUd.d[0], n, LUd.stride, amax))){
+            fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, matrix is singular\n");
+            ws->used = mark;
+            return -1;
+        }
+        memcpy(x->d, b.d, n*sizeof(double));
+        if(unlikely(__lu_apply(LUd.d[0], n, LUd.stride, ipiv, x->d, 1, 1))){
+            fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_mixed_ws, triangular solve failed\n");
+            ws->used = mark;
             return -1;
         }
-        // triangulation of matrix with coefficients
-        for(j=(k+1);j<nDim;j++){ // current row of matrix
-            fAcc = -Atemp.d[j][k]/Atemp.d[k][k];
-            for(i=k;i<nDim;i++){
-                Atemp.d[j][i]=Atemp.d[j][i]+fAcc*Atemp.d[k][i];
+        xnorm = 0.0;
+        for(i=0;i<n;i++) if(fabs(x->d[i])>xnorm) xnorm = fabs(x->d[i]);
+        rnorm = __residual_inf(A, b, x->d, r.d);
+    }
+
+    if(info!=NULL){
+        info->iterations = it;
+        info->fallback = fallback;
+        info->residual = (anorm*xnorm>0.0) ? rnorm/(anorm*xnorm) : rnorm;
+    }
+    ws->used = mark;
+    return 0;
+}
+
+
+/*
+ * Blocked right-looking Cholesky A = L*L^T of the lower triangle of the n x n
+ * matrix in a, done in place. The factor is built as U = L^T in the upper
+ * triangle, whose rows are contiguous, so each panel of CHOL_BLOCK rows is
+ * factored with axpys along rows and the trailing matrix updated with one
+ * gemm that only forms its upper triangle. L is then mirrored back down and
+ * the upper triangle zeroed. Returns 1 if A is not positive definite, -1 if
+ * gemm failed, 0 otherwise.
+ */
+#define CHOL_BLOCK  64
+
+static int __chol_inplace(double* a, int n, int lda)
+{
+    int i,j,k,k0,nb,m2;
+    double d;
+    for(i=1;i<n;i++){
+        for(j=0;j<i;j++) a[(j*lda)+i] = a[(i*lda)+j];
+    }
+    for(k0=0;k0<n;k0+=CHOL_BLOCK){
+        nb = (n-k0<CHOL_BLOCK) ? n-k0 : CHOL_BLOCK;
+        for(k=k0;k<k0+nb;k++){
+            d = a[(k*lda)+k];
+            if(!(d>0.0)) return 1;
+            d = sqrt(d);
+            a[(k*lda)+k] = d;
+            __vectorized_scale(1.0/d, &a[(k*lda)+k+1], n-k-1);
+            for(i=k+1;i<k0+nb;i++){
+                __vectorized_axpy(-a[(k*lda)+i], &a[(k*lda)+i], &a[(i*lda)+i], n-i);
             }
-            // free member recalculation
-            btemp.d[j] = btemp.d[j] + (fAcc*btemp.d[k]);
         }
+        // A22 -= U12^T*U12
+        m2 = n-k0-nb;
+        if(m2>0 && unlikely(__gemm_upper(1, 0, m2, nb, -1.0, &a[(k0*lda)+k0+nb], lda,
+                        &a[(k0*lda)+k0+nb], lda, 1.0, &a[((k0+nb)*lda)+k0+nb], lda))) return -1;
     }
-    // now run up the upper diagonal matrix solving for x
-    for(k=nDim-1;k>=0;k--){
-        x->d[k]=btemp.d[k];
-        for(i=k+1;i<nDim;i++) x->d[k]-=Atemp.d[k][i]*x->d[i];
-        x->d[k]=x->d[k]/Atemp.d[k][k];
+    for(i=0;i<n;i++){
+        for(j=i+1;j<n;j++){
+            a[(j*lda)+i] = a[(i*lda)+j];
+            a[(i*lda)+j] = 0.0;
+        }
     }
-    // free memory
-    rc_matrix_free(&Atemp);
-    rc_vector_free(&btemp);
     return 0;
 }
 
-void rc_algebra_set_zero_tolerance(double tol){
-    zero_tolerance=tol;
-    return;
+
+/*
+ * Solves L^T*X = B in place in X for lower triangular L, the second half of a
+ * Cholesky solve. Rows of X are finished from the bottom up and each one is
+ * pushed into the rows above it along a row of L, so L is only ever read a
+ * row at a time. Blocks of rows already finished are pushed up with one gemm.
+ */
+static int __trsm_lower_trans(int n, int k, double* T, int ldt, double* X, int ldx)
+{
+    int i,p,i0,i1;
+    if(k==1 && ldx==1){
+        for(i=n-1;i>=0;i--){
+            X[i] /= T[(i*ldt)+i];
+            __vectorized_axpy(-X[i], &T[i*ldt], X, i);
+        }
+        return 0;
+    }
+    for(i1=n;i1>0;i1-=TRSM_BLOCK){
+        i0 = (i1>TRSM_BLOCK) ? i1-TRSM_BLOCK : 0;
+        for(i=i1-1;i>=i0;i--){
+            __vectorized_scale(1.0/T[(i*ldt)+i], &X[i*ldx], k);
+            for(p=i0;p<i;p++) __vectorized_axpy(-T[(i*ldt)+p], &X[i*ldx], &X[p*ldx], k);
+        }
+        if(i0>0 && unlikely(__gemm(1, 0, i0, k, i1-i0, -1.0, &T[i0*ldt], ldt,
+                        &X[i0*ldx], ldx, 1.0, X, ldx))) return -1;
+    }
+    return 0;
+}
+
+
+int rc_algebra_cholesky_decomp(rc_matrix_t A, rc_matrix_t* L)
+{
+    if(unlikely(!A.initialized || L==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_decomp, matrix not initialized or NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_duplicate(A,L))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_decomp, failed to allocate L\n");
+        return -1;
+    }
+    return rc_algebra_cholesky_decomp_inplace(L);
+}
+
+
+int rc_algebra_cholesky_decomp_inplace(rc_matrix_t* A)
+{
+    int ret;
+    // sanity checks
+    if(unlikely(A==NULL || !A->initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_decomp, matrix not initialized or NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(A->rows!=A->cols)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_decomp, matrix is not square\n");
+        return -1;
+    }
+    ret = __chol_inplace(A->d[0], A->rows, A->stride);
+    if(unlikely(ret>0)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_decomp, matrix is not positive definite\n");
+        return -1;
+    }
+    if(unlikely(ret<0)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_decomp, gemm failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+// shared checks for functions taking a Cholesky factor
+static int __chol_check(rc_matrix_t L, int rows, const char* name)
+{
+    int i;
+    if(unlikely(!L.initialized)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", name);
+        return -1;
+    }
+    if(unlikely(L.rows!=L.cols || rows!=L.rows)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", name);
+        return -1;
+    }
+    for(i=0;i<L.rows;i++){
+        if(unlikely(!(L.d[i][i]>0.0))){
+            fprintf(stderr,"ERROR in %s, L is not a Cholesky factor\n", name);
+            return -1;
+        }
+    }
+    return 0;
 }
 
-int rc_algebra_lin_system_solve_qr(rc_matrix_t A, rc_vector_t b, rc_vector_t* x)
+
+/*
+ * L*L^T + sign*x*x^T with one sweep of plane rotations, circular to update
+ * and hyperbolic to downdate, that fold x into L a column at a time. x is
+ * used as scratch.
+ */
+static void __chol_rank1(rc_matrix_t* L, double* x, double sign)
 {
     int i,k;
-    rc_vector_t temp = RC_VECTOR_INITIALIZER;
-    rc_matrix_t Q = RC_MATRIX_INITIALIZER;
-    rc_matrix_t R = RC_MATRIX_INITIALIZER;
-    if(unlikely(!A.initialized || !b.initialized)){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_qr, matrix or vector uninitialized\n");
+    double r,c,s;
+    for(k=0;k<L->rows;k++){
+        r = sqrt((L->d[k][k]*L->d[k][k]) + (sign*x[k]*x[k]));
+        c = r/L->d[k][k];
+        s = x[k]/L->d[k][k];
+        L->d[k][k] = r;
+        for(i=k+1;i<L->rows;i++){
+            L->d[i][k] = (L->d[i][k] + (sign*s*x[i]))/c;
+            x[i] = (c*x[i]) - (s*L->d[i][k]);
+        }
+    }
+    return;
+}
+
+
+int rc_algebra_cholesky_update(rc_matrix_t* L, rc_vector_t x)
+{
+    rc_vector_t tmp = RC_VECTOR_INITIALIZER;
+    if(unlikely(L==NULL || !x.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_update, received NULL pointer or uninitialized vector\n");
+        return -1;
+    }
+    if(unlikely(__chol_check(*L, x.len, "rc_algebra_cholesky_update"))) return -1;
+    if(unlikely(rc_vector_duplicate(x,&tmp))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_update, failed to allocate memory\n");
+        return -1;
+    }
+    __chol_rank1(L, tmp.d, 1.0);
+    rc_vector_free(&tmp);
+    return 0;
+}
+
+
+int rc_algebra_cholesky_downdate(rc_matrix_t* L, rc_vector_t x)
+{
+    int i;
+    double norm = 0.0;
+    rc_vector_t tmp = RC_VECTOR_INITIALIZER;
+    if(unlikely(L==NULL || !x.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_downdate, received NULL pointer or uninitialized vector\n");
+        return -1;
+    }
+    if(unlikely(__chol_check(*L, x.len, "rc_algebra_cholesky_downdate"))) return -1;
+    // L*L^T - x*x^T stays positive definite only if |inv(L)*x| < 1, check
+    // that before touching L
+    if(unlikely(rc_vector_duplicate(x,&tmp))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_downdate, failed to allocate memory\n");
+        return -1;
+    }
+    __trsm_lower(L->rows, 1, L->d[0], L->stride, tmp.d, 1, 0);
+    for(i=0;i<tmp.len;i++) norm += tmp.d[i]*tmp.d[i];
+    if(unlikely(norm>=1.0-zero_tolerance)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_downdate, result would not be positive definite\n");
+        rc_vector_free(&tmp);
+        return -1;
+    }
+    memcpy(tmp.d, x.d, x.len*sizeof(double));
+    __chol_rank1(L, tmp.d, -1.0);
+    rc_vector_free(&tmp);
+    return 0;
+}
+
+
+int rc_algebra_cholesky_solve(rc_matrix_t L, rc_vector_t b, rc_vector_t* x)
+{
+    if(unlikely(!b.initialized || x==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_solve, vector not initialized or NULL pointer\n");
         return -1;
     }
-    // do QR decomposition
-    if(unlikely(rc_algebra_qr_decomp(A,&Q,&R))){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_qr, failed to perform QR decomp\n");
+    if(unlikely(__chol_check(L, b.len, "rc_algebra_cholesky_solve"))) return -1;
+    // nothing to copy when solving in place
+    if(x->d!=b.d && unlikely(rc_vector_duplicate(b,x))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_solve, failed to allocate x\n");
+        return -1;
+    }
+    __trsm_lower(L.rows, 1, L.d[0], L.stride, x->d, 1, 0);
+    __trsm_lower_trans(L.rows, 1, L.d[0], L.stride, x->d, 1);
+    return 0;
+}
+
+
+int rc_algebra_cholesky_solve_matrix(rc_matrix_t L, rc_matrix_t B, rc_matrix_t* X)
+{
+    if(unlikely(!B.initialized || X==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_solve_matrix, matrix not initialized or NULL pointer\n");
         return -1;
     }
-    // Ax=b
-    // QRx=b
-    // Rx=Q'b   because Q'Q=I
-    // RX=(b'Q)'    to avoid transposing q
-    // multiply through right hand side. No difference between row and col
-    // vector so avoid transposing Q by left instead of right multiplying
-    if(unlikely(rc_matrix_row_vec_times_matrix(b,Q,&temp))){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_qr, failed to multiply vec by matrix\n");
-        rc_matrix_free(&Q);
-        rc_matrix_free(&R);
+    if(unlikely(__chol_check(L, B.rows, "rc_algebra_cholesky_solve_matrix"))) return -1;
+    if(unlikely(X->initialized && X->d[0]==L.d[0])){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_solve_matrix, X must not be L\n");
         return -1;
     }
-    // allocate memory for the output x
-    if(unlikely(rc_vector_alloc(x,R.cols))){
-        fprintf(stderr,"ERROR in rc_algebra_lin_system_solve_qr, failed to alloc vector\n");
-        rc_matrix_free(&Q);
-        rc_matrix_free(&R);
-        rc_vector_free(&temp);
+    if(unlikely(rc_matrix_duplicate(B,X))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_solve_matrix, failed to allocate X\n");
         return -1;
     }
-    // solve for x knowing R is upper triangular
-    for(k=R.cols-1;k>=0;k--){
-        x->d[k]=temp.d[k];
-        for(i=k+1;i<R.cols;i++) x->d[k]-=R.d[k][i]*x->d[i];
-        x->d[k] = x->d[k]/R.d[k][k];
+    if(unlikely(__trsm_lower(L.rows, B.cols, L.d[0], L.stride, X->d[0], X->stride, 0) ||
+                __trsm_lower_trans(L.rows, B.cols, L.d[0], L.stride, X->d[0], X->stride))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_solve_matrix, triangular solve failed\n");
+        return -1;
     }
-    // free memory and return
-    rc_matrix_free(&Q);
-    rc_matrix_free(&R);
-    rc_vector_free(&temp);
     return 0;
 }
 
 
+int rc_algebra_cholesky_inverse(rc_matrix_t L, rc_matrix_t* Ainv)
+{
+    if(unlikely(Ainv==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_inverse, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(__chol_check(L, L.rows, "rc_algebra_cholesky_inverse"))) return -1;
+    if(unlikely(Ainv->initialized && Ainv->d[0]==L.d[0])){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_inverse, Ainv must not be L\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_identity(Ainv, L.rows))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_inverse, failed to allocate Ainv\n");
+        return -1;
+    }
+    if(unlikely(__trsm_lower(L.rows, L.rows, L.d[0], L.stride, Ainv->d[0], Ainv->stride, 0) ||
+                __trsm_lower_trans(L.rows, L.rows, L.d[0], L.stride, Ainv->d[0], Ainv->stride))){
+        fprintf(stderr,"ERROR in rc_algebra_cholesky_inverse, triangular solve failed\n");
+        return -1;
+    }
+    // exactly symmetric like A itself
+    rc_matrix_symmetrize(Ainv);
+    return 0;
+}
+
+
+void rc_algebra_set_zero_tolerance(double tol){
+    zero_tolerance=tol;
+    return;
+}
+
 int rc_algebra_fit_ellipsoid(rc_matrix_t pts, rc_vector_t* ctr, rc_vector_t* lens)
 {
-    int i,p;
-    rc_matrix_t A = RC_MATRIX_INITIALIZER;
-    rc_vector_t b = RC_VECTOR_INITIALIZER;
-    rc_vector_t f = RC_VECTOR_INITIALIZER;
+    rc_ellipsoid_fit_t fit;
     // sanity checks
     if(unlikely(!pts.initialized)){
         fprintf(stderr,"ERROR in rc_fit_ellipsoid, matrix not initialized\n");
@@ -503,90 +1006,240 @@ int rc_algebra_fit_ellipsoid(rc_matrix_t pts, rc_vector_t* ctr, rc_vector_t* len
         fprintf(stderr,"ERROR in rc_fit_ellipsoid, matrix pts must have 3 columns\n");
         return -1;
     }
-    p = pts.rows;
-    if(p<6){
+    if(pts.rows<6){
         fprintf(stderr,"ERROR in rc_fit_ellipsoid, matrix pts must have at least 6 rows\n");
         return -1;
     }
-    // allocate memory for linear system
-    if(unlikely(rc_vector_ones(&b,p))){
-        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to alloc vector\n");
-        return -1;
-    }
-    if(unlikely(rc_matrix_alloc(&A,p,6))){
-        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to alloc matrix\n");
-        rc_vector_free(&b);
-        return -1;
-    }
-    // fill in A for QR
-    for(i=0;i<p;i++){
-        A.d[i][0] = pts.d[i][0] * pts.d[i][0];
-        A.d[i][1] = pts.d[i][0];
-        A.d[i][2] = pts.d[i][1] * pts.d[i][1];
-        A.d[i][3] = pts.d[i][1];
-        A.d[i][4] = pts.d[i][2] * pts.d[i][2];
-        A.d[i][5] = pts.d[i][2];
-    }
-    // solve least squares fit for centroid
-    if(unlikely(rc_algebra_lin_system_solve_qr(A,b,&f))){
-        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to solve QR\n");
-        rc_matrix_free(&A);
-        rc_vector_free(&b);
-        rc_vector_free(&f);
-        return -1;
-    }
-    // done with A&b now
-    rc_matrix_free(&A);
-    rc_vector_free(&b);
-
-    // compute center
-    if(unlikely(rc_vector_alloc(ctr,3))){
-        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to allocate ctr\n");
-        rc_vector_free(&f);
-        return -1;
-    }
-    ctr->d[0] = -f.d[1]/(2.0*f.d[0]);
-    ctr->d[1] = -f.d[3]/(2.0*f.d[2]);
-    ctr->d[2] = -f.d[5]/(2.0*f.d[4]);
-
-    // Solve for lengths
-    if(unlikely(rc_vector_alloc(&b,3))){
-        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to alloc vector\n");
-        return -1;
-    }
-    if(unlikely(rc_matrix_alloc(&A,3,3))){
-        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to alloc matrix\n");
-        rc_vector_free(&b);
-        return -1;
-    }
-    // fill in A
-    A.d[0][0] = (f.d[0] * ctr->d[0] * ctr->d[0]) + 1.0;
-    A.d[0][1] = (f.d[0] * ctr->d[1] * ctr->d[1]);
-    A.d[0][2] = (f.d[0] * ctr->d[2] * ctr->d[2]);
-    A.d[1][0] = (f.d[2] * ctr->d[0] * ctr->d[0]);
-    A.d[1][1] = (f.d[2] * ctr->d[1] * ctr->d[1]) + 1.0;
-    A.d[1][2] = (f.d[2] * ctr->d[2] * ctr->d[2]);
-    A.d[2][0] = (f.d[4] * ctr->d[0] * ctr->d[0]);
-    A.d[2][1] = (f.d[4] * ctr->d[1] * ctr->d[1]);
-    A.d[2][2] = (f.d[4] * ctr->d[2] * ctr->d[2]) + 1.0;
-    // fill in b
-    b.d[0] = f.d[0];
-    b.d[1] = f.d[2];
-    b.d[2] = f.d[4];
-    // solve for lengths
-    if(unlikely(rc_algebra_lin_system_solve(A,b,lens))){
-        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to solve linear system\n");
-        rc_matrix_free(&A);
-        rc_vector_free(&b);
-        rc_vector_free(&f);
-        return -1;
-    }
-    lens->d[0] = 1.0/sqrt(lens->d[0]);
-    lens->d[1] = 1.0/sqrt(lens->d[1]);
-    lens->d[2] = 1.0/sqrt(lens->d[2]);
-    // cleanup
-    rc_matrix_free(&A);
-    rc_vector_free(&b);
-    rc_vector_free(&f);
+    // the same least-squares system, folded into its R factor a row at a
+    // time so the p x 6 matrix is never formed
+    rc_ellipsoid_fit_init(&fit, RC_ELLIPSOID_ALIGNED);
+    if(unlikely(rc_ellipsoid_fit_add_points(&fit, pts) ||
+                rc_ellipsoid_fit_solve(fit, ctr, lens, NULL))){
+        fprintf(stderr,"ERROR in rc_fit_ellipsoid, failed to solve\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+int rc_ellipsoid_fit_init(rc_ellipsoid_fit_t* fit, int mode)
+{
+    if(unlikely(fit==NULL)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_init, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(mode!=RC_ELLIPSOID_ALIGNED && mode!=RC_ELLIPSOID_ROTATED)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_init, invalid mode\n");
+        return -1;
+    }
+    memset(fit, 0, sizeof(rc_ellipsoid_fit_t));
+    fit->mode = mode;
+    fit->n = (mode==RC_ELLIPSOID_ALIGNED) ? 6 : 9;
+    fit->initialized = 1;
+    return 0;
+}
+
+
+/*
+ * Folds the row r, n+1 long, into the upper triangular R with one Givens
+ * rotation per column. r is destroyed. The magnitude of the last diagonal
+ * element of R grows into the norm of the least-squares residual.
+ */
+static void __givens_add_row(int n, double R[][RC_ELLIPSOID_MAX_PARAMS+1], double* r)
+{
+    int i,j;
+    double h,c,s,t;
+    for(i=0;i<n;i++){
+        if(r[i]==0.0) continue;
+        h = hypot(R[i][i], r[i]);
+        c = R[i][i]/h;
+        s = r[i]/h;
+        R[i][i] = h;
+        for(j=i+1;j<n;j++){
+            t = R[i][j];
+            R[i][j] = c*t + s*r[j];
+            r[j] = c*r[j] - s*t;
+        }
+    }
+    return;
+}
+
+
+int rc_ellipsoid_fit_add_point(rc_ellipsoid_fit_t* fit, const double p[3])
+{
+    double r[RC_ELLIPSOID_MAX_PARAMS+1];
+    double x,y,z;
+    if(unlikely(fit==NULL || p==NULL)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_add_point, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!fit->initialized)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_add_point, fit not initialized\n");
+        return -1;
+    }
+    x = p[0];
+    y = p[1];
+    z = p[2];
+    if(fit->mode==RC_ELLIPSOID_ALIGNED){
+        // a*x^2 + b*x + c*y^2 + d*y + e*z^2 + f*z = 1
+        r[0] = x*x;
+        r[1] = x;
+        r[2] = y*y;
+        r[3] = y;
+        r[4] = z*z;
+        r[5] = z;
+    }
+    else{
+        // p^T*M*p + 2*v^T*p = 1 with M symmetric
+        r[0] = x*x;
+        r[1] = y*y;
+        r[2] = z*z;
+        r[3] = 2.0*x*y;
+        r[4] = 2.0*x*z;
+        r[5] = 2.0*y*z;
+        r[6] = 2.0*x;
+        r[7] = 2.0*y;
+        r[8] = 2.0*z;
+    }
+    r[fit->n] = 1.0;
+    __givens_add_row(fit->n+1, fit->R, r);
+    fit->count++;
     return 0;
 }
+
+
+int rc_ellipsoid_fit_add_points(rc_ellipsoid_fit_t* fit, rc_matrix_t pts)
+{
+    int i;
+    if(unlikely(!pts.initialized)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_add_points, matrix not initialized\n");
+        return -1;
+    }
+    if(unlikely(pts.cols!=3)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_add_points, matrix pts must have 3 columns\n");
+        return -1;
+    }
+    for(i=0;i<pts.rows;i++){
+        if(unlikely(rc_ellipsoid_fit_add_point(fit, pts.d[i]))) return -1;
+    }
+    return 0;
+}
+
+
+int rc_ellipsoid_fit_solve(rc_ellipsoid_fit_t fit, rc_vector_t* ctr, rc_vector_t* lens, rc_matrix_t* axes)
+{
+    int i,j,n,ret;
+    double f[RC_ELLIPSOID_MAX_PARAMS];
+    double rmax, g, det;
+    double C[3][3];
+    rc_matrix_t M = RC_MATRIX_INITIALIZER;
+    rc_vector_t ev = RC_VECTOR_INITIALIZER;
+
+    // sanity checks
+    if(unlikely(ctr==NULL || lens==NULL)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!fit.initialized)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, fit not initialized\n");
+        return -1;
+    }
+    n = fit.n;
+    if(unlikely(fit.count<n)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, need at least %d points\n", n);
+        return -1;
+    }
+    // back substitution R*f = last column of R, refusing a rank deficient R
+    rmax = 0.0;
+    for(i=0;i<n;i++) rmax = fmax(rmax, fabs(fit.R[i][i]));
+    for(i=n-1;i>=0;i--){
+        if(unlikely(fabs(fit.R[i][i])<=zero_tolerance*rmax)){
+            fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, points do not determine an ellipsoid\n");
+            return -1;
+        }
+        f[i] = fit.R[i][n];
+        for(j=i+1;j<n;j++) f[i] -= fit.R[i][j]*f[j];
+        f[i] /= fit.R[i][i];
+    }
+    if(unlikely(rc_vector_alloc(ctr,3) || rc_vector_alloc(lens,3))){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, failed to allocate vector\n");
+        return -1;
+    }
+
+    if(fit.mode==RC_ELLIPSOID_ALIGNED){
+        // a*(x-cx)^2 + c*(y-cy)^2 + e*(z-cz)^2 = 1 + a*cx^2 + c*cy^2 + e*cz^2
+        // which is an ellipsoid only if a, c, and e are all positive, and
+        // then g>=1. Checked before dividing so flat or degenerate point sets
+        // can't produce an infinite center.
+        for(i=0;i<3;i++){
+            if(unlikely(!(f[2*i]>0.0))){
+                fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, fit is not an ellipsoid\n");
+                return -1;
+            }
+        }
+        g = 1.0;
+        for(i=0;i<3;i++){
+            ctr->d[i] = -f[2*i+1]/(2.0*f[2*i]);
+            g += f[2*i]*ctr->d[i]*ctr->d[i];
+        }
+        for(i=0;i<3;i++) lens->d[i] = sqrt(g/f[2*i]);
+        if(axes!=NULL && unlikely(rc_matrix_identity(axes,3))){
+            fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, failed to allocate axes\n");
+            return -1;
+        }
+        return 0;
+    }
+
+    // rotated: center = -M^-1*v from the cofactors of M
+    C[0][0] = f[1]*f[2] - f[5]*f[5];
+    C[0][1] = f[4]*f[5] - f[3]*f[2];
+    C[0][2] = f[3]*f[5] - f[4]*f[1];
+    C[1][1] = f[0]*f[2] - f[4]*f[4];
+    C[1][2] = f[3]*f[4] - f[0]*f[5];
+    C[2][2] = f[0]*f[1] - f[3]*f[3];
+    C[1][0] = C[0][1];
+    C[2][0] = C[0][2];
+    C[2][1] = C[1][2];
+    det = f[0]*C[0][0] + f[3]*C[0][1] + f[4]*C[0][2];
+    if(unlikely(det==0.0)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, fit is not an ellipsoid\n");
+        return -1;
+    }
+    // (p-c)^T*M*(p-c) = 1 - v^T*c
+    g = 1.0;
+    for(i=0;i<3;i++){
+        ctr->d[i] = -(C[i][0]*f[6] + C[i][1]*f[7] + C[i][2]*f[8])/det;
+        g -= f[6+i]*ctr->d[i];
+    }
+    if(unlikely(g==0.0)){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, fit is not an ellipsoid\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_alloc(&M,3,3))){
+        fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, failed to allocate matrix\n");
+        return -1;
+    }
+    M.d[0][0] = f[0]/g;
+    M.d[1][1] = f[1]/g;
+    M.d[2][2] = f[2]/g;
+    M.d[0][1] = M.d[1][0] = f[3]/g;
+    M.d[0][2] = M.d[2][0] = f[4]/g;
+    M.d[1][2] = M.d[2][1] = f[5]/g;
+    // axes are the eigenvectors of M/g, the smallest eigenvalue belongs to
+    // the longest axis
+    ret = rc_algebra_eig_sym(M, &ev, axes);
+    if(likely(ret==0)){
+        for(i=0;i<3;i++){
+            if(unlikely(ev.d[i]<=0.0)){
+                fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, fit is not an ellipsoid\n");
+                ret = -1;
+                break;
+            }
+            lens->d[i] = 1.0/sqrt(ev.d[i]);
+        }
+    }
+    else fprintf(stderr,"ERROR in rc_ellipsoid_fit_solve, eigendecomposition failed\n");
+    rc_matrix_free(&M);
+    rc_vector_free(&ev);
+    return ret;
+}
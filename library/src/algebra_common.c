@@ -2,11 +2,20 @@
  * @file       algebra_common.c
  *
  * @brief      see algebra_common.h
+ *
+ * Holds the generic C versions of the innermost kernels and the table that
+ * decides which implementation is used. The table is filled in once by a
+ * constructor when the library is loaded, picking the fastest path the
+ * running CPU supports.
  **/
 
+#include <stdio.h>
+#include <math.h>   // for fabs
+
 #include "algebra_common.h"
 
-double __vectorized_mult_accumulate(double * __restrict__ a, double * __restrict__ b, int n)
+
+static double __dot_generic(double * __restrict__ a, double * __restrict__ b, int n)
 {
     int i;
     double sum = 0.0;
@@ -17,7 +26,7 @@ double __vectorized_mult_accumulate(double * __restrict__ a, double * __restrict
 }
 
 
-double __vectorized_square_accumulate(double * __restrict__ a, int n)
+static double __square_generic(double * __restrict__ a, int n)
 {
     int i;
     double sum = 0.0;
@@ -25,4 +34,226 @@ double __vectorized_square_accumulate(double * __restrict__ a, int n)
         sum+=a[i]*a[i];
     }
     return sum;
-}
\ No newline at end of file
+}
+
+
+static void __axpy_generic(double alpha, double * __restrict__ x, double * __restrict__ y, int n)
+{
+    int i;
+    for(i=0;i<n;i++) y[i] += alpha*x[i];
+    return;
+}
+
+
+static void __scale_generic(double s, double * __restrict__ x, int n)
+{
+    int i;
+    for(i=0;i<n;i++) x[i] *= s;
+    return;
+}
+
+
+// the flag tests are loop invariant so the compiler unswitches this into one
+// loop per combination, each of which vectorizes
+static void __stats_generic(double * __restrict__ x, int n, double shift, int flags, __stats_acc_t* acc)
+{
+    int i;
+    double d;
+    double sum = 0.0;
+    double sumsq = 0.0;
+    double sq = 0.0;
+    double abs = 0.0;
+    double min = x[0];
+    double max = x[0];
+    const int moments = flags & (RC_VECTOR_STATS_MEAN|RC_VECTOR_STATS_STD_DEV);
+    const int norms   = flags & RC_VECTOR_STATS_NORM;
+    const int range   = flags & (RC_VECTOR_STATS_MAX|RC_VECTOR_STATS_MIN);
+
+    for(i=0;i<n;i++){
+        if(moments){
+            d = x[i]-shift;
+            sum += d;
+            sumsq += d*d;
+        }
+        if(norms){
+            sq += x[i]*x[i];
+            abs += fabs(x[i]);
+        }
+        if(range){
+            min = x[i]<min ? x[i] : min;
+            max = x[i]>max ? x[i] : max;
+        }
+    }
+    acc->sum    = sum;
+    acc->sumsq  = sumsq;
+    acc->sq     = sq;
+    acc->abs    = abs;
+    acc->min    = min;
+    acc->max    = max;
+    return;
+}
+
+
+#define GENERIC_KERNELS {\
+    .path       = RC_SIMD_GENERIC,\
+    .dot        = __dot_generic,\
+    .square     = __square_generic,\
+    .axpy       = __axpy_generic,\
+    .scale      = __scale_generic,\
+    .stats      = __stats_generic,\
+    .gemm_micro = __gemm_micro_generic,\
+    .gemm_microf= __gemm_micro_genericf}
+
+// start with the generic path so kernels work even before the constructor runs
+__algebra_kernels_t __kernels = GENERIC_KERNELS;
+
+
+// build the table for one path from scratch, returns -1 if unsupported. Newer
+// x86 paths are layered on top of the older ones so any kernel without a
+// newer version falls back to the next best one.
+static int __build_table(int path, __algebra_kernels_t* k)
+{
+    __algebra_kernels_t generic = GENERIC_KERNELS;
+    *k = generic;
+
+    switch(path){
+    case RC_SIMD_GENERIC:
+        return 0;
+    case RC_SIMD_SSE2:
+        return __kernels_sse2(k);
+    case RC_SIMD_AVX2:
+        if(__kernels_sse2(k)) return -1;
+        return __kernels_avx2(k);
+    case RC_SIMD_AVX512:
+        if(__kernels_sse2(k)) return -1;
+        if(__kernels_avx2(k)) return -1;
+        return __kernels_avx512(k);
+    case RC_SIMD_NEON:
+        return __kernels_neon(k);
+    default:
+        return -1;
+    }
+}
+
+
+// runs when the shared library is loaded, pick the best path available
+__attribute__((constructor))
+static void __kernels_init(void)
+{
+    static const int order[] = {RC_SIMD_AVX512, RC_SIMD_AVX2, RC_SIMD_NEON, RC_SIMD_SSE2};
+    __algebra_kernels_t k;
+    unsigned int i;
+
+    for(i=0;i<sizeof(order)/sizeof(order[0]);i++){
+        if(__build_table(order[i], &k)==0){
+            __kernels = k;
+            return;
+        }
+    }
+    return;
+}
+
+
+int rc_algebra_get_simd_path(void)
+{
+    return __kernels.path;
+}
+
+
+const char* rc_algebra_simd_path_name(int path)
+{
+    switch(path){
+    case RC_SIMD_GENERIC:   return "generic";
+    case RC_SIMD_SSE2:      return "sse2";
+    case RC_SIMD_AVX2:      return "avx2";
+    case RC_SIMD_AVX512:    return "avx512";
+    case RC_SIMD_NEON:      return "neon";
+    default:                return "unknown";
+    }
+}
+
+
+int rc_algebra_set_simd_path(int path)
+{
+    __algebra_kernels_t k;
+    if(unlikely(__build_table(path, &k))){
+        fprintf(stderr,"ERROR in rc_algebra_set_simd_path, %s path not supported on this CPU\n",
+                                            rc_algebra_simd_path_name(path));
+        return -1;
+    }
+    __kernels = k;
+    return 0;
+}
+
+
+double __vectorized_mult_accumulate(double * __restrict__ a, double * __restrict__ b, int n)
+{
+    return __kernels.dot(a,b,n);
+}
+
+
+double __vectorized_square_accumulate(double * __restrict__ a, int n)
+{
+    return __kernels.square(a,n);
+}
+
+
+void __vectorized_axpy(double alpha, double * __restrict__ x, double * __restrict__ y, int n)
+{
+    __kernels.axpy(alpha,x,y,n);
+    return;
+}
+
+
+void __vectorized_scale(double s, double * __restrict__ x, int n)
+{
+    __kernels.scale(s,x,n);
+    return;
+}
+
+
+void __vectorized_stats(double * __restrict__ x, int n, double shift, int flags, __stats_acc_t* acc)
+{
+    __kernels.stats(x,n,shift,flags,acc);
+    return;
+}
+
+
+/*
+ * Float kernels for the single precision API. There is no hand-written
+ * version of these so they are not part of the dispatch table, the compiler
+ * vectorizes the loops for whatever the library is built for. Only the gemm
+ * micro-kernel has SIMD versions, see gemm_microf in the table.
+ */
+float __vectorized_mult_accumulatef(float * __restrict__ a, float * __restrict__ b, int n)
+{
+    int i;
+    float sum = 0.0f;
+    for(i=0;i<n;i++) sum+=a[i]*b[i];
+    return sum;
+}
+
+
+float __vectorized_square_accumulatef(float * __restrict__ a, int n)
+{
+    int i;
+    float sum = 0.0f;
+    for(i=0;i<n;i++) sum+=a[i]*a[i];
+    return sum;
+}
+
+
+void __vectorized_axpyf(float alpha, float * __restrict__ x, float * __restrict__ y, int n)
+{
+    int i;
+    for(i=0;i<n;i++) y[i] += alpha*x[i];
+    return;
+}
+
+
+void __vectorized_scalef(float s, float * __restrict__ x, int n)
+{
+    int i;
+    for(i=0;i<n;i++) x[i] *= s;
+    return;
+}
@@ -23,6 +23,9 @@
 #define M_PI_2 1.57079632679489661923
 #endif
 
+#include <rc_math/algebra.h> // for RC_SIMD_* path definitions
+#include <rc_math/single_precision.h>
+
 /*
  * Performs a vector dot product on the contents of a and b over n values.
  *
@@ -43,4 +46,194 @@ double __vectorized_mult_accumulate(double * __restrict__ a, double * __restrict
  */
 double __vectorized_square_accumulate(double * __restrict__ a, int n);
 
+/*
+ * y = y + alpha*x over n values, x and y must not overlap
+ */
+void __vectorized_axpy(double alpha, double * __restrict__ x, double * __restrict__ y, int n);
+
+/*
+ * x = s*x over n values
+ */
+void __vectorized_scale(double s, double * __restrict__ x, int n);
+
+/*
+ * Partial sums of one block of a vector for rc_vector_stats. sum and sumsq are
+ * taken about a shift close to the mean so the block variance
+ * sumsq-sum*sum/n does not cancel, sq and abs are of the raw values.
+ */
+typedef struct __stats_acc_t{
+    double sum;     // sum of x-shift
+    double sumsq;   // sum of (x-shift)^2
+    double sq;      // sum of x^2
+    double abs;     // sum of |x|
+    double min;
+    double max;
+} __stats_acc_t;
+
+/*
+ * Fills in acc for the n>=1 values of x in one sweep. Only the members needed
+ * for the RC_VECTOR_STATS_* flags are computed, the rest are left at 0.
+ */
+void __vectorized_stats(double * __restrict__ x, int n, double shift, int flags, __stats_acc_t* acc);
+
+// register tile of the gemm micro-kernel, MR rows by NR columns of C
+#define GEMM_MR     4
+#define GEMM_NR     8
+
+/*
+ * gemm micro-kernel, see gemm.c. Multiplies a packed GEMM_MR row panel a by a
+ * packed GEMM_NR column panel b, both kc long, and adds alpha times the result
+ * to the top left mr x nr corner of C.
+ */
+typedef void (*__gemm_micro_t)(int kc, double * __restrict__ a, double * __restrict__ b,
+                    double alpha, double* C, int ldc, int mr, int nr);
+
+void __gemm_micro_generic(int kc, double * __restrict__ a, double * __restrict__ b,
+                    double alpha, double* C, int ldc, int mr, int nr);
+
+// float version with the same tile shape, see single_precision.c
+typedef void (*__gemm_microf_t)(int kc, float * __restrict__ a, float * __restrict__ b,
+                    float alpha, float* C, int ldc, int mr, int nr);
+
+void __gemm_micro_genericf(int kc, float * __restrict__ a, float * __restrict__ b,
+                    float alpha, float* C, int ldc, int mr, int nr);
+
+/*
+ * Table of the innermost kernels. One instance is filled in when the library
+ * is loaded with the fastest implementation the running CPU supports, see
+ * algebra_common.c. Everything else calls through it.
+ */
+typedef struct __algebra_kernels_t{
+    int path;   ///< one of RC_SIMD_*
+    double (*dot)(double * __restrict__ a, double * __restrict__ b, int n);
+    double (*square)(double * __restrict__ a, int n);
+    void (*axpy)(double alpha, double * __restrict__ x, double * __restrict__ y, int n);
+    void (*scale)(double s, double * __restrict__ x, int n);
+    void (*stats)(double * __restrict__ x, int n, double shift, int flags, __stats_acc_t* acc);
+    __gemm_micro_t gemm_micro;
+    __gemm_microf_t gemm_microf;
+} __algebra_kernels_t;
+
+extern __algebra_kernels_t __kernels;
+
+/*
+ * Architecture specific tables, see kernels_x86.c and kernels_neon.c. Each one
+ * fills in the kernels it implements and returns 0 if the running CPU supports
+ * that path, otherwise it leaves k untouched and returns -1. Kernels a path
+ * does not implement are left as they were so tables can be layered on top of
+ * the generic one.
+ */
+int __kernels_sse2(__algebra_kernels_t* k);
+int __kernels_avx2(__algebra_kernels_t* k);
+int __kernels_avx512(__algebra_kernels_t* k);
+int __kernels_neon(__algebra_kernels_t* k);
+
+/*
+ * General matrix multiply C = alpha*op(A)*op(B) + beta*C, see gemm.c
+ *
+ * op(A) is m x k, op(B) is k x n and C is m x n. ta and tb select whether A
+ * and B are read transposed. All three are row-major with leading dimensions
+ * lda, ldb, ldc (doubles between the start of consecutive rows). C must not
+ * overlap A or B. When beta is 0 the original contents of C are never read.
+ *
+ * Returns 0 on success or -1 if a packing buffer could not be allocated.
+ */
+int __gemm(int ta, int tb, int m, int n, int k, double alpha,
+            double* A, int lda, double* B, int ldb,
+            double beta, double* C, int ldc);
+
+/*
+ * Same as __gemm for a square m x m result of which only the upper triangle
+ * is wanted, as when op(A)*op(B) is known to be symmetric. Tiles entirely
+ * below the diagonal are skipped so the entries there are left unspecified.
+ */
+int __gemm_upper(int ta, int tb, int m, int k, double alpha,
+            double* A, int lda, double* B, int ldb,
+            double beta, double* C, int ldc);
+
+/*
+ * LU factorization with partial pivoting of the n x n matrix in a with leading
+ * dimension lda, done in place, see algebra_template.h. Afterwards the strictly lower
+ * triangle holds L, whose unit diagonal is not stored, and the upper triangle
+ * holds U. Rows k and ipiv[k] were swapped in turn for k=0..n-1, and sign is
+ * the sign of that permutation. A zero pivot is skipped rather than treated
+ * as an error so callers decide what counts as singular.
+ *
+ * Returns 0 on success or -1 if gemm could not allocate its packing buffers.
+ */
+int __lu_inplace(double* a, int n, int lda, int* ipiv, int* sign);
+
+/*
+ * Overwrites the k columns of X, leading dimension ldx, with inv(A)*X given
+ * the in-place LU of A from __lu_inplace, see algebra_template.h.
+ *
+ * Returns 0 on success or -1 if gemm could not allocate its packing buffers.
+ */
+int __lu_apply(double* lu, int n, int ld, int* ipiv, double* X, int k, int ldx);
+
+/*
+ * Thread pool, see thread_pool.c. __pool_run calls fn(arg,i) for every i from
+ * 0 to ntasks-1 spread across the pool and the calling thread, returning once
+ * all are done. It runs them serially on the calling thread when the pool is
+ * not started, is busy, or when called from inside another job.
+ * __pool_threads is how many ways it is worth splitting work from the current
+ * thread. Work is only split above these sizes.
+ */
+#define POOL_GEMM_FLOPS     (96L*96L*96L)   // m*n*k of a multiply
+#define POOL_MATVEC_ELEMS   (256L*256L)     // rows*cols of a mat-vec
+#define POOL_LU_ELEMS       (128L*128L)     // remaining trailing block of an LU
+#define POOL_BATCH_FLOPS    (64L*64L*64L)   // n*dim^3 of a batched solve
+
+typedef void (*__pool_task_t)(void* arg, int task);
+
+void __pool_run(__pool_task_t fn, void* arg, int ntasks);
+int __pool_threads(void);
+
+/*
+ * Float versions of the kernels above, __gemm, and the LU, see algebra_common.c and
+ * single_precision.c. Apart from the gemm micro-kernel, which is dispatched
+ * through the table, these are plain C loops left to the compiler's
+ * auto-vectorizer.
+ */
+float __vectorized_mult_accumulatef(float * __restrict__ a, float * __restrict__ b, int n);
+float __vectorized_square_accumulatef(float * __restrict__ a, int n);
+void __vectorized_axpyf(float alpha, float * __restrict__ x, float * __restrict__ y, int n);
+void __vectorized_scalef(float s, float * __restrict__ x, int n);
+int __gemmf(int ta, int tb, int m, int n, int k, float alpha,
+            float* A, int lda, float* B, int ldb,
+            float beta, float* C, int ldc);
+int __gemm_upperf(int ta, int tb, int m, int k, float alpha,
+            float* A, int lda, float* B, int ldb,
+            float beta, float* C, int ldc);
+int __lu_inplacef(float* a, int n, int lda, int* ipiv, int* sign);
+int __lu_applyf(float* lu, int n, int ld, int* ipiv, float* X, int k, int ldx);
+
+/*
+ * Workspace helpers, see workspace.c. Every block handed out is aligned to and
+ * padded to a multiple of WS_ALIGN bytes. Functions using a workspace should
+ * save ws->used on entry and restore it before returning.
+ */
+#define WS_ALIGN    RC_MATRIX_ALIGN
+
+static inline size_t __ws_round(size_t bytes)
+{
+    return (bytes + WS_ALIGN - 1) & ~((size_t)WS_ALIGN - 1);
+}
+
+// bytes of workspace taken by __ws_matrix and __ws_vector
+#define WS_MATRIX_BYTES(rows,cols) \
+    (__ws_round((rows)*sizeof(double*)) + __ws_round((rows)*(cols)*sizeof(double)))
+#define WS_VECTOR_BYTES(len)    __ws_round((len)*sizeof(double))
+
+// returns NULL and prints an error if the workspace is too small
+void* __ws_push(rc_workspace_t* ws, size_t bytes);
+
+// fill in an rc_matrix_t or rc_vector_t backed by workspace memory, contents
+// are not initialized. These must never be passed to rc_matrix_free or
+// rc_vector_free.
+int __ws_matrix(rc_workspace_t* ws, rc_matrix_t* A, int rows, int cols);
+int __ws_vector(rc_workspace_t* ws, rc_vector_t* v, int len);
+int __ws_matrixf(rc_workspace_t* ws, rc_matrixf_t* A, int rows, int cols);
+int __ws_vectorf(rc_workspace_t* ws, rc_vectorf_t* v, int len);
+
 #endif // RC_ALGEBRA_COMMON_H
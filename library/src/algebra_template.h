@@ -0,0 +1,637 @@
+/**
+ * @file       algebra_template.h
+ *
+ * @brief      QR decomposition and linear solvers shared by the double and
+ *             float APIs, see precision.h. Included by algebra.c and
+ *             single_precision.c.
+ */
+
+/*
+ * Blocked Householder QR. Reflectors H = I - tau*v*v^T, with v[0]=1 implicit,
+ * are generated a panel of QR_BLOCK columns at a time and stored below the
+ * diagonal of R in place of the zeros they create. The panel's reflectors are
+ * then combined into the compact WY form H1*H2*...*Hnb = I - V*T*V^T, T upper
+ * triangular, so applying all of them to the rest of the matrix, or to Q when
+ * it is wanted, is two matrix multiplies instead of nb rank-1 updates. Q never
+ * has to be formed to solve a system, Q^T is applied to the right hand side
+ * straight from the stored reflectors.
+ */
+#define QR_BLOCK    32
+
+// elements of scratch the QR needs for a rows x cols matrix: the reflector
+// coefficients, one panel of reflectors, its T factor, and the product of the
+// panel with the columns it is applied to
+#define QR_SCRATCH(rows,cols) ((rows) + ((rows)*QR_BLOCK) + (QR_BLOCK*QR_BLOCK) + \
+                                (QR_BLOCK*(((rows)>(cols)) ? (rows) : (cols))))
+
+
+// number of reflectors for an m x n QR, the last row of a square or wide
+// matrix needs none
+static int __qr_steps(int m, int n)
+{
+    return (m-1<n) ? m-1 : n;
+}
+
+
+// makes the reflector for column k of a from the diagonal down, writing beta
+// to the diagonal and v below it, and returns tau. The sign of beta is
+// opposite the pivot to avoid loss of significance.
+static REAL __qr_reflector(int m, int k, REAL* a, int lda)
+{
+    int i;
+    REAL alpha, beta, norm, scale;
+    alpha = a[(k*lda)+k];
+    norm = RL(0.0);
+    for(i=k;i<m;i++) norm += a[(i*lda)+k]*a[(i*lda)+k];
+    norm = SQRT(norm);
+    if(norm==RL(0.0)) return RL(0.0);
+    beta = (alpha>=RL(0.0)) ? -norm : norm;
+    scale = RL(1.0)/(alpha-beta);
+    for(i=k+1;i<m;i++) a[(i*lda)+k] *= scale;
+    a[(k*lda)+k] = beta;
+    return (beta-alpha)/beta;
+}
+
+
+// factors columns j0 to j0+nb-1 one reflector at a time, applying each only
+// to the columns of the panel to its right. w is scratch for nb elements.
+static void __qr_panel(int m, int j0, int nb, REAL* a, int lda, REAL* tau, REAL* w)
+{
+    int i,k,nc;
+    for(k=j0;k<j0+nb;k++){
+        tau[k] = __qr_reflector(m,k,a,lda);
+        nc = j0+nb-k-1;
+        if(tau[k]==RL(0.0) || nc==0) continue;
+        // w = v^T*A, then A -= tau*v*w^T, a row at a time
+        memcpy(w, &a[(k*lda)+k+1], nc*sizeof(REAL));
+        for(i=k+1;i<m;i++) PREC(__vectorized_axpy)(a[(i*lda)+k], &a[(i*lda)+k+1], w, nc);
+        PREC(__vectorized_axpy)(-tau[k], w, &a[(k*lda)+k+1], nc);
+        for(i=k+1;i<m;i++) PREC(__vectorized_axpy)(-tau[k]*a[(i*lda)+k], w, &a[(i*lda)+k+1], nc);
+    }
+    return;
+}
+
+
+// copies the reflectors of the panel at j0 into V, m-j0 x nb with the unit
+// diagonal and zeros made explicit, and builds its upper triangular T, both
+// with leading dimension nb
+static void __qr_wy(int m, int j0, int nb, REAL* a, int lda, REAL* tau, REAL* V, REAL* T)
+{
+    int i,p,q,r;
+    REAL sum;
+    for(r=0;r<m-j0;r++){
+        for(i=0;i<nb;i++){
+            if(r<i)         V[(r*nb)+i] = RL(0.0);
+            else if(r==i)   V[(r*nb)+i] = RL(1.0);
+            else            V[(r*nb)+i] = a[((j0+r)*lda)+j0+i];
+        }
+    }
+    // column i of T is -tau_i*T*(V^T v_i) over the columns before it
+    for(i=0;i<nb;i++){
+        for(p=0;p<i;p++) T[(p*nb)+i] = RL(0.0);
+        for(r=i;r<m-j0;r++){
+            for(p=0;p<i;p++) T[(p*nb)+i] += V[(r*nb)+p]*V[(r*nb)+i];
+        }
+        for(p=0;p<i;p++){
+            sum = RL(0.0);
+            for(q=p;q<i;q++) sum += T[(p*nb)+q]*T[(q*nb)+i];
+            T[(p*nb)+i] = -tau[j0+i]*sum;
+        }
+        T[(i*nb)+i] = tau[j0+i];
+        for(p=i+1;p<nb;p++) T[(p*nb)+i] = RL(0.0);
+    }
+    return;
+}
+
+
+// C = (I - V*T*V^T)*C, or with T^T when trans is set, for the mv x nc matrix
+// C. W is scratch for nb*nc elements.
+static int __qr_apply(int trans, int mv, int nb, REAL* V, REAL* T, REAL* C, int ldc, int nc, REAL* W)
+{
+    int i,p;
+    // W = V^T*C
+    if(unlikely(PREC(__gemm)(1, 0, nb, nc, mv, RL(1.0), V, nb, C, ldc, RL(0.0), W, nc))) return -1;
+    // W = op(T)*W in place, going the direction that only reads unchanged rows
+    if(trans){
+        for(i=nb-1;i>=0;i--){
+            PREC(__vectorized_scale)(T[(i*nb)+i], &W[i*nc], nc);
+            for(p=0;p<i;p++) PREC(__vectorized_axpy)(T[(p*nb)+i], &W[p*nc], &W[i*nc], nc);
+        }
+    }
+    else{
+        for(i=0;i<nb;i++){
+            PREC(__vectorized_scale)(T[(i*nb)+i], &W[i*nc], nc);
+            for(p=i+1;p<nb;p++) PREC(__vectorized_axpy)(T[(i*nb)+p], &W[p*nc], &W[i*nc], nc);
+        }
+    }
+    // C -= V*W
+    if(unlikely(PREC(__gemm)(0, 0, mv, nc, nb, RL(-1.0), V, nb, W, nc, RL(1.0), C, ldc))) return -1;
+    return 0;
+}
+
+
+// factors the m x n matrix a in place, scratch holds QR_SCRATCH(m,n)
+// elements and keeps tau at its start for __qr_form_q and __qr_apply_qt
+static int __qr_factor(int m, int n, REAL* a, int lda, REAL* scratch)
+{
+    int j0,nb,nc;
+    int steps = __qr_steps(m,n);
+    REAL* tau = scratch;
+    REAL* V = tau+m;
+    REAL* T = V+(m*QR_BLOCK);
+    REAL* W = T+(QR_BLOCK*QR_BLOCK);
+    for(j0=0;j0<steps;j0+=QR_BLOCK){
+        nb = (steps-j0<QR_BLOCK) ? steps-j0 : QR_BLOCK;
+        __qr_panel(m, j0, nb, a, lda, tau, W);
+        nc = n-j0-nb;
+        if(nc<=0) continue;
+        __qr_wy(m, j0, nb, a, lda, tau, V, T);
+        if(unlikely(__qr_apply(1, m-j0, nb, V, T, &a[(j0*lda)+j0+nb], lda, nc, W))) return -1;
+    }
+    return 0;
+}
+
+
+// forms the m x m Q of a factored matrix in q, applying the panels to the
+// identity last to first so each only touches the trailing block
+static int __qr_form_q(int m, int n, REAL* a, int lda, REAL* q, int ldq, REAL* scratch)
+{
+    int i,j0,nb;
+    int steps = __qr_steps(m,n);
+    REAL* tau = scratch;
+    REAL* V = tau+m;
+    REAL* T = V+(m*QR_BLOCK);
+    REAL* W = T+(QR_BLOCK*QR_BLOCK);
+    for(i=0;i<m;i++){
+        memset(&q[i*ldq], 0, m*sizeof(REAL));
+        q[(i*ldq)+i] = RL(1.0);
+    }
+    if(steps<1) return 0;
+    for(j0=((steps-1)/QR_BLOCK)*QR_BLOCK;j0>=0;j0-=QR_BLOCK){
+        nb = (steps-j0<QR_BLOCK) ? steps-j0 : QR_BLOCK;
+        __qr_wy(m, j0, nb, a, lda, tau, V, T);
+        if(unlikely(__qr_apply(0, m-j0, nb, V, T, &q[(j0*ldq)+j0], ldq, m-j0, W))) return -1;
+    }
+    return 0;
+}
+
+
+// b = Q^T*b for the length m vector b, one reflector at a time
+static void __qr_apply_qt(int m, int n, REAL* a, int lda, REAL* tau, REAL* b)
+{
+    int i,k;
+    REAL s;
+    for(k=0;k<__qr_steps(m,n);k++){
+        if(tau[k]==RL(0.0)) continue;
+        s = b[k];
+        for(i=k+1;i<m;i++) s += a[(i*lda)+k]*b[i];
+        s *= tau[k];
+        b[k] -= s;
+        for(i=k+1;i<m;i++) b[i] -= s*a[(i*lda)+k];
+    }
+    return;
+}
+
+
+// fill an already allocated square matrix with the identity
+static void __set_identity(MAT* A)
+{
+    int i;
+    memset(A->d[0], 0, (size_t)A->rows*A->stride*sizeof(REAL));
+    for(i=0;i<A->rows;i++) A->d[i][i]=RL(1.0);
+    return;
+}
+
+
+int ALGEBRA_FN(qr_decomp)(MAT A, MAT* Q, MAT* R)
+{
+    int ret;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(rc_workspace_alloc(&ws, rc_algebra_workspace_size(A.rows,A.cols)))){
+        fprintf(stderr,"ERROR in %s, failed to allocate workspace\n", __func__);
+        return -1;
+    }
+    ret = ALGEBRA_FN(qr_decomp_ws)(A,Q,R,&ws);
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+int ALGEBRA_FN(qr_decomp_ws)(MAT A, MAT* Q, MAT* R, rc_workspace_t* ws)
+{
+    int i,j;
+    size_t mark;
+    REAL* scratch;
+
+    // Sanity Checks
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized yet\n", __func__);
+        return -1;
+    }
+    if(unlikely(ws==NULL || R==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    // start R as A
+    if(unlikely(MATRIX_FN(duplicate)(A,R))){
+        fprintf(stderr,"ERROR in %s, failed to duplicate A\n", __func__);
+        return -1;
+    }
+    if(unlikely(Q!=NULL && MATRIX_FN(alloc)(Q,A.rows,A.rows))){
+        fprintf(stderr,"ERROR in %s, failed to allocate Q\n", __func__);
+        return -1;
+    }
+    mark = ws->used;
+    scratch = __ws_push(ws, QR_SCRATCH(A.rows,A.cols)*sizeof(REAL));
+    if(unlikely(scratch==NULL)){
+        fprintf(stderr,"ERROR in %s, workspace too small\n", __func__);
+        ws->used = mark;
+        return -1;
+    }
+    if(unlikely(__qr_factor(A.rows, A.cols, R->d[0], R->stride, scratch) ||
+                (Q!=NULL && __qr_form_q(A.rows, A.cols, R->d[0], R->stride,
+                                                Q->d[0], Q->stride, scratch)))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", __func__);
+        ws->used = mark;
+        return -1;
+    }
+    // the reflectors are no longer needed, clear them out of R
+    for(i=1;i<A.rows;i++){
+        for(j=0;j<i && j<A.cols;j++) R->d[i][j] = RL(0.0);
+    }
+    ws->used = mark;
+    return 0;
+}
+
+
+/*
+ * Triangular solves T*X = B done in place in X, where T is n x n with leading
+ * dimension ldt and X holds k right hand sides as n x k with leading dimension
+ * ldx. Rows are handled TRSM_BLOCK at a time: the contribution of every row
+ * already solved is subtracted from the whole block in one gemm, which leaves
+ * only a small triangle on the diagonal for axpy updates across all k right
+ * hand sides at once. A single contiguous right hand side is done with dot
+ * products instead since there is nothing to sweep across. The diagonal must
+ * be nonzero, callers check that. When unit is set the lower solve takes the
+ * diagonal of T to be ones without reading it, as for the L of an in-place LU.
+ */
+#define TRSM_BLOCK  64
+
+static int __trsm_lower(int n, int k, REAL* T, int ldt, REAL* X, int ldx, int unit)
+{
+    int i,p,i0,nb;
+    if(k==1 && ldx==1){
+        for(i=0;i<n;i++){
+            X[i] -= PREC(__vectorized_mult_accumulate)(&T[i*ldt], X, i);
+            if(!unit) X[i] /= T[(i*ldt)+i];
+        }
+        return 0;
+    }
+    for(i0=0;i0<n;i0+=TRSM_BLOCK){
+        nb = (n-i0<TRSM_BLOCK) ? n-i0 : TRSM_BLOCK;
+        if(i0>0 && unlikely(PREC(__gemm)(0, 0, nb, k, i0, RL(-1.0), &T[i0*ldt], ldt,
+                                    X, ldx, RL(1.0), &X[i0*ldx], ldx))) return -1;
+        for(i=i0;i<i0+nb;i++){
+            for(p=i0;p<i;p++) PREC(__vectorized_axpy)(-T[(i*ldt)+p], &X[p*ldx], &X[i*ldx], k);
+            if(!unit) PREC(__vectorized_scale)(RL(1.0)/T[(i*ldt)+i], &X[i*ldx], k);
+        }
+    }
+    return 0;
+}
+
+
+static int __trsm_upper(int n, int k, REAL* T, int ldt, REAL* X, int ldx)
+{
+    int i,p,i0,i1;
+    if(k==1 && ldx==1){
+        for(i=n-1;i>=0;i--){
+            X[i] -= PREC(__vectorized_mult_accumulate)(&T[(i*ldt)+i+1], &X[i+1], n-i-1);
+            X[i] /= T[(i*ldt)+i];
+        }
+        return 0;
+    }
+    for(i1=n;i1>0;i1-=TRSM_BLOCK){
+        i0 = (i1>TRSM_BLOCK) ? i1-TRSM_BLOCK : 0;
+        if(i1<n && unlikely(PREC(__gemm)(0, 0, i1-i0, k, n-i1, RL(-1.0), &T[(i0*ldt)+i1], ldt,
+                                    &X[i1*ldx], ldx, RL(1.0), &X[i0*ldx], ldx))) return -1;
+        for(i=i1-1;i>=i0;i--){
+            for(p=i+1;p<i1;p++) PREC(__vectorized_axpy)(-T[(i*ldt)+p], &X[p*ldx], &X[i*ldx], k);
+            PREC(__vectorized_scale)(RL(1.0)/T[(i*ldt)+i], &X[i*ldx], k);
+        }
+    }
+    return 0;
+}
+
+
+/*
+ * Blocked right-looking LU, see algebra_common.h. Each panel of LU_BLOCK
+ * columns is factored with plain row operations, then the block row to its
+ * right is solved against the panel's unit lower triangle and the whole
+ * trailing matrix is updated with one gemm, which is where nearly all of the
+ * flops go for large n.
+ */
+#define LU_BLOCK    64
+
+int PREC(__lu_inplace)(REAL* a, int n, int lda, int* ipiv, int* sign)
+{
+    int i,j,k,p,j0,nb,m2;
+    REAL l, max, tmp;
+    *sign = 1;
+    for(j0=0;j0<n;j0+=LU_BLOCK){
+        nb = (n-j0<LU_BLOCK) ? n-j0 : LU_BLOCK;
+        // factor the panel, columns j0 to j0+nb-1 of every row from j0 down
+        for(k=j0;k<j0+nb;k++){
+            p = k;
+            max = FABS(a[(k*lda)+k]);
+            for(i=k+1;i<n;i++){
+                if(FABS(a[(i*lda)+k])>max){
+                    max = FABS(a[(i*lda)+k]);
+                    p = i;
+                }
+            }
+            ipiv[k] = p;
+            if(p!=k){
+                for(j=0;j<n;j++){
+                    tmp = a[(k*lda)+j];
+                    a[(k*lda)+j] = a[(p*lda)+j];
+                    a[(p*lda)+j] = tmp;
+                }
+                *sign = -*sign;
+            }
+            if(max==RL(0.0)) continue;
+            for(i=k+1;i<n;i++){
+                l = a[(i*lda)+k] /= a[(k*lda)+k];
+                if(l!=RL(0.0)) PREC(__vectorized_axpy)(-l, &a[(k*lda)+k+1], &a[(i*lda)+k+1], j0+nb-k-1);
+            }
+        }
+        m2 = n-j0-nb;
+        if(m2<=0) break;
+        // U12 = inv(L11)*A12
+        for(i=j0+1;i<j0+nb;i++){
+            for(p=j0;p<i;p++) PREC(__vectorized_axpy)(-a[(i*lda)+p], &a[(p*lda)+j0+nb], &a[(i*lda)+j0+nb], m2);
+        }
+        // A22 -= L21*U12
+        if(unlikely(PREC(__gemm)(0, 0, m2, m2, nb, RL(-1.0), &a[((j0+nb)*lda)+j0], lda,
+                        &a[(j0*lda)+j0+nb], lda, RL(1.0), &a[((j0+nb)*lda)+j0+nb], lda))) return -1;
+    }
+    return 0;
+}
+
+
+int PREC(__lu_apply)(REAL* lu, int n, int ld, int* ipiv, REAL* X, int k, int ldx)
+{
+    int i,j;
+    REAL tmp;
+    for(i=0;i<n;i++){
+        if(ipiv[i]==i) continue;
+        for(j=0;j<k;j++){
+            tmp = X[(i*ldx)+j];
+            X[(i*ldx)+j] = X[(ipiv[i]*ldx)+j];
+            X[(ipiv[i]*ldx)+j] = tmp;
+        }
+    }
+    if(unlikely(__trsm_lower(n, k, lu, ld, X, ldx, 1) ||
+                __trsm_upper(n, k, lu, ld, X, ldx))) return -1;
+    return 0;
+}
+
+
+// shared checks and setup for the public triangular solves, copies B into X
+static int __trsm_setup(MAT T, MAT B, MAT* X, const char* name)
+{
+    int i;
+    if(unlikely(!T.initialized || !B.initialized)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", name);
+        return -1;
+    }
+    if(unlikely(T.rows!=T.cols || B.rows!=T.rows)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", name);
+        return -1;
+    }
+    for(i=0;i<T.rows;i++){
+        if(unlikely(FABS(T.d[i][i])<(REAL)zero_tolerance)){
+            fprintf(stderr,"ERROR in %s, matrix is singular\n", name);
+            return -1;
+        }
+    }
+    if(unlikely(X->initialized && X->d[0]==T.d[0])){
+        fprintf(stderr,"ERROR in %s, X must not be T\n", name);
+        return -1;
+    }
+    if(unlikely(MATRIX_FN(duplicate)(B,X))){
+        fprintf(stderr,"ERROR in %s, failed to allocate X\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+
+int ALGEBRA_FN(solve_lower_triangular)(MAT L, MAT B, MAT* X)
+{
+    if(unlikely(__trsm_setup(L,B,X,__func__))) return -1;
+    if(unlikely(__trsm_lower(L.rows, B.cols, L.d[0], L.stride, X->d[0], X->stride, 0))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+int ALGEBRA_FN(solve_upper_triangular)(MAT U, MAT B, MAT* X)
+{
+    if(unlikely(__trsm_setup(U,B,X,__func__))) return -1;
+    if(unlikely(__trsm_upper(U.rows, B.cols, U.d[0], U.stride, X->d[0], X->stride))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+int ALGEBRA_FN(lin_system_solve)(MAT A, VEC b, VEC* x)
+{
+    int ret;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(rc_workspace_alloc(&ws, rc_algebra_workspace_size(A.rows,A.cols)))){
+        fprintf(stderr,"ERROR in %s, failed to allocate workspace\n", __func__);
+        return -1;
+    }
+    ret = ALGEBRA_FN(lin_system_solve_ws)(A,b,x,&ws);
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+// eliminating column k from a block of rows below the pivot row, large
+// trailing blocks are split across the thread pool
+typedef struct __elim_job_t{
+    REAL** a;
+    REAL* b;
+    int k, n, chunk;
+} __elim_job_t;
+
+
+static void __elim_rows(REAL** a, REAL* b, int k, int n, int start, int end)
+{
+    int j;
+    REAL fAcc;
+    for(j=start;j<end;j++){ // current row of matrix
+        fAcc = -a[j][k]/a[k][k];
+        PREC(__vectorized_axpy)(fAcc, &a[k][k], &a[j][k], n-k);
+        // free member recalculation
+        b[j] = b[j] + (fAcc*b[k]);
+    }
+    return;
+}
+
+
+static void __elim_task(void* arg, int task)
+{
+    __elim_job_t* e = (__elim_job_t*)arg;
+    int start = e->k+1+(task*e->chunk);
+    int end = start+e->chunk;
+    if(end>e->n) end = e->n;
+    __elim_rows(e->a, e->b, e->k, e->n, start, end);
+    return;
+}
+
+
+int ALGEBRA_FN(lin_system_solve_ws)(MAT A, VEC b, VEC* x, rc_workspace_t* ws)
+{
+    /*Thank you to Henry Guennadi Levkin for open sourcing this routine, it's
+    * adapted here and includes better detection of unsolvable systems.
+    */
+    REAL fMaxElem, fAcc;
+    int nDim,i,k,m;
+    int threads = __pool_threads();
+    size_t mark;
+    MAT Atemp;
+    VEC btemp;
+    // sanity checks
+    if(!A.initialized || !b.initialized){
+        fprintf(stderr,"ERROR in %s, matrix or vector uninitialized\n", __func__);
+        return -1;
+    }
+    if(A.cols != b.len){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    if(unlikely(ws==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL workspace\n", __func__);
+        return -1;
+    }
+    // alloc memory for x
+    nDim = A.cols;
+    if(unlikely(VECTOR_FN(alloc)(x,nDim))){
+        fprintf(stderr,"ERROR in %s, failed to alloc vector\n", __func__);
+        return -1;
+    }
+    // duplicate user arguments into the workspace so we don't modify them
+    mark = ws->used;
+    if(unlikely(PREC(__ws_matrix)(ws,&Atemp,A.rows,A.cols) || PREC(__ws_vector)(ws,&btemp,b.len))){
+        fprintf(stderr,"ERROR in %s, workspace too small\n", __func__);
+        ws->used = mark;
+        return -1;
+    }
+    for(i=0;i<A.rows;i++) memcpy(Atemp.d[i],A.d[i],A.cols*sizeof(REAL));
+    memcpy(btemp.d,b.d,b.len*sizeof(REAL));
+    // gaussian elemination
+    for(k=0;k<(nDim-1);k++){ // base row of matrix
+        // search of line with max element
+        fMaxElem=FABS(Atemp.d[k][k]);
+        m=k;
+        for(i=k+1;i<nDim;i++){
+            if(fMaxElem<FABS(Atemp.d[i][k])){
+                fMaxElem=Atemp.d[i][k];
+                m=i;
+            }
+        }
+        // permutation of base line (index k) and max element line(index m)
+        if(m!=k){
+            for(i=k;i<nDim;i++){
+                fAcc=Atemp.d[k][i];
+                Atemp.d[k][i]=Atemp.d[m][i];
+                Atemp.d[m][i]=fAcc;
+            }
+            fAcc=btemp.d[k];
+            btemp.d[k]=btemp.d[m];
+            btemp.d[m]=fAcc;
+        }
+        // check if we got 0 on the diagonal indicating matrix isn't full rank
+        if(unlikely(FABS(Atemp.d[k][k])<(REAL)zero_tolerance)){
+            fprintf(stderr,"ERROR in %s, matrix not full rank\n", __func__);
+            ws->used = mark;
+            return -1;
+        }
+        // triangulation of matrix with coefficients
+        if(threads>1 && (long)(nDim-k)*(nDim-k) >= POOL_LU_ELEMS){
+            __elim_job_t job = {.a=Atemp.d, .b=btemp.d, .k=k, .n=nDim,
+                                .chunk=(nDim-k-1+threads-1)/threads};
+            __pool_run(__elim_task, &job, threads);
+        }
+        else __elim_rows(Atemp.d, btemp.d, k, nDim, k+1, nDim);
+    }
+    // check the last pivot which the loop above never reached
+    if(unlikely(FABS(Atemp.d[nDim-1][nDim-1])<(REAL)zero_tolerance)){
+        fprintf(stderr,"ERROR in %s, matrix not full rank\n", __func__);
+        ws->used = mark;
+        return -1;
+    }
+    // now run up the upper diagonal matrix solving for x
+    memcpy(x->d,btemp.d,nDim*sizeof(REAL));
+    __trsm_upper(nDim, 1, Atemp.d[0], Atemp.stride, x->d, 1);
+    // give the workspace back
+    ws->used = mark;
+    return 0;
+}
+
+
+int ALGEBRA_FN(lin_system_solve_qr)(MAT A, VEC b, VEC* x)
+{
+    int ret = -1;
+    REAL *scratch, *y;
+    MAT R = MAT_INIT;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(!A.initialized || !b.initialized)){
+        fprintf(stderr,"ERROR in %s, matrix or vector uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A.rows<A.cols || b.len!=A.rows)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    // Ax=b
+    // QRx=b
+    // Rx=Q'b   because Q'Q=I
+    // Q' is applied to a copy of b straight from the reflectors so Q is never
+    // formed, which for a tall A is most of the work and memory
+    if(unlikely(MATRIX_FN(duplicate)(A,&R) ||
+                rc_workspace_alloc(&ws, __ws_round(QR_SCRATCH(A.rows,A.cols)*sizeof(REAL)) +
+                                        __ws_round(b.len*sizeof(REAL))))){
+        fprintf(stderr,"ERROR in %s, failed to allocate memory\n", __func__);
+        MATRIX_FN(free)(&R);
+        return -1;
+    }
+    scratch = __ws_push(&ws, QR_SCRATCH(A.rows,A.cols)*sizeof(REAL));
+    y = __ws_push(&ws, b.len*sizeof(REAL));
+    memcpy(y, b.d, b.len*sizeof(REAL));
+    if(unlikely(__qr_factor(R.rows, R.cols, R.d[0], R.stride, scratch))){
+        fprintf(stderr,"ERROR in %s, failed to perform QR decomp\n", __func__);
+        goto end;
+    }
+    __qr_apply_qt(R.rows, R.cols, R.d[0], R.stride, scratch, y);
+    // allocate memory for the output x
+    if(unlikely(VECTOR_FN(alloc)(x,R.cols))){
+        fprintf(stderr,"ERROR in %s, failed to alloc vector\n", __func__);
+        goto end;
+    }
+    // solve for x knowing R is upper triangular
+    memcpy(x->d,y,R.cols*sizeof(REAL));
+    __trsm_upper(R.cols, 1, R.d[0], R.stride, x->d, 1);
+    ret = 0;
+
+end:
+    MATRIX_FN(free)(&R);
+    rc_workspace_free(&ws);
+    return ret;
+}
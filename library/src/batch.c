@@ -0,0 +1,571 @@
+/**
+ * @file       batch.c
+ *
+ * @brief      see batch.h
+ *
+ * Every operation is split into chunks of BATCH_CHUNK matrices so all of the
+ * planes touched by one chunk stay in L1 cache while the chunk is worked on.
+ * Inside a chunk the innermost loop always runs across the batch with unit
+ * stride which is what lets the compiler vectorize it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // for malloc, calloc, free
+#include <string.h> // for memset
+#include <math.h>
+
+#include <rc_math/batch.h>
+#include "algebra_common.h"
+
+#define BATCH_CHUNK 256
+
+// doubles of stack scratch a batched solve works in, one chunk at a time
+#define BATCH_SOLVE_SCRATCH 8192
+
+// build the inner loops for AVX2 and AVX-512 too where gcc and the C library
+// support picking a function version at load time
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__) && \
+    defined(__linux__) && !defined(__ANDROID__)
+#define BATCH_CLONES __attribute__((target_clones("avx512f","avx2","default")))
+#else
+#define BATCH_CLONES
+#endif
+
+// element (i,j) of the current lane in a chunk of dim x dim matrices
+#define IN(i,j)  A[((((i)*dim)+(j))*n)+k]
+#define OUT(i,j) O[((((i)*dim)+(j))*n)+k]
+
+
+rc_matrix_batch_t rc_matrix_batch_empty(void)
+{
+    rc_matrix_batch_t out = RC_MATRIX_BATCH_INITIALIZER;
+    return out;
+}
+
+
+int rc_matrix_batch_alloc(rc_matrix_batch_t* B, int n, int rows, int cols)
+{
+    // sanity checks
+    if(unlikely(n<1 || rows<1 || cols<1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_alloc, n, rows, and cols must be >=1\n");
+        return -1;
+    }
+    if(unlikely(B==NULL)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_alloc, received NULL pointer\n");
+        return -1;
+    }
+    // if B is already allocated and of the right size, nothing to do!
+    if(B->initialized==1 && n==B->n && rows==B->rows && cols==B->cols) return 0;
+    // free any old memory
+    rc_matrix_batch_free(B);
+    B->d = (double*)malloc((size_t)n*rows*cols*sizeof(double));
+    if(unlikely(B->d==NULL)){
+        perror("ERROR in rc_matrix_batch_alloc");
+        fprintf(stderr, "tried allocating %d %dx%d matrices\n", n,rows,cols);
+        return -1;
+    }
+    B->n = n;
+    B->rows = rows;
+    B->cols = cols;
+    B->initialized = 1;
+    return 0;
+}
+
+
+int rc_matrix_batch_zeros(rc_matrix_batch_t* B, int n, int rows, int cols)
+{
+    if(unlikely(rc_matrix_batch_alloc(B,n,rows,cols))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_zeros, failed to allocate batch\n");
+        return -1;
+    }
+    memset(B->d, 0, (size_t)n*rows*cols*sizeof(double));
+    return 0;
+}
+
+
+int rc_matrix_batch_free(rc_matrix_batch_t* B)
+{
+    rc_matrix_batch_t new = RC_MATRIX_BATCH_INITIALIZER;
+    if(unlikely(B==NULL)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_free, received NULL pointer\n");
+        return -1;
+    }
+    if(B->initialized==1) free(B->d);
+    *B = new;
+    return 0;
+}
+
+
+int rc_matrix_batch_set(rc_matrix_batch_t* B, int k, rc_matrix_t A)
+{
+    int i,j;
+    if(unlikely(B==NULL || B->initialized!=1 || A.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_set, batch or matrix uninitialized\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=B->rows || A.cols!=B->cols)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_set, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(k<0 || k>=B->n)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_set, index %d out of range\n", k);
+        return -1;
+    }
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) RC_MATRIX_BATCH_AT(*B,k,i,j) = A.d[i][j];
+    }
+    return 0;
+}
+
+
+int rc_matrix_batch_get(rc_matrix_batch_t B, int k, rc_matrix_t* A)
+{
+    int i,j;
+    if(unlikely(B.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_get, batch uninitialized\n");
+        return -1;
+    }
+    if(unlikely(k<0 || k>=B.n)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_get, index %d out of range\n", k);
+        return -1;
+    }
+    if(unlikely(rc_matrix_alloc(A,B.rows,B.cols))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_get, failed to allocate matrix\n");
+        return -1;
+    }
+    for(i=0;i<B.rows;i++){
+        for(j=0;j<B.cols;j++) A->d[i][j] = RC_MATRIX_BATCH_AT(B,k,i,j);
+    }
+    return 0;
+}
+
+
+// C = A*B for 'len' lanes, A is m x p, B is p x q, all planes n apart
+BATCH_CLONES
+static void __multiply_chunk(double* __restrict__ A, double* __restrict__ B,
+                double* __restrict__ C, int n, int len, int m, int p, int q)
+{
+    int i,j,l,k;
+    for(i=0;i<m;i++){
+        for(j=0;j<q;j++){
+            double* __restrict__ c = &C[((i*q)+j)*n];
+            for(k=0;k<len;k++) c[k] = 0.0;
+            for(l=0;l<p;l++){
+                double* __restrict__ a = &A[((i*p)+l)*n];
+                double* __restrict__ b = &B[((l*q)+j)*n];
+                for(k=0;k<len;k++) c[k] += a[k]*b[k];
+            }
+        }
+    }
+    return;
+}
+
+
+int rc_matrix_batch_multiply(rc_matrix_batch_t A, rc_matrix_batch_t B, rc_matrix_batch_t* C)
+{
+    int k0;
+    if(unlikely(A.initialized!=1 || B.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_multiply, batch not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.cols!=B.rows || A.n!=B.n)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_multiply, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(C->initialized && (C->d==A.d || C->d==B.d))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_multiply, C must not be A or B\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_batch_alloc(C,A.n,A.rows,B.cols))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_multiply, can't allocate memory for C\n");
+        return -1;
+    }
+    for(k0=0;k0<A.n;k0+=BATCH_CHUNK){
+        int len = (A.n-k0)<BATCH_CHUNK ? (A.n-k0) : BATCH_CHUNK;
+        __multiply_chunk(&A.d[k0], &B.d[k0], &C->d[k0], A.n, len, A.rows, A.cols, B.cols);
+    }
+    return 0;
+}
+
+
+int rc_matrix_batch_times_col_vec(rc_matrix_batch_t A, rc_matrix_batch_t v, rc_matrix_batch_t* c)
+{
+    int k0;
+    if(unlikely(A.initialized!=1 || v.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_times_col_vec, batch not initialized\n");
+        return -1;
+    }
+    if(unlikely(v.cols!=1 || A.cols!=v.rows || A.n!=v.n)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_times_col_vec, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(c->initialized && (c->d==A.d || c->d==v.d))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_times_col_vec, c must not be A or v\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_batch_alloc(c,A.n,A.rows,1))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_times_col_vec, can't allocate memory for c\n");
+        return -1;
+    }
+    // a mat-vec is just a multiply with a single column
+    for(k0=0;k0<A.n;k0+=BATCH_CHUNK){
+        int len = (A.n-k0)<BATCH_CHUNK ? (A.n-k0) : BATCH_CHUNK;
+        __multiply_chunk(&A.d[k0], &v.d[k0], &c->d[k0], A.n, len, A.rows, A.cols, 1);
+    }
+    return 0;
+}
+
+
+// determinant of 'len' lanes of dim x dim matrices into det
+BATCH_CLONES
+static void __det_chunk(double* __restrict__ A, double* __restrict__ det, int n, int len, int dim)
+{
+    int k;
+    switch(dim){
+    case 1:
+        for(k=0;k<len;k++) det[k] = IN(0,0);
+        break;
+    case 2:
+        for(k=0;k<len;k++) det[k] = IN(0,0)*IN(1,1) - IN(0,1)*IN(1,0);
+        break;
+    case 3:
+        for(k=0;k<len;k++){
+            det[k] = IN(0,0)*(IN(1,1)*IN(2,2) - IN(1,2)*IN(2,1))
+                   + IN(0,1)*(IN(1,2)*IN(2,0) - IN(1,0)*IN(2,2))
+                   + IN(0,2)*(IN(1,0)*IN(2,1) - IN(1,1)*IN(2,0));
+        }
+        break;
+    case 4:
+        for(k=0;k<len;k++){
+            // 2x2 minors of the top two and bottom two rows
+            double s0 = IN(0,0)*IN(1,1) - IN(1,0)*IN(0,1);
+            double s1 = IN(0,0)*IN(1,2) - IN(1,0)*IN(0,2);
+            double s2 = IN(0,0)*IN(1,3) - IN(1,0)*IN(0,3);
+            double s3 = IN(0,1)*IN(1,2) - IN(1,1)*IN(0,2);
+            double s4 = IN(0,1)*IN(1,3) - IN(1,1)*IN(0,3);
+            double s5 = IN(0,2)*IN(1,3) - IN(1,2)*IN(0,3);
+            double c5 = IN(2,2)*IN(3,3) - IN(3,2)*IN(2,3);
+            double c4 = IN(2,1)*IN(3,3) - IN(3,1)*IN(2,3);
+            double c3 = IN(2,1)*IN(3,2) - IN(3,1)*IN(2,2);
+            double c2 = IN(2,0)*IN(3,3) - IN(3,0)*IN(2,3);
+            double c1 = IN(2,0)*IN(3,2) - IN(3,0)*IN(2,2);
+            double c0 = IN(2,0)*IN(3,1) - IN(3,0)*IN(2,1);
+            det[k] = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+        }
+        break;
+    }
+    return;
+}
+
+
+// inverse of 'len' lanes of dim x dim matrices into O, singular lanes are
+// zeroed. Returns the number of singular lanes.
+BATCH_CLONES
+static int __invert_chunk(double* __restrict__ A, double* __restrict__ O, int n, int len, int dim)
+{
+    int k;
+    int singular = 0;
+    double tol = zero_tolerance;
+
+    switch(dim){
+    case 1:
+        for(k=0;k<len;k++){
+            int ok = fabs(IN(0,0))>tol;
+            OUT(0,0) = ok ? 1.0/IN(0,0) : 0.0;
+            singular += !ok;
+        }
+        break;
+    case 2:
+        for(k=0;k<len;k++){
+            double d = IN(0,0)*IN(1,1) - IN(0,1)*IN(1,0);
+            int ok = fabs(d)>tol;
+            double id = ok ? 1.0/d : 0.0;
+            singular += !ok;
+            OUT(0,0) =  IN(1,1)*id;
+            OUT(0,1) = -IN(0,1)*id;
+            OUT(1,0) = -IN(1,0)*id;
+            OUT(1,1) =  IN(0,0)*id;
+        }
+        break;
+    case 3:
+        for(k=0;k<len;k++){
+            // cofactors, transposed into the adjugate below
+            double c00 = IN(1,1)*IN(2,2) - IN(1,2)*IN(2,1);
+            double c01 = IN(1,2)*IN(2,0) - IN(1,0)*IN(2,2);
+            double c02 = IN(1,0)*IN(2,1) - IN(1,1)*IN(2,0);
+            double d = IN(0,0)*c00 + IN(0,1)*c01 + IN(0,2)*c02;
+            int ok = fabs(d)>tol;
+            double id = ok ? 1.0/d : 0.0;
+            singular += !ok;
+            OUT(0,0) = c00*id;
+            OUT(0,1) = (IN(0,2)*IN(2,1) - IN(0,1)*IN(2,2))*id;
+            OUT(0,2) = (IN(0,1)*IN(1,2) - IN(0,2)*IN(1,1))*id;
+            OUT(1,0) = c01*id;
+            OUT(1,1) = (IN(0,0)*IN(2,2) - IN(0,2)*IN(2,0))*id;
+            OUT(1,2) = (IN(0,2)*IN(1,0) - IN(0,0)*IN(1,2))*id;
+            OUT(2,0) = c02*id;
+            OUT(2,1) = (IN(0,1)*IN(2,0) - IN(0,0)*IN(2,1))*id;
+            OUT(2,2) = (IN(0,0)*IN(1,1) - IN(0,1)*IN(1,0))*id;
+        }
+        break;
+    case 4:
+        for(k=0;k<len;k++){
+            double s0 = IN(0,0)*IN(1,1) - IN(1,0)*IN(0,1);
+            double s1 = IN(0,0)*IN(1,2) - IN(1,0)*IN(0,2);
+            double s2 = IN(0,0)*IN(1,3) - IN(1,0)*IN(0,3);
+            double s3 = IN(0,1)*IN(1,2) - IN(1,1)*IN(0,2);
+            double s4 = IN(0,1)*IN(1,3) - IN(1,1)*IN(0,3);
+            double s5 = IN(0,2)*IN(1,3) - IN(1,2)*IN(0,3);
+            double c5 = IN(2,2)*IN(3,3) - IN(3,2)*IN(2,3);
+            double c4 = IN(2,1)*IN(3,3) - IN(3,1)*IN(2,3);
+            double c3 = IN(2,1)*IN(3,2) - IN(3,1)*IN(2,2);
+            double c2 = IN(2,0)*IN(3,3) - IN(3,0)*IN(2,3);
+            double c1 = IN(2,0)*IN(3,2) - IN(3,0)*IN(2,2);
+            double c0 = IN(2,0)*IN(3,1) - IN(3,0)*IN(2,1);
+            double d = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+            int ok = fabs(d)>tol;
+            double id = ok ? 1.0/d : 0.0;
+            singular += !ok;
+            OUT(0,0) = ( IN(1,1)*c5 - IN(1,2)*c4 + IN(1,3)*c3)*id;
+            OUT(0,1) = (-IN(0,1)*c5 + IN(0,2)*c4 - IN(0,3)*c3)*id;
+            OUT(0,2) = ( IN(3,1)*s5 - IN(3,2)*s4 + IN(3,3)*s3)*id;
+            OUT(0,3) = (-IN(2,1)*s5 + IN(2,2)*s4 - IN(2,3)*s3)*id;
+            OUT(1,0) = (-IN(1,0)*c5 + IN(1,2)*c2 - IN(1,3)*c1)*id;
+            OUT(1,1) = ( IN(0,0)*c5 - IN(0,2)*c2 + IN(0,3)*c1)*id;
+            OUT(1,2) = (-IN(3,0)*s5 + IN(3,2)*s2 - IN(3,3)*s1)*id;
+            OUT(1,3) = ( IN(2,0)*s5 - IN(2,2)*s2 + IN(2,3)*s1)*id;
+            OUT(2,0) = ( IN(1,0)*c4 - IN(1,1)*c2 + IN(1,3)*c0)*id;
+            OUT(2,1) = (-IN(0,0)*c4 + IN(0,1)*c2 - IN(0,3)*c0)*id;
+            OUT(2,2) = ( IN(3,0)*s4 - IN(3,1)*s2 + IN(3,3)*s0)*id;
+            OUT(2,3) = (-IN(2,0)*s4 + IN(2,1)*s2 - IN(2,3)*s0)*id;
+            OUT(3,0) = (-IN(1,0)*c3 + IN(1,1)*c1 - IN(1,2)*c0)*id;
+            OUT(3,1) = ( IN(0,0)*c3 - IN(0,1)*c1 + IN(0,2)*c0)*id;
+            OUT(3,2) = (-IN(3,0)*s3 + IN(3,1)*s1 - IN(3,2)*s0)*id;
+            OUT(3,3) = ( IN(2,0)*s3 - IN(2,1)*s1 + IN(2,2)*s0)*id;
+        }
+        break;
+    }
+    return singular;
+}
+
+
+int rc_matrix_batch_determinant(rc_matrix_batch_t A, rc_vector_t* det)
+{
+    int k0;
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_determinant, batch not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=A.cols || A.rows>4)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_determinant, matrices must be square and at most 4x4\n");
+        return -1;
+    }
+    if(unlikely(rc_vector_alloc(det,A.n))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_determinant, failed to allocate det\n");
+        return -1;
+    }
+    for(k0=0;k0<A.n;k0+=BATCH_CHUNK){
+        int len = (A.n-k0)<BATCH_CHUNK ? (A.n-k0) : BATCH_CHUNK;
+        __det_chunk(&A.d[k0], &det->d[k0], A.n, len, A.rows);
+    }
+    return 0;
+}
+
+
+int rc_matrix_batch_invert(rc_matrix_batch_t A, rc_matrix_batch_t* Ainv)
+{
+    int k0;
+    int singular = 0;
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_invert, batch not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=A.cols || A.rows>4)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_invert, matrices must be square and at most 4x4\n");
+        return -1;
+    }
+    if(unlikely(Ainv->initialized && Ainv->d==A.d)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_invert, Ainv must not be A\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_batch_alloc(Ainv,A.n,A.rows,A.cols))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_invert, can't allocate memory for Ainv\n");
+        return -1;
+    }
+    for(k0=0;k0<A.n;k0+=BATCH_CHUNK){
+        int len = (A.n-k0)<BATCH_CHUNK ? (A.n-k0) : BATCH_CHUNK;
+        singular += __invert_chunk(&A.d[k0], &Ainv->d[k0], A.n, len, A.rows);
+    }
+    if(unlikely(singular)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_invert, %d of %d matrices are singular\n", singular, A.n);
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * Solves 'len' lanes of dim x dim systems with partial pivoting. A and b are
+ * copied into scratch planes len apart, the pivot row of each lane is found
+ * with a running max and swapped into place with selects so every lane runs
+ * the same loops. The inverse of each pivot is kept on the diagonal for the
+ * back substitution into x. Lanes with a zero pivot are written as zeros.
+ * Returns the number of such lanes.
+ */
+BATCH_CLONES
+static int __solve_chunk(double* __restrict__ A, double* b, double* x, double* __restrict__ scratch,
+                                int n, int len, int dim)
+{
+    int i,j,c,k,any;
+    int singular = 0;
+    double tol = zero_tolerance;
+    double* __restrict__ M   = scratch;
+    double* __restrict__ y   = &M[dim*dim*len];
+    double* __restrict__ bad = &y[dim*len];
+    double* __restrict__ mx  = &bad[len];
+    double* __restrict__ pv  = &mx[len];
+
+    for(i=0;i<dim*dim;i++) memcpy(&M[i*len], &A[i*n], len*sizeof(double));
+    for(i=0;i<dim;i++) memcpy(&y[i*len], &b[i*n], len*sizeof(double));
+    for(k=0;k<len;k++) bad[k] = 0.0;
+
+    for(j=0;j<dim;j++){
+        double* __restrict__ pj = &M[(j*dim+j)*len];
+        // row of the largest element in column j of each lane
+        for(k=0;k<len;k++){
+            mx[k] = fabs(pj[k]);
+            pv[k] = j;
+        }
+        for(i=j+1;i<dim;i++){
+            double* __restrict__ a = &M[(i*dim+j)*len];
+            for(k=0;k<len;k++){
+                double v = fabs(a[k]);
+                int gt = v>mx[k];
+                mx[k] = gt ? v : mx[k];
+                pv[k] = gt ? i : pv[k];
+            }
+        }
+        // swap it with row j in the lanes that picked it
+        for(i=j+1;i<dim;i++){
+            any = 0;
+            for(k=0;k<len;k++) any |= (pv[k]==i);
+            if(!any) continue;
+            for(c=j;c<=dim;c++){
+                double* __restrict__ r = (c<dim) ? &M[(j*dim+c)*len] : &y[j*len];
+                double* __restrict__ s = (c<dim) ? &M[(i*dim+c)*len] : &y[i*len];
+                for(k=0;k<len;k++){
+                    double t = r[k];
+                    int sw = (pv[k]==i);
+                    r[k] = sw ? s[k] : t;
+                    s[k] = sw ? t : s[k];
+                }
+            }
+        }
+        // mx becomes the inverse pivot, 0 in singular lanes so they do nothing
+        for(k=0;k<len;k++){
+            int ok = mx[k]>tol;
+            bad[k] = ok ? bad[k] : 1.0;
+            mx[k] = ok ? 1.0/pj[k] : 0.0;
+            pj[k] = mx[k];
+        }
+        // eliminate below the pivot, pv holds each row's factor
+        for(i=j+1;i<dim;i++){
+            double* __restrict__ a = &M[(i*dim+j)*len];
+            for(k=0;k<len;k++) pv[k] = a[k]*mx[k];
+            for(c=j+1;c<dim;c++){
+                double* __restrict__ r = &M[(j*dim+c)*len];
+                double* __restrict__ s = &M[(i*dim+c)*len];
+                for(k=0;k<len;k++) s[k] -= pv[k]*r[k];
+            }
+            double* __restrict__ yi = &y[i*len];
+            double* __restrict__ yj = &y[j*len];
+            for(k=0;k<len;k++) yi[k] -= pv[k]*yj[k];
+        }
+    }
+
+    // back substitution, all in the scratch y before touching x
+    for(i=dim-1;i>=0;i--){
+        double* __restrict__ yi = &y[i*len];
+        for(c=i+1;c<dim;c++){
+            double* __restrict__ a = &M[(i*dim+c)*len];
+            double* __restrict__ yc = &y[c*len];
+            for(k=0;k<len;k++) yi[k] -= a[k]*yc[k];
+        }
+        double* __restrict__ d = &M[(i*dim+i)*len];
+        for(k=0;k<len;k++) yi[k] *= d[k];
+    }
+    for(i=0;i<dim;i++){
+        double* __restrict__ yi = &y[i*len];
+        double* xi = &x[i*n];
+        for(k=0;k<len;k++) xi[k] = bad[k]!=0.0 ? 0.0 : yi[k];
+    }
+    for(k=0;k<len;k++) singular += bad[k]!=0.0;
+    return singular;
+}
+
+
+// one chunk of lanes of a batched solve per task
+typedef struct __solve_job_t{
+    double* A;
+    double* b;
+    double* x;
+    int n, dim, lanes, singular;
+} __solve_job_t;
+
+
+static void __solve_task(void* arg, int task)
+{
+    __solve_job_t* j = (__solve_job_t*)arg;
+    double scratch[BATCH_SOLVE_SCRATCH];
+    int k0 = task*j->lanes;
+    int len = (j->n-k0)<j->lanes ? (j->n-k0) : j->lanes;
+    int s = __solve_chunk(&j->A[k0], &j->b[k0], &j->x[k0], scratch, j->n, len, j->dim);
+    if(s) __atomic_fetch_add(&j->singular, s, __ATOMIC_RELAXED);
+    return;
+}
+
+
+int rc_matrix_batch_lin_system_solve(rc_matrix_batch_t A, rc_matrix_batch_t b, rc_matrix_batch_t* x)
+{
+    int t, tasks;
+    __solve_job_t job;
+    if(unlikely(A.initialized!=1 || b.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_lin_system_solve, batch not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=A.cols || A.rows>RC_MATRIX_BATCH_SOLVE_MAX_DIM)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_lin_system_solve, matrices must be square and at most %dx%d\n",
+                    RC_MATRIX_BATCH_SOLVE_MAX_DIM, RC_MATRIX_BATCH_SOLVE_MAX_DIM);
+        return -1;
+    }
+    if(unlikely(b.cols!=1 || b.rows!=A.rows || b.n!=A.n)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_lin_system_solve, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(x->initialized && x->d==A.d)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_lin_system_solve, x must not be A\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_batch_alloc(x,A.n,A.rows,1))){
+        fprintf(stderr,"ERROR in rc_matrix_batch_lin_system_solve, can't allocate memory for x\n");
+        return -1;
+    }
+    // as many lanes as fit in the scratch, a multiple of 8 when possible so
+    // the vector loops have no remainder
+    job = (__solve_job_t){.A=A.d, .b=b.d, .x=x->d, .n=A.n, .dim=A.rows, .singular=0};
+    job.lanes = BATCH_SOLVE_SCRATCH/(A.rows*(A.rows+1)+3);
+    if(job.lanes>BATCH_CHUNK) job.lanes = BATCH_CHUNK;
+    if(job.lanes>8) job.lanes &= ~7;
+    tasks = (A.n+job.lanes-1)/job.lanes;
+    if(__pool_threads()>1 && tasks>1 && (long)A.n*A.rows*A.rows*A.rows >= POOL_BATCH_FLOPS){
+        __pool_run(__solve_task, &job, tasks);
+    }
+    else{
+        for(t=0;t<tasks;t++) __solve_task(&job, t);
+    }
+    if(unlikely(job.singular)){
+        fprintf(stderr,"ERROR in rc_matrix_batch_lin_system_solve, %d of %d systems are singular\n", job.singular, A.n);
+        return -1;
+    }
+    return 0;
+}
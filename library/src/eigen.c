@@ -0,0 +1,479 @@
+/**
+ * @file       eigen.c
+ *
+ * @brief      symmetric eigendecomposition and SVD, see algebra.h
+ *
+ * The eigensolver reduces A to tridiagonal form with Householder reflections
+ * and then diagonalizes that with implicit QL steps, after the EISPACK
+ * routines tred2 and tql2. Both work on the transpose of the usual
+ * eigenvector matrix, eigenvectors as rows, so every inner loop runs along a
+ * row of memory.
+ *
+ * The SVD is one-sided Jacobi. The rows of a copy of A, or of A^T when A is
+ * tall, are rotated in pairs until they are all orthogonal to each other, at
+ * which point their lengths are the singular values. Each rotation touches
+ * two contiguous rows and needs only one dot product since the squared row
+ * lengths are carried along from one rotation to the next.
+ */
+
+#include <stdio.h>
+#include <string.h> // for memcpy
+#include <math.h>
+#include <float.h>  // for DBL_EPSILON
+
+#include <rc_math/algebra.h>
+#include "algebra_common.h"
+
+// QL iterations allowed for one eigenvalue before giving up
+#define EIG_MAX_ITER    60
+
+// Jacobi sweeps over every pair of rows allowed before giving up
+#define SVD_MAX_SWEEPS  60
+
+
+/*
+ * x,y = c*x - s*y, s*x + c*y over n values, a plane rotation of two rows
+ */
+static void __rotate_rows(double * __restrict__ x, double * __restrict__ y, double c, double s, int n)
+{
+    int i;
+    double t;
+    for(i=0;i<n;i++){
+        t = x[i];
+        x[i] = c*t - s*y[i];
+        y[i] = s*t + c*y[i];
+    }
+    return;
+}
+
+
+/*
+ * Householder reduction of the n x n symmetric matrix in T to tridiagonal
+ * form, reading only its upper triangle. On return d holds the diagonal and
+ * e[1..n-1] the subdiagonal. With vecs set the rows of T are left holding the
+ * accumulated orthogonal transform, otherwise T is just scratch.
+ */
+static void __tridiagonalize(int n, double** T, double* d, double* e, int vecs)
+{
+    int i,j,k;
+    double scale,h,f,g,hh;
+
+    for(j=0;j<n;j++) d[j] = T[j][n-1];
+    for(i=n-1;i>0;i--){
+        scale = 0.0;
+        h = 0.0;
+        for(k=0;k<i;k++) scale += fabs(d[k]);
+        if(scale==0.0){
+            // row is already reduced
+            e[i] = d[i-1];
+            for(j=0;j<i;j++){
+                d[j] = T[j][i-1];
+                T[j][i] = 0.0;
+                T[i][j] = 0.0;
+            }
+            d[i] = h;
+            continue;
+        }
+        // Householder vector for this row, kept in d
+        for(k=0;k<i;k++){
+            d[k] /= scale;
+            h += d[k]*d[k];
+        }
+        f = d[i-1];
+        g = sqrt(h);
+        if(f>0) g = -g;
+        e[i] = scale*g;
+        h -= f*g;
+        d[i-1] = f-g;
+        // e = A*d over the leading i x i block
+        for(j=0;j<i;j++) e[j] = 0.0;
+        for(j=0;j<i;j++){
+            f = d[j];
+            T[i][j] = f;
+            e[j] += T[j][j]*f + __vectorized_mult_accumulate(&T[j][j+1], &d[j+1], i-j-1);
+            __vectorized_axpy(f, &T[j][j+1], &e[j+1], i-j-1);
+        }
+        f = 0.0;
+        for(j=0;j<i;j++){
+            e[j] /= h;
+            f += e[j]*d[j];
+        }
+        hh = f/(h+h);
+        for(j=0;j<i;j++) e[j] -= hh*d[j];
+        // rank two update of the leading block
+        for(j=0;j<i;j++){
+            __vectorized_axpy(-d[j], &e[j], &T[j][j], i-j);
+            __vectorized_axpy(-e[j], &d[j], &T[j][j], i-j);
+            d[j] = T[j][i-1];
+            T[j][i] = 0.0;
+        }
+        d[i] = h;
+    }
+
+    if(!vecs){
+        for(j=0;j<n;j++) d[j] = T[j][j];
+        e[0] = 0.0;
+        return;
+    }
+
+    // accumulate the reflections
+    for(i=0;i<n-1;i++){
+        T[i][n-1] = T[i][i];
+        T[i][i] = 1.0;
+        h = d[i+1];
+        if(h!=0.0){
+            for(k=0;k<=i;k++) d[k] = T[i+1][k]/h;
+            for(j=0;j<=i;j++){
+                g = __vectorized_mult_accumulate(T[i+1], T[j], i+1);
+                __vectorized_axpy(-g, d, T[j], i+1);
+            }
+        }
+        for(k=0;k<=i;k++) T[i+1][k] = 0.0;
+    }
+    for(j=0;j<n;j++){
+        d[j] = T[j][n-1];
+        T[j][n-1] = 0.0;
+    }
+    T[n-1][n-1] = 1.0;
+    e[0] = 0.0;
+    return;
+}
+
+
+/*
+ * Implicit QL iterations on the tridiagonal matrix from __tridiagonalize,
+ * leaving the eigenvalues in d in ascending order. With vecs set the same
+ * rotations are applied to the rows of T, which then hold the eigenvectors.
+ * Returns -1 if an eigenvalue fails to converge.
+ */
+static int __tridiagonal_ql(int n, double** T, double* d, double* e, int vecs)
+{
+    int i,j,k,l,m,iter;
+    double f,tst1,g,p,r,dl1,h,c,c2,c3,el1,s,s2;
+
+    for(i=1;i<n;i++) e[i-1] = e[i];
+    e[n-1] = 0.0;
+    f = 0.0;
+    tst1 = 0.0;
+    for(l=0;l<n;l++){
+        // find a small subdiagonal element
+        tst1 = fmax(tst1, fabs(d[l])+fabs(e[l]));
+        m = l;
+        while(m<n-1 && fabs(e[m])>DBL_EPSILON*tst1) m++;
+        // iterate until d[l] splits off
+        iter = 0;
+        while(m>l && fabs(e[l])>DBL_EPSILON*tst1){
+            if(unlikely(++iter>EIG_MAX_ITER)) return -1;
+            g = d[l];
+            p = (d[l+1]-g)/(2.0*e[l]);
+            r = hypot(p,1.0);
+            if(p<0) r = -r;
+            d[l] = e[l]/(p+r);
+            d[l+1] = e[l]*(p+r);
+            dl1 = d[l+1];
+            h = g-d[l];
+            for(i=l+2;i<n;i++) d[i] -= h;
+            f += h;
+            // implicit QL transformation
+            p = d[m];
+            c = 1.0;
+            c2 = c;
+            c3 = c;
+            el1 = e[l+1];
+            s = 0.0;
+            s2 = 0.0;
+            for(i=m-1;i>=l;i--){
+                c3 = c2;
+                c2 = c;
+                s2 = s;
+                g = c*e[i];
+                h = c*p;
+                r = hypot(p,e[i]);
+                e[i+1] = s*r;
+                s = e[i]/r;
+                c = p/r;
+                p = c*d[i] - s*g;
+                d[i+1] = h + s*(c*g + s*d[i]);
+                if(vecs) __rotate_rows(T[i], T[i+1], c, s, n);
+            }
+            p = -s*s2*c3*el1*e[l]/dl1;
+            e[l] = s*p;
+            d[l] = c*p;
+        }
+        d[l] += f;
+        e[l] = 0.0;
+    }
+
+    // selection sort, at most n-1 row swaps
+    for(i=0;i<n-1;i++){
+        k = i;
+        p = d[i];
+        for(j=i+1;j<n;j++){
+            if(d[j]<p){
+                k = j;
+                p = d[j];
+            }
+        }
+        if(k==i) continue;
+        d[k] = d[i];
+        d[i] = p;
+        if(vecs){
+            for(j=0;j<n;j++){
+                p = T[i][j];
+                T[i][j] = T[k][j];
+                T[k][j] = p;
+            }
+        }
+    }
+    return 0;
+}
+
+
+int rc_algebra_eig_sym(rc_matrix_t A, rc_vector_t* evals, rc_matrix_t* evecs)
+{
+    int ret;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym, matrix not initialized yet\n");
+        return -1;
+    }
+    if(unlikely(rc_workspace_alloc(&ws, rc_algebra_workspace_size(A.rows,A.cols)))){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym, failed to allocate workspace\n");
+        return -1;
+    }
+    ret = rc_algebra_eig_sym_ws(A,evals,evecs,&ws);
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+int rc_algebra_eig_sym_ws(rc_matrix_t A, rc_vector_t* evals, rc_matrix_t* evecs, rc_workspace_t* ws)
+{
+    int i,j,n;
+    size_t mark;
+    double tmp;
+    rc_matrix_t T;
+    rc_vector_t e;
+
+    // sanity checks
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym_ws, matrix not initialized yet\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=A.cols)){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym_ws, matrix must be square\n");
+        return -1;
+    }
+    if(unlikely(evals==NULL || ws==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym_ws, received NULL pointer\n");
+        return -1;
+    }
+    n = A.rows;
+    mark = ws->used;
+    if(unlikely(__ws_vector(ws,&e,n) || (evecs==NULL && __ws_matrix(ws,&T,n,n)))){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym_ws, workspace too small\n");
+        ws->used = mark;
+        return -1;
+    }
+    // the reduction works in T, which is evecs itself when it is wanted
+    if(evecs!=NULL){
+        if(unlikely(rc_matrix_duplicate(A,evecs))){
+            fprintf(stderr,"ERROR in rc_algebra_eig_sym_ws, failed to duplicate A\n");
+            ws->used = mark;
+            return -1;
+        }
+        T = *evecs;
+    }
+    else{
+        for(i=0;i<n;i++) memcpy(T.d[i], A.d[i], n*sizeof(double));
+    }
+    if(unlikely(rc_vector_alloc(evals,n))){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym_ws, failed to allocate evals\n");
+        ws->used = mark;
+        return -1;
+    }
+
+    __tridiagonalize(n, T.d, evals->d, e.d, evecs!=NULL);
+    if(unlikely(__tridiagonal_ql(n, T.d, evals->d, e.d, evecs!=NULL))){
+        fprintf(stderr,"ERROR in rc_algebra_eig_sym_ws, failed to converge\n");
+        ws->used = mark;
+        return -1;
+    }
+    ws->used = mark;
+    if(evecs==NULL) return 0;
+
+    // eigenvectors are the rows of T, hand them back as columns
+    for(i=1;i<n;i++){
+        for(j=0;j<i;j++){
+            tmp = T.d[i][j];
+            T.d[i][j] = T.d[j][i];
+            T.d[j][i] = tmp;
+        }
+    }
+    return 0;
+}
+
+
+/*
+ * One-sided Jacobi on the k rows of W, each l long. Pairs of rows are rotated
+ * until every pair is orthogonal to within rounding. When J is not NULL the
+ * same rotations are applied to its k rows of length k. nrm is scratch for
+ * the squared row lengths. Returns -1 if it fails to converge.
+ */
+static int __svd_jacobi(int k, int l, double** W, double** J, double* nrm)
+{
+    int i,j,sweep,rotated;
+    double a,b,g,z,t,c,s,tol;
+
+    tol = l*DBL_EPSILON;
+    for(sweep=0;sweep<SVD_MAX_SWEEPS;sweep++){
+        // recompute the lengths each sweep so rounding does not build up
+        for(i=0;i<k;i++) nrm[i] = __vectorized_square_accumulate(W[i],l);
+        rotated = 0;
+        for(i=0;i<k-1;i++){
+            for(j=i+1;j<k;j++){
+                a = nrm[i];
+                b = nrm[j];
+                if(a==0.0 || b==0.0) continue;
+                g = __vectorized_mult_accumulate(W[i],W[j],l);
+                if(fabs(g)<=tol*sqrt(a*b)) continue;
+                // rotation that makes rows i and j orthogonal
+                rotated = 1;
+                z = (b-a)/(2.0*g);
+                t = ((z>=0.0) ? 1.0 : -1.0)/(fabs(z)+hypot(1.0,z));
+                c = 1.0/sqrt(1.0+t*t);
+                s = c*t;
+                __rotate_rows(W[i], W[j], c, s, l);
+                if(J!=NULL) __rotate_rows(J[i], J[j], c, s, k);
+                nrm[i] = a - t*g;
+                nrm[j] = b + t*g;
+            }
+        }
+        if(!rotated) return 0;
+    }
+    return -1;
+}
+
+
+/*
+ * out = the columns src[perm[i]][*]*scale[i] side by side for i=0..k-1, or
+ * unscaled when scale is NULL
+ */
+static int __svd_output(rc_matrix_t src, int k, int* perm, double* scale, rc_matrix_t* out)
+{
+    int i,r;
+    double sc;
+    if(unlikely(rc_matrix_alloc(out, src.cols, k))) return -1;
+    for(i=0;i<k;i++){
+        sc = (scale==NULL) ? 1.0 : scale[i];
+        for(r=0;r<src.cols;r++) out->d[r][i] = src.d[perm[i]][r]*sc;
+    }
+    return 0;
+}
+
+
+int rc_algebra_svd(rc_matrix_t A, rc_matrix_t* U, rc_vector_t* S, rc_matrix_t* V)
+{
+    int ret;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_svd, matrix not initialized yet\n");
+        return -1;
+    }
+    if(unlikely(rc_workspace_alloc(&ws, rc_algebra_workspace_size(A.rows,A.cols)))){
+        fprintf(stderr,"ERROR in rc_algebra_svd, failed to allocate workspace\n");
+        return -1;
+    }
+    ret = rc_algebra_svd_ws(A,U,S,V,&ws);
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+int rc_algebra_svd_ws(rc_matrix_t A, rc_matrix_t* U, rc_vector_t* S, rc_matrix_t* V, rc_workspace_t* ws)
+{
+    int i,j,k,l,tall,p,*perm;
+    size_t mark;
+    rc_matrix_t W, J;
+    rc_matrix_t *Yout, *Jout;
+    rc_vector_t nrm;
+
+    // sanity checks
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_algebra_svd_ws, matrix not initialized yet\n");
+        return -1;
+    }
+    if(unlikely(S==NULL || ws==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_svd_ws, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely((U!=NULL && U->d==A.d) || (V!=NULL && V->d==A.d))){
+        fprintf(stderr,"ERROR in rc_algebra_svd_ws, U and V must not be A\n");
+        return -1;
+    }
+
+    // work on whichever of A and A^T has fewer, longer rows
+    tall = A.rows>=A.cols;
+    k = tall ? A.cols : A.rows;
+    l = tall ? A.rows : A.cols;
+    Yout = tall ? U : V;
+    Jout = tall ? V : U;
+    mark = ws->used;
+    perm = NULL;
+    if(unlikely(__ws_matrix(ws,&W,k,l) || __ws_matrix(ws,&J,k,k) ||
+                __ws_vector(ws,&nrm,k) ||
+                (perm = __ws_push(ws,k*sizeof(int)))==NULL)){
+        fprintf(stderr,"ERROR in rc_algebra_svd_ws, workspace too small\n");
+        ws->used = mark;
+        return -1;
+    }
+    if(tall){
+        for(i=0;i<A.rows;i++){
+            for(j=0;j<A.cols;j++) W.d[j][i] = A.d[i][j];
+        }
+    }
+    else{
+        for(i=0;i<k;i++) memcpy(W.d[i], A.d[i], l*sizeof(double));
+    }
+    if(Jout!=NULL){
+        for(i=0;i<k;i++){
+            memset(J.d[i], 0, k*sizeof(double));
+            J.d[i][i] = 1.0;
+        }
+    }
+
+    if(unlikely(__svd_jacobi(k, l, W.d, (Jout!=NULL) ? J.d : NULL, nrm.d))){
+        fprintf(stderr,"ERROR in rc_algebra_svd_ws, failed to converge\n");
+        ws->used = mark;
+        return -1;
+    }
+
+    // singular values are the row lengths, sort them largest first
+    for(i=0;i<k;i++){
+        nrm.d[i] = sqrt(__vectorized_square_accumulate(W.d[i],l));
+        perm[i] = i;
+    }
+    for(i=1;i<k;i++){
+        p = perm[i];
+        for(j=i;j>0 && nrm.d[perm[j-1]]<nrm.d[p];j--) perm[j] = perm[j-1];
+        perm[j] = p;
+    }
+    if(unlikely(rc_vector_alloc(S,k))){
+        fprintf(stderr,"ERROR in rc_algebra_svd_ws, failed to allocate S\n");
+        ws->used = mark;
+        return -1;
+    }
+    for(i=0;i<k;i++) S->d[i] = nrm.d[perm[i]];
+
+    // the normalized rows of W are the singular vectors on the long side and
+    // the accumulated rotations are the ones on the short side
+    for(i=0;i<k;i++) nrm.d[i] = (S->d[i]>0.0) ? 1.0/S->d[i] : 0.0;
+    if(unlikely((Yout!=NULL && __svd_output(W, k, perm, nrm.d, Yout)) ||
+                (Jout!=NULL && __svd_output(J, k, perm, NULL, Jout)))){
+        fprintf(stderr,"ERROR in rc_algebra_svd_ws, failed to allocate U or V\n");
+        ws->used = mark;
+        return -1;
+    }
+    ws->used = mark;
+    return 0;
+}
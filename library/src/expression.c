@@ -0,0 +1,222 @@
+/**
+ * @file       expression.c
+ *
+ * @brief      see expression.h
+ *
+ * Evaluation walks the output in blocks small enough to stay in L1. Each term
+ * is accumulated into the block with its own tight loop, a vectorized dot
+ * product per row for matrix-vector terms, and the finished block is then
+ * stored once. Transposed matrix-vector terms read A a row at a time, so they
+ * are added afterwards as scaled rows of A like rc_matrix_times_col_vec_trans.
+ */
+
+#include <stdio.h>
+#include <string.h> // for memset, memcpy
+
+#include <rc_math/expression.h>
+#include "algebra_common.h"
+
+// kinds of terms
+#define TERM_VECTOR 0
+#define TERM_MATVEC 1
+#define TERM_MATRIX 2
+
+// elements of the output accumulated at a time
+#define EXPR_BLOCK  256
+
+
+// checks there is room for one more term whose result is rows x cols, cols=0
+// for vectors, and sets the size of the expression from its first term
+static int __check_term(rc_expr_t* e, int rows, int cols, const char* name)
+{
+    if(unlikely(e==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", name);
+        return -1;
+    }
+    if(unlikely(e->n>=RC_EXPR_MAX_TERMS)){
+        fprintf(stderr,"ERROR in %s, expression already has %d terms\n", name, RC_EXPR_MAX_TERMS);
+        return -1;
+    }
+    if(e->n==0){
+        e->rows = rows;
+        e->cols = cols;
+        return 0;
+    }
+    if(unlikely(e->rows!=rows || e->cols!=cols)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch with earlier terms\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+
+int rc_expr_clear(rc_expr_t* e)
+{
+    rc_expr_t new = RC_EXPR_INITIALIZER;
+    if(unlikely(e==NULL)){
+        fprintf(stderr,"ERROR in rc_expr_clear, received NULL pointer\n");
+        return -1;
+    }
+    *e = new;
+    return 0;
+}
+
+
+int rc_expr_add_vector(rc_expr_t* e, double s, rc_vector_t v)
+{
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in rc_expr_add_vector, vector not initialized\n");
+        return -1;
+    }
+    if(unlikely(__check_term(e, v.len, 0, "rc_expr_add_vector"))) return -1;
+    e->t[e->n].type = TERM_VECTOR;
+    e->t[e->n].s = s;
+    e->t[e->n].v = v;
+    e->n++;
+    return 0;
+}
+
+
+int rc_expr_add_times_col_vec(rc_expr_t* e, double s, rc_matrix_t A, int ta, rc_vector_t v)
+{
+    if(unlikely(!A.initialized || !v.initialized)){
+        fprintf(stderr,"ERROR in rc_expr_add_times_col_vec, matrix or vector not initialized\n");
+        return -1;
+    }
+    if(unlikely(v.len!=(ta ? A.rows : A.cols))){
+        fprintf(stderr,"ERROR in rc_expr_add_times_col_vec, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(__check_term(e, ta ? A.cols : A.rows, 0, "rc_expr_add_times_col_vec"))) return -1;
+    e->t[e->n].type = TERM_MATVEC;
+    e->t[e->n].s = s;
+    e->t[e->n].A = A;
+    e->t[e->n].trans = ta ? 1 : 0;
+    e->t[e->n].v = v;
+    e->n++;
+    return 0;
+}
+
+
+int rc_expr_add_matrix(rc_expr_t* e, double s, rc_matrix_t A)
+{
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_expr_add_matrix, matrix not initialized\n");
+        return -1;
+    }
+    if(unlikely(__check_term(e, A.rows, A.cols, "rc_expr_add_matrix"))) return -1;
+    e->t[e->n].type = TERM_MATRIX;
+    e->t[e->n].s = s;
+    e->t[e->n].A = A;
+    e->n++;
+    return 0;
+}
+
+
+int rc_expr_scale(rc_expr_t* e, double s)
+{
+    int k;
+    if(unlikely(e==NULL)){
+        fprintf(stderr,"ERROR in rc_expr_scale, received NULL pointer\n");
+        return -1;
+    }
+    for(k=0;k<e->n;k++) e->t[k].s *= s;
+    return 0;
+}
+
+
+int rc_expr_eval_vector(rc_expr_t e, rc_vector_t* out)
+{
+    int i, k, r, i0, nb;
+    double tmp[EXPR_BLOCK];
+    rc_expr_term_t* t;
+
+    // sanity checks
+    if(unlikely(out==NULL)){
+        fprintf(stderr,"ERROR in rc_expr_eval_vector, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(e.n<1)){
+        fprintf(stderr,"ERROR in rc_expr_eval_vector, expression is empty\n");
+        return -1;
+    }
+    if(unlikely(e.cols!=0)){
+        fprintf(stderr,"ERROR in rc_expr_eval_vector, expression is a matrix\n");
+        return -1;
+    }
+    for(k=0;k<e.n;k++){
+        if(unlikely(e.t[k].type==TERM_MATVEC && out->d==e.t[k].v.d)){
+            fprintf(stderr,"ERROR in rc_expr_eval_vector, out must not be the vector of a matrix-vector term\n");
+            return -1;
+        }
+    }
+    if(unlikely(rc_vector_alloc(out, e.rows))){
+        fprintf(stderr,"ERROR in rc_expr_eval_vector, failed to allocate out\n");
+        return -1;
+    }
+
+    for(i0=0;i0<e.rows;i0+=EXPR_BLOCK){
+        nb = e.rows-i0 < EXPR_BLOCK ? e.rows-i0 : EXPR_BLOCK;
+        memset(tmp, 0, nb*sizeof(double));
+        for(k=0;k<e.n;k++){
+            t = &e.t[k];
+            if(t->type==TERM_VECTOR){
+                for(r=0;r<nb;r++) tmp[r] += t->s*t->v.d[i0+r];
+            }
+            else if(!t->trans){
+                for(r=0;r<nb;r++){
+                    tmp[r] += t->s*__vectorized_mult_accumulate(t->A.d[i0+r], t->v.d, t->A.cols);
+                }
+            }
+        }
+        memcpy(&out->d[i0], tmp, nb*sizeof(double));
+    }
+
+    // op(A)=A^T terms are sums of the rows of A scaled by v
+    for(k=0;k<e.n;k++){
+        t = &e.t[k];
+        if(t->type!=TERM_MATVEC || !t->trans) continue;
+        for(i=0;i<t->A.rows;i++) __vectorized_axpy(t->s*t->v.d[i], t->A.d[i], out->d, t->A.cols);
+    }
+    return 0;
+}
+
+
+int rc_expr_eval_matrix(rc_expr_t e, rc_matrix_t* out)
+{
+    int i, k, j0, c, nb;
+    double tmp[EXPR_BLOCK];
+    rc_expr_term_t* t;
+
+    // sanity checks
+    if(unlikely(out==NULL)){
+        fprintf(stderr,"ERROR in rc_expr_eval_matrix, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(e.n<1)){
+        fprintf(stderr,"ERROR in rc_expr_eval_matrix, expression is empty\n");
+        return -1;
+    }
+    if(unlikely(e.cols==0)){
+        fprintf(stderr,"ERROR in rc_expr_eval_matrix, expression is a vector\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_alloc(out, e.rows, e.cols))){
+        fprintf(stderr,"ERROR in rc_expr_eval_matrix, failed to allocate out\n");
+        return -1;
+    }
+
+    // rows of the terms may have different strides so go a row at a time
+    for(i=0;i<e.rows;i++){
+        for(j0=0;j0<e.cols;j0+=EXPR_BLOCK){
+            nb = e.cols-j0 < EXPR_BLOCK ? e.cols-j0 : EXPR_BLOCK;
+            memset(tmp, 0, nb*sizeof(double));
+            for(k=0;k<e.n;k++){
+                t = &e.t[k];
+                for(c=0;c<nb;c++) tmp[c] += t->s*t->A.d[i][j0+c];
+            }
+            memcpy(&out->d[i][j0], tmp, nb*sizeof(double));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,333 @@
+/**
+ * @file       filter_template.h
+ *
+ * @brief      Filter allocation and the difference equation shared by the
+ *             double and float APIs, see precision.h. Included by filter.c and
+ *             single_precision.c. Filter design stays in double precision in
+ *             filter.c, float filters are made from a designed rc_filter_t with
+ *             rc_filterf_from_filter.
+ */
+
+FILTER FILTER_FN(empty)(void)
+{
+    FILTER f = FILTER_INIT;
+    return f;
+}
+
+
+int FILTER_FN(alloc)(FILTER* f, VEC num, VEC den, REAL dt)
+{
+    // sanity checks
+    if(unlikely(dt<=RL(0.0))){
+        fprintf(stderr,"ERROR in %s, dt must be >0\n", __func__);
+        return -1;
+    }
+    if(unlikely(!num.initialized||!den.initialized)){
+        fprintf(stderr,"ERROR in %s, vector uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(num.len>den.len)){
+        fprintf(stderr,"ERROR in %s, improper transfer function\n", __func__);
+        return -1;
+    }
+    if(unlikely(FABS(den.d[0]) < (REAL)zero_tolerance)){
+        fprintf(stderr,"ERROR in %s, first coefficient in denominator is 0\n", __func__);
+        return -1;
+    }
+    // free existing memory, this also zeros out all fields
+    FILTER_FN(free)(f);
+    // move in vectors
+    if(unlikely(VECTOR_FN(duplicate)(num,&f->num))){
+        fprintf(stderr,"ERROR in %s, failed to duplicate numerator\n", __func__);
+        return -1;
+    }
+    if(unlikely(VECTOR_FN(duplicate)(den,&f->den))){
+        fprintf(stderr,"ERROR in %s, failed to duplicate denominator\n", __func__);
+        VECTOR_FN(free)(&f->num);
+        return -1;
+    }
+    // allocate buffers making sure they are at least 2 in length
+    int buflen = den.len;
+    if(buflen<2) buflen=2;
+    if(unlikely(RINGBUF_FN(alloc)(&f->in_buf,buflen))){
+        fprintf(stderr,"ERROR in %s, failed to allocate ring buffer\n", __func__);
+        VECTOR_FN(free)(&f->num);
+        VECTOR_FN(free)(&f->den);
+        return -1;
+    }
+    if(unlikely(RINGBUF_FN(alloc)(&f->out_buf,buflen))){
+        fprintf(stderr,"ERROR in %s, failed to allocate ring buffer\n", __func__);
+        VECTOR_FN(free)(&f->num);
+        VECTOR_FN(free)(&f->den);
+        RINGBUF_FN(free)(&f->in_buf);
+        return -1;
+    }
+    // populate remaining values, everything else zero'd by rc_filter_free
+    f->dt=dt;
+    f->order=den.len-1;
+    f->initialized=1;
+    return 0;
+}
+
+
+int FILTER_FN(alloc_from_arrays)(FILTER* f,REAL dt,REAL* num,int numlen,\
+                            REAL* den,int denlen)
+{
+    // sanity checks
+    if(unlikely(numlen<1 || denlen<1)){
+        fprintf(stderr,"ERROR in %s, numlen & denlen must be >=1\n", __func__);
+        return -1;
+    }
+    if(unlikely(numlen>denlen)){
+        fprintf(stderr,"ERROR in %s, improper transfer function\n", __func__);
+        return -1;
+    }
+    if(unlikely(num==NULL || den==NULL || f==NULL)){
+        fprintf(stderr,"ERROR in %s, received null pointer\n", __func__);
+        return -1;
+    }
+    if(unlikely(dt<RL(0.0))){
+        fprintf(stderr,"ERROR in %s, dt must be >0\n", __func__);
+        return -1;
+    }
+    if(unlikely(FABS(den[0]) < (REAL)zero_tolerance)){
+        fprintf(stderr,"ERROR in %s, first coefficient in denominator is 0\n", __func__);
+        return -1;
+    }
+    // free existing memory, this also zeros out all fields
+    FILTER_FN(free)(f);
+    // copy numerator and denominators over
+    if(unlikely(VECTOR_FN(from_array)(&f->num,num,numlen))){
+        fprintf(stderr,"ERROR in %s, failed to alloc vector\n", __func__);
+        return -1;
+    }
+    if(unlikely(VECTOR_FN(from_array)(&f->den,den,denlen))){
+        fprintf(stderr,"ERROR in %s, failed to alloc vector\n", __func__);
+        VECTOR_FN(free)(&f->num);
+        return -1;
+    }
+    // allocate buffers
+    if(unlikely(RINGBUF_FN(alloc)(&f->in_buf,denlen))){
+        fprintf(stderr,"ERROR in %s, failed to allocate ring buffer\n", __func__);
+        VECTOR_FN(free)(&f->num);
+        VECTOR_FN(free)(&f->den);
+        return -1;
+    }
+    if(unlikely(RINGBUF_FN(alloc)(&f->out_buf,denlen))){
+        fprintf(stderr,"ERROR in %s, failed to allocate ring buffer\n", __func__);
+        VECTOR_FN(free)(&f->num);
+        VECTOR_FN(free)(&f->den);
+        RINGBUF_FN(free)(&f->in_buf);
+        return -1;
+    }
+    // populate remaining values, everything else zero'd by rc_filter_free
+    f->dt=dt;
+    f->order=denlen-1;
+    f->initialized=1;
+    return 0;
+}
+
+
+int FILTER_FN(duplicate)(FILTER* f, FILTER old)
+{
+    if(unlikely(!old.initialized)){
+        fprintf(stderr, "ERROR in %s, old filter not initialized\n", __func__);
+        return -1;
+    }
+    if(FILTER_FN(alloc)(f, old.num, old.den, old.dt)){
+        fprintf(stderr, "ERROR in %s, failed to alloc memory\n", __func__);
+        return -1;
+    }
+    f->gain     = old.gain;
+    f->sat_en   = old.sat_en;
+    f->sat_min  = old.sat_min;
+    f->sat_max  = old.sat_max;
+    f->ss_en    = old.ss_en;
+    f->ss_steps = old.ss_steps;
+    return 0;
+}
+
+
+int FILTER_FN(free)(FILTER* f)
+{
+    FILTER new = FILTER_INIT;
+    if(unlikely(f==NULL)){
+        fprintf(stderr, "ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    RINGBUF_FN(free)(&f->in_buf);
+    RINGBUF_FN(free)(&f->out_buf);
+    VECTOR_FN(free)(&f->num);
+    VECTOR_FN(free)(&f->den);
+    *f = new;
+    return 0;
+}
+
+
+REAL FILTER_FN(march)(FILTER* f, REAL new_input)
+{
+    int i, rel_deg;
+    REAL tmp1 = RL(0.0);
+    REAL tmp2 = RL(0.0);
+    REAL new_out;
+    // sanity checks
+    if(unlikely(!f->initialized)){
+        printf("ERROR in %s, filter uninitialized\n", __func__);
+        return RL(-1.0);
+    }
+    // log new input
+    RINGBUF_FN(insert)(&f->in_buf, new_input);
+    f->newest_input = new_input;
+    // relative degree should never be negative as rc_filter_alloc checks
+    // for improper transfer functions
+    rel_deg = f->den.len - f->num.len;
+    // evaluate the difference equation
+    for(i=0; i<(f->num.len); i++){
+        tmp1+=f->num.d[i]*RINGBUF_FN(get_value)(&f->in_buf, i+rel_deg);
+    }
+    if(FABS(f->gain - RL(1.0)) > (REAL)zero_tolerance) tmp1=tmp1*f->gain;
+    for(i=0; i<(f->order); i++){
+        tmp2-=f->den.d[i+1]*RINGBUF_FN(get_value)(&f->out_buf, i);
+    }
+    new_out=tmp2+tmp1;
+    // scale in case denominator doesn't have a leading 1
+    if(FABS(f->den.d[0] - RL(1.0)) > (REAL)zero_tolerance) new_out /= f->den.d[0];
+    // soft start limits
+    if(f->ss_en && f->step<f->ss_steps){
+        REAL a=f->sat_max*(f->step/f->ss_steps);
+        REAL b=f->sat_min*(f->step/f->ss_steps);
+        if(new_out>a) new_out=a;
+        if(new_out<b) new_out=b;
+    }
+    // saturate and set flag
+    if(f->sat_en){
+        if(new_out>f->sat_max){
+            new_out=f->sat_max;
+            f->sat_flag=1;
+        }
+        else if(new_out<f->sat_min){
+            new_out=f->sat_min;
+            f->sat_flag=1;
+        }
+        else f->sat_flag=0;
+    }
+    // record the output to filter struct and ring buffer
+    f->newest_output = new_out;
+    RINGBUF_FN(insert)(&f->out_buf, new_out);
+    // increment steps
+    f->step++;
+    return new_out;
+}
+
+
+int FILTER_FN(reset)(FILTER* f)
+{
+    if(unlikely(!f->initialized)){
+        fprintf(stderr,"ERROR in %s, filter uninitialized\n", __func__);
+        return -1;
+    }
+    RINGBUF_FN(reset)(&f->in_buf);
+    RINGBUF_FN(reset)(&f->out_buf);
+    f->newest_input = RL(0.0);
+    f->newest_output = RL(0.0);
+    f->sat_flag = 0;
+    f->step = 0;
+    return 0;
+}
+
+
+int FILTER_FN(enable_saturation)(FILTER* f, REAL min, REAL max)
+{
+    if(unlikely(!f->initialized)){
+        fprintf(stderr, "ERROR in %s, filter uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(min>max)){
+        fprintf(stderr, "ERROR in %s, max must be >= min\n", __func__);
+        return -1;
+    }
+    f->sat_en   = 1;
+    f->sat_min  = min;
+    f->sat_max  = max;
+    return 0;
+}
+
+
+int FILTER_FN(get_saturation_flag)(FILTER* f)
+{
+    if(unlikely(!f->initialized)){
+        fprintf(stderr,"ERROR in %s, filter uninitialized\n", __func__);
+        return -1;
+    }
+    return f->sat_flag;
+}
+
+
+int FILTER_FN(enable_soft_start)(FILTER* f, REAL seconds)
+{
+    if(unlikely(!f->initialized)){
+        fprintf(stderr,"ERROR in %s, filter uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(seconds<=RL(0.0))){
+        fprintf(stderr,"ERROR in %s, seconds must be >=0\n", __func__);
+        return -1;
+    }
+    if(unlikely(!f->sat_en)){
+        fprintf(stderr,"ERROR in %s, saturation must be enabled first\n", __func__);
+        return -1;
+    }
+    f->ss_en    = 1;
+    f->ss_steps = seconds/f->dt;
+    return 0;
+}
+
+
+REAL FILTER_FN(previous_input)(FILTER* f, int steps)
+{
+    if(unlikely(!f->initialized)){
+        fprintf(stderr,"ERROR in %s, filter uninitialized\n", __func__);
+        return RL(-1.0);
+    }
+    return RINGBUF_FN(get_value)(&f->in_buf, steps);
+}
+
+
+REAL FILTER_FN(previous_output)(FILTER* f, int steps)
+{
+    if(unlikely(!f->initialized)){
+        fprintf(stderr,"ERROR in %s, filter uninitialized\n", __func__);
+        return RL(-1.0);
+    }
+    return RINGBUF_FN(get_value)(&f->out_buf, steps);
+}
+
+
+int FILTER_FN(prefill_inputs)(FILTER* f, REAL in)
+{
+    int i;
+    if(unlikely(!f->initialized)){
+        fprintf(stderr,"ERROR in %s, filter uninitialized\n", __func__);
+        return -1;
+    }
+    for(i=0;i<=f->order;i++){
+        RINGBUF_FN(insert)(&f->in_buf, in);
+    }
+    f->newest_input = in;
+    return 0;
+}
+
+
+int FILTER_FN(prefill_outputs)(FILTER* f, REAL out)
+{
+    int i;
+    if(unlikely(!f->initialized)){
+        fprintf(stderr,"ERROR in %s, filter uninitialized\n", __func__);
+        return -1;
+    }
+    for(i=0;i<=f->order;i++){
+        RINGBUF_FN(insert)(&(f->out_buf), out);
+    }
+    f->newest_output = out;
+    return 0;
+}
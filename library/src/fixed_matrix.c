@@ -0,0 +1,490 @@
+/**
+ * @file       fixed_matrix.c
+ *
+ * @brief      see fixed_matrix.h
+ *
+ * The 3x3 and 4x4 functions are written out term by term. The 6x6 ones use
+ * loops with constant bounds which the compiler unrolls at -O3.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+#include <rc_math/fixed_matrix.h>
+#include "algebra_common.h"
+
+
+/*******************************************************************************
+* vectors
+*******************************************************************************/
+
+double rc_vec3_dot(rc_vec3_t a, rc_vec3_t b)
+{
+    return a.d[0]*b.d[0] + a.d[1]*b.d[1] + a.d[2]*b.d[2];
+}
+
+
+rc_vec3_t rc_vec3_cross(rc_vec3_t a, rc_vec3_t b)
+{
+    rc_vec3_t c;
+    c.d[0] = a.d[1]*b.d[2] - a.d[2]*b.d[1];
+    c.d[1] = a.d[2]*b.d[0] - a.d[0]*b.d[2];
+    c.d[2] = a.d[0]*b.d[1] - a.d[1]*b.d[0];
+    return c;
+}
+
+
+double rc_vec3_norm(rc_vec3_t v)
+{
+    return sqrt(v.d[0]*v.d[0] + v.d[1]*v.d[1] + v.d[2]*v.d[2]);
+}
+
+
+// shared body of the rc_vecN_from_vector functions
+static int __vec_from_vector(const char* name, rc_vector_t v, double* out, int n)
+{
+    int i;
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in %s, vector uninitialized\n", name);
+        return -1;
+    }
+    if(unlikely(v.len!=n)){
+        fprintf(stderr,"ERROR in %s, expected vector of length %d\n", name, n);
+        return -1;
+    }
+    for(i=0;i<n;i++) out[i] = v.d[i];
+    return 0;
+}
+
+
+// shared body of the rc_vecN_to_vector functions
+static int __vec_to_vector(const char* name, const double* v, rc_vector_t* out, int n)
+{
+    int i;
+    if(unlikely(rc_vector_alloc(out,n))){
+        fprintf(stderr,"ERROR in %s, failed to alloc vector\n", name);
+        return -1;
+    }
+    for(i=0;i<n;i++) out->d[i] = v[i];
+    return 0;
+}
+
+
+int rc_vec3_from_vector(rc_vector_t v, rc_vec3_t* out)
+{
+    return __vec_from_vector(__FUNCTION__, v, out->d, 3);
+}
+
+
+int rc_vec3_to_vector(rc_vec3_t v, rc_vector_t* out)
+{
+    return __vec_to_vector(__FUNCTION__, v.d, out, 3);
+}
+
+
+int rc_vec4_from_vector(rc_vector_t v, rc_vec4_t* out)
+{
+    return __vec_from_vector(__FUNCTION__, v, out->d, 4);
+}
+
+
+int rc_vec4_to_vector(rc_vec4_t v, rc_vector_t* out)
+{
+    return __vec_to_vector(__FUNCTION__, v.d, out, 4);
+}
+
+
+int rc_vec6_from_vector(rc_vector_t v, rc_vec6_t* out)
+{
+    return __vec_from_vector(__FUNCTION__, v, out->d, 6);
+}
+
+
+int rc_vec6_to_vector(rc_vec6_t v, rc_vector_t* out)
+{
+    return __vec_to_vector(__FUNCTION__, v.d, out, 6);
+}
+
+
+/*******************************************************************************
+* conversions shared by all matrix sizes
+*******************************************************************************/
+
+static int __mat_from_matrix(const char* name, rc_matrix_t A, double* out, int n)
+{
+    int i,j;
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in %s, matrix uninitialized\n", name);
+        return -1;
+    }
+    if(unlikely(A.rows!=n || A.cols!=n)){
+        fprintf(stderr,"ERROR in %s, expected %dx%d matrix\n", name, n, n);
+        return -1;
+    }
+    for(i=0;i<n;i++){
+        for(j=0;j<n;j++) out[(i*n)+j] = A.d[i][j];
+    }
+    return 0;
+}
+
+
+static int __mat_to_matrix(const char* name, const double* A, rc_matrix_t* out, int n)
+{
+    int i,j;
+    if(unlikely(rc_matrix_alloc(out,n,n))){
+        fprintf(stderr,"ERROR in %s, failed to alloc matrix\n", name);
+        return -1;
+    }
+    for(i=0;i<n;i++){
+        for(j=0;j<n;j++) out->d[i][j] = A[(i*n)+j];
+    }
+    return 0;
+}
+
+
+/*******************************************************************************
+* 3x3
+*******************************************************************************/
+
+rc_mat3_t rc_mat3_identity(void)
+{
+    rc_mat3_t I = {{{1.0, 0.0, 0.0},
+                    {0.0, 1.0, 0.0},
+                    {0.0, 0.0, 1.0}}};
+    return I;
+}
+
+
+// one row of C=A*B
+#define MAT3_ROW(C,A,B,i) \
+    C.d[i][0] = A.d[i][0]*B.d[0][0] + A.d[i][1]*B.d[1][0] + A.d[i][2]*B.d[2][0];\
+    C.d[i][1] = A.d[i][0]*B.d[0][1] + A.d[i][1]*B.d[1][1] + A.d[i][2]*B.d[2][1];\
+    C.d[i][2] = A.d[i][0]*B.d[0][2] + A.d[i][1]*B.d[1][2] + A.d[i][2]*B.d[2][2];
+
+rc_mat3_t rc_mat3_multiply(rc_mat3_t A, rc_mat3_t B)
+{
+    rc_mat3_t C;
+    MAT3_ROW(C,A,B,0)
+    MAT3_ROW(C,A,B,1)
+    MAT3_ROW(C,A,B,2)
+    return C;
+}
+
+
+rc_mat3_t rc_mat3_transpose(rc_mat3_t A)
+{
+    rc_mat3_t T = {{{A.d[0][0], A.d[1][0], A.d[2][0]},
+                    {A.d[0][1], A.d[1][1], A.d[2][1]},
+                    {A.d[0][2], A.d[1][2], A.d[2][2]}}};
+    return T;
+}
+
+
+double rc_mat3_determinant(rc_mat3_t A)
+{
+    return    A.d[0][0]*(A.d[1][1]*A.d[2][2] - A.d[1][2]*A.d[2][1])
+            - A.d[0][1]*(A.d[1][0]*A.d[2][2] - A.d[1][2]*A.d[2][0])
+            + A.d[0][2]*(A.d[1][0]*A.d[2][1] - A.d[1][1]*A.d[2][0]);
+}
+
+
+int rc_mat3_invert(rc_mat3_t A, rc_mat3_t* Ainv)
+{
+    double det, inv;
+    // first row of the adjugate doubles as the cofactors for the determinant
+    double c00 = A.d[1][1]*A.d[2][2] - A.d[1][2]*A.d[2][1];
+    double c01 = A.d[0][2]*A.d[2][1] - A.d[0][1]*A.d[2][2];
+    double c02 = A.d[0][1]*A.d[1][2] - A.d[0][2]*A.d[1][1];
+
+    det = A.d[0][0]*c00 + A.d[1][0]*c01 + A.d[2][0]*c02;
+    if(unlikely(fabs(det)<zero_tolerance)){
+        fprintf(stderr,"ERROR in rc_mat3_invert, matrix is singular\n");
+        return -1;
+    }
+    inv = 1.0/det;
+
+    Ainv->d[0][0] = c00*inv;
+    Ainv->d[0][1] = c01*inv;
+    Ainv->d[0][2] = c02*inv;
+    Ainv->d[1][0] = (A.d[1][2]*A.d[2][0] - A.d[1][0]*A.d[2][2])*inv;
+    Ainv->d[1][1] = (A.d[0][0]*A.d[2][2] - A.d[0][2]*A.d[2][0])*inv;
+    Ainv->d[1][2] = (A.d[0][2]*A.d[1][0] - A.d[0][0]*A.d[1][2])*inv;
+    Ainv->d[2][0] = (A.d[1][0]*A.d[2][1] - A.d[1][1]*A.d[2][0])*inv;
+    Ainv->d[2][1] = (A.d[0][1]*A.d[2][0] - A.d[0][0]*A.d[2][1])*inv;
+    Ainv->d[2][2] = (A.d[0][0]*A.d[1][1] - A.d[0][1]*A.d[1][0])*inv;
+    return 0;
+}
+
+
+rc_vec3_t rc_mat3_times_vec(rc_mat3_t A, rc_vec3_t v)
+{
+    rc_vec3_t out;
+    out.d[0] = A.d[0][0]*v.d[0] + A.d[0][1]*v.d[1] + A.d[0][2]*v.d[2];
+    out.d[1] = A.d[1][0]*v.d[0] + A.d[1][1]*v.d[1] + A.d[1][2]*v.d[2];
+    out.d[2] = A.d[2][0]*v.d[0] + A.d[2][1]*v.d[1] + A.d[2][2]*v.d[2];
+    return out;
+}
+
+
+int rc_mat3_from_matrix(rc_matrix_t A, rc_mat3_t* out)
+{
+    return __mat_from_matrix(__FUNCTION__, A, &out->d[0][0], 3);
+}
+
+
+int rc_mat3_to_matrix(rc_mat3_t A, rc_matrix_t* out)
+{
+    return __mat_to_matrix(__FUNCTION__, &A.d[0][0], out, 3);
+}
+
+
+/*******************************************************************************
+* 4x4
+*******************************************************************************/
+
+rc_mat4_t rc_mat4_identity(void)
+{
+    rc_mat4_t I = {{{1.0, 0.0, 0.0, 0.0},
+                    {0.0, 1.0, 0.0, 0.0},
+                    {0.0, 0.0, 1.0, 0.0},
+                    {0.0, 0.0, 0.0, 1.0}}};
+    return I;
+}
+
+
+// one row of C=A*B
+#define MAT4_ROW(C,A,B,i) \
+    C.d[i][0] = A.d[i][0]*B.d[0][0] + A.d[i][1]*B.d[1][0] + A.d[i][2]*B.d[2][0] + A.d[i][3]*B.d[3][0];\
+    C.d[i][1] = A.d[i][0]*B.d[0][1] + A.d[i][1]*B.d[1][1] + A.d[i][2]*B.d[2][1] + A.d[i][3]*B.d[3][1];\
+    C.d[i][2] = A.d[i][0]*B.d[0][2] + A.d[i][1]*B.d[1][2] + A.d[i][2]*B.d[2][2] + A.d[i][3]*B.d[3][2];\
+    C.d[i][3] = A.d[i][0]*B.d[0][3] + A.d[i][1]*B.d[1][3] + A.d[i][2]*B.d[2][3] + A.d[i][3]*B.d[3][3];
+
+rc_mat4_t rc_mat4_multiply(rc_mat4_t A, rc_mat4_t B)
+{
+    rc_mat4_t C;
+    MAT4_ROW(C,A,B,0)
+    MAT4_ROW(C,A,B,1)
+    MAT4_ROW(C,A,B,2)
+    MAT4_ROW(C,A,B,3)
+    return C;
+}
+
+
+rc_mat4_t rc_mat4_transpose(rc_mat4_t A)
+{
+    rc_mat4_t T = {{{A.d[0][0], A.d[1][0], A.d[2][0], A.d[3][0]},
+                    {A.d[0][1], A.d[1][1], A.d[2][1], A.d[3][1]},
+                    {A.d[0][2], A.d[1][2], A.d[2][2], A.d[3][2]},
+                    {A.d[0][3], A.d[1][3], A.d[2][3], A.d[3][3]}}};
+    return T;
+}
+
+
+/*
+ * The 2x2 minors of the top two rows (s) and bottom two rows (c) are enough to
+ * build both the determinant and every cofactor of a 4x4 matrix, see the
+ * Laplace expansion theorem.
+ */
+#define MAT4_MINORS(A) \
+    double s0 = A.d[0][0]*A.d[1][1] - A.d[1][0]*A.d[0][1];\
+    double s1 = A.d[0][0]*A.d[1][2] - A.d[1][0]*A.d[0][2];\
+    double s2 = A.d[0][0]*A.d[1][3] - A.d[1][0]*A.d[0][3];\
+    double s3 = A.d[0][1]*A.d[1][2] - A.d[1][1]*A.d[0][2];\
+    double s4 = A.d[0][1]*A.d[1][3] - A.d[1][1]*A.d[0][3];\
+    double s5 = A.d[0][2]*A.d[1][3] - A.d[1][2]*A.d[0][3];\
+    double c5 = A.d[2][2]*A.d[3][3] - A.d[3][2]*A.d[2][3];\
+    double c4 = A.d[2][1]*A.d[3][3] - A.d[3][1]*A.d[2][3];\
+    double c3 = A.d[2][1]*A.d[3][2] - A.d[3][1]*A.d[2][2];\
+    double c2 = A.d[2][0]*A.d[3][3] - A.d[3][0]*A.d[2][3];\
+    double c1 = A.d[2][0]*A.d[3][2] - A.d[3][0]*A.d[2][2];\
+    double c0 = A.d[2][0]*A.d[3][1] - A.d[3][0]*A.d[2][1];
+
+double rc_mat4_determinant(rc_mat4_t A)
+{
+    MAT4_MINORS(A)
+    return s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+}
+
+
+int rc_mat4_invert(rc_mat4_t A, rc_mat4_t* Ainv)
+{
+    double det, inv;
+    MAT4_MINORS(A)
+
+    det = s0*c5 - s1*c4 + s2*c3 + s3*c2 - s4*c1 + s5*c0;
+    if(unlikely(fabs(det)<zero_tolerance)){
+        fprintf(stderr,"ERROR in rc_mat4_invert, matrix is singular\n");
+        return -1;
+    }
+    inv = 1.0/det;
+
+    Ainv->d[0][0] = ( A.d[1][1]*c5 - A.d[1][2]*c4 + A.d[1][3]*c3)*inv;
+    Ainv->d[0][1] = (-A.d[0][1]*c5 + A.d[0][2]*c4 - A.d[0][3]*c3)*inv;
+    Ainv->d[0][2] = ( A.d[3][1]*s5 - A.d[3][2]*s4 + A.d[3][3]*s3)*inv;
+    Ainv->d[0][3] = (-A.d[2][1]*s5 + A.d[2][2]*s4 - A.d[2][3]*s3)*inv;
+
+    Ainv->d[1][0] = (-A.d[1][0]*c5 + A.d[1][2]*c2 - A.d[1][3]*c1)*inv;
+    Ainv->d[1][1] = ( A.d[0][0]*c5 - A.d[0][2]*c2 + A.d[0][3]*c1)*inv;
+    Ainv->d[1][2] = (-A.d[3][0]*s5 + A.d[3][2]*s2 - A.d[3][3]*s1)*inv;
+    Ainv->d[1][3] = ( A.d[2][0]*s5 - A.d[2][2]*s2 + A.d[2][3]*s1)*inv;
+
+    Ainv->d[2][0] = ( A.d[1][0]*c4 - A.d[1][1]*c2 + A.d[1][3]*c0)*inv;
+    Ainv->d[2][1] = (-A.d[0][0]*c4 + A.d[0][1]*c2 - A.d[0][3]*c0)*inv;
+    Ainv->d[2][2] = ( A.d[3][0]*s4 - A.d[3][1]*s2 + A.d[3][3]*s0)*inv;
+    Ainv->d[2][3] = (-A.d[2][0]*s4 + A.d[2][1]*s2 - A.d[2][3]*s0)*inv;
+
+    Ainv->d[3][0] = (-A.d[1][0]*c3 + A.d[1][1]*c1 - A.d[1][2]*c0)*inv;
+    Ainv->d[3][1] = ( A.d[0][0]*c3 - A.d[0][1]*c1 + A.d[0][2]*c0)*inv;
+    Ainv->d[3][2] = (-A.d[3][0]*s3 + A.d[3][1]*s1 - A.d[3][2]*s0)*inv;
+    Ainv->d[3][3] = ( A.d[2][0]*s3 - A.d[2][1]*s1 + A.d[2][2]*s0)*inv;
+    return 0;
+}
+
+
+rc_vec4_t rc_mat4_times_vec(rc_mat4_t A, rc_vec4_t v)
+{
+    rc_vec4_t out;
+    out.d[0] = A.d[0][0]*v.d[0] + A.d[0][1]*v.d[1] + A.d[0][2]*v.d[2] + A.d[0][3]*v.d[3];
+    out.d[1] = A.d[1][0]*v.d[0] + A.d[1][1]*v.d[1] + A.d[1][2]*v.d[2] + A.d[1][3]*v.d[3];
+    out.d[2] = A.d[2][0]*v.d[0] + A.d[2][1]*v.d[1] + A.d[2][2]*v.d[2] + A.d[2][3]*v.d[3];
+    out.d[3] = A.d[3][0]*v.d[0] + A.d[3][1]*v.d[1] + A.d[3][2]*v.d[2] + A.d[3][3]*v.d[3];
+    return out;
+}
+
+
+int rc_mat4_from_matrix(rc_matrix_t A, rc_mat4_t* out)
+{
+    return __mat_from_matrix(__FUNCTION__, A, &out->d[0][0], 4);
+}
+
+
+int rc_mat4_to_matrix(rc_mat4_t A, rc_matrix_t* out)
+{
+    return __mat_to_matrix(__FUNCTION__, &A.d[0][0], out, 4);
+}
+
+
+/*******************************************************************************
+* 6x6
+*******************************************************************************/
+
+rc_mat6_t rc_mat6_identity(void)
+{
+    int i;
+    rc_mat6_t I = {{{0.0}}};
+    for(i=0;i<6;i++) I.d[i][i] = 1.0;
+    return I;
+}
+
+
+rc_mat6_t rc_mat6_multiply(rc_mat6_t A, rc_mat6_t B)
+{
+    int i,j,k;
+    rc_mat6_t C = {{{0.0}}};
+    // i-k-j order streams rows of B and C so the inner loop vectorizes
+    for(i=0;i<6;i++){
+        for(k=0;k<6;k++){
+            for(j=0;j<6;j++) C.d[i][j] += A.d[i][k]*B.d[k][j];
+        }
+    }
+    return C;
+}
+
+
+rc_mat6_t rc_mat6_transpose(rc_mat6_t A)
+{
+    int i,j;
+    rc_mat6_t T;
+    for(i=0;i<6;i++){
+        for(j=0;j<6;j++) T.d[i][j] = A.d[j][i];
+    }
+    return T;
+}
+
+
+/*
+ * In-place LU factorization with partial pivoting, U ends up in the upper
+ * triangle of A and the row swaps are applied to B as they happen so the same
+ * sweep can be reused by the inverse. Returns the determinant of A.
+ */
+static double __mat6_eliminate(double A[6][6], double B[6][6])
+{
+    int i,j,k,p;
+    double det = 1.0;
+    double tmp, ratio;
+
+    for(k=0;k<6;k++){
+        // find the pivot
+        p = k;
+        for(i=k+1;i<6;i++){
+            if(fabs(A[i][k])>fabs(A[p][k])) p = i;
+        }
+        if(p!=k){
+            for(j=0;j<6;j++){
+                tmp = A[k][j]; A[k][j] = A[p][j]; A[p][j] = tmp;
+                tmp = B[k][j]; B[k][j] = B[p][j]; B[p][j] = tmp;
+            }
+            det = -det;
+        }
+        det *= A[k][k];
+        if(A[k][k]==0.0) return 0.0;
+        for(i=k+1;i<6;i++){
+            ratio = A[i][k]/A[k][k];
+            for(j=k;j<6;j++) A[i][j] -= ratio*A[k][j];
+            for(j=0;j<6;j++) B[i][j] -= ratio*B[k][j];
+        }
+    }
+    return det;
+}
+
+
+double rc_mat6_determinant(rc_mat6_t A)
+{
+    rc_mat6_t scratch = {{{0.0}}};
+    return __mat6_eliminate(A.d, scratch.d);
+}
+
+
+int rc_mat6_invert(rc_mat6_t A, rc_mat6_t* Ainv)
+{
+    int i,j,k;
+    rc_mat6_t X = rc_mat6_identity();
+
+    if(unlikely(fabs(__mat6_eliminate(A.d, X.d))<zero_tolerance)){
+        fprintf(stderr,"ERROR in rc_mat6_invert, matrix is singular\n");
+        return -1;
+    }
+    // back substitution, one row of the inverse at a time from the bottom up
+    for(i=5;i>=0;i--){
+        for(k=i+1;k<6;k++){
+            for(j=0;j<6;j++) X.d[i][j] -= A.d[i][k]*X.d[k][j];
+        }
+        for(j=0;j<6;j++) X.d[i][j] /= A.d[i][i];
+    }
+    *Ainv = X;
+    return 0;
+}
+
+
+rc_vec6_t rc_mat6_times_vec(rc_mat6_t A, rc_vec6_t v)
+{
+    int i,j;
+    rc_vec6_t out;
+    for(i=0;i<6;i++){
+        out.d[i] = 0.0;
+        for(j=0;j<6;j++) out.d[i] += A.d[i][j]*v.d[j];
+    }
+    return out;
+}
+
+
+int rc_mat6_from_matrix(rc_matrix_t A, rc_mat6_t* out)
+{
+    return __mat_from_matrix(__FUNCTION__, A, &out->d[0][0], 6);
+}
+
+
+int rc_mat6_to_matrix(rc_mat6_t A, rc_matrix_t* out)
+{
+    return __mat_to_matrix(__FUNCTION__, &A.d[0][0], out, 6);
+}
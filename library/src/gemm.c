@@ -0,0 +1,29 @@
+/**
+ * @file       gemm.c
+ *
+ * @brief      Cache-blocked general matrix multiply used by the matrix and
+ *             algebra modules.
+ *
+ * The layout follows the usual Goto/BLIS scheme. B is copied in KCxNC blocks
+ * into column panels NR wide, A is copied in MCxKC blocks into row panels MR
+ * tall, and a small MRxNR register tile of C is accumulated by the micro-kernel
+ * while streaming through both packed panels. Packing puts every operand the
+ * micro-kernel touches in sequential memory and zero-pads partial panels so the
+ * kernel never needs edge cases in its inner loop.
+ *
+ * All matrices are row-major with a leading dimension (distance in doubles
+ * between the start of consecutive rows) so the same engine serves whole
+ * matrices as well as sub-blocks and transposed operands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // for malloc, free
+#include <string.h> // for memset
+
+#include "algebra_common.h"
+#include "precision.h"
+
+// the double micro-kernel is picked at load time, see algebra_common.c
+#define GEMM_MICRO  __kernels.gemm_micro
+
+#include "gemm_template.h"
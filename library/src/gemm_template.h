@@ -0,0 +1,309 @@
+/**
+ * @file       gemm_template.h
+ *
+ * @brief      Blocked matrix multiply shared by the double and float APIs, see
+ *             gemm.c for the layout and precision.h for the macros. The
+ *             including file defines GEMM_MICRO as the micro-kernel to call.
+ */
+
+// cache block sizes. MCxKC block of A is sized to stay in L2 and a KCxNR
+// sliver of B should stay in L1 while the micro-kernel sweeps down A.
+#define GEMM_MC     96
+#define GEMM_KC     256
+#define GEMM_NC     2048
+
+// below this many multiply-adds the packing overhead outweighs the benefit
+#define GEMM_SMALL_FLOPS    (12*12*12)
+
+// packed buffers up to this many elements live on the stack instead of the
+// heap, 64x64 operands fit, workspace.h documents that limit for the _ws calls
+#define GEMM_MAX_STACK_DOUBLES  8192
+
+// element (i,j) of op(X) where op is an optional transpose
+#define OP(X,ld,t,i,j)  ((t) ? (X)[((j)*(ld))+(i)] : (X)[((i)*(ld))+(j)])
+
+
+/*
+ * Naive path for tiny products where packing costs more than it saves. C has
+ * already been scaled by beta.
+ */
+static void __gemm_small(int ta, int tb, int m, int n, int k, REAL alpha,
+                REAL* A, int lda, REAL* B, int ldb, REAL* C, int ldc)
+{
+    int i,j,p;
+    REAL a;
+
+    for(i=0;i<m;i++){
+        for(p=0;p<k;p++){
+            a = alpha*OP(A,lda,ta,i,p);
+            for(j=0;j<n;j++) C[(i*ldc)+j] += a*OP(B,ldb,tb,p,j);
+        }
+    }
+    return;
+}
+
+
+/*
+ * Copy an mc x kc block of op(A) into row panels GEMM_MR tall. Within each
+ * panel the MR entries of one column are adjacent, which is the order the
+ * micro-kernel consumes them. Rows past mc are zero-filled.
+ */
+static void __pack_a(int ta, int mc, int kc, REAL* A, int lda, REAL* pa)
+{
+    int i,p,r,mr;
+
+    for(r=0;r<mc;r+=GEMM_MR){
+        mr = mc-r;
+        if(mr>GEMM_MR) mr=GEMM_MR;
+        for(p=0;p<kc;p++){
+            for(i=0;i<mr;i++)       pa[i] = OP(A,lda,ta,r+i,p);
+            for(i=mr;i<GEMM_MR;i++) pa[i] = RL(0.0);
+            pa += GEMM_MR;
+        }
+    }
+    return;
+}
+
+
+/*
+ * Copy a kc x nc block of op(B) into column panels GEMM_NR wide. Within each
+ * panel the NR entries of one row are adjacent. Columns past nc are
+ * zero-filled.
+ */
+static void __pack_b(int tb, int kc, int nc, REAL* B, int ldb, REAL* pb)
+{
+    int j,p,c,nr;
+
+    for(c=0;c<nc;c+=GEMM_NR){
+        nr = nc-c;
+        if(nr>GEMM_NR) nr=GEMM_NR;
+        for(p=0;p<kc;p++){
+            for(j=0;j<nr;j++)       pb[j] = OP(B,ldb,tb,p,c+j);
+            for(j=nr;j<GEMM_NR;j++) pb[j] = RL(0.0);
+            pb += GEMM_NR;
+        }
+    }
+    return;
+}
+
+
+/*
+ * Multiply one packed MR row panel by one packed NR column panel and add alpha
+ * times the result into the mr x nr corner of C. The accumulator is a small
+ * fixed-size array so gcc keeps it in vector registers and fully unrolls the
+ * two inner loops. For doubles this is the fallback for the hand-written
+ * versions in kernels_x86.c and kernels_neon.c, for floats it is the only one
+ * and gets twice the lanes per vector register.
+ */
+void PREC(__gemm_micro_generic)(int kc, REAL* __restrict__ a, REAL* __restrict__ b,
+                    REAL alpha, REAL* C, int ldc, int mr, int nr)
+{
+    int i,j,p;
+    REAL ab[GEMM_MR*GEMM_NR];
+
+    for(i=0;i<GEMM_MR*GEMM_NR;i++) ab[i]=RL(0.0);
+
+    for(p=0;p<kc;p++){
+        for(i=0;i<GEMM_MR;i++){
+            for(j=0;j<GEMM_NR;j++) ab[(i*GEMM_NR)+j] += a[i]*b[j];
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    // write back, full tiles take the fast path
+    if(likely(mr==GEMM_MR && nr==GEMM_NR)){
+        for(i=0;i<GEMM_MR;i++){
+            for(j=0;j<GEMM_NR;j++) C[(i*ldc)+j] += alpha*ab[(i*GEMM_NR)+j];
+        }
+    }
+    else{
+        for(i=0;i<mr;i++){
+            for(j=0;j<nr;j++) C[(i*ldc)+j] += alpha*ab[(i*GEMM_NR)+j];
+        }
+    }
+    return;
+}
+
+
+/*
+ * Run the two innermost loops over one packed block of A and one packed block
+ * of B, updating the mc x nc block of C that they produce. The block starts at
+ * row ic, column jc of the full C. When upper is set, tiles lying entirely
+ * below the diagonal of the full C are skipped.
+ */
+static void __gemm_macro(int mc, int nc, int kc, REAL alpha, REAL* pa,
+                        REAL* pb, REAL* C, int ldc, int upper, int ic, int jc)
+{
+    int ir,jr,mr,nr;
+    for(jr=0;jr<nc;jr+=GEMM_NR){
+        nr = nc-jr;
+        if(nr>GEMM_NR) nr=GEMM_NR;
+        for(ir=0;ir<mc;ir+=GEMM_MR){
+            mr = mc-ir;
+            if(mr>GEMM_MR) mr=GEMM_MR;
+            if(upper && (ic+ir)>=(jc+jr+nr)) break;
+            GEMM_MICRO(kc, &pa[ir*kc], &pb[jr*kc], alpha, &C[(ir*ldc)+jr], ldc, mr, nr);
+        }
+    }
+    return;
+}
+
+
+static void __gemm_blocked(int ta, int tb, int m, int n, int k, REAL alpha,
+                REAL* A, int lda, REAL* B, int ldb, REAL* C, int ldc,
+                REAL* pa, REAL* pb, int upper)
+{
+    int ic,jc,pc,mc,nc,kc;
+
+    for(jc=0;jc<n;jc+=GEMM_NC){
+        nc = n-jc;
+        if(nc>GEMM_NC) nc=GEMM_NC;
+        for(pc=0;pc<k;pc+=GEMM_KC){
+            kc = k-pc;
+            if(kc>GEMM_KC) kc=GEMM_KC;
+            // pack block of op(B) starting at row pc, column jc
+            if(tb)  __pack_b(tb, kc, nc, &B[(jc*ldb)+pc], ldb, pb);
+            else    __pack_b(tb, kc, nc, &B[(pc*ldb)+jc], ldb, pb);
+            for(ic=0;ic<m;ic+=GEMM_MC){
+                // rest of this column block is below the diagonal
+                if(upper && ic>=(jc+nc)) break;
+                mc = m-ic;
+                if(mc>GEMM_MC) mc=GEMM_MC;
+                // pack block of op(A) starting at row ic, column pc
+                if(ta)  __pack_a(ta, mc, kc, &A[(pc*lda)+ic], lda, pa);
+                else    __pack_a(ta, mc, kc, &A[(ic*lda)+pc], lda, pa);
+                __gemm_macro(mc, nc, kc, alpha, pa, pb, &C[(ic*ldc)+jc], ldc, upper, ic, jc);
+            }
+        }
+    }
+    return;
+}
+
+
+// round x up to the next multiple of r
+static inline int __round_up(int x, int r)
+{
+    return ((x+r-1)/r)*r;
+}
+
+
+static int __gemm_impl(int ta, int tb, int m, int n, int k, REAL alpha,
+            REAL* A, int lda, REAL* B, int ldb,
+            REAL beta, REAL* C, int ldc, int upper)
+{
+    int i,j,mc,nc,kc,size_a,size_b;
+    REAL* buf;
+
+    if(unlikely(m<1 || n<1)) return 0;
+
+    // scale C by beta first so everything afterwards is a pure accumulate.
+    // beta==0 must not read C since it may not have been initialized.
+    if(beta==RL(0.0)){
+        for(i=0;i<m;i++) memset(&C[i*ldc], 0, n*sizeof(REAL));
+    }
+    else if(beta!=RL(1.0)){
+        for(i=0;i<m;i++){
+            for(j=0;j<n;j++) C[(i*ldc)+j] *= beta;
+        }
+    }
+    if(k<1 || alpha==RL(0.0)) return 0;
+
+    if((long)m*n*k <= GEMM_SMALL_FLOPS){
+        __gemm_small(ta, tb, m, n, k, alpha, A, lda, B, ldb, C, ldc);
+        return 0;
+    }
+
+    // size the packing buffers for the blocks actually used
+    mc = m<GEMM_MC ? __round_up(m,GEMM_MR) : GEMM_MC;
+    nc = n<GEMM_NC ? __round_up(n,GEMM_NR) : GEMM_NC;
+    kc = k<GEMM_KC ? k : GEMM_KC;
+    size_a = mc*kc;
+    size_b = kc*nc;
+
+    if(size_a+size_b <= GEMM_MAX_STACK_DOUBLES){
+        REAL stackbuf[size_a+size_b];
+        __gemm_blocked(ta, tb, m, n, k, alpha, A, lda, B, ldb, C, ldc,
+                                        stackbuf, &stackbuf[size_a], upper);
+        return 0;
+    }
+
+    buf = (REAL*)malloc((size_a+size_b)*sizeof(REAL));
+    if(unlikely(buf==NULL)){
+        perror("ERROR in gemm, failed to allocate packing buffer");
+        return -1;
+    }
+    __gemm_blocked(ta, tb, m, n, k, alpha, A, lda, B, ldb, C, ldc,
+                                                buf, &buf[size_a], upper);
+    free(buf);
+    return 0;
+}
+
+
+/*
+ * Large products are split across the thread pool. Each task multiplies its
+ * own strip of rows of C, or of columns when C is wider than it is tall, with
+ * its own packing buffers.
+ */
+typedef struct __gemm_job_t{
+    int ta, tb, m, n, k;
+    REAL alpha, beta;
+    REAL *A, *B, *C;
+    int lda, ldb, ldc;
+    int by_rows;    // 1 to split rows of C, 0 to split columns
+    int chunk;      // rows or columns per task
+    int ret;        // set to -1 if any task fails
+} __gemm_job_t;
+
+
+static void __gemm_task(void* arg, int task)
+{
+    __gemm_job_t* j = (__gemm_job_t*)arg;
+    int start = task*j->chunk;
+    int ret;
+
+    if(j->by_rows){
+        int rows = (j->m-start)<j->chunk ? (j->m-start) : j->chunk;
+        if(rows<1) return;
+        REAL* A = j->ta ? &j->A[start] : &j->A[start*j->lda];
+        ret = __gemm_impl(j->ta, j->tb, rows, j->n, j->k, j->alpha, A, j->lda,
+                j->B, j->ldb, j->beta, &j->C[start*j->ldc], j->ldc, 0);
+    }
+    else{
+        int cols = (j->n-start)<j->chunk ? (j->n-start) : j->chunk;
+        if(cols<1) return;
+        REAL* B = j->tb ? &j->B[start*j->ldb] : &j->B[start];
+        ret = __gemm_impl(j->ta, j->tb, j->m, cols, j->k, j->alpha, j->A, j->lda,
+                B, j->ldb, j->beta, &j->C[start], j->ldc, 0);
+    }
+    if(unlikely(ret)) j->ret = -1;
+    return;
+}
+
+
+int PREC(__gemm)(int ta, int tb, int m, int n, int k, REAL alpha,
+            REAL* A, int lda, REAL* B, int ldb,
+            REAL beta, REAL* C, int ldc)
+{
+    int threads = __pool_threads();
+    if(threads<2 || (long)m*n*k < POOL_GEMM_FLOPS){
+        return __gemm_impl(ta, tb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc, 0);
+    }
+
+    __gemm_job_t job = {.ta=ta, .tb=tb, .m=m, .n=n, .k=k, .alpha=alpha,
+                .beta=beta, .A=A, .B=B, .C=C, .lda=lda, .ldb=ldb, .ldc=ldc,
+                .by_rows=(m>=n), .ret=0};
+    // whole micro-tiles per task
+    if(job.by_rows) job.chunk = __round_up((m+threads-1)/threads, GEMM_MR);
+    else            job.chunk = __round_up((n+threads-1)/threads, GEMM_NR);
+    __pool_run(__gemm_task, &job, threads);
+    return job.ret;
+}
+
+
+int PREC(__gemm_upper)(int ta, int tb, int m, int k, REAL alpha,
+            REAL* A, int lda, REAL* B, int ldb,
+            REAL beta, REAL* C, int ldc)
+{
+    return __gemm_impl(ta, tb, m, m, k, alpha, A, lda, B, ldb, beta, C, ldc, 1);
+}
@@ -0,0 +1,688 @@
+/**
+ * @file       iterative.c
+ *
+ * @brief      see iterative.h
+ *
+ * The solvers work on raw double arrays taken from one workspace allocated
+ * per call so the inner loops are nothing but calls to the vectorized dot,
+ * axpy and scale kernels between applications of A and M. The operator
+ * callback is handed rc_vector_t wrappers around those arrays.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // for malloc, free
+#include <string.h> // for memset, memcpy
+#include <math.h>
+#include <float.h>
+
+#include <rc_math/iterative.h>
+#include "algebra_common.h"
+
+// largest number of times rc_precond_ic0 shifts the diagonal after a breakdown
+#define IC0_MAX_SHIFTS  6
+
+
+static int __linop_matrix_fn(rc_vector_t x, rc_vector_t* y, void* ctx)
+{
+    return rc_matrix_times_col_vec(*(rc_matrix_t*)ctx, x, y);
+}
+
+
+static int __linop_sparse_fn(rc_vector_t x, rc_vector_t* y, void* ctx)
+{
+    return rc_sparse_times_col_vec(*(rc_sparse_t*)ctx, x, y);
+}
+
+
+rc_linop_t rc_linop_matrix(rc_matrix_t* A)
+{
+    rc_linop_t op = {0, __linop_matrix_fn, A};
+    if(unlikely(A==NULL || !A->initialized || A->rows!=A->cols)){
+        fprintf(stderr,"ERROR in rc_linop_matrix, matrix must be initialized and square\n");
+        return op;
+    }
+    op.n = A->rows;
+    return op;
+}
+
+
+rc_linop_t rc_linop_sparse(rc_sparse_t* S)
+{
+    rc_linop_t op = {0, __linop_sparse_fn, S};
+    if(unlikely(S==NULL || !S->initialized || S->rows!=S->cols)){
+        fprintf(stderr,"ERROR in rc_linop_sparse, matrix must be initialized and square\n");
+        return op;
+    }
+    op.n = S->rows;
+    return op;
+}
+
+
+// y = A*x on arrays of length A.n
+static int __op_apply(rc_linop_t A, double* x, double* y)
+{
+    rc_vector_t vx = RC_VECTOR_INITIALIZER;
+    rc_vector_t vy = RC_VECTOR_INITIALIZER;
+    vx.len = vy.len = A.n;
+    vx.d = x;
+    vy.d = y;
+    vx.initialized = vy.initialized = 1;
+    if(unlikely(A.fn(vx,&vy,A.ctx))){
+        fprintf(stderr,"ERROR in rc_iterative, operator failed\n");
+        return -1;
+    }
+    if(unlikely(vy.d!=y)){
+        fprintf(stderr,"ERROR in rc_iterative, operator must not reallocate its output\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+// z = M*r, M may be NULL for the identity. z and r must not overlap.
+static void __precond_apply(rc_precond_t* M, double* r, double* z, int n)
+{
+    int i,p,last;
+    int *ptr, *idx;
+    double s, *val;
+
+    if(M==NULL || M->type==RC_PRECOND_NONE){
+        memcpy(z, r, n*sizeof(double));
+        return;
+    }
+    if(M->type==RC_PRECOND_JACOBI){
+        for(i=0;i<n;i++) z[i] = M->dinv.d[i]*r[i];
+        return;
+    }
+    // IC0, forward substitution with the rows of L then back substitution
+    // with L^T, reading the same rows as its columns. The diagonal element is
+    // the last one of each row.
+    ptr = M->L.ptr;
+    idx = M->L.idx;
+    val = M->L.val;
+    for(i=0;i<n;i++){
+        s = r[i];
+        last = ptr[i+1]-1;
+        for(p=ptr[i];p<last;p++) s -= val[p]*z[idx[p]];
+        z[i] = s/val[last];
+    }
+    for(i=n-1;i>=0;i--){
+        last = ptr[i+1]-1;
+        z[i] /= val[last];
+        for(p=ptr[i];p<last;p++) z[idx[p]] -= val[p]*z[i];
+    }
+    return;
+}
+
+
+int rc_precond_free(rc_precond_t* M)
+{
+    rc_precond_t new = RC_PRECOND_INITIALIZER;
+    if(unlikely(M==NULL)){
+        fprintf(stderr,"ERROR in rc_precond_free, received NULL pointer\n");
+        return -1;
+    }
+    rc_vector_free(&M->dinv);
+    rc_sparse_free(&M->L);
+    *M = new;
+    return 0;
+}
+
+
+int rc_precond_jacobi(rc_matrix_t A, rc_precond_t* M)
+{
+    int i;
+    // sanity checks
+    if(unlikely(M==NULL)){
+        fprintf(stderr,"ERROR in rc_precond_jacobi, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!A.initialized || A.rows!=A.cols)){
+        fprintf(stderr,"ERROR in rc_precond_jacobi, matrix must be initialized and square\n");
+        return -1;
+    }
+    rc_precond_free(M);
+    if(unlikely(rc_vector_alloc(&M->dinv, A.rows))){
+        fprintf(stderr,"ERROR in rc_precond_jacobi, failed to allocate memory\n");
+        return -1;
+    }
+    for(i=0;i<A.rows;i++){
+        if(unlikely(A.d[i][i]==0.0)){
+            fprintf(stderr,"ERROR in rc_precond_jacobi, zero on the diagonal\n");
+            rc_precond_free(M);
+            return -1;
+        }
+        M->dinv.d[i] = 1.0/A.d[i][i];
+    }
+    M->type = RC_PRECOND_JACOBI;
+    M->n = A.rows;
+    M->initialized = 1;
+    return 0;
+}
+
+
+int rc_precond_jacobi_sparse(rc_sparse_t S, rc_precond_t* M)
+{
+    int i,p;
+    // sanity checks
+    if(unlikely(M==NULL)){
+        fprintf(stderr,"ERROR in rc_precond_jacobi_sparse, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!S.initialized || S.rows!=S.cols)){
+        fprintf(stderr,"ERROR in rc_precond_jacobi_sparse, matrix must be initialized and square\n");
+        return -1;
+    }
+    rc_precond_free(M);
+    if(unlikely(rc_vector_zeros(&M->dinv, S.rows))){
+        fprintf(stderr,"ERROR in rc_precond_jacobi_sparse, failed to allocate memory\n");
+        return -1;
+    }
+    // the diagonal is element i of line i in either format
+    for(i=0;i<S.rows;i++){
+        for(p=S.ptr[i];p<S.ptr[i+1];p++){
+            if(S.idx[p]==i) M->dinv.d[i] += S.val[p];
+        }
+        if(unlikely(M->dinv.d[i]==0.0)){
+            fprintf(stderr,"ERROR in rc_precond_jacobi_sparse, zero on the diagonal\n");
+            rc_precond_free(M);
+            return -1;
+        }
+        M->dinv.d[i] = 1.0/M->dinv.d[i];
+    }
+    M->type = RC_PRECOND_JACOBI;
+    M->n = S.rows;
+    M->initialized = 1;
+    return 0;
+}
+
+
+/*
+ * Factors the CSR lower triangle L in place, row by row. Element (i,k) takes
+ * the sparse dot product of rows i and k to its left, found by merging the
+ * two sorted index lists, and the diagonal is scaled by 1+shift first.
+ * Returns -1 if a diagonal element does not come out positive.
+ */
+static int __ic0_factor(rc_sparse_t L, double shift)
+{
+    int i,k,p,a,b,end;
+    double s,d;
+    for(i=0;i<L.rows;i++){
+        for(p=L.ptr[i];p<L.ptr[i+1];p++){
+            k = L.idx[p];
+            s = 0.0;
+            a = L.ptr[i];
+            b = L.ptr[k];
+            end = L.ptr[k+1]-1;
+            while(a<p && b<end){
+                if(L.idx[a]==L.idx[b]) s += L.val[a++]*L.val[b++];
+                else if(L.idx[a]<L.idx[b]) a++;
+                else b++;
+            }
+            if(k<i){
+                L.val[p] = (L.val[p]-s)/L.val[end];
+                continue;
+            }
+            d = L.val[p]*(1.0+shift) - s;
+            if(!(d>0.0)) return -1;
+            L.val[p] = sqrt(d);
+        }
+    }
+    return 0;
+}
+
+
+int rc_precond_ic0(rc_sparse_t S, rc_precond_t* M)
+{
+    int i,p,k,n,cnt,ret;
+    int *ti, *tj;
+    double shift, *tv, *orig;
+
+    // sanity checks
+    if(unlikely(M==NULL)){
+        fprintf(stderr,"ERROR in rc_precond_ic0, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!S.initialized || S.rows!=S.cols)){
+        fprintf(stderr,"ERROR in rc_precond_ic0, matrix must be initialized and square\n");
+        return -1;
+    }
+    rc_precond_free(M);
+    n = S.rows;
+
+    // Lower triangle of S plus an explicit zero on every diagonal so each row
+    // of L ends with its diagonal element. S is symmetric so its stored lines
+    // are its rows whichever the format.
+    cnt = n;
+    for(i=0;i<n;i++){
+        for(p=S.ptr[i];p<S.ptr[i+1];p++) if(S.idx[p]<=i) cnt++;
+    }
+    ti = (int*)malloc(cnt*sizeof(int));
+    tj = (int*)malloc(cnt*sizeof(int));
+    tv = (double*)malloc(cnt*sizeof(double));
+    if(unlikely(ti==NULL || tj==NULL || tv==NULL)){
+        perror("ERROR in rc_precond_ic0");
+        free(ti);
+        free(tj);
+        free(tv);
+        return -1;
+    }
+    k = 0;
+    for(i=0;i<n;i++){
+        ti[k] = i;
+        tj[k] = i;
+        tv[k++] = 0.0;
+        for(p=S.ptr[i];p<S.ptr[i+1];p++){
+            if(S.idx[p]>i) continue;
+            ti[k] = i;
+            tj[k] = S.idx[p];
+            tv[k++] = S.val[p];
+        }
+    }
+    ret = rc_sparse_from_triplets(&M->L, n, n, cnt, ti, tj, tv, RC_SPARSE_CSR);
+    free(ti);
+    free(tj);
+    free(tv);
+    if(unlikely(ret)){
+        fprintf(stderr,"ERROR in rc_precond_ic0, failed to build L\n");
+        return -1;
+    }
+
+    orig = (double*)malloc(M->L.nnz*sizeof(double));
+    if(unlikely(orig==NULL)){
+        perror("ERROR in rc_precond_ic0");
+        rc_precond_free(M);
+        return -1;
+    }
+    memcpy(orig, M->L.val, M->L.nnz*sizeof(double));
+    shift = 0.0;
+    for(i=0;__ic0_factor(M->L, shift);i++){
+        if(unlikely(i==IC0_MAX_SHIFTS)){
+            fprintf(stderr,"ERROR in rc_precond_ic0, factorization broke down, matrix is not positive definite\n");
+            free(orig);
+            rc_precond_free(M);
+            return -1;
+        }
+        shift = (shift==0.0) ? 1e-3 : 10.0*shift;
+        memcpy(M->L.val, orig, M->L.nnz*sizeof(double));
+    }
+    free(orig);
+    M->type = RC_PRECOND_IC0;
+    M->n = n;
+    M->initialized = 1;
+    return 0;
+}
+
+
+/*
+ * Checks shared by the solvers and preparation of x, zeroed unless warm
+ * starting. Returns -1 on bad input, 1 if b is zero in which case x has been
+ * set to the solution, otherwise 0 with |b| in bnorm.
+ */
+static int __iter_start(const char* fn, rc_linop_t A, rc_vector_t b, rc_vector_t* x,
+                rc_precond_t* M, rc_iterative_opts_t opts, rc_iterative_info_t* info,
+                double* bnorm)
+{
+    if(unlikely(x==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", fn);
+        return -1;
+    }
+    if(unlikely(A.n<1 || A.fn==NULL)){
+        fprintf(stderr,"ERROR in %s, invalid operator\n", fn);
+        return -1;
+    }
+    if(unlikely(!b.initialized || b.len!=A.n)){
+        fprintf(stderr,"ERROR in %s, b must be initialized and of length n\n", fn);
+        return -1;
+    }
+    if(unlikely(M!=NULL && M->type!=RC_PRECOND_NONE && (!M->initialized || M->n!=A.n))){
+        fprintf(stderr,"ERROR in %s, preconditioner not built for this size\n", fn);
+        return -1;
+    }
+    if(unlikely(!(opts.tol>0.0) || opts.max_iter<1)){
+        fprintf(stderr,"ERROR in %s, tol and max_iter must be positive\n", fn);
+        return -1;
+    }
+    if(opts.warm_start){
+        if(unlikely(!x->initialized || x->len!=A.n)){
+            fprintf(stderr,"ERROR in %s, warm start needs x of length n\n", fn);
+            return -1;
+        }
+        if(unlikely(x->d==b.d)){
+            fprintf(stderr,"ERROR in %s, x must not be b\n", fn);
+            return -1;
+        }
+    }
+    else if(unlikely(rc_vector_zeros(x, A.n))){
+        fprintf(stderr,"ERROR in %s, failed to allocate x\n", fn);
+        return -1;
+    }
+    *bnorm = sqrt(__vectorized_square_accumulate(b.d, b.len));
+    if(*bnorm==0.0){
+        memset(x->d, 0, A.n*sizeof(double));
+        if(info!=NULL){
+            info->iterations = 0;
+            info->residual = 0.0;
+            info->converged = 1;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+
+// r = b - A*x, or just b when starting from zero
+static int __iter_residual(rc_linop_t A, rc_vector_t b, rc_vector_t x, int warm, double* r)
+{
+    if(!warm){
+        memcpy(r, b.d, A.n*sizeof(double));
+        return 0;
+    }
+    if(unlikely(__op_apply(A, x.d, r))) return -1;
+    __vectorized_scale(-1.0, r, A.n);
+    __vectorized_axpy(1.0, b.d, r, A.n);
+    return 0;
+}
+
+
+/*
+ * Fills in info, measuring the true residual with scratch of length n, and
+ * turns the solver result into the return value.
+ */
+static int __iter_finish(rc_linop_t A, rc_vector_t b, rc_vector_t x, double bnorm,
+                int converged, int iterations, double* scratch, rc_iterative_info_t* info)
+{
+    if(info!=NULL){
+        info->iterations = iterations;
+        info->converged = converged;
+        if(unlikely(__iter_residual(A, b, x, 1, scratch))) return -1;
+        info->residual = sqrt(__vectorized_square_accumulate(scratch, A.n))/bnorm;
+    }
+    return converged ? 0 : 1;
+}
+
+
+int rc_iterative_cg(rc_linop_t A, rc_vector_t b, rc_vector_t* x, rc_precond_t* M,
+                                rc_iterative_opts_t opts, rc_iterative_info_t* info)
+{
+    int n,it,ret;
+    double bnorm,tol2,rr,rz,rz_new,pq,alpha;
+    double *r, *z, *p, *q;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+
+    ret = __iter_start("rc_iterative_cg", A, b, x, M, opts, info, &bnorm);
+    if(ret) return ret<0 ? -1 : 0;
+    n = A.n;
+    if(unlikely(rc_workspace_alloc(&ws, 4*WS_VECTOR_BYTES(n)))){
+        fprintf(stderr,"ERROR in rc_iterative_cg, failed to allocate workspace\n");
+        return -1;
+    }
+    r = __ws_push(&ws, n*sizeof(double));
+    z = __ws_push(&ws, n*sizeof(double));
+    p = __ws_push(&ws, n*sizeof(double));
+    q = __ws_push(&ws, n*sizeof(double));
+
+    ret = -1;
+    it = 0;
+    tol2 = opts.tol*bnorm*opts.tol*bnorm;
+    if(unlikely(__iter_residual(A, b, *x, opts.warm_start, r))) goto END;
+    rr = __vectorized_square_accumulate(r, n);
+    __precond_apply(M, r, z, n);
+    memcpy(p, z, n*sizeof(double));
+    rz = __vectorized_mult_accumulate(r, z, n);
+
+    while(rr>tol2 && it<opts.max_iter){
+        if(unlikely(!(rz>0.0))){
+            fprintf(stderr,"ERROR in rc_iterative_cg, preconditioner is not positive definite\n");
+            goto END;
+        }
+        if(unlikely(__op_apply(A, p, q))) goto END;
+        it++;
+        pq = __vectorized_mult_accumulate(p, q, n);
+        if(unlikely(!(pq>0.0))){
+            fprintf(stderr,"ERROR in rc_iterative_cg, matrix is not positive definite\n");
+            goto END;
+        }
+        alpha = rz/pq;
+        __vectorized_axpy(alpha, p, x->d, n);
+        __vectorized_axpy(-alpha, q, r, n);
+        rr = __vectorized_square_accumulate(r, n);
+        if(rr<=tol2) break;
+        __precond_apply(M, r, z, n);
+        rz_new = __vectorized_mult_accumulate(r, z, n);
+        // p = z + beta*p
+        __vectorized_scale(rz_new/rz, p, n);
+        __vectorized_axpy(1.0, z, p, n);
+        rz = rz_new;
+    }
+    ret = __iter_finish(A, b, *x, bnorm, rr<=tol2, it, q, info);
+
+END:
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+/*
+ * Preconditioned MINRES following Paige and Saunders. A Lanczos process in
+ * the inner product given by M builds an orthonormal basis, a QR of its
+ * tridiagonal matrix is updated with one rotation per step and x moves along
+ * search directions w built from the last two. phibar is the norm of the
+ * residual measured with M, which is the plain norm when M is NULL.
+ */
+int rc_iterative_minres(rc_linop_t A, rc_vector_t b, rc_vector_t* x, rc_precond_t* M,
+                                rc_iterative_opts_t opts, rc_iterative_info_t* info)
+{
+    int n,it,ret;
+    double bnorm,target,beta,oldb,alfa,dbar,epsln,oldeps,phibar,phi;
+    double cs,sn,delta,gbar,gamma;
+    double *v, *y, *r1, *r2, *w, *w1, *w2, *tmp;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+
+    ret = __iter_start("rc_iterative_minres", A, b, x, M, opts, info, &bnorm);
+    if(ret) return ret<0 ? -1 : 0;
+    n = A.n;
+    if(unlikely(rc_workspace_alloc(&ws, 7*WS_VECTOR_BYTES(n)))){
+        fprintf(stderr,"ERROR in rc_iterative_minres, failed to allocate workspace\n");
+        return -1;
+    }
+    v  = __ws_push(&ws, n*sizeof(double));
+    y  = __ws_push(&ws, n*sizeof(double));
+    r1 = __ws_push(&ws, n*sizeof(double));
+    r2 = __ws_push(&ws, n*sizeof(double));
+    w  = __ws_push(&ws, n*sizeof(double));
+    w1 = __ws_push(&ws, n*sizeof(double));
+    w2 = __ws_push(&ws, n*sizeof(double));
+
+    ret = -1;
+    it = 0;
+    // the tolerance is relative to b measured in the same norm as phibar
+    __precond_apply(M, b.d, y, n);
+    target = __vectorized_mult_accumulate(b.d, y, n);
+    if(unlikely(!(target>0.0))){
+        fprintf(stderr,"ERROR in rc_iterative_minres, preconditioner is not positive definite\n");
+        goto END;
+    }
+    target = opts.tol*sqrt(target);
+
+    if(unlikely(__iter_residual(A, b, *x, opts.warm_start, r1))) goto END;
+    __precond_apply(M, r1, y, n);
+    beta = __vectorized_mult_accumulate(r1, y, n);
+    if(unlikely(beta<0.0)){
+        fprintf(stderr,"ERROR in rc_iterative_minres, preconditioner is not positive definite\n");
+        goto END;
+    }
+    beta = sqrt(beta);
+    memcpy(r2, r1, n*sizeof(double));
+    memset(w, 0, n*sizeof(double));
+    memset(w2, 0, n*sizeof(double));
+    oldb = 0.0;
+    dbar = 0.0;
+    epsln = 0.0;
+    phibar = beta;
+    cs = -1.0;
+    sn = 0.0;
+
+    while(phibar>target && beta>0.0 && it<opts.max_iter){
+        // next Lanczos vector v and the new column alfa, beta of T
+        memcpy(v, y, n*sizeof(double));
+        __vectorized_scale(1.0/beta, v, n);
+        if(unlikely(__op_apply(A, v, y))) goto END;
+        it++;
+        if(it>=2) __vectorized_axpy(-beta/oldb, r1, y, n);
+        alfa = __vectorized_mult_accumulate(v, y, n);
+        __vectorized_axpy(-alfa/beta, r2, y, n);
+        tmp = r1;
+        r1 = r2;
+        r2 = y;
+        y = tmp;
+        __precond_apply(M, r2, y, n);
+        oldb = beta;
+        beta = __vectorized_mult_accumulate(r2, y, n);
+        if(unlikely(beta<0.0)){
+            fprintf(stderr,"ERROR in rc_iterative_minres, preconditioner is not positive definite\n");
+            goto END;
+        }
+        beta = sqrt(beta);
+
+        // apply the previous rotation to the column then make a new one
+        oldeps = epsln;
+        delta = cs*dbar + sn*alfa;
+        gbar = sn*dbar - cs*alfa;
+        epsln = sn*beta;
+        dbar = -cs*beta;
+        gamma = fmax(hypot(gbar, beta), DBL_EPSILON);
+        cs = gbar/gamma;
+        sn = beta/gamma;
+        phi = cs*phibar;
+        phibar = sn*phibar;
+
+        // w = (v - oldeps*w1 - delta*w2)/gamma with w1, w2 the last two w
+        tmp = w1;
+        w1 = w2;
+        w2 = w;
+        w = tmp;
+        memcpy(w, v, n*sizeof(double));
+        __vectorized_axpy(-oldeps, w1, w, n);
+        __vectorized_axpy(-delta, w2, w, n);
+        __vectorized_scale(1.0/gamma, w, n);
+        __vectorized_axpy(phi, w, x->d, n);
+    }
+    ret = __iter_finish(A, b, *x, bnorm, phibar<=target || beta==0.0, it, v, info);
+
+END:
+    rc_workspace_free(&ws);
+    return ret;
+}
+
+
+/*
+ * Restarted GMRES with right preconditioning, A*M*u = b with x = M*u, so the
+ * residual it minimizes is the true one. Each cycle builds an orthonormal
+ * basis V of the Krylov space with modified Gram-Schmidt, reduces the
+ * Hessenberg matrix H to triangular form with Givens rotations as its columns
+ * arrive, and the rotated right hand side g tracks the residual norm. H is
+ * stored by columns.
+ */
+int rc_iterative_gmres(rc_linop_t A, rc_vector_t b, rc_vector_t* x, rc_precond_t* M,
+                                rc_iterative_opts_t opts, rc_iterative_info_t* info)
+{
+    int i,j,k,m,n,it,ret,ldv;
+    double bnorm,target,beta,h,t;
+    double *V, *H, *cs, *sn, *g, *z, *w;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+
+    ret = __iter_start("rc_iterative_gmres", A, b, x, M, opts, info, &bnorm);
+    if(ret) return ret<0 ? -1 : 0;
+    if(unlikely(opts.restart<1)){
+        fprintf(stderr,"ERROR in rc_iterative_gmres, restart must be positive\n");
+        return -1;
+    }
+    n = A.n;
+    m = opts.restart<n ? opts.restart : n;
+    ldv = WS_VECTOR_BYTES(n)/sizeof(double);
+    if(unlikely(rc_workspace_alloc(&ws, (m+3)*WS_VECTOR_BYTES(n) + WS_VECTOR_BYTES((m+1)*m)
+                                        + 2*WS_VECTOR_BYTES(m) + WS_VECTOR_BYTES(m+1)))){
+        fprintf(stderr,"ERROR in rc_iterative_gmres, failed to allocate workspace\n");
+        return -1;
+    }
+    V  = __ws_push(&ws, (m+1)*ldv*sizeof(double));
+    z  = __ws_push(&ws, n*sizeof(double));
+    w  = __ws_push(&ws, n*sizeof(double));
+    H  = __ws_push(&ws, (m+1)*m*sizeof(double));
+    cs = __ws_push(&ws, m*sizeof(double));
+    sn = __ws_push(&ws, m*sizeof(double));
+    g  = __ws_push(&ws, (m+1)*sizeof(double));
+
+    ret = -1;
+    it = 0;
+    target = opts.tol*bnorm;
+    if(unlikely(__iter_residual(A, b, *x, opts.warm_start, w))) goto END;
+    beta = sqrt(__vectorized_square_accumulate(w, n));
+
+    while(beta>target && it<opts.max_iter){
+        memcpy(V, w, n*sizeof(double));
+        __vectorized_scale(1.0/beta, V, n);
+        memset(g, 0, (m+1)*sizeof(double));
+        g[0] = beta;
+        k = 0;
+        for(j=0;j<m && it<opts.max_iter;j++){
+            // new basis vector A*M*v_j orthogonalized against the others
+            __precond_apply(M, &V[j*ldv], z, n);
+            if(unlikely(__op_apply(A, z, &V[(j+1)*ldv]))) goto END;
+            it++;
+            for(i=0;i<=j;i++){
+                h = __vectorized_mult_accumulate(&V[i*ldv], &V[(j+1)*ldv], n);
+                __vectorized_axpy(-h, &V[i*ldv], &V[(j+1)*ldv], n);
+                H[j*(m+1)+i] = h;
+            }
+            h = sqrt(__vectorized_square_accumulate(&V[(j+1)*ldv], n));
+            H[j*(m+1)+j+1] = h;
+            if(h>0.0) __vectorized_scale(1.0/h, &V[(j+1)*ldv], n);
+
+            // previous rotations, then a new one to zero the subdiagonal
+            for(i=0;i<j;i++){
+                t = cs[i]*H[j*(m+1)+i] + sn[i]*H[j*(m+1)+i+1];
+                H[j*(m+1)+i+1] = -sn[i]*H[j*(m+1)+i] + cs[i]*H[j*(m+1)+i+1];
+                H[j*(m+1)+i] = t;
+            }
+            t = hypot(H[j*(m+1)+j], h);
+            if(unlikely(t==0.0)){
+                fprintf(stderr,"ERROR in rc_iterative_gmres, matrix is singular\n");
+                goto END;
+            }
+            cs[j] = H[j*(m+1)+j]/t;
+            sn[j] = h/t;
+            H[j*(m+1)+j] = t;
+            g[j+1] = -sn[j]*g[j];
+            g[j] = cs[j]*g[j];
+            k = j+1;
+            if(fabs(g[j+1])<=target || h==0.0) break;
+        }
+
+        // u = V*y with H*y = g, then x += M*u
+        for(i=k-1;i>=0;i--){
+            t = g[i];
+            for(j=i+1;j<k;j++) t -= H[j*(m+1)+i]*g[j];
+            g[i] = t/H[i*(m+1)+i];
+        }
+        memset(w, 0, n*sizeof(double));
+        for(i=0;i<k;i++) __vectorized_axpy(g[i], &V[i*ldv], w, n);
+        __precond_apply(M, w, z, n);
+        __vectorized_axpy(1.0, z, x->d, n);
+
+        // restart from the true residual
+        if(unlikely(__iter_residual(A, b, *x, 1, w))) goto END;
+        beta = sqrt(__vectorized_square_accumulate(w, n));
+    }
+    ret = beta<=target ? 0 : 1;
+    if(info!=NULL){
+        info->iterations = it;
+        info->residual = beta/bnorm;
+        info->converged = beta<=target;
+    }
+
+END:
+    rc_workspace_free(&ws);
+    return ret;
+}
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <rc_math/algebra.h>
 #include <rc_math/kalman.h>
+#include <rc_math/expression.h>
 #include <alloca.h> // for alloca
 #include "algebra_common.h"
 
@@ -113,6 +114,61 @@ int rc_kalman_alloc_ekf(rc_kalman_t* kf, rc_matrix_t Q, rc_matrix_t R, rc_matrix
 }
 
 
+int rc_kalman_alloc_lin_sparse(rc_kalman_t* kf, rc_sparse_t F, rc_matrix_t G, rc_sparse_t H, rc_matrix_t Q, rc_matrix_t R, rc_matrix_t Pi)
+{
+    // sanity checks
+    if(kf==NULL){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, received NULL pointer\n");
+        return -1;
+    }
+    if(!F.initialized || !H.initialized || !G.initialized){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, received uninitialized F, G, or H\n");
+        return -1;
+    }
+    if(!Q.initialized || !R.initialized || !Pi.initialized){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, received uninitialized Q, R, or Pi\n");
+        return -1;
+    }
+    if(F.rows != F.cols){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, F must be square\n");
+        return -1;
+    }
+    if(H.cols != F.cols){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, F and H must have same number of columns\n");
+        return -1;
+    }
+    if(G.rows != F.rows){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, F and G must have same number of rows\n");
+        return -1;
+    }
+    if(Q.rows != Q.cols || Q.rows != F.rows){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, Q must be square and match F\n");
+        return -1;
+    }
+    if(R.rows != R.cols || R.rows != H.rows){
+        fprintf(stderr, "ERROR in rc_kalman_alloc_lin_sparse, R must be square and match rows of H\n");
+        return -1;
+    }
+
+    // free existing memory, this also zero's out the struct
+    if(rc_kalman_free(kf)==-1) return -1;
+
+    // allocate memory, converting to the same format is a copy
+    if(rc_sparse_convert(F, F.format, &kf->Fs)==-1) return -1;
+    if(rc_sparse_convert(H, H.format, &kf->Hs)==-1) return -1;
+    if(rc_matrix_duplicate(G, &kf->G)==-1) return -1;
+    if(rc_matrix_duplicate(Q, &kf->Q)==-1) return -1;
+    if(rc_matrix_duplicate(R, &kf->R)==-1) return -1;
+    if(rc_matrix_duplicate(Pi, &kf->P)==-1) return -1;
+    if(rc_matrix_duplicate(Pi, &kf->Pi)==-1) return -1;
+
+    if(rc_vector_zeros(&kf->x_est, F.cols)==-1) return -1;
+    if(rc_vector_zeros(&kf->x_pre, F.cols)==-1) return -1;
+    kf->initialized = 1;
+    return 0;
+}
+
+
 int rc_kalman_free(rc_kalman_t* kf)
 {
     rc_kalman_t new = RC_KALMAN_INITIALIZER;
@@ -124,6 +180,8 @@ int rc_kalman_free(rc_kalman_t* kf)
     rc_matrix_free(&kf->F);
     rc_matrix_free(&kf->G);
     rc_matrix_free(&kf->H);
+    rc_sparse_free(&kf->Fs);
+    rc_sparse_free(&kf->Hs);
 
     rc_matrix_free(&kf->Q);
     rc_matrix_free(&kf->R);
@@ -157,16 +215,71 @@ int rc_kalman_reset(rc_kalman_t* kf)
     return 0;
 }
 
+/*
+ * Prediction of P and the measurement update for sparse F and H, x_pre must
+ * already be set. Same steps as the dense update functions below with every
+ * product involving F or H done by the sparse kernels.
+ */
+static int __update_sparse(rc_kalman_t* kf, rc_sparse_t F, rc_sparse_t H, rc_vector_t y, rc_vector_t h)
+{
+    int ret = -1;
+    rc_matrix_t L = RC_MATRIX_INITIALIZER;
+    rc_matrix_t newP = RC_MATRIX_INITIALIZER;
+    rc_matrix_t S = RC_MATRIX_INITIALIZER;
+    rc_matrix_t T = RC_MATRIX_INITIALIZER;
+    rc_vector_t z = RC_VECTOR_INITIALIZER;
+    rc_expr_t e = RC_EXPR_INITIALIZER;
+
+    // P[k|k-1] = F*P[k-1|k-1]*F^T + Q
+    if(rc_sparse_multiply_dense(F, 0, kf->P, &T)) goto end;        // T = F*P
+    if(rc_sparse_dense_multiply(T, F, 1, &newP)) goto end;        // newP = F*P*F^T
+    rc_matrix_add_inplace(&newP, kf->Q);
+    rc_matrix_symmetrize(&newP);
+
+    // S = H*P*H^T + R, keeping T = H*P for below
+    if(rc_sparse_multiply_dense(H, 0, newP, &T)) goto end;        // T = H*P
+    if(rc_sparse_dense_multiply(T, H, 1, &S)) goto end;           // S = (H*P)*H^T
+    rc_matrix_add_inplace(&S, kf->R);
+
+    // L^T = S^-1*(H*P) with a Cholesky solve, see rc_kalman_update_lin
+    if(rc_algebra_cholesky_decomp_inplace(&S)) goto end;
+    if(rc_algebra_cholesky_solve_matrix(S, T, &L)) goto end;
+
+    // x[k|k] = x[k|k-1] + L[k]*(y[k]-h[k])
+    rc_vector_subtract(y, h, &z);
+    rc_expr_add_vector(&e, 1.0, kf->x_pre);
+    rc_expr_add_times_col_vec(&e, 1.0, L, 1, z);
+    if(rc_expr_eval_vector(e, &kf->x_est)) goto end;
+
+    // P[k|k] = P - L*H*P
+    rc_matrix_multiply_trans(L, 1, T, 0, &S);                     // S = L*(H*P)
+    rc_matrix_subtract_inplace(&newP, S);
+    rc_matrix_symmetrize(&newP);
+    rc_matrix_duplicate(newP, &kf->P);
+    ret = 0;
+
+end:
+    if(ret) fprintf(stderr, "ERROR in rc_kalman_update, sparse update failed\n");
+    rc_matrix_free(&L);
+    rc_matrix_free(&newP);
+    rc_matrix_free(&S);
+    rc_matrix_free(&T);
+    rc_vector_free(&z);
+    return ret;
+}
+
+
 int rc_kalman_update_lin(rc_kalman_t* kf, rc_vector_t u, rc_vector_t y)
 {
+    int ret = 0;
     rc_matrix_t L = RC_MATRIX_INITIALIZER;
     rc_matrix_t newP = RC_MATRIX_INITIALIZER;
     rc_matrix_t S = RC_MATRIX_INITIALIZER;
-    rc_matrix_t FT = RC_MATRIX_INITIALIZER;
+    rc_matrix_t T = RC_MATRIX_INITIALIZER;
     rc_vector_t h = RC_VECTOR_INITIALIZER;
     rc_vector_t z = RC_VECTOR_INITIALIZER;
-    rc_vector_t tmp1 = RC_VECTOR_INITIALIZER;
-    rc_vector_t tmp2 = RC_VECTOR_INITIALIZER;
+    rc_vector_t tmp = RC_VECTOR_INITIALIZER;
+    rc_expr_t e = RC_EXPR_INITIALIZER;
 
     // sanity checks
     if(unlikely(kf==NULL)){
@@ -185,78 +298,95 @@ int rc_kalman_update_lin(rc_kalman_t* kf, rc_vector_t u, rc_vector_t y)
         fprintf(stderr, "ERROR in rc_kalman_lin_update u must have same dimension as columns of G\n");
         return -1;
     }
-    if(unlikely(y.len != kf->H.rows)){
+    if(unlikely(y.len != (kf->Hs.initialized ? kf->Hs.rows : kf->H.rows))){
         fprintf(stderr, "ERROR in rc_kalman_lin_update y must have same dimension as rows of H\n");
         return -1;
     }
 
+    // sparse model from rc_kalman_alloc_lin_sparse
+    if(kf->Hs.initialized){
+        // x_pre = F*x[k-1|k-1] + G*u[k-1] and h = H*x_pre
+        rc_sparse_times_col_vec(kf->Fs, kf->x_est, &tmp);
+        rc_expr_add_vector(&e, 1.0, tmp);
+        rc_expr_add_times_col_vec(&e, 1.0, kf->G, 0, u);
+        rc_expr_eval_vector(e, &kf->x_pre);
+        rc_sparse_times_col_vec(kf->Hs, kf->x_pre, &h);
+        if(__update_sparse(kf, kf->Fs, kf->Hs, y, h)){
+            rc_vector_free(&h);
+            rc_vector_free(&tmp);
+            return -1;
+        }
+        rc_vector_free(&h);
+        rc_vector_free(&tmp);
+        kf->step++;
+        return 0;
+    }
+
     // for linear case only, calculate x_pre from linear system model
-    // x_pre = x[k|k-1] = F*x[k-1|k-1] +  G*u[k-1]
-    rc_matrix_times_col_vec(kf->F, kf->x_est, &tmp1);
-    rc_matrix_times_col_vec(kf->G, u, &tmp2);
-    rc_vector_sum(tmp1, tmp2, &kf->x_pre);
+    // x_pre = x[k|k-1] = F*x[k-1|k-1] +  G*u[k-1] in one pass
+    rc_expr_add_times_col_vec(&e, 1.0, kf->F, 0, kf->x_est);
+    rc_expr_add_times_col_vec(&e, 1.0, kf->G, 0, u);
+    rc_expr_eval_vector(e, &kf->x_pre);
 
     // F is constant in this linear case
     // P[k|k-1] = F*P[k-1|k-1]*F^T + Q
-    rc_matrix_multiply(kf->F, kf->P, &newP);    // newP = F*P_old
-    rc_matrix_transpose(kf->F, &FT);
-    rc_matrix_right_multiply_inplace(&newP, FT);    // P = F*P*F^T
-    rc_matrix_add_inplace(&newP, kf->Q);        // P = F*P*F^T + Q
-    rc_matrix_symmetrize(&newP);            // Force symmetric P
+    rc_matrix_sandwich_add(kf->F, kf->P, kf->Q, &newP); // newP = F*P*F^T + Q
 
     // h[k] = H * x_pre[k]
     rc_matrix_times_col_vec(kf->H,kf->x_pre,&h);
 
     // H is constant in the linear case
     // S = H*P*H^T + R
-    // Calculate H^T, borrow S for H^T
-    rc_matrix_transpose(kf->H, &S);         // S = H^T
-    // Calculate a part of L in advance before we modify S = H^T
-    rc_matrix_multiply(newP, S, &L);        // K = P*(H^T)
-    rc_matrix_left_multiply_inplace(newP, &S);  // S = P*H^T
-    rc_matrix_left_multiply_inplace(kf->H, &S); // S = H*(P*H^T)
+    // T = H*P is needed again below so compute it once, reading H as its
+    // transpose in place
+    rc_matrix_multiply(kf->H, newP, &T);    // T = H*P
+    rc_matrix_multiply_trans(T, 0, kf->H, 1, &S);  // S = (H*P)*H^T
     rc_matrix_add_inplace(&S, kf->R);       // S = H*P*H^T + R
 
-    // L = P*(H^T)*(S^-1)
-    rc_algebra_invert_matrix_inplace(&S);       // S2^(-1) = S^(-1)
-    rc_matrix_right_multiply_inplace(&L, S);    // L = (P*H^T)*(S^-1)
+    // L = P*(H^T)*(S^-1). S is symmetric positive definite so rather than
+    // inverting it, factor S = C*C^T and solve S*L^T = H*P for L^T.
+    if(rc_algebra_cholesky_decomp_inplace(&S) ||  // S = C
+       rc_algebra_cholesky_solve_matrix(S, T, &L)){   // L holds L^T
+        fprintf(stderr, "ERROR in rc_kalman_lin_update, S is not positive definite\n");
+        ret = -1;
+        goto end;
+    }
 
     // x[k|k] = x[k|k-1] + K[k]*(y[k]-h[k])
     rc_vector_subtract(y,h,&z);         // z = k-h
-    rc_matrix_times_col_vec(L, z, &tmp1);       // temp = L*z
-    rc_vector_sum(kf->x_pre, tmp1, &kf->x_est); // x_est = x + K*y
+    rc_expr_clear(&e);
+    rc_expr_add_vector(&e, 1.0, kf->x_pre);
+    rc_expr_add_times_col_vec(&e, 1.0, L, 1, z);
+    rc_expr_eval_vector(e, &kf->x_est);         // x_est = x + K*z
 
     // P[k|k] = (I - L*H)*P = P[k|k-1] - L*H*P[k|k-1], reuse the matrix S.
-    rc_matrix_multiply(kf->H, newP, &S);        // S = H*P
-    rc_matrix_left_multiply_inplace(L, &S);     // S = L*(H*P)
+    rc_matrix_multiply_trans(L, 1, T, 0, &S);   // S = L*(H*P)
     rc_matrix_subtract_inplace(&newP, S);       // P = P - K*H*P
     rc_matrix_symmetrize(&newP);            // Force symmetric P
     rc_matrix_duplicate(newP,&kf->P);
+    kf->step++;
 
+end:
     // cleanup
     rc_matrix_free(&L);
     rc_matrix_free(&newP);
     rc_matrix_free(&S);
-    rc_matrix_free(&FT);
+    rc_matrix_free(&T);
     rc_vector_free(&h);
     rc_vector_free(&z);
-    rc_vector_free(&tmp1);
-    rc_vector_free(&tmp2);
-
-    kf->step++;
-    return 0;
+    return ret;
 }
 
 
 int rc_kalman_update_ekf(rc_kalman_t* kf, rc_matrix_t F, rc_matrix_t H, rc_vector_t x_pre, rc_vector_t y, rc_vector_t h)
 {
+    int ret = 0;
     rc_matrix_t L = RC_MATRIX_INITIALIZER;
     rc_matrix_t newP = RC_MATRIX_INITIALIZER;
     rc_matrix_t S = RC_MATRIX_INITIALIZER;
-    rc_matrix_t FT = RC_MATRIX_INITIALIZER;
+    rc_matrix_t T = RC_MATRIX_INITIALIZER;
     rc_vector_t z = RC_VECTOR_INITIALIZER;
-    rc_vector_t tmp1 = RC_VECTOR_INITIALIZER;
-    rc_vector_t tmp2 = RC_VECTOR_INITIALIZER;
+    rc_expr_t e = RC_EXPR_INITIALIZER;
 
     // sanity checks
     if(unlikely(kf==NULL)){
@@ -303,48 +433,89 @@ int rc_kalman_update_ekf(rc_kalman_t* kf, rc_matrix_t F, rc_matrix_t H, rc_vecto
 
     // F is new now in non-linear case
     // P[k|k-1] = F*P[k-1|k-1]*F^T + Q
-    rc_matrix_multiply(kf->F, kf->P, &newP);    // P_new = F*P_old
-    rc_matrix_transpose(kf->F, &FT);
-    rc_matrix_right_multiply_inplace(&newP, FT);    // P = F*P*F^T
-    rc_matrix_add(newP, kf->Q, &kf->P);     // P = F*P*F^T + Q
-    rc_matrix_symmetrize(&kf->P);           // Force symmetric P
+    rc_matrix_sandwich_add(kf->F, kf->P, kf->Q, &newP); // newP = F*P*F^T + Q
 
-    // H is constant in the linear case
     // S = H*P*H^T + R
-    // Calculate H^T, borrow S for H^T
-    rc_matrix_transpose(kf->H, &S);         // S = H^T
-    // Calculate a part of L in advance before we modify S = H^T
-    rc_matrix_multiply(kf->P, S, &L);       // K = P*(H^T)
-    rc_matrix_left_multiply_inplace(kf->P, &S); // S = P*H^T
-    rc_matrix_left_multiply_inplace(kf->H, &S); // S = H*(P*H^T)
+    // T = H*P is needed again below so compute it once, reading H as its
+    // transpose in place
+    rc_matrix_multiply(kf->H, newP, &T);    // T = H*P
+    rc_matrix_multiply_trans(T, 0, kf->H, 1, &S);  // S = (H*P)*H^T
     rc_matrix_add_inplace(&S, kf->R);       // S = H*P*H^T + R
 
-    // L = P*(H^T)*(S^-1)
-    rc_algebra_invert_matrix_inplace(&S);       // S2^(-1) = S^(-1)
-    rc_matrix_right_multiply_inplace(&L, S);    // L = (P*H^T)*(S^-1)
+    // L = P*(H^T)*(S^-1) by a Cholesky solve, see rc_kalman_update_lin
+    if(rc_algebra_cholesky_decomp_inplace(&S) ||  // S = C
+       rc_algebra_cholesky_solve_matrix(S, T, &L)){   // L holds L^T
+        fprintf(stderr, "ERROR in rc_kalman_ekf_update, S is not positive definite\n");
+        ret = -1;
+        goto end;
+    }
 
     // x[k|k] = x[k|k-1] + L[k]*(y[k]-h[k])
     rc_vector_subtract(y,h,&z);         // z = k-h
-    rc_matrix_times_col_vec(L, z, &tmp1);       // temp = L*z
-    rc_vector_sum(kf->x_pre, tmp1, &kf->x_est); // x_est = x + L*y
+    rc_expr_add_vector(&e, 1.0, kf->x_pre);
+    rc_expr_add_times_col_vec(&e, 1.0, L, 1, z);
+    rc_expr_eval_vector(e, &kf->x_est);         // x_est = x + L*z
 
     // P[k|k] = (I - L*H)*P = P - L*H*P, reuse the matrix S.
-    rc_matrix_multiply(kf->H, newP, &S);        // S = H*P
-    rc_matrix_left_multiply_inplace(L, &S);     // S = L*(H*P)
+    rc_matrix_multiply_trans(L, 1, T, 0, &S);   // S = L*(H*P)
     rc_matrix_subtract_inplace(&newP, S);       // P = P - K*H*P
     rc_matrix_symmetrize(&newP);            // Force symmetric P
     rc_matrix_duplicate(newP,&kf->P);
+    kf->step++;
 
+end:
     // cleanup
     rc_matrix_free(&L);
     rc_matrix_free(&newP);
     rc_matrix_free(&S);
-    rc_matrix_free(&FT);
+    rc_matrix_free(&T);
     rc_vector_free(&z);
-    rc_vector_free(&tmp1);
-    rc_vector_free(&tmp2);
+    return ret;
+}
+
 
+int rc_kalman_update_ekf_sparse(rc_kalman_t* kf, rc_sparse_t F, rc_sparse_t H, rc_vector_t x_pre, rc_vector_t y, rc_vector_t h)
+{
+    // sanity checks
+    if(unlikely(kf==NULL)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(kf->initialized !=1)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse, kf uninitialized\n");
+        return -1;
+    }
+    if(unlikely(F.initialized!=1 || H.initialized!=1)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse received uninitialized matrix\n");
+        return -1;
+    }
+    if(unlikely(x_pre.initialized!=1 || y.initialized!=1 || h.initialized!=1)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse received uninitialized vector\n");
+        return -1;
+    }
+    if(unlikely(F.rows != F.cols)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse F must be square\n");
+        return -1;
+    }
+    if(unlikely(x_pre.len != F.rows || F.rows != kf->P.rows)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse x_pre must have same dimension as rows of F and P\n");
+        return -1;
+    }
+    if(unlikely(x_pre.len != H.cols)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse x_pre must have same dimension as columns of H\n");
+        return -1;
+    }
+    if(unlikely(y.len != H.rows)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse y must have same dimension as rows of H\n");
+        return -1;
+    }
+    if(unlikely(y.len != h.len)){
+        fprintf(stderr, "ERROR in rc_kalman_update_ekf_sparse y must have same dimension h\n");
+        return -1;
+    }
+
+    rc_vector_duplicate(x_pre, &kf->x_pre);
+    if(__update_sparse(kf, F, H, y, h)) return -1;
     kf->step++;
     return 0;
 }
-
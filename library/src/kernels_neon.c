@@ -0,0 +1,177 @@
+/**
+ * @file       kernels_neon.c
+ *
+ * @brief      Hand-written aarch64 Advanced SIMD versions of the innermost
+ *             kernels, see algebra_common.h
+ *
+ * Advanced SIMD with double precision lanes is mandatory on aarch64 so these
+ * are always available there. 32-bit ARM NEON has no double precision lanes so
+ * 32-bit builds, like every other architecture, only get the stub below and
+ * stay on the generic path.
+ **/
+
+#include "algebra_common.h"
+
+#if defined(__aarch64__)
+
+#include <arm_neon.h>
+
+
+static double __dot_neon(double * __restrict__ a, double * __restrict__ b, int n)
+{
+    int i = 0;
+    double sum;
+    float64x2_t s0 = vdupq_n_f64(0.0);
+    float64x2_t s1 = vdupq_n_f64(0.0);
+    float64x2_t s2 = vdupq_n_f64(0.0);
+    float64x2_t s3 = vdupq_n_f64(0.0);
+
+    // four independent accumulators hide the FMA latency
+    for(;i<=n-8;i+=8){
+        s0 = vfmaq_f64(s0, vld1q_f64(&a[i  ]), vld1q_f64(&b[i  ]));
+        s1 = vfmaq_f64(s1, vld1q_f64(&a[i+2]), vld1q_f64(&b[i+2]));
+        s2 = vfmaq_f64(s2, vld1q_f64(&a[i+4]), vld1q_f64(&b[i+4]));
+        s3 = vfmaq_f64(s3, vld1q_f64(&a[i+6]), vld1q_f64(&b[i+6]));
+    }
+    for(;i<=n-2;i+=2){
+        s0 = vfmaq_f64(s0, vld1q_f64(&a[i]), vld1q_f64(&b[i]));
+    }
+    sum = vaddvq_f64(vaddq_f64(vaddq_f64(s0,s1), vaddq_f64(s2,s3)));
+    for(;i<n;i++) sum += a[i]*b[i];
+    return sum;
+}
+
+
+static double __square_neon(double * __restrict__ a, int n)
+{
+    int i = 0;
+    double sum;
+    float64x2_t x0, x1, x2, x3;
+    float64x2_t s0 = vdupq_n_f64(0.0);
+    float64x2_t s1 = vdupq_n_f64(0.0);
+    float64x2_t s2 = vdupq_n_f64(0.0);
+    float64x2_t s3 = vdupq_n_f64(0.0);
+
+    for(;i<=n-8;i+=8){
+        x0 = vld1q_f64(&a[i  ]);
+        x1 = vld1q_f64(&a[i+2]);
+        x2 = vld1q_f64(&a[i+4]);
+        x3 = vld1q_f64(&a[i+6]);
+        s0 = vfmaq_f64(s0, x0, x0);
+        s1 = vfmaq_f64(s1, x1, x1);
+        s2 = vfmaq_f64(s2, x2, x2);
+        s3 = vfmaq_f64(s3, x3, x3);
+    }
+    for(;i<=n-2;i+=2){
+        x0 = vld1q_f64(&a[i]);
+        s0 = vfmaq_f64(s0, x0, x0);
+    }
+    sum = vaddvq_f64(vaddq_f64(vaddq_f64(s0,s1), vaddq_f64(s2,s3)));
+    for(;i<n;i++) sum += a[i]*a[i];
+    return sum;
+}
+
+
+static void __axpy_neon(double alpha, double * __restrict__ x, double * __restrict__ y, int n)
+{
+    int i = 0;
+    float64x2_t va = vdupq_n_f64(alpha);
+
+    for(;i<=n-4;i+=4){
+        vst1q_f64(&y[i  ], vfmaq_f64(vld1q_f64(&y[i  ]), va, vld1q_f64(&x[i  ])));
+        vst1q_f64(&y[i+2], vfmaq_f64(vld1q_f64(&y[i+2]), va, vld1q_f64(&x[i+2])));
+    }
+    for(;i<n;i++) y[i] += alpha*x[i];
+    return;
+}
+
+
+static void __scale_neon(double s, double * __restrict__ x, int n)
+{
+    int i = 0;
+    float64x2_t vs = vdupq_n_f64(s);
+
+    for(;i<=n-4;i+=4){
+        vst1q_f64(&x[i  ], vmulq_f64(vs, vld1q_f64(&x[i  ])));
+        vst1q_f64(&x[i+2], vmulq_f64(vs, vld1q_f64(&x[i+2])));
+    }
+    for(;i<n;i++) x[i] *= s;
+    return;
+}
+
+
+/*
+ * 4x8 tile in sixteen q-register accumulators, four per row of C. With the
+ * four registers of b and the broadcast of a this still leaves room in the
+ * 32 register file so nothing spills.
+ */
+static void __gemm_micro_neon(int kc, double * __restrict__ a, double * __restrict__ b,
+                    double alpha, double* C, int ldc, int mr, int nr)
+{
+    int i,j,p;
+    float64x2_t b0, b1, b2, b3, ai;
+    float64x2_t c[GEMM_MR][4];
+    double ab[GEMM_MR*GEMM_NR];
+    float64x2_t va = vdupq_n_f64(alpha);
+
+    for(i=0;i<GEMM_MR;i++){
+        for(j=0;j<4;j++) c[i][j] = vdupq_n_f64(0.0);
+    }
+
+    for(p=0;p<kc;p++){
+        b0 = vld1q_f64(&b[0]);
+        b1 = vld1q_f64(&b[2]);
+        b2 = vld1q_f64(&b[4]);
+        b3 = vld1q_f64(&b[6]);
+        for(i=0;i<GEMM_MR;i++){
+            ai = vdupq_n_f64(a[i]);
+            c[i][0] = vfmaq_f64(c[i][0], ai, b0);
+            c[i][1] = vfmaq_f64(c[i][1], ai, b1);
+            c[i][2] = vfmaq_f64(c[i][2], ai, b2);
+            c[i][3] = vfmaq_f64(c[i][3], ai, b3);
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if(likely(mr==GEMM_MR && nr==GEMM_NR)){
+        for(i=0;i<GEMM_MR;i++){
+            double* row = &C[i*ldc];
+            for(j=0;j<4;j++){
+                vst1q_f64(&row[2*j], vfmaq_f64(vld1q_f64(&row[2*j]), va, c[i][j]));
+            }
+        }
+        return;
+    }
+    // partial tile at the bottom or right edge of C
+    for(i=0;i<GEMM_MR;i++){
+        for(j=0;j<4;j++) vst1q_f64(&ab[(i*GEMM_NR)+(2*j)], c[i][j]);
+    }
+    for(i=0;i<mr;i++){
+        for(j=0;j<nr;j++) C[(i*ldc)+j] += alpha*ab[(i*GEMM_NR)+j];
+    }
+    return;
+}
+
+
+int __kernels_neon(__algebra_kernels_t* k)
+{
+    k->path         = RC_SIMD_NEON;
+    k->dot          = __dot_neon;
+    k->square       = __square_neon;
+    k->axpy         = __axpy_neon;
+    k->scale        = __scale_neon;
+    k->gemm_micro   = __gemm_micro_neon;
+    return 0;
+}
+
+
+#else // not aarch64
+
+int __kernels_neon(__algebra_kernels_t* k)
+{
+    (void)k;
+    return -1;
+}
+
+#endif // aarch64
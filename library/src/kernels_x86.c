@@ -0,0 +1,624 @@
+/**
+ * @file       kernels_x86.c
+ *
+ * @brief      Hand-written SSE2, AVX2+FMA, and AVX-512 versions of the
+ *             innermost kernels, see algebra_common.h
+ *
+ * Every function is compiled with a gcc target attribute for its own
+ * instruction set so the library can be built for the baseline x86-64 target
+ * and still use newer instructions when the running CPU has them. The choice
+ * is made once at load time in algebra_common.c. On other architectures this
+ * file only provides stubs reporting that these paths are unavailable.
+ **/
+
+#include "algebra_common.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <math.h>   // for fabs
+#include <immintrin.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// SSE2
+////////////////////////////////////////////////////////////////////////////////
+
+__attribute__((target("sse2")))
+static inline double __hsum_sse2(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v,v)));
+}
+
+
+__attribute__((target("sse2")))
+static double __dot_sse2(double * __restrict__ a, double * __restrict__ b, int n)
+{
+    int i = 0;
+    double sum;
+    __m128d s0 = _mm_setzero_pd();
+    __m128d s1 = _mm_setzero_pd();
+    __m128d s2 = _mm_setzero_pd();
+    __m128d s3 = _mm_setzero_pd();
+
+    // four independent accumulators hide the add latency
+    for(;i<=n-8;i+=8){
+        s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(&a[i  ]), _mm_loadu_pd(&b[i  ])));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(&a[i+2]), _mm_loadu_pd(&b[i+2])));
+        s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_loadu_pd(&a[i+4]), _mm_loadu_pd(&b[i+4])));
+        s3 = _mm_add_pd(s3, _mm_mul_pd(_mm_loadu_pd(&a[i+6]), _mm_loadu_pd(&b[i+6])));
+    }
+    for(;i<=n-2;i+=2){
+        s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(&a[i]), _mm_loadu_pd(&b[i])));
+    }
+    sum = __hsum_sse2(_mm_add_pd(_mm_add_pd(s0,s1), _mm_add_pd(s2,s3)));
+    for(;i<n;i++) sum += a[i]*b[i];
+    return sum;
+}
+
+
+__attribute__((target("sse2")))
+static double __square_sse2(double * __restrict__ a, int n)
+{
+    int i = 0;
+    double sum;
+    __m128d x0, x1, x2, x3;
+    __m128d s0 = _mm_setzero_pd();
+    __m128d s1 = _mm_setzero_pd();
+    __m128d s2 = _mm_setzero_pd();
+    __m128d s3 = _mm_setzero_pd();
+
+    for(;i<=n-8;i+=8){
+        x0 = _mm_loadu_pd(&a[i  ]);
+        x1 = _mm_loadu_pd(&a[i+2]);
+        x2 = _mm_loadu_pd(&a[i+4]);
+        x3 = _mm_loadu_pd(&a[i+6]);
+        s0 = _mm_add_pd(s0, _mm_mul_pd(x0,x0));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(x1,x1));
+        s2 = _mm_add_pd(s2, _mm_mul_pd(x2,x2));
+        s3 = _mm_add_pd(s3, _mm_mul_pd(x3,x3));
+    }
+    for(;i<=n-2;i+=2){
+        x0 = _mm_loadu_pd(&a[i]);
+        s0 = _mm_add_pd(s0, _mm_mul_pd(x0,x0));
+    }
+    sum = __hsum_sse2(_mm_add_pd(_mm_add_pd(s0,s1), _mm_add_pd(s2,s3)));
+    for(;i<n;i++) sum += a[i]*a[i];
+    return sum;
+}
+
+
+__attribute__((target("sse2")))
+static void __axpy_sse2(double alpha, double * __restrict__ x, double * __restrict__ y, int n)
+{
+    int i = 0;
+    __m128d va = _mm_set1_pd(alpha);
+
+    for(;i<=n-4;i+=4){
+        _mm_storeu_pd(&y[i  ], _mm_add_pd(_mm_loadu_pd(&y[i  ]), _mm_mul_pd(va, _mm_loadu_pd(&x[i  ]))));
+        _mm_storeu_pd(&y[i+2], _mm_add_pd(_mm_loadu_pd(&y[i+2]), _mm_mul_pd(va, _mm_loadu_pd(&x[i+2]))));
+    }
+    for(;i<n;i++) y[i] += alpha*x[i];
+    return;
+}
+
+
+__attribute__((target("sse2")))
+static void __scale_sse2(double s, double * __restrict__ x, int n)
+{
+    int i = 0;
+    __m128d vs = _mm_set1_pd(s);
+
+    for(;i<=n-4;i+=4){
+        _mm_storeu_pd(&x[i  ], _mm_mul_pd(vs, _mm_loadu_pd(&x[i  ])));
+        _mm_storeu_pd(&x[i+2], _mm_mul_pd(vs, _mm_loadu_pd(&x[i+2])));
+    }
+    for(;i<n;i++) x[i] *= s;
+    return;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// AVX2 + FMA
+////////////////////////////////////////////////////////////////////////////////
+
+__attribute__((target("avx2,fma")))
+static inline double __hsum_avx2(__m256d v)
+{
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    lo = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(lo, _mm_unpackhi_pd(lo,lo)));
+}
+
+
+__attribute__((target("avx2,fma")))
+static double __dot_avx2(double * __restrict__ a, double * __restrict__ b, int n)
+{
+    int i = 0;
+    double sum;
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd();
+    __m256d s3 = _mm256_setzero_pd();
+
+    for(;i<=n-16;i+=16){
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(&a[i   ]), _mm256_loadu_pd(&b[i   ]), s0);
+        s1 = _mm256_fmadd_pd(_mm256_loadu_pd(&a[i+ 4]), _mm256_loadu_pd(&b[i+ 4]), s1);
+        s2 = _mm256_fmadd_pd(_mm256_loadu_pd(&a[i+ 8]), _mm256_loadu_pd(&b[i+ 8]), s2);
+        s3 = _mm256_fmadd_pd(_mm256_loadu_pd(&a[i+12]), _mm256_loadu_pd(&b[i+12]), s3);
+    }
+    for(;i<=n-4;i+=4){
+        s0 = _mm256_fmadd_pd(_mm256_loadu_pd(&a[i]), _mm256_loadu_pd(&b[i]), s0);
+    }
+    sum = __hsum_avx2(_mm256_add_pd(_mm256_add_pd(s0,s1), _mm256_add_pd(s2,s3)));
+    for(;i<n;i++) sum += a[i]*b[i];
+    return sum;
+}
+
+
+__attribute__((target("avx2,fma")))
+static double __square_avx2(double * __restrict__ a, int n)
+{
+    int i = 0;
+    double sum;
+    __m256d x0, x1, x2, x3;
+    __m256d s0 = _mm256_setzero_pd();
+    __m256d s1 = _mm256_setzero_pd();
+    __m256d s2 = _mm256_setzero_pd();
+    __m256d s3 = _mm256_setzero_pd();
+
+    for(;i<=n-16;i+=16){
+        x0 = _mm256_loadu_pd(&a[i   ]);
+        x1 = _mm256_loadu_pd(&a[i+ 4]);
+        x2 = _mm256_loadu_pd(&a[i+ 8]);
+        x3 = _mm256_loadu_pd(&a[i+12]);
+        s0 = _mm256_fmadd_pd(x0, x0, s0);
+        s1 = _mm256_fmadd_pd(x1, x1, s1);
+        s2 = _mm256_fmadd_pd(x2, x2, s2);
+        s3 = _mm256_fmadd_pd(x3, x3, s3);
+    }
+    for(;i<=n-4;i+=4){
+        x0 = _mm256_loadu_pd(&a[i]);
+        s0 = _mm256_fmadd_pd(x0, x0, s0);
+    }
+    sum = __hsum_avx2(_mm256_add_pd(_mm256_add_pd(s0,s1), _mm256_add_pd(s2,s3)));
+    for(;i<n;i++) sum += a[i]*a[i];
+    return sum;
+}
+
+
+__attribute__((target("avx2,fma")))
+static void __axpy_avx2(double alpha, double * __restrict__ x, double * __restrict__ y, int n)
+{
+    int i = 0;
+    __m256d va = _mm256_set1_pd(alpha);
+
+    for(;i<=n-8;i+=8){
+        _mm256_storeu_pd(&y[i  ], _mm256_fmadd_pd(va, _mm256_loadu_pd(&x[i  ]), _mm256_loadu_pd(&y[i  ])));
+        _mm256_storeu_pd(&y[i+4], _mm256_fmadd_pd(va, _mm256_loadu_pd(&x[i+4]), _mm256_loadu_pd(&y[i+4])));
+    }
+    for(;i<n;i++) y[i] += alpha*x[i];
+    return;
+}
+
+
+__attribute__((target("avx2,fma")))
+static void __scale_avx2(double s, double * __restrict__ x, int n)
+{
+    int i = 0;
+    __m256d vs = _mm256_set1_pd(s);
+
+    for(;i<=n-8;i+=8){
+        _mm256_storeu_pd(&x[i  ], _mm256_mul_pd(vs, _mm256_loadu_pd(&x[i  ])));
+        _mm256_storeu_pd(&x[i+4], _mm256_mul_pd(vs, _mm256_loadu_pd(&x[i+4])));
+    }
+    for(;i<n;i++) x[i] *= s;
+    return;
+}
+
+
+__attribute__((target("avx2,fma")))
+static inline double __hmin_avx2(__m256d v)
+{
+    __m128d lo = _mm_min_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_min_sd(lo, _mm_unpackhi_pd(lo,lo)));
+}
+
+
+__attribute__((target("avx2,fma")))
+static inline double __hmax_avx2(__m256d v)
+{
+    __m128d lo = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(lo, _mm_unpackhi_pd(lo,lo)));
+}
+
+
+/*
+ * Every statistic from one load of each element, two sets of accumulators
+ * hide the add latency. The flag tests are loop invariant and get unswitched.
+ */
+__attribute__((target("avx2,fma")))
+static void __stats_avx2(double * __restrict__ x, int n, double shift, int flags, __stats_acc_t* acc)
+{
+    int i = 0;
+    double d;
+    __m256d x0, x1, d0, d1;
+    __m256d vshift = _mm256_set1_pd(shift);
+    __m256d sign = _mm256_set1_pd(-0.0);
+    __m256d s0  = _mm256_setzero_pd();
+    __m256d s1  = _mm256_setzero_pd();
+    __m256d ss0 = _mm256_setzero_pd();
+    __m256d ss1 = _mm256_setzero_pd();
+    __m256d q0  = _mm256_setzero_pd();
+    __m256d q1  = _mm256_setzero_pd();
+    __m256d a0  = _mm256_setzero_pd();
+    __m256d a1  = _mm256_setzero_pd();
+    __m256d mn  = _mm256_set1_pd(x[0]);
+    __m256d mx  = mn;
+    const int moments = flags & (RC_VECTOR_STATS_MEAN|RC_VECTOR_STATS_STD_DEV);
+    const int norms   = flags & RC_VECTOR_STATS_NORM;
+    const int range   = flags & (RC_VECTOR_STATS_MAX|RC_VECTOR_STATS_MIN);
+
+    for(;i<=n-8;i+=8){
+        x0 = _mm256_loadu_pd(&x[i  ]);
+        x1 = _mm256_loadu_pd(&x[i+4]);
+        if(moments){
+            d0  = _mm256_sub_pd(x0, vshift);
+            d1  = _mm256_sub_pd(x1, vshift);
+            s0  = _mm256_add_pd(s0, d0);
+            s1  = _mm256_add_pd(s1, d1);
+            ss0 = _mm256_fmadd_pd(d0, d0, ss0);
+            ss1 = _mm256_fmadd_pd(d1, d1, ss1);
+        }
+        if(norms){
+            q0  = _mm256_fmadd_pd(x0, x0, q0);
+            q1  = _mm256_fmadd_pd(x1, x1, q1);
+            a0  = _mm256_add_pd(a0, _mm256_andnot_pd(sign, x0));
+            a1  = _mm256_add_pd(a1, _mm256_andnot_pd(sign, x1));
+        }
+        if(range){
+            mn  = _mm256_min_pd(mn, _mm256_min_pd(x0, x1));
+            mx  = _mm256_max_pd(mx, _mm256_max_pd(x0, x1));
+        }
+    }
+    acc->sum    = __hsum_avx2(_mm256_add_pd(s0, s1));
+    acc->sumsq  = __hsum_avx2(_mm256_add_pd(ss0, ss1));
+    acc->sq     = __hsum_avx2(_mm256_add_pd(q0, q1));
+    acc->abs    = __hsum_avx2(_mm256_add_pd(a0, a1));
+    acc->min    = __hmin_avx2(mn);
+    acc->max    = __hmax_avx2(mx);
+    for(;i<n;i++){
+        if(moments){
+            d = x[i]-shift;
+            acc->sum += d;
+            acc->sumsq += d*d;
+        }
+        if(norms){
+            acc->sq += x[i]*x[i];
+            acc->abs += fabs(x[i]);
+        }
+        if(range){
+            if(x[i]<acc->min) acc->min = x[i];
+            if(x[i]>acc->max) acc->max = x[i];
+        }
+    }
+    return;
+}
+
+
+/*
+ * 4x8 tile held in eight ymm accumulators, two per row of C. Each step
+ * broadcasts one entry of a and does two FMAs against the packed row of b.
+ */
+__attribute__((target("avx2,fma")))
+static void __gemm_micro_avx2(int kc, double * __restrict__ a, double * __restrict__ b,
+                    double alpha, double* C, int ldc, int mr, int nr)
+{
+    int i,j,p;
+    __m256d b0, b1, ai;
+    __m256d c[GEMM_MR][2];
+    double ab[GEMM_MR*GEMM_NR];
+    __m256d va = _mm256_set1_pd(alpha);
+
+    for(i=0;i<GEMM_MR;i++) c[i][0] = c[i][1] = _mm256_setzero_pd();
+
+    for(p=0;p<kc;p++){
+        b0 = _mm256_loadu_pd(&b[0]);
+        b1 = _mm256_loadu_pd(&b[4]);
+        for(i=0;i<GEMM_MR;i++){
+            ai = _mm256_broadcast_sd(&a[i]);
+            c[i][0] = _mm256_fmadd_pd(ai, b0, c[i][0]);
+            c[i][1] = _mm256_fmadd_pd(ai, b1, c[i][1]);
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if(likely(mr==GEMM_MR && nr==GEMM_NR)){
+        for(i=0;i<GEMM_MR;i++){
+            double* row = &C[i*ldc];
+            _mm256_storeu_pd(&row[0], _mm256_fmadd_pd(va, c[i][0], _mm256_loadu_pd(&row[0])));
+            _mm256_storeu_pd(&row[4], _mm256_fmadd_pd(va, c[i][1], _mm256_loadu_pd(&row[4])));
+        }
+        return;
+    }
+    // partial tile at the bottom or right edge of C
+    for(i=0;i<GEMM_MR;i++){
+        _mm256_storeu_pd(&ab[(i*GEMM_NR)  ], c[i][0]);
+        _mm256_storeu_pd(&ab[(i*GEMM_NR)+4], c[i][1]);
+    }
+    for(i=0;i<mr;i++){
+        for(j=0;j<nr;j++) C[(i*ldc)+j] += alpha*ab[(i*GEMM_NR)+j];
+    }
+    return;
+}
+
+
+/*
+ * Float version of the tile above. A row of 8 floats fits in one ymm register
+ * so the whole 4x8 tile lives in four accumulators.
+ */
+__attribute__((target("avx2,fma")))
+static void __gemm_microf_avx2(int kc, float * __restrict__ a, float * __restrict__ b,
+                    float alpha, float* C, int ldc, int mr, int nr)
+{
+    int i,j,p;
+    __m256 b0, ai;
+    __m256 c[GEMM_MR];
+    float ab[GEMM_MR*GEMM_NR];
+    __m256 va = _mm256_set1_ps(alpha);
+
+    for(i=0;i<GEMM_MR;i++) c[i] = _mm256_setzero_ps();
+
+    for(p=0;p<kc;p++){
+        b0 = _mm256_loadu_ps(b);
+        for(i=0;i<GEMM_MR;i++){
+            ai = _mm256_broadcast_ss(&a[i]);
+            c[i] = _mm256_fmadd_ps(ai, b0, c[i]);
+        }
+        a += GEMM_MR;
+        b += GEMM_NR;
+    }
+
+    if(likely(mr==GEMM_MR && nr==GEMM_NR)){
+        for(i=0;i<GEMM_MR;i++){
+            float* row = &C[i*ldc];
+            _mm256_storeu_ps(row, _mm256_fmadd_ps(va, c[i], _mm256_loadu_ps(row)));
+        }
+        return;
+    }
+    // partial tile at the bottom or right edge of C
+    for(i=0;i<GEMM_MR;i++) _mm256_storeu_ps(&ab[i*GEMM_NR], c[i]);
+    for(i=0;i<mr;i++){
+        for(j=0;j<nr;j++) C[(i*ldc)+j] += alpha*ab[(i*GEMM_NR)+j];
+    }
+    return;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// AVX-512
+////////////////////////////////////////////////////////////////////////////////
+
+__attribute__((target("avx512f")))
+static double __dot_avx512(double * __restrict__ a, double * __restrict__ b, int n)
+{
+    int i = 0;
+    __m512d s0 = _mm512_setzero_pd();
+    __m512d s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd();
+    __m512d s3 = _mm512_setzero_pd();
+    __mmask8 m;
+
+    for(;i<=n-32;i+=32){
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(&a[i   ]), _mm512_loadu_pd(&b[i   ]), s0);
+        s1 = _mm512_fmadd_pd(_mm512_loadu_pd(&a[i+ 8]), _mm512_loadu_pd(&b[i+ 8]), s1);
+        s2 = _mm512_fmadd_pd(_mm512_loadu_pd(&a[i+16]), _mm512_loadu_pd(&b[i+16]), s2);
+        s3 = _mm512_fmadd_pd(_mm512_loadu_pd(&a[i+24]), _mm512_loadu_pd(&b[i+24]), s3);
+    }
+    for(;i<=n-8;i+=8){
+        s0 = _mm512_fmadd_pd(_mm512_loadu_pd(&a[i]), _mm512_loadu_pd(&b[i]), s0);
+    }
+    // masked loads take care of the last few entries without a scalar loop
+    if(i<n){
+        m = (__mmask8)((1u<<(n-i))-1u);
+        s1 = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(m,&a[i]), _mm512_maskz_loadu_pd(m,&b[i]), s1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0,s1), _mm512_add_pd(s2,s3)));
+}
+
+
+__attribute__((target("avx512f")))
+static double __square_avx512(double * __restrict__ a, int n)
+{
+    int i = 0;
+    __m512d x0, x1, x2, x3;
+    __m512d s0 = _mm512_setzero_pd();
+    __m512d s1 = _mm512_setzero_pd();
+    __m512d s2 = _mm512_setzero_pd();
+    __m512d s3 = _mm512_setzero_pd();
+    __mmask8 m;
+
+    for(;i<=n-32;i+=32){
+        x0 = _mm512_loadu_pd(&a[i   ]);
+        x1 = _mm512_loadu_pd(&a[i+ 8]);
+        x2 = _mm512_loadu_pd(&a[i+16]);
+        x3 = _mm512_loadu_pd(&a[i+24]);
+        s0 = _mm512_fmadd_pd(x0, x0, s0);
+        s1 = _mm512_fmadd_pd(x1, x1, s1);
+        s2 = _mm512_fmadd_pd(x2, x2, s2);
+        s3 = _mm512_fmadd_pd(x3, x3, s3);
+    }
+    for(;i<=n-8;i+=8){
+        x0 = _mm512_loadu_pd(&a[i]);
+        s0 = _mm512_fmadd_pd(x0, x0, s0);
+    }
+    if(i<n){
+        m = (__mmask8)((1u<<(n-i))-1u);
+        x1 = _mm512_maskz_loadu_pd(m,&a[i]);
+        s1 = _mm512_fmadd_pd(x1, x1, s1);
+    }
+    return _mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(s0,s1), _mm512_add_pd(s2,s3)));
+}
+
+
+__attribute__((target("avx512f")))
+static void __axpy_avx512(double alpha, double * __restrict__ x, double * __restrict__ y, int n)
+{
+    int i = 0;
+    __m512d va = _mm512_set1_pd(alpha);
+    __mmask8 m;
+
+    for(;i<=n-8;i+=8){
+        _mm512_storeu_pd(&y[i], _mm512_fmadd_pd(va, _mm512_loadu_pd(&x[i]), _mm512_loadu_pd(&y[i])));
+    }
+    if(i<n){
+        m = (__mmask8)((1u<<(n-i))-1u);
+        _mm512_mask_storeu_pd(&y[i], m, _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(m,&x[i]),
+                                                    _mm512_maskz_loadu_pd(m,&y[i])));
+    }
+    return;
+}
+
+
+__attribute__((target("avx512f")))
+static void __scale_avx512(double s, double * __restrict__ x, int n)
+{
+    int i = 0;
+    __m512d vs = _mm512_set1_pd(s);
+    __mmask8 m;
+
+    for(;i<=n-8;i+=8){
+        _mm512_storeu_pd(&x[i], _mm512_mul_pd(vs, _mm512_loadu_pd(&x[i])));
+    }
+    if(i<n){
+        m = (__mmask8)((1u<<(n-i))-1u);
+        _mm512_mask_storeu_pd(&x[i], m, _mm512_mul_pd(vs, _mm512_maskz_loadu_pd(m,&x[i])));
+    }
+    return;
+}
+
+
+/*
+ * 4x8 tile where each row of C fits in one zmm register. The k loop is
+ * unrolled by two into separate accumulators so there are eight independent
+ * FMA chains in flight, enough to cover the FMA latency.
+ */
+__attribute__((target("avx512f")))
+static void __gemm_micro_avx512(int kc, double * __restrict__ a, double * __restrict__ b,
+                    double alpha, double* C, int ldc, int mr, int nr)
+{
+    int i,j,p;
+    __m512d b0, b1;
+    __m512d c[GEMM_MR], d[GEMM_MR];
+    double ab[GEMM_MR*GEMM_NR];
+    __m512d va = _mm512_set1_pd(alpha);
+    __mmask8 m;
+
+    for(i=0;i<GEMM_MR;i++) c[i] = d[i] = _mm512_setzero_pd();
+
+    for(p=0;p<=kc-2;p+=2){
+        b0 = _mm512_loadu_pd(&b[0]);
+        b1 = _mm512_loadu_pd(&b[GEMM_NR]);
+        for(i=0;i<GEMM_MR;i++){
+            c[i] = _mm512_fmadd_pd(_mm512_set1_pd(a[i]), b0, c[i]);
+            d[i] = _mm512_fmadd_pd(_mm512_set1_pd(a[GEMM_MR+i]), b1, d[i]);
+        }
+        a += 2*GEMM_MR;
+        b += 2*GEMM_NR;
+    }
+    if(p<kc){
+        b0 = _mm512_loadu_pd(&b[0]);
+        for(i=0;i<GEMM_MR;i++){
+            c[i] = _mm512_fmadd_pd(_mm512_set1_pd(a[i]), b0, c[i]);
+        }
+    }
+    for(i=0;i<GEMM_MR;i++) c[i] = _mm512_add_pd(c[i], d[i]);
+
+    if(likely(mr==GEMM_MR)){
+        m = (__mmask8)((1u<<nr)-1u);
+        for(i=0;i<GEMM_MR;i++){
+            double* row = &C[i*ldc];
+            _mm512_mask_storeu_pd(row, m, _mm512_fmadd_pd(va, c[i], _mm512_maskz_loadu_pd(m,row)));
+        }
+        return;
+    }
+    // partial tile at the bottom edge of C
+    for(i=0;i<GEMM_MR;i++) _mm512_storeu_pd(&ab[i*GEMM_NR], c[i]);
+    for(i=0;i<mr;i++){
+        for(j=0;j<nr;j++) C[(i*ldc)+j] += alpha*ab[(i*GEMM_NR)+j];
+    }
+    return;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// tables
+////////////////////////////////////////////////////////////////////////////////
+
+int __kernels_sse2(__algebra_kernels_t* k)
+{
+    __builtin_cpu_init();
+    if(!__builtin_cpu_supports("sse2")) return -1;
+    k->path     = RC_SIMD_SSE2;
+    k->dot      = __dot_sse2;
+    k->square   = __square_sse2;
+    k->axpy     = __axpy_sse2;
+    k->scale    = __scale_sse2;
+    // the generic micro-kernel and stats kernel already compile to good SSE2
+    // code
+    return 0;
+}
+
+
+int __kernels_avx2(__algebra_kernels_t* k)
+{
+    __builtin_cpu_init();
+    if(!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) return -1;
+    k->path         = RC_SIMD_AVX2;
+    k->dot          = __dot_avx2;
+    k->square       = __square_avx2;
+    k->axpy         = __axpy_avx2;
+    k->scale        = __scale_avx2;
+    k->stats        = __stats_avx2;
+    k->gemm_micro   = __gemm_micro_avx2;
+    k->gemm_microf  = __gemm_microf_avx2;
+    return 0;
+}
+
+
+int __kernels_avx512(__algebra_kernels_t* k)
+{
+    __builtin_cpu_init();
+    if(!__builtin_cpu_supports("avx512f")) return -1;
+    k->path         = RC_SIMD_AVX512;
+    k->dot          = __dot_avx512;
+    k->square       = __square_avx512;
+    k->axpy         = __axpy_avx512;
+    k->scale        = __scale_avx512;
+    k->gemm_micro   = __gemm_micro_avx512;
+    return 0;
+}
+
+
+#else // not x86
+
+int __kernels_sse2(__algebra_kernels_t* k)
+{
+    (void)k;
+    return -1;
+}
+
+int __kernels_avx2(__algebra_kernels_t* k)
+{
+    (void)k;
+    return -1;
+}
+
+int __kernels_avx512(__algebra_kernels_t* k)
+{
+    (void)k;
+    return -1;
+}
+
+#endif // x86
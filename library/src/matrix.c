@@ -17,128 +17,22 @@
 #include <rc_math/other.h>
 #include <rc_math/matrix.h>
 #include "algebra_common.h"
+#include "precision.h"
 
-
-rc_matrix_t rc_matrix_empty(void)
-{
-    rc_matrix_t out = RC_MATRIX_INITIALIZER;
-    return out;
-}
-
-
-int rc_matrix_alloc(rc_matrix_t* A, int rows, int cols)
-{
-    int i;
-    // sanity checks
-    if(unlikely(rows<1 || cols<1)){
-        fprintf(stderr,"ERROR in rc_matrix_alloc, rows and cols must be >=1\n");
-        return -1;
-    }
-    if(unlikely(A==NULL)){
-        fprintf(stderr,"ERROR in rc_matrix_alloc, received NULL pointer\n");
-        return -1;
-    }
-    // if A is already allocated and of the right size, nothing to do!
-    if(A->initialized==1 && rows==A->rows && cols==A->cols) return 0;
-    // free any old memory
-    rc_matrix_free(A);
-    // allocate contiguous memory for the major(row) pointers
-    A->d = (double**)malloc(rows*sizeof(double*));
-    if(unlikely(A->d==NULL)){
-        perror("ERROR in rc_matrix_alloc");
-        fprintf(stderr, "tried allocating a %dx%d matrix\n", rows,cols);
-        return -1;
-    }
-    // allocate contiguous memory for the actual data
-    void* ptr = malloc(rows*cols*sizeof(double));
-    if(unlikely(ptr==NULL)){
-        perror("ERROR in rc_matrix_alloc");
-        fprintf(stderr, "tried allocating a %dx%d matrix\n", rows,cols);
-        free(A->d);
-        return -1;
-    }
-    // manually fill in the pointer to each row
-    for(i=0;i<rows;i++) A->d[i]=(double*)(((char*)ptr) + (i*cols*sizeof(double)));
-    A->rows = rows;
-    A->cols = cols;
-    A->initialized = 1;
-    return 0;
-}
-
-
-int rc_matrix_free(rc_matrix_t* A)
-{
-    rc_matrix_t new = RC_MATRIX_INITIALIZER;
-    if(unlikely(A==NULL)){
-        fprintf(stderr,"ERROR in rc_matrix_free, received NULL pointer\n");
-        return -1;
-    }
-    // free memory allocated for the data then the major array
-    if(A->d!=NULL && A->initialized==1) free(A->d[0]);
-    free(A->d);
-    // zero out the struct
-    *A = new;
-    return 0;
-}
-
-
-int rc_matrix_zeros(rc_matrix_t* A, int rows, int cols)
-{
-    int i;
-    // sanity checks
-    if(unlikely(rows<1 || cols<1)){
-        fprintf(stderr,"ERROR in rc_create_matrix_zeros, rows and cols must be >=1\n");
-        return -1;
-    }
-    if(unlikely(A==NULL)){
-        fprintf(stderr,"ERROR in rc_create_matrix_zeros, received NULL pointer\n");
-        return -1;
-    }
-    // make sure A is freed before allocating new memory
-    rc_matrix_free(A);
-    // allocate contiguous memory for the major(row) pointers
-    A->d = (double**)malloc(rows*sizeof(double*));
-    if(unlikely(A->d==NULL)){
-        fprintf(stderr,"ERROR in rc_create_matrix_zeros, not enough memory\n");
-        return -1;
-    }
-    // allocate contiguous memory for the actual data
-    void* ptr = calloc(rows*cols,sizeof(double));
-    if(unlikely(ptr==NULL)){
-        fprintf(stderr,"ERROR in rc_create_matrix_zeros, not enough memory\n");
-        free(A->d);
-        return -1;
-    }
-    // manually fill in the pointer to each row
-    for(i=0;i<rows;i++) A->d[i]=(double*)(((char*)ptr) + (i*cols*sizeof(double)));
-    A->rows = rows;
-    A->cols = cols;
-    A->initialized = 1;
-    return 0;
-}
-
-
-int rc_matrix_identity(rc_matrix_t* A, int dim)
-{
-    int i;
-    if(unlikely(rc_matrix_zeros(A,dim,dim))){
-        fprintf(stderr,"ERROR in rc_matrix_identity, failed to allocate matrix\n");
-        return -1;
-    }
-    // fill in diagonal of ones
-    for(i=0;i<dim;i++) A->d[i][i]=1.0;
-    return 0;
-}
+// functions shared with the float API, see single_precision.c
+#include "matrix_template.h"
 
 
 int rc_matrix_random(rc_matrix_t* A, int rows, int cols)
 {
-    int i;
+    int i,j;
     if(unlikely(rc_matrix_alloc(A,rows,cols))){
         fprintf(stderr,"ERROR in rc_matrix_random, failed to allocate matrix\n");
         return -1;
     }
-    for(i=0;i<(A->rows*A->cols);i++) A->d[0][i]=rc_get_random_double();
+    for(i=0;i<A->rows;i++){
+        for(j=0;j<A->cols;j++) A->d[i][j]=rc_get_random_double();
+    }
     return 0;
 }
 
@@ -161,25 +55,9 @@ int rc_matrix_diagonal(rc_matrix_t* A, rc_vector_t v)
 }
 
 
-int rc_matrix_duplicate(rc_matrix_t A, rc_matrix_t* B)
-{
-    // sanity check
-    if(unlikely(A.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_duplicate not initialized yet\n");
-        return -1;
-    }
-    // make sure there is enough space in B
-    if(unlikely(rc_matrix_alloc(B,A.rows,A.cols))){
-        fprintf(stderr,"ERROR in rc_matrix_duplicate, failed to allocate memory\n");
-        return -1;
-    }
-    // all matrix data is stored contiguously so one memcpy is sufficient
-    memcpy(B->d[0],A.d[0],A.rows*A.cols*sizeof(double));
-    return 0;
-}
-
 int rc_matrix_from_array(rc_matrix_t* A, double** ptr, int rows, int cols)
 {
+    int i;
     // sanity check pointer
     if(unlikely(ptr==NULL)){
         fprintf(stderr,"ERROR in rc_matrix_from_array, received NULL pointer\n");
@@ -190,272 +68,47 @@ int rc_matrix_from_array(rc_matrix_t* A, double** ptr, int rows, int cols)
         fprintf(stderr,"ERROR in rc_matrix_from_array, failed to allocate matrix\n");
         return -1;
     }
-    // copy memory over
-    memcpy(A->d, ptr, rows*cols*sizeof(double));
+    // copy memory over a row at a time
+    for(i=0;i<rows;i++) memcpy(A->d[i], ptr[i], cols*sizeof(double));
     return 0;
 }
 
-int rc_matrix_print(rc_matrix_t A)
-{
-    int i,j;
-    if(unlikely(A.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_print, matrix not initialized yet\n");
-        return -1;
-    }
-    for(i=0;i<A.rows;i++){
-        for(j=0;j<A.cols;j++){
-            printf("%7.4f  ",A.d[i][j]);
-        }
-        printf("\n");
-    }
-    return 0;
-}
-
-
-int rc_matrix_print_sci(rc_matrix_t A)
-{
-    int i,j;
-    if(unlikely(A.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_print_sci, matrix not initialized yet\n");
-        return -1;
-    }
-    for(i=0;i<A.rows;i++){
-        for(j=0;j<A.cols;j++){
-            printf("%11.4e  ",A.d[i][j]);
-        }
-        printf("\n");
-    }
-    return 0;
-}
-
-
-int rc_matrix_zero_out(rc_matrix_t* A)
-{
-    int i,j;
-    if(unlikely(A->initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_zero_out, matrix not initialized yet\n");
-        return -1;
-    }
-    for(i=0;i<A->rows;i++){
-        for(j=0;j<A->cols;j++){
-            A->d[i][j]=0.0;
-        }
-    }
-    return 0;
-}
-
-
-int rc_matrix_times_scalar(rc_matrix_t* A, double s)
-{
-    int i;
-    if(unlikely(A->initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_times_scalar. matrix uninitialized\n");
-        return -1;
-    }
-    // since A contains contiguous memory, gcc should vectorize this loop
-    for(i=0;i<(A->rows*A->cols);i++) A->d[0][i] *= s;
-    return 0;
-}
-
-
-int rc_matrix_multiply(rc_matrix_t A, rc_matrix_t B, rc_matrix_t* C)
+int rc_matrix_multiply_abc(rc_matrix_t A, rc_matrix_t B, rc_matrix_t C, rc_matrix_t* out)
 {
-    int i,j;
+    long cost_ab, cost_bc;
 
-    if(unlikely(A.initialized!=1 || B.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_multiply, matrix not initialized\n");
-        return -1;
-    }
-    if(unlikely(A.cols!=B.rows)){
-        fprintf(stderr,"ERROR in rc_matrix_multiply, dimension mismatch\n");
+    if(unlikely(A.initialized!=1 || B.initialized!=1 || C.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_multiply_abc, matrix not initialized\n");
         return -1;
     }
-    // if C is not initialized, allocate memory for it
-    if(unlikely(rc_matrix_alloc(C,A.rows,B.cols))){
-        fprintf(stderr,"ERROR in rc_matrix_multiply, can't allocate memory for C\n");
+    if(unlikely(A.cols!=B.rows || B.cols!=C.rows)){
+        fprintf(stderr,"ERROR in rc_matrix_multiply_abc, dimension mismatch\n");
         return -1;
     }
+    // pick whichever association needs fewer multiply-adds
+    cost_ab = ((long)A.rows*A.cols*B.cols) + ((long)A.rows*B.cols*C.cols);
+    cost_bc = ((long)B.rows*B.cols*C.cols) + ((long)A.rows*A.cols*C.cols);
 
-    double tmp[B.rows];
-    // go through columns of B calculating columns of C left to right
-    for(i=0;i<(B.cols);i++){
-        // put column of B in sequential memory slot
-        for(j=0;j<B.rows;j++) tmp[j]=B.d[j][i];
-        // calculate each row in column i
-        for(j=0;j<(A.rows);j++){
-            C->d[j][i]=__vectorized_mult_accumulate(A.d[j],tmp,B.rows);
+    if(cost_ab<cost_bc){
+        // out = (A*B)*C
+        if(unlikely(rc_matrix_multiply(A,B,out))){
+            fprintf(stderr,"ERROR in rc_matrix_multiply_abc\n");
+            return -1;
         }
-    }
-    return 0;
-}
-
-
-int rc_matrix_left_multiply_inplace(rc_matrix_t A, rc_matrix_t* B)
-{
-    int i,j;
-
-    // Sanity Checks
-    if(unlikely(A.initialized!=1 || B->initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_left_multiply_inplace, matrix not initialized\n");
-        return -1;
-    }
-    if(unlikely(A.cols!=B->rows)){
-        fprintf(stderr,"ERROR in rc_matrix_left_multiply_inplace, dimension mismatch\n");
-        return -1;
-    }
-
-    // populate tmp matrix with transpose of B
-    // it is faster to put a column in contiguous memory before multiplying
-    double tmp[B->rows*B->cols];
-    int s = B->rows;
-    for(i=0;i<(B->cols);i++){
-        // put column of B in sequential memory slot
-        for(j=0;j<B->rows;j++) tmp[(i*s)+j]=B->d[j][i];
-    }
-
-    // reallocate B if it needs changing size
-    if(unlikely(rc_matrix_alloc(B,A.rows,B->cols))){
-        fprintf(stderr,"ERROR in rc_matrix_left_multiply_inplace, can't allocate memory for B\n");
-        return -1;
-    }
-
-    // calculate each row in column i
-    for(i=0;i<(B->cols);i++){
-        for(j=0;j<(B->rows);j++){
-            B->d[j][i]=__vectorized_mult_accumulate(A.d[j], &tmp[i*s], A.cols);
+        if(unlikely(rc_matrix_right_multiply_inplace(out,C))){
+            fprintf(stderr,"ERROR in rc_matrix_multiply_abc\n");
+            return -1;
         }
     }
-    return 0;
-}
-
-
-// TODO: move all temporary memory to stack
-int rc_matrix_right_multiply_inplace(rc_matrix_t* A, rc_matrix_t B)
-{
-    int i,j;
-    // Sanity Checks
-    if(unlikely(A->initialized!=1 || B.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_right_multiply_inplace, matrix not initialized\n");
-        return -1;
-    }
-    if(unlikely(A->cols!=B.rows)){
-        fprintf(stderr,"ERROR in rc_matrix_right_multiply_inplace, dimension mismatch\n");
-        return -1;
-    }
-
-    // populate tmp matrix with contents of A
-    double tmpA[A->rows*A->cols];
-    int s = A->cols;
-    for(i=0;i<(A->rows);i++){
-        for(j=0;j<A->cols;j++) tmpA[(i*s)+j]=A->d[i][j];
-    }
-
-    // resize A if necessary
-    if(unlikely(rc_matrix_alloc(A,A->rows,B.cols))){
-        fprintf(stderr,"ERROR in rc_matrix_right_multiply_inplace, can't allocate memory for A\n");
-        return -1;
-    }
-
-    double tmp[B.rows];
-    // go through columns of B calculating columns of C left to right
-    for(i=0;i<(B.cols);i++){
-        // put column of B in sequential memory slot
-        for(j=0;j<B.rows;j++) tmp[j]=B.d[j][i];
-        // calculate each row in column i
-        for(j=0;j<(A->rows);j++){
-            A->d[j][i]=__vectorized_mult_accumulate(&tmpA[j*s],tmp,B.rows);
+    else{
+        // out = A*(B*C)
+        if(unlikely(rc_matrix_multiply(B,C,out))){
+            fprintf(stderr,"ERROR in rc_matrix_multiply_abc\n");
+            return -1;
         }
-    }
-    return 0;
-}
-
-
-int rc_matrix_multiply_abc(rc_matrix_t A, rc_matrix_t B, rc_matrix_t C, rc_matrix_t* out)
-{
-    if(unlikely(A.initialized!=1 || B.initialized!=1 || C.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_multiply_abc, matrix not initialized\n");
-        return -1;
-    }
-    if(unlikely(rc_matrix_multiply(B,C,out))){
-        fprintf(stderr,"ERROR in rc_matrix_multiply_abc\n");
-        return -1;
-    }
-    if(unlikely(rc_matrix_left_multiply_inplace(A,out))){
-        fprintf(stderr,"ERROR in rc_matrix_multiply_abc\n");
-        return -1;
-    }
-    return 0;
-}
-
-
-int rc_matrix_add(rc_matrix_t A, rc_matrix_t B, rc_matrix_t* C)
-{
-    int i;
-    if(unlikely(A.initialized!=1 || B.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_add, matrix not initialized\n");
-        return -1;
-    }
-    if(unlikely(A.rows!=B.rows || A.cols!=B.cols)){
-        fprintf(stderr,"ERROR in rc_matrix_add, dimension mismatch\n");
-        return -1;
-    }
-    // make sure C is allocated
-    if(unlikely(rc_matrix_alloc(C,A.rows,A.cols))){
-        fprintf(stderr,"ERROR in rc_matrix_add, can't allocate memory for C\n");
-        return -1;
-    }
-    for(i=0;i<(A.rows*A.cols);i++) C->d[0][i]=A.d[0][i]+B.d[0][i];
-    return 0;
-}
-
-
-int rc_matrix_add_inplace(rc_matrix_t* A, rc_matrix_t B)
-{
-    int i;
-    if(unlikely(A->initialized!=1 || B.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_add_inplace, matrix not initialized\n");
-        return -1;
-    }
-    if(unlikely(A->rows!=B.rows || A->cols!=B.cols)){
-        fprintf(stderr,"ERROR in rc_matrix_add_inplace, dimension mismatch\n");
-        return -1;
-    }
-    for(i=0;i<(A->rows*A->cols);i++) A->d[0][i]+=B.d[0][i];
-    return 0;
-}
-
-int rc_matrix_subtract_inplace(rc_matrix_t* A, rc_matrix_t B)
-{
-    int i;
-    if(unlikely(A->initialized!=1 || B.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_subtract_inplace, matrix not initialized\n");
-        return -1;
-    }
-    if(unlikely(A->rows!=B.rows || A->cols!=B.cols)){
-        fprintf(stderr,"ERROR in rc_matrix_subtract_inplace, dimension mismatch\n");
-        return -1;
-    }
-    for(i=0;i<(A->rows*A->cols);i++) A->d[0][i]-=B.d[0][i];
-    return 0;
-}
-
-
-int rc_matrix_transpose(rc_matrix_t A, rc_matrix_t* T)
-{
-    int i,j;
-    if(unlikely(A.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_transpose, received uninitialized matrix\n");
-        return -1;
-    }
-    // make sure T is allocated
-    if(unlikely(rc_matrix_alloc(T,A.cols,A.rows))){
-        fprintf(stderr,"ERROR in rc_matrix_transpose, can't allocate memory for T\n");
-        return -1;
-    }
-    // fill in new memory
-    for(i=0;i<(A.rows);i++){
-        for(j=0;j<(A.cols);j++){
-            T->d[j][i] = A.d[i][j];
+        if(unlikely(rc_matrix_left_multiply_inplace(A,out))){
+            fprintf(stderr,"ERROR in rc_matrix_multiply_abc\n");
+            return -1;
         }
     }
     return 0;
@@ -489,28 +142,6 @@ int rc_matrix_transpose_inplace(rc_matrix_t* A)
 }
 
 
-int rc_matrix_times_col_vec(rc_matrix_t A, rc_vector_t v, rc_vector_t* c)
-{
-    int i;
-    // sanity checks
-    if(unlikely(A.initialized!=1 || v.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_times_col_vec, matrix or vector uninitialized\n");
-        return -1;
-    }
-    if(unlikely(A.cols!=v.len)){
-        fprintf(stderr,"ERROR in rc_matrix_times_col_vec, dimension mismatch\n");
-        return -1;
-    }
-    if(unlikely(rc_vector_alloc(c,A.rows))){
-        fprintf(stderr,"ERROR in rc_matrix_times_col_vec, failed to allocate c\n");
-        return -1;
-    }
-    // run the sum
-    for(i=0;i<A.rows;i++) c->d[i]=__vectorized_mult_accumulate(A.d[i],v.d,v.len);
-    return 0;
-}
-
-
 int rc_matrix_times_col_vec_inplace(rc_matrix_t A, rc_vector_t* v)
 {
     // sanity checks
@@ -535,42 +166,6 @@ int rc_matrix_times_col_vec_inplace(rc_matrix_t A, rc_vector_t* v)
 }
 
 
-int rc_matrix_row_vec_times_matrix(rc_vector_t v, rc_matrix_t A, rc_vector_t* c)
-{
-    int i,j;
-
-    // sanity checks
-    if(unlikely(A.initialized!=1 || v.initialized!=1)){
-        fprintf(stderr,"ERROR in rc_matrix_row_vec_times_matrix, matrix or vector uninitialized\n");
-        return -1;
-    }
-    if(unlikely(A.rows!=v.len)){
-        fprintf(stderr,"ERROR in rc_matrix_row_vec_times_matrix, dimension mismatch\n");
-        return -1;
-    }
-    // allocate memory for a column of A from the stack, this is faster than
-    // malloc and the memory is freed automatically when this function returns
-    // it is faster to put a column of A in contiguous memory then multiply
-    double tmp[A.rows];
-    if(unlikely(tmp==NULL)){
-        fprintf(stderr,"ERROR in rc_matrix_row_vec_times_matrix, alloca failed, stack overflow\n");
-        return -1;
-    }
-    // make sure c is allocated correctly
-    if(unlikely(rc_vector_alloc(c,A.cols))){
-        fprintf(stderr,"ERROR in rc_matrix_row_vec_times_matrix, failed to allocate c\n");
-        return -1;
-    }
-    // go through columns of A calculating c left to right
-    for(i=0;i<A.cols;i++){
-        // put column of A in sequential memory slot
-        for(j=0;j<A.rows;j++) tmp[j]=A.d[j][i];
-        // calculate each entry in c
-        c->d[i]=__vectorized_mult_accumulate(v.d,tmp,v.len);
-    }
-    return 0;
-}
-
 int rc_matrix_outer_product(rc_vector_t v1, rc_vector_t v2, rc_matrix_t* A)
 {
     int i, j;
@@ -592,9 +187,36 @@ int rc_matrix_outer_product(rc_vector_t v1, rc_vector_t v2, rc_matrix_t* A)
 
 double rc_matrix_determinant(rc_matrix_t A)
 {
-    int i,j,k;
-    double ratio, det;
-    rc_matrix_t tmp = RC_MATRIX_INITIALIZER;
+    double det;
+    rc_workspace_t ws = RC_WORKSPACE_INITIALIZER;
+    // sanity checks
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_determinant, received uninitialized matrix\n");
+        return -1.0;
+    }
+    if(unlikely(A.rows!=A.cols)){
+        fprintf(stderr,"ERROR in rc_matrix_determinant, expected square matrix\n");
+        return -1.0;
+    }
+    // shortcuts for 1x1 and 2x2 don't need any memory
+    if(A.rows<=2) return rc_matrix_determinant_ws(A,NULL);
+    if(unlikely(rc_workspace_alloc(&ws, WS_MATRIX_BYTES(A.rows,A.cols)+__ws_round(A.rows*sizeof(int))))){
+        fprintf(stderr,"ERROR in rc_matrix_determinant, failed to allocate workspace\n");
+        return -1.0;
+    }
+    det = rc_matrix_determinant_ws(A,&ws);
+    rc_workspace_free(&ws);
+    return det;
+}
+
+
+double rc_matrix_determinant_ws(rc_matrix_t A, rc_workspace_t* ws)
+{
+    int i,sign;
+    int* ipiv;
+    size_t mark;
+    double det;
+    rc_matrix_t tmp;
     // sanity checks
     if(unlikely(A.initialized!=1)){
         fprintf(stderr,"ERROR in rc_matrix_determinant, received uninitialized matrix\n");
@@ -608,22 +230,30 @@ double rc_matrix_determinant(rc_matrix_t A)
     if(A.rows==1) return A.d[0][0];
     // shortcut for 2x2 matrix
     if(A.rows==2) return A.d[0][0]*A.d[1][1] - A.d[0][1]*A.d[1][0];
-    // allocate a duplicate to shuffle around
-    if(unlikely(rc_matrix_duplicate(A,&tmp))){
+    if(unlikely(ws==NULL)){
+        fprintf(stderr,"ERROR in rc_matrix_determinant, received NULL workspace\n");
+        return -1.0;
+    }
+    // take a duplicate to factor in place and the pivots from the workspace
+    mark = ws->used;
+    ipiv = __ws_push(ws, A.rows*sizeof(int));
+    if(unlikely(ipiv==NULL || __ws_matrix(ws,&tmp,A.rows,A.cols))){
         fprintf(stderr,"ERROR in rc_matrix_determinant, failed to allocate duplicate\n");
+        ws->used = mark;
         return -1.0;
     }
-    for(i=0;i<(A.rows-1);i++){
-        for(j=i+1;j<A.rows;j++){
-            ratio = tmp.d[j][i]/tmp.d[i][i];
-            for(k=0;k<A.rows;k++) tmp.d[j][k] -= ratio*tmp.d[i][k];
-        }
+    for(i=0;i<A.rows;i++) memcpy(tmp.d[i],A.d[i],A.cols*sizeof(double));
+    // pivoting keeps this stable where plain elimination divides by zero
+    if(unlikely(__lu_inplace(tmp.d[0], A.rows, tmp.stride, ipiv, &sign))){
+        fprintf(stderr,"ERROR in rc_matrix_determinant, failed to LU decomp\n");
+        ws->used = mark;
+        return -1.0;
     }
     // multiply along the main diagonal
-    det = 1.0;
+    det = (double)sign;
     for(i=0;i<A.rows;i++) det *= tmp.d[i][i];
-    // free memory and return
-    rc_matrix_free(&tmp);
+    // give the memory back and return
+    ws->used = mark;
     return det;
 }
 
@@ -654,4 +284,81 @@ int rc_matrix_symmetrize(rc_matrix_t* P)
         }
     }
     return 0;
-}
\ No newline at end of file
+}
+
+
+// out = A*P*A^T (+ symmetric part of Q if Q is not NULL). T=A*P is formed
+// first, then only the upper triangle of T*A^T is computed, reading A
+// transposed in place, and mirrored down.
+static int __sandwich(rc_matrix_t A, rc_matrix_t P, rc_matrix_t* Q, rc_matrix_t* out, const char* name)
+{
+    int i,j;
+    if(unlikely(A.initialized!=1 || P.initialized!=1 || (Q!=NULL && Q->initialized!=1))){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", name);
+        return -1;
+    }
+    if(unlikely(P.rows!=P.cols || A.cols!=P.rows)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", name);
+        return -1;
+    }
+    if(unlikely(Q!=NULL && (Q->rows!=A.rows || Q->cols!=A.rows))){
+        fprintf(stderr,"ERROR in %s, Q must be square with as many rows as A\n", name);
+        return -1;
+    }
+    // out is written before Q is read, so Q can't be out either
+    if(unlikely(out->initialized==1 && (out->d==A.d || out->d==P.d ||
+                                        (Q!=NULL && out->d==Q->d)))){
+        fprintf(stderr,"ERROR in %s, out must not be A, P, or Q\n", name);
+        return -1;
+    }
+
+    int m = A.rows;
+    int n = A.cols;
+    double* T = (double*)malloc((size_t)m*n*sizeof(double));
+    if(unlikely(T==NULL)){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for A*P\n", name);
+        return -1;
+    }
+
+    // T = A*P
+    if(unlikely(__gemm(0, 0, m, n, n, 1.0, A.d[0], A.stride, P.d[0], P.stride, 0.0, T, n))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", name);
+        free(T);
+        return -1;
+    }
+    if(unlikely(rc_matrix_alloc(out,m,m))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for out\n", name);
+        free(T);
+        return -1;
+    }
+    // upper triangle of T*A^T
+    if(unlikely(__gemm_upper(0, 1, m, n, 1.0, T, n, A.d[0], A.stride, 0.0, out->d[0], out->stride))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", name);
+        free(T);
+        return -1;
+    }
+    free(T);
+    // mirror the upper triangle down, adding Q along the way
+    for(i=0;i<m;i++){
+        if(Q!=NULL) out->d[i][i] += Q->d[i][i];
+        for(j=i+1;j<m;j++){
+            double val = out->d[i][j];
+            if(Q!=NULL) val += (Q->d[i][j]+Q->d[j][i])/2.0;
+            out->d[i][j] = val;
+            out->d[j][i] = val;
+        }
+    }
+    return 0;
+}
+
+
+int rc_matrix_sandwich(rc_matrix_t A, rc_matrix_t P, rc_matrix_t* out)
+{
+    return __sandwich(A, P, NULL, out, "rc_matrix_sandwich");
+}
+
+
+int rc_matrix_sandwich_add(rc_matrix_t A, rc_matrix_t P, rc_matrix_t Q, rc_matrix_t* out)
+{
+    return __sandwich(A, P, &Q, out, "rc_matrix_sandwich_add");
+}
@@ -0,0 +1,603 @@
+/**
+ * @file       matrix_template.h
+ *
+ * @brief      Matrix functions shared by the double and float APIs, see
+ *             precision.h. Included by matrix.c and single_precision.c.
+ */
+
+MAT MATRIX_FN(empty)(void)
+{
+    MAT out = MAT_INIT;
+    return out;
+}
+
+
+// One allocation holds the row pointers followed by the data, which starts on
+// the next RC_MATRIX_ALIGN boundary. Padding at the end of each row is zeroed
+// so whole-buffer operations over rows*stride never touch garbage.
+static int __alloc(MAT* A, int rows, int cols, int stride, const char* name)
+{
+    int i;
+    size_t head, bytes;
+    void* ptr;
+    // sanity checks
+    if(unlikely(rows<1 || cols<1)){
+        fprintf(stderr,"ERROR in %s, rows and cols must be >=1\n", name);
+        return -1;
+    }
+    if(unlikely(A==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", name);
+        return -1;
+    }
+    // free any old memory
+    MATRIX_FN(free)(A);
+    head = (((size_t)rows*sizeof(REAL*))+RC_MATRIX_ALIGN-1) & ~(size_t)(RC_MATRIX_ALIGN-1);
+    bytes = head + ((size_t)rows*stride*sizeof(REAL));
+    if(unlikely(posix_memalign(&ptr, RC_MATRIX_ALIGN, bytes))){
+        fprintf(stderr,"ERROR in %s, not enough memory\n", name);
+        fprintf(stderr, "tried allocating a %dx%d matrix\n", rows,cols);
+        return -1;
+    }
+    A->d = (REAL**)ptr;
+    // manually fill in the pointer to each row
+    for(i=0;i<rows;i++){
+        A->d[i] = (REAL*)((char*)ptr + head) + ((size_t)i*stride);
+        if(stride>cols) memset(&A->d[i][cols], 0, (stride-cols)*sizeof(REAL));
+    }
+    A->rows = rows;
+    A->cols = cols;
+    A->stride = stride;
+    A->initialized = 1;
+    return 0;
+}
+
+
+int MATRIX_FN(alloc)(MAT* A, int rows, int cols)
+{
+    // if A is already allocated and of the right size, nothing to do!
+    if(A!=NULL && A->initialized==1 && rows==A->rows && cols==A->cols) return 0;
+    return __alloc(A, rows, cols, cols, __func__);
+}
+
+
+int MATRIX_FN(alloc_padded)(MAT* A, int rows, int cols)
+{
+    // round each row up to a whole number of cache lines
+    const int per_line = RC_MATRIX_ALIGN/sizeof(REAL);
+    int stride = ((cols+per_line-1)/per_line)*per_line;
+    if(A!=NULL && A->initialized==1 && rows==A->rows && cols==A->cols &&
+                                            stride==A->stride) return 0;
+    return __alloc(A, rows, cols, stride, __func__);
+}
+
+
+int MATRIX_FN(free)(MAT* A)
+{
+    MAT new = MAT_INIT;
+    if(unlikely(A==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    // row pointers and data are a single allocation
+    if(A->initialized==1) free(A->d);
+    // zero out the struct
+    *A = new;
+    return 0;
+}
+
+
+int MATRIX_FN(zeros)(MAT* A, int rows, int cols)
+{
+    if(unlikely(MATRIX_FN(alloc)(A,rows,cols))){
+        fprintf(stderr,"ERROR in %s, failed to allocate matrix\n", __func__);
+        return -1;
+    }
+    // data and padding are one block starting at d[0]
+    memset(A->d[0], 0, (size_t)A->rows*A->stride*sizeof(REAL));
+    return 0;
+}
+
+
+int MATRIX_FN(identity)(MAT* A, int dim)
+{
+    int i;
+    if(unlikely(MATRIX_FN(zeros)(A,dim,dim))){
+        fprintf(stderr,"ERROR in %s, failed to allocate matrix\n", __func__);
+        return -1;
+    }
+    // fill in diagonal of ones
+    for(i=0;i<dim;i++) A->d[i][i]=RL(1.0);
+    return 0;
+}
+
+
+int MATRIX_FN(duplicate)(MAT A, MAT* B)
+{
+    int i;
+    // sanity check
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in %s not initialized yet\n", __func__);
+        return -1;
+    }
+    // make sure there is enough space in B
+    if(unlikely(MATRIX_FN(alloc)(B,A.rows,A.cols))){
+        fprintf(stderr,"ERROR in %s, failed to allocate memory\n", __func__);
+        return -1;
+    }
+    // one memcpy is sufficient when both have the same layout
+    if(B->d[0]==A.d[0]) return 0;
+    if(A.stride==B->stride){
+        memcpy(B->d[0],A.d[0],(size_t)A.rows*A.stride*sizeof(REAL));
+        return 0;
+    }
+    for(i=0;i<A.rows;i++) memcpy(B->d[i],A.d[i],A.cols*sizeof(REAL));
+    return 0;
+}
+
+
+int MATRIX_FN(print)(MAT A)
+{
+    int i,j;
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized yet\n", __func__);
+        return -1;
+    }
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++){
+            printf("%7.4f  ",(double)A.d[i][j]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(print_sci)(MAT A)
+{
+    int i,j;
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized yet\n", __func__);
+        return -1;
+    }
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++){
+            printf("%11.4e  ",(double)A.d[i][j]);
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(zero_out)(MAT* A)
+{
+    int i,j;
+    if(unlikely(A->initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized yet\n", __func__);
+        return -1;
+    }
+    for(i=0;i<A->rows;i++){
+        for(j=0;j<A->cols;j++){
+            A->d[i][j]=RL(0.0);
+        }
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(times_scalar)(MAT* A, REAL s)
+{
+    if(unlikely(A->initialized!=1)){
+        fprintf(stderr,"ERROR in %s. matrix uninitialized\n", __func__);
+        return -1;
+    }
+    // scale rows and any zero padding between them in one sweep
+    PREC(__vectorized_scale)(s, A->d[0], A->rows*A->stride);
+    return 0;
+}
+
+
+int MATRIX_FN(multiply)(MAT A, MAT B, MAT* C)
+{
+    if(unlikely(A.initialized!=1 || B.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A.cols!=B.rows)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    // if C is not initialized, allocate memory for it
+    if(unlikely(MATRIX_FN(alloc)(C,A.rows,B.cols))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for C\n", __func__);
+        return -1;
+    }
+    // blocked multiply straight into C, see gemm.c
+    if(unlikely(PREC(__gemm)(0, 0, A.rows, B.cols, A.cols, RL(1.0), A.d[0], A.stride,
+                                B.d[0], B.stride, RL(0.0), C->d[0], C->stride))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(multiply_trans)(MAT A, int ta, MAT B, int tb, MAT* C)
+{
+    int m,n,k;
+    if(unlikely(A.initialized!=1 || B.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", __func__);
+        return -1;
+    }
+    // dimensions of op(A) and op(B)
+    m = ta ? A.cols : A.rows;
+    k = ta ? A.rows : A.cols;
+    n = tb ? B.rows : B.cols;
+    if(unlikely(k!=(tb ? B.cols : B.rows))){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    // gemm reads A and B in place so C can't share memory with either
+    if(unlikely(C->d==A.d || C->d==B.d)){
+        fprintf(stderr,"ERROR in %s, C must not be A or B\n", __func__);
+        return -1;
+    }
+    if(unlikely(MATRIX_FN(alloc)(C,m,n))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for C\n", __func__);
+        return -1;
+    }
+    // the packing step of gemm picks rows or columns as needed so neither
+    // operand is ever transposed in memory
+    if(unlikely(PREC(__gemm)(ta, tb, m, n, k, RL(1.0), A.d[0], A.stride,
+                                B.d[0], B.stride, RL(0.0), C->d[0], C->stride))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(left_multiply_inplace)(MAT A, MAT* B)
+{
+    int i;
+    // Sanity Checks
+    if(unlikely(A.initialized!=1 || B->initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A.cols!=B->rows)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+
+    // keep a copy of the original B on the stack since B gets overwritten
+    int rows = B->rows;
+    int cols = B->cols;
+    REAL tmp[rows*cols];
+    for(i=0;i<rows;i++) memcpy(&tmp[i*cols], B->d[i], cols*sizeof(REAL));
+
+    // reallocate B if it needs changing size
+    if(unlikely(MATRIX_FN(alloc)(B,A.rows,cols))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for B\n", __func__);
+        return -1;
+    }
+    if(unlikely(PREC(__gemm)(0, 0, A.rows, cols, rows, RL(1.0), A.d[0], A.stride,
+                                    tmp, cols, RL(0.0), B->d[0], B->stride))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(right_multiply_inplace)(MAT* A, MAT B)
+{
+    int i;
+    // Sanity Checks
+    if(unlikely(A->initialized!=1 || B.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A->cols!=B.rows)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+
+    // keep a copy of the original A on the stack since A gets overwritten
+    int rows = A->rows;
+    int cols = A->cols;
+    REAL tmpA[rows*cols];
+    for(i=0;i<rows;i++) memcpy(&tmpA[i*cols], A->d[i], cols*sizeof(REAL));
+
+    // resize A if necessary
+    if(unlikely(MATRIX_FN(alloc)(A,rows,B.cols))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for A\n", __func__);
+        return -1;
+    }
+    if(unlikely(PREC(__gemm)(0, 0, rows, B.cols, cols, RL(1.0), tmpA, cols,
+                                B.d[0], B.stride, RL(0.0), A->d[0], A->stride))){
+        fprintf(stderr,"ERROR in %s, gemm failed\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(add)(MAT A, MAT B, MAT* C)
+{
+    int i,j;
+    if(unlikely(A.initialized!=1 || B.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A.rows!=B.rows || A.cols!=B.cols)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    // make sure C is allocated
+    if(unlikely(MATRIX_FN(alloc)(C,A.rows,A.cols))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for C\n", __func__);
+        return -1;
+    }
+    if(A.stride==B.stride && A.stride==C->stride){
+        for(i=0;i<(A.rows*A.stride);i++) C->d[0][i]=A.d[0][i]+B.d[0][i];
+        return 0;
+    }
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) C->d[i][j]=A.d[i][j]+B.d[i][j];
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(add_inplace)(MAT* A, MAT B)
+{
+    int i,j;
+    if(unlikely(A->initialized!=1 || B.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A->rows!=B.rows || A->cols!=B.cols)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    if(A->stride==B.stride){
+        for(i=0;i<(A->rows*A->stride);i++) A->d[0][i]+=B.d[0][i];
+        return 0;
+    }
+    for(i=0;i<A->rows;i++){
+        for(j=0;j<A->cols;j++) A->d[i][j]+=B.d[i][j];
+    }
+    return 0;
+}
+
+int MATRIX_FN(subtract_inplace)(MAT* A, MAT B)
+{
+    int i,j;
+    if(unlikely(A->initialized!=1 || B.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A->rows!=B.rows || A->cols!=B.cols)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    if(A->stride==B.stride){
+        for(i=0;i<(A->rows*A->stride);i++) A->d[0][i]-=B.d[0][i];
+        return 0;
+    }
+    for(i=0;i<A->rows;i++){
+        for(j=0;j<A->cols;j++) A->d[i][j]-=B.d[i][j];
+    }
+    return 0;
+}
+
+
+int MATRIX_FN(transpose)(MAT A, MAT* T)
+{
+    int i,j;
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, received uninitialized matrix\n", __func__);
+        return -1;
+    }
+    // make sure T is allocated
+    if(unlikely(MATRIX_FN(alloc)(T,A.cols,A.rows))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for T\n", __func__);
+        return -1;
+    }
+    // fill in new memory
+    for(i=0;i<(A.rows);i++){
+        for(j=0;j<(A.cols);j++){
+            T->d[j][i] = A.d[i][j];
+        }
+    }
+    return 0;
+}
+
+
+// rows of a large mat-vec are split across the thread pool
+typedef struct __matvec_job_t{
+    REAL** a;
+    REAL* v;
+    REAL* c;
+    int rows, cols, chunk;
+} __matvec_job_t;
+
+
+static void __matvec_task(void* arg, int task)
+{
+    __matvec_job_t* j = (__matvec_job_t*)arg;
+    int i;
+    int end = (task+1)*j->chunk;
+    if(end>j->rows) end = j->rows;
+    for(i=task*j->chunk;i<end;i++) j->c[i]=PREC(__vectorized_mult_accumulate)(j->a[i],j->v,j->cols);
+    return;
+}
+
+
+int MATRIX_FN(times_col_vec)(MAT A, VEC v, VEC* c)
+{
+    int i;
+    // sanity checks
+    if(unlikely(A.initialized!=1 || v.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix or vector uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A.cols!=v.len)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    if(unlikely(VECTOR_FN(alloc)(c,A.rows))){
+        fprintf(stderr,"ERROR in %s, failed to allocate c\n", __func__);
+        return -1;
+    }
+    int threads = __pool_threads();
+    if(threads>1 && (long)A.rows*A.cols >= POOL_MATVEC_ELEMS){
+        __matvec_job_t job = {.a=A.d, .v=v.d, .c=c->d, .rows=A.rows, .cols=A.cols,
+                                .chunk=(A.rows+threads-1)/threads};
+        __pool_run(__matvec_task, &job, threads);
+        return 0;
+    }
+    // run the sum
+    for(i=0;i<A.rows;i++) c->d[i]=PREC(__vectorized_mult_accumulate)(A.d[i],v.d,v.len);
+    return 0;
+}
+
+
+// rows of a large multi-vector mat-vec are split across the thread pool
+typedef struct __matvecs_job_t{
+    REAL** a;
+    VEC* v;
+    VEC* c;
+    int rows, cols, k, chunk;
+} __matvecs_job_t;
+
+
+// each row of A is pulled into cache once and dotted with all k vectors
+static void __matvecs_rows(__matvecs_job_t* j, int start, int end)
+{
+    int i,n;
+    for(i=start;i<end;i++){
+        for(n=0;n<j->k;n++) j->c[n].d[i]=PREC(__vectorized_mult_accumulate)(j->a[i],j->v[n].d,j->cols);
+    }
+    return;
+}
+
+
+static void __matvecs_task(void* arg, int task)
+{
+    __matvecs_job_t* j = (__matvecs_job_t*)arg;
+    int end = (task+1)*j->chunk;
+    if(end>j->rows) end = j->rows;
+    __matvecs_rows(j, task*j->chunk, end);
+    return;
+}
+
+
+int MATRIX_FN(times_col_vecs)(MAT A, VEC* v, VEC* c, int k)
+{
+    int i,n;
+    // sanity checks
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(v==NULL || c==NULL || k<1)){
+        fprintf(stderr,"ERROR in %s, need at least one vector\n", __func__);
+        return -1;
+    }
+    for(n=0;n<k;n++){
+        if(unlikely(v[n].initialized!=1)){
+            fprintf(stderr,"ERROR in %s, vector %d uninitialized\n", __func__, n);
+            return -1;
+        }
+        if(unlikely(A.cols!=v[n].len)){
+            fprintf(stderr,"ERROR in %s, dimension mismatch on vector %d\n", __func__, n);
+            return -1;
+        }
+    }
+    // outputs are written while inputs are still being read
+    for(n=0;n<k;n++){
+        for(i=0;i<k;i++){
+            if(unlikely(c[n].initialized && c[n].d==v[i].d)){
+                fprintf(stderr,"ERROR in %s, outputs must not be inputs\n", __func__);
+                return -1;
+            }
+        }
+    }
+    for(n=0;n<k;n++){
+        if(unlikely(VECTOR_FN(alloc)(&c[n],A.rows))){
+            fprintf(stderr,"ERROR in %s, failed to allocate c\n", __func__);
+            return -1;
+        }
+    }
+    __matvecs_job_t job = {.a=A.d, .v=v, .c=c, .rows=A.rows, .cols=A.cols, .k=k};
+    int threads = __pool_threads();
+    if(threads>1 && (long)A.rows*A.cols*k >= POOL_MATVEC_ELEMS){
+        job.chunk = (A.rows+threads-1)/threads;
+        __pool_run(__matvecs_task, &job, threads);
+        return 0;
+    }
+    __matvecs_rows(&job, 0, A.rows);
+    return 0;
+}
+
+
+int MATRIX_FN(times_col_vec_trans)(MAT A, int ta, VEC v, VEC* c)
+{
+    int i;
+    if(!ta) return MATRIX_FN(times_col_vec)(A,v,c);
+    // sanity checks
+    if(unlikely(A.initialized!=1 || v.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix or vector uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A.rows!=v.len)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    if(unlikely(c->d==v.d)){
+        fprintf(stderr,"ERROR in %s, c must not be v\n", __func__);
+        return -1;
+    }
+    if(unlikely(VECTOR_FN(alloc)(c,A.cols))){
+        fprintf(stderr,"ERROR in %s, failed to allocate c\n", __func__);
+        return -1;
+    }
+    // A^T*v is a sum of the rows of A scaled by v, which walks A in its
+    // stored row order instead of striding down columns
+    memset(c->d, 0, A.cols*sizeof(REAL));
+    for(i=0;i<A.rows;i++) PREC(__vectorized_axpy)(v.d[i], A.d[i], c->d, A.cols);
+    return 0;
+}
+
+
+int MATRIX_FN(row_vec_times_matrix)(VEC v, MAT A, VEC* c)
+{
+    int i,j;
+
+    // sanity checks
+    if(unlikely(A.initialized!=1 || v.initialized!=1)){
+        fprintf(stderr,"ERROR in %s, matrix or vector uninitialized\n", __func__);
+        return -1;
+    }
+    if(unlikely(A.rows!=v.len)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return -1;
+    }
+    // it is faster to put a column of A in contiguous memory then multiply
+    REAL tmp[A.rows];
+    // make sure c is allocated correctly
+    if(unlikely(VECTOR_FN(alloc)(c,A.cols))){
+        fprintf(stderr,"ERROR in %s, failed to allocate c\n", __func__);
+        return -1;
+    }
+    // go through columns of A calculating c left to right
+    for(i=0;i<A.cols;i++){
+        // put column of A in sequential memory slot
+        for(j=0;j<A.rows;j++) tmp[j]=A.d[j][i];
+        // calculate each entry in c
+        c->d[i]=PREC(__vectorized_mult_accumulate)(v.d,tmp,v.len);
+    }
+    return 0;
+}
@@ -0,0 +1,239 @@
+/**
+ * @file       matrix_view.c
+ *
+ * @brief      see matrix_view.h
+ */
+
+#include <stdio.h>
+
+#include <rc_math/matrix_view.h>
+#include "algebra_common.h"
+
+#define AT(V,i,j) RC_MATRIX_VIEW_AT(V,i,j)
+
+
+// returns 1 if the view points somewhere and has a sensible shape
+static int __view_ok(rc_matrix_view_t V)
+{
+    return V.d!=NULL && V.rows>0 && V.cols>0 && V.ld>0;
+}
+
+
+// number of elements in a row or column view, -1 if it's not vector shaped
+static int __vec_len(rc_matrix_view_t V)
+{
+    if(V.cols==1) return V.rows;
+    if(V.rows==1) return V.cols;
+    return -1;
+}
+
+
+// doubles between consecutive elements of a row or column view
+static int __vec_stride(rc_matrix_view_t V)
+{
+    if(V.cols==1) return V.trans ? 1 : V.ld;
+    return V.trans ? V.ld : 1;
+}
+
+
+rc_matrix_view_t rc_matrix_view(rc_matrix_t A)
+{
+    rc_matrix_view_t V = {NULL, 0, 0, 1, 0};
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_view, matrix uninitialized\n");
+        return V;
+    }
+    V.d = A.d[0];
+    V.rows = A.rows;
+    V.cols = A.cols;
+    V.ld = A.stride;
+    return V;
+}
+
+
+rc_matrix_view_t rc_matrix_view_of_vector(rc_vector_t v)
+{
+    rc_matrix_view_t V = {NULL, 0, 0, 1, 0};
+    if(unlikely(v.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_view_of_vector, vector uninitialized\n");
+        return V;
+    }
+    V.d = v.d;
+    V.rows = v.len;
+    V.cols = 1;
+    return V;
+}
+
+
+int rc_matrix_view_from_array(double* ptr, int rows, int cols, int ld, rc_matrix_view_t* V)
+{
+    if(unlikely(ptr==NULL || V==NULL)){
+        fprintf(stderr,"ERROR in rc_matrix_view_from_array, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(rows<1 || cols<1 || ld<cols)){
+        fprintf(stderr,"ERROR in rc_matrix_view_from_array, need rows,cols>=1 and ld>=cols\n");
+        return -1;
+    }
+    V->d = ptr;
+    V->rows = rows;
+    V->cols = cols;
+    V->ld = ld;
+    V->trans = 0;
+    return 0;
+}
+
+
+int rc_matrix_view_block(rc_matrix_view_t V, int row, int col, int rows, int cols, rc_matrix_view_t* out)
+{
+    if(unlikely(!__view_ok(V) || out==NULL)){
+        fprintf(stderr,"ERROR in rc_matrix_view_block, invalid view\n");
+        return -1;
+    }
+    if(unlikely(row<0 || col<0 || rows<1 || cols<1 || row+rows>V.rows || col+cols>V.cols)){
+        fprintf(stderr,"ERROR in rc_matrix_view_block, %dx%d block at (%d,%d) does not fit in %dx%d view\n",
+                                                rows, cols, row, col, V.rows, V.cols);
+        return -1;
+    }
+    *out = V;
+    out->d = &AT(V,row,col);
+    out->rows = rows;
+    out->cols = cols;
+    return 0;
+}
+
+
+int rc_matrix_view_rows(rc_matrix_view_t V, int row, int rows, rc_matrix_view_t* out)
+{
+    return rc_matrix_view_block(V, row, 0, rows, V.cols, out);
+}
+
+
+int rc_matrix_view_col(rc_matrix_view_t V, int col, rc_matrix_view_t* out)
+{
+    return rc_matrix_view_block(V, 0, col, V.rows, 1, out);
+}
+
+
+rc_matrix_view_t rc_matrix_view_transpose(rc_matrix_view_t V)
+{
+    rc_matrix_view_t T = V;
+    T.rows = V.cols;
+    T.cols = V.rows;
+    T.trans = !V.trans;
+    return T;
+}
+
+
+int rc_matrix_view_copy(rc_matrix_view_t src, rc_matrix_view_t dst)
+{
+    int i,j;
+    if(unlikely(!__view_ok(src) || !__view_ok(dst))){
+        fprintf(stderr,"ERROR in rc_matrix_view_copy, invalid view\n");
+        return -1;
+    }
+    if(unlikely(src.rows!=dst.rows || src.cols!=dst.cols)){
+        fprintf(stderr,"ERROR in rc_matrix_view_copy, dimension mismatch\n");
+        return -1;
+    }
+    for(i=0;i<dst.rows;i++){
+        for(j=0;j<dst.cols;j++) AT(dst,i,j) = AT(src,i,j);
+    }
+    return 0;
+}
+
+
+int rc_matrix_view_multiply_accumulate(double alpha, rc_matrix_view_t A, rc_matrix_view_t B,
+                                        double beta, rc_matrix_view_t C)
+{
+    int ret;
+    if(unlikely(!__view_ok(A) || !__view_ok(B) || !__view_ok(C))){
+        fprintf(stderr,"ERROR in rc_matrix_view_multiply, invalid view\n");
+        return -1;
+    }
+    if(unlikely(A.cols!=B.rows || C.rows!=A.rows || C.cols!=B.cols)){
+        fprintf(stderr,"ERROR in rc_matrix_view_multiply, dimension mismatch\n");
+        return -1;
+    }
+    // a transposed C is filled in as C'=B'A'
+    if(C.trans){
+        ret = __gemm(!B.trans, !A.trans, C.cols, C.rows, A.cols, alpha,
+                        B.d, B.ld, A.d, A.ld, beta, C.d, C.ld);
+    }
+    else{
+        ret = __gemm(A.trans, B.trans, C.rows, C.cols, A.cols, alpha,
+                        A.d, A.ld, B.d, B.ld, beta, C.d, C.ld);
+    }
+    if(unlikely(ret)){
+        fprintf(stderr,"ERROR in rc_matrix_view_multiply, failed to allocate packing buffers\n");
+        return -1;
+    }
+    return 0;
+}
+
+
+int rc_matrix_view_multiply(rc_matrix_view_t A, rc_matrix_view_t B, rc_matrix_view_t C)
+{
+    return rc_matrix_view_multiply_accumulate(1.0, A, B, 0.0, C);
+}
+
+
+int rc_matrix_view_add(rc_matrix_view_t A, rc_matrix_view_t B, rc_matrix_view_t C)
+{
+    int i,j;
+    if(unlikely(!__view_ok(A) || !__view_ok(B) || !__view_ok(C))){
+        fprintf(stderr,"ERROR in rc_matrix_view_add, invalid view\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=B.rows || A.cols!=B.cols || C.rows!=A.rows || C.cols!=A.cols)){
+        fprintf(stderr,"ERROR in rc_matrix_view_add, dimension mismatch\n");
+        return -1;
+    }
+    for(i=0;i<C.rows;i++){
+        for(j=0;j<C.cols;j++) AT(C,i,j) = AT(A,i,j) + AT(B,i,j);
+    }
+    return 0;
+}
+
+
+int rc_matrix_view_times_col_vec(rc_matrix_view_t A, rc_matrix_view_t x, rc_matrix_view_t y)
+{
+    int i,j,xs,ys;
+    double sum;
+    if(unlikely(!__view_ok(A) || !__view_ok(x) || !__view_ok(y))){
+        fprintf(stderr,"ERROR in rc_matrix_view_times_col_vec, invalid view\n");
+        return -1;
+    }
+    if(unlikely(__vec_len(x)!=A.cols || __vec_len(y)!=A.rows)){
+        fprintf(stderr,"ERROR in rc_matrix_view_times_col_vec, dimension mismatch\n");
+        return -1;
+    }
+    xs = __vec_stride(x);
+    ys = __vec_stride(y);
+
+    if(!A.trans){
+        // rows of A are contiguous, dot each one with x
+        for(i=0;i<A.rows;i++){
+            double* row = &A.d[i*A.ld];
+            if(xs==1) sum = __vectorized_mult_accumulate(row, x.d, A.cols);
+            else{
+                sum = 0.0;
+                for(j=0;j<A.cols;j++) sum += row[j]*x.d[j*xs];
+            }
+            y.d[i*ys] = sum;
+        }
+        return 0;
+    }
+    // columns of A are contiguous, accumulate y as a sum of scaled columns
+    if(ys==1){
+        for(i=0;i<A.rows;i++) y.d[i] = 0.0;
+        for(j=0;j<A.cols;j++) __vectorized_axpy(x.d[j*xs], &A.d[j*A.ld], y.d, A.rows);
+        return 0;
+    }
+    for(i=0;i<A.rows;i++){
+        sum = 0.0;
+        for(j=0;j<A.cols;j++) sum += A.d[(j*A.ld)+i]*x.d[j*xs];
+        y.d[i*ys] = sum;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file       precision.h
+ *
+ * Type and name macros for the *_template.h sources which hold the code shared
+ * by the double and single precision APIs. Each template is included once by
+ * its own module (vector.c, matrix.c, ...) to build the double functions and
+ * once by single_precision.c, which defines RC_SINGLE_PRECISION first, to build
+ * the float functions. Both families therefore come from the same lines of
+ * code and cannot drift apart.
+ *
+ * Inside a template use REAL for the scalar type, the *_FN() macros for public
+ * names, PREC() for internal helpers with an f-suffixed float twin, the math
+ * wrappers below instead of sqrt/fabs/etc, and RL() around floating point
+ * literals so float code is not promoted to double.
+ */
+
+#ifndef RC_PRECISION_H
+#define RC_PRECISION_H
+
+#include <float.h>  // for FLT_MAX DBL_MAX
+#include <math.h>
+
+#ifdef RC_SINGLE_PRECISION
+
+#include <rc_math/single_precision.h>
+
+#define REAL            float
+#define REAL_MAX        FLT_MAX
+#define VEC             rc_vectorf_t
+#define VEC_INIT        RC_VECTORF_INITIALIZER
+#define MAT             rc_matrixf_t
+#define MAT_INIT        RC_MATRIXF_INITIALIZER
+#define RINGBUF         rc_ringbuff_t
+#define RINGBUF_INIT    RC_RINGBUFF_INITIALIZER
+#define FILTER          rc_filterf_t
+#define FILTER_INIT     RC_FILTERF_INITIALIZER
+
+#define VECTOR_FN(x)    rc_vectorf_##x
+#define MATRIX_FN(x)    rc_matrixf_##x
+#define ALGEBRA_FN(x)   rc_algebraf_##x
+#define QUAT_FN(x)      rc_quaternionf_##x
+#define RINGBUF_FN(x)   rc_ringbuff_##x
+#define FILTER_FN(x)    rc_filterf_##x
+#define PREC(x)         x##f
+
+#define SQRT(x)         sqrtf(x)
+#define FABS(x)         fabsf(x)
+#define POW(x,y)        powf(x,y)
+#define SIN(x)          sinf(x)
+#define COS(x)          cosf(x)
+#define ASIN(x)         asinf(x)
+#define ATAN2(y,x)      atan2f(y,x)
+
+#else
+
+#include <rc_math/vector.h>
+#include <rc_math/matrix.h>
+#include <rc_math/ring_buffer.h>
+#include <rc_math/filter.h>
+
+#define REAL            double
+#define REAL_MAX        DBL_MAX
+#define VEC             rc_vector_t
+#define VEC_INIT        RC_VECTOR_INITIALIZER
+#define MAT             rc_matrix_t
+#define MAT_INIT        RC_MATRIX_INITIALIZER
+#define RINGBUF         rc_ringbuf_t
+#define RINGBUF_INIT    RC_RINGBUF_INITIALIZER
+#define FILTER          rc_filter_t
+#define FILTER_INIT     RC_FILTER_INITIALIZER
+
+#define VECTOR_FN(x)    rc_vector_##x
+#define MATRIX_FN(x)    rc_matrix_##x
+#define ALGEBRA_FN(x)   rc_algebra_##x
+#define QUAT_FN(x)      rc_quaternion_##x
+#define RINGBUF_FN(x)   rc_ringbuf_##x
+#define FILTER_FN(x)    rc_filter_##x
+#define PREC(x)         x
+
+#define SQRT(x)         sqrt(x)
+#define FABS(x)         fabs(x)
+#define POW(x,y)        pow(x,y)
+#define SIN(x)          sin(x)
+#define COS(x)          cos(x)
+#define ASIN(x)         asin(x)
+#define ATAN2(y,x)      atan2(y,x)
+
+#endif // RC_SINGLE_PRECISION
+
+// floating point literal in the working precision
+#define RL(x)           ((REAL)(x))
+
+#endif // RC_PRECISION_H
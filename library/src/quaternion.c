@@ -14,6 +14,11 @@
 
 #include <rc_math/quaternion.h>
 #include "algebra_common.h"
+#include "precision.h"
+
+// array functions shared with the float API, see single_precision.c
+#include "quaternion_template.h"
+
 
 double rc_quaternion_norm(rc_vector_t q)
 {
@@ -25,19 +30,6 @@ double rc_quaternion_norm(rc_vector_t q)
 }
 
 
-double rc_quaternion_norm_array(double q[4])
-{
-    double sum = 0.0;
-    int i;
-    if(unlikely(q==NULL)){
-        fprintf(stderr, "ERROR in rc_quaternion_norm_array, received NULL pointer\n");
-        return -1.0;
-    }
-    for(i=0;i<4;i++) sum+=q[i]*q[i];
-    return sqrt(sum);
-}
-
-
 int rc_quaternion_normalize(rc_vector_t* q)
 {
     int i;
@@ -57,25 +49,6 @@ int rc_quaternion_normalize(rc_vector_t* q)
 }
 
 
-int rc_quaternion_normalize_array(double q[4])
-{
-    int i;
-    double len;
-    double sum=0.0;
-    for(i=0;i<4;i++) sum+=q[i]*q[i];
-    len = sqrtf(sum);
-
-    // can't check if length is below a constant value as q may be filled
-    // with extremely small but valid doubles
-    if(unlikely(fabs(len) < zero_tolerance)){
-        fprintf(stderr, "ERROR in quaternion has 0 length\n");
-        return -1;
-    }
-    for(i=0;i<4;i++) q[i]=q[i]/len;
-    return 0;
-}
-
-
 int rc_quaternion_to_tb(rc_vector_t q, rc_vector_t* tb)
 {
     if(unlikely(!q.initialized)){
@@ -95,24 +68,6 @@ int rc_quaternion_to_tb(rc_vector_t q, rc_vector_t* tb)
 }
 
 
-int rc_quaternion_to_tb_array(double q[4], double tb[3])
-{
-    if(unlikely(q==NULL||tb==NULL)){
-        fprintf(stderr,"ERROR: in rc_quaternion_to_tb_array, received NULL pointer\n");
-        return -1;
-    }
-    // these functions are done with double precision since they cannot be
-    // accelerated by the NEON unit and the VFP computes doubles at the same
-    // speed as single-precision doubles
-    tb[1] = asin(2.0*(q[0]*q[2] - q[1]*q[3]));
-    tb[0] = atan2(2.0*(q[2]*q[3] + q[0]*q[1]),
-        1.0 - 2.0*(q[1]*q[1] + q[2]*q[2]));
-    tb[2] = atan2(2.0*(q[1]*q[2] + q[0]*q[3]),
-        1.0 - 2.0*(q[2]*q[2] + q[3]*q[3]));
-    return 0;
-}
-
-
 int rc_quaternion_from_tb(rc_vector_t tb, rc_vector_t* q)
 {
     if(unlikely(!tb.initialized)){
@@ -132,32 +87,6 @@ int rc_quaternion_from_tb(rc_vector_t tb, rc_vector_t* q)
 }
 
 
-int rc_quaternion_from_tb_array(double tb[3], double q[4])
-{
-    if(unlikely(q==NULL||q==NULL)){
-        fprintf(stderr,"ERROR: in rc_quaternion_from_tb_array, received NULL pointer\n");
-        return -1;
-    }
-
-    double tbt[3];
-    tbt[0]=tb[0]/2.0;
-    tbt[1]=tb[1]/2.0;
-    tbt[2]=tb[2]/2.0;
-    double cosX2 = cos(tbt[0]);
-    double sinX2 = sin(tbt[0]);
-    double cosY2 = cos(tbt[1]);
-    double sinY2 = sin(tbt[1]);
-    double cosZ2 = cos(tbt[2]);
-    double sinZ2 = sin(tbt[2]);
-    q[0] = cosX2*cosY2*cosZ2 + sinX2*sinY2*sinZ2;
-    q[1] = sinX2*cosY2*cosZ2 - cosX2*sinY2*sinZ2;
-    q[2] = cosX2*sinY2*cosZ2 + sinX2*cosY2*sinZ2;
-    q[3] = cosX2*cosY2*sinZ2 - sinX2*sinY2*cosZ2;
-    rc_quaternion_normalize_array(q);
-    return 0;
-}
-
-
 int rc_quaternion_conjugate(rc_vector_t q, rc_vector_t* c)
 {
     // sanity checks
@@ -201,33 +130,6 @@ int rc_quaternion_conjugate_inplace(rc_vector_t* q)
 }
 
 
-int rc_quaternion_conjugate_array(double q[4], double c[4])
-{
-    if(unlikely(q==NULL||c==NULL)){
-        fprintf(stderr,"ERROR: in rc_quaternion_conjugate_array, received NULL pointer\n");
-        return -1;
-    }
-    c[0] =  q[0];
-    c[1] = -q[1];
-    c[2] = -q[2];
-    c[3] = -q[3];
-    return 0;
-}
-
-
-int rc_quaternion_conjugate_array_inplace(double q[4])
-{
-    if(unlikely(q==NULL)){
-        fprintf(stderr,"ERROR: in rc_quaternion_conjugate_array_inplace, received NULL pointer\n");
-        return -1;
-    }
-    q[1] = -q[1];
-    q[2] = -q[2];
-    q[3] = -q[3];
-    return 0;
-}
-
-
 int rc_quaternion_imaginary_part(rc_vector_t q, rc_vector_t* img)
 {
     int i;
@@ -269,61 +171,6 @@ int rc_quaternion_multiply(rc_vector_t a, rc_vector_t b, rc_vector_t* c)
 }
 
 
-int rc_quaternion_multiply_array(double a[4], double b[4], double c[4])
-{
-    if(unlikely(a==NULL||b==NULL||c==NULL)){
-        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __FUNCTION__);
-        return -1;
-    }
-
-    c[0] = (b[0] * a[0]) - (b[1] * a[1]) - (b[2] * a[2]) - (b[3] * a[3]);
-    c[1] = (b[0] * a[1]) + (b[1] * a[0]) + (b[2] * a[3]) - (b[3] * a[2]);
-    c[2] = (b[0] * a[2]) + (b[2] * a[0]) + (b[3] * a[1]) - (b[1] * a[3]);
-    c[3] = (b[0] * a[3]) + (b[3] * a[0]) + (b[1] * a[2]) - (b[2] * a[1]);
-
-    return 0;
-}
-
-
-int rc_quaternion_left_multiply_inplace_array(double a[4], double b[4])
-{
-    if(unlikely(a==NULL||b==NULL)){
-        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __FUNCTION__);
-        return -1;
-    }
-
-    double tmp[4];
-    tmp[0] = b[0];
-    tmp[1] = b[1];
-    tmp[2] = b[2];
-    tmp[3] = b[3];
-
-    b[0] = (tmp[0] * a[0]) - (tmp[1] * a[1]) - (tmp[2] * a[2]) - (tmp[3] * a[3]);
-    b[1] = (tmp[0] * a[1]) + (tmp[1] * a[0]) + (tmp[2] * a[3]) - (tmp[3] * a[2]);
-    b[2] = (tmp[0] * a[2]) + (tmp[2] * a[0]) + (tmp[3] * a[1]) - (tmp[1] * a[3]);
-    b[3] = (tmp[0] * a[3]) + (tmp[3] * a[0]) + (tmp[1] * a[2]) - (tmp[2] * a[1]);
-
-    return 0;
-}
-
-
-int rc_quaternion_right_multiply_inplace_array(double a[4], double b[4])
-{
-    if(unlikely(a==NULL||b==NULL)){
-        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __FUNCTION__);
-        return -1;
-    }
-
-    double tmp[4];
-    tmp[0] = a[0];
-    tmp[1] = a[1];
-    tmp[2] = a[2];
-    tmp[3] = a[3];
-
-    return rc_quaternion_multiply_array(tmp, b, a);
-}
-
-
 int rc_quaternion_rotate(rc_vector_t* p, rc_vector_t q)
 {
     rc_vector_t conj = RC_VECTOR_INITIALIZER;
@@ -360,26 +207,6 @@ int rc_quaternion_rotate(rc_vector_t* p, rc_vector_t q)
 }
 
 
-int rc_quaternion_rotate_array(double p[4], double q[4])
-{
-    double conj[4], tmp[4];
-    if(unlikely(p==NULL||q==NULL)){
-        fprintf(stderr,"ERROR: in rc_quaternion_rotate_array, received NULL pointer\n");
-        return -1;
-    }
-    // make a conjugate of q
-    conj[0]= q[0];
-    conj[1]=-q[1];
-    conj[2]=-q[2];
-    conj[3]=-q[3];
-    // multiply tmp=pq*
-    rc_quaternion_multiply_array(p,conj,tmp);
-    // multiply p'=q*tmp
-    rc_quaternion_multiply_array(q,tmp,p);
-    return 0;
-}
-
-
 int rc_quaternion_rotate_vector(rc_vector_t* v, rc_vector_t q)
 {
     rc_vector_t vq = RC_VECTOR_INITIALIZER;
@@ -417,32 +244,9 @@ int rc_quaternion_rotate_vector(rc_vector_t* v, rc_vector_t q)
 }
 
 
-int rc_quaternion_rotate_vector_array(double v[3], double q[4])
-{
-    double vq[4];
-    if(unlikely(v==NULL||q==NULL)){
-        fprintf(stderr,"ERROR: in rc_quaternion_rotate_vector_array, received NULL pointer\n");
-        return -1;
-    }
-    // duplicate v into a quaternion with 0 real part
-    vq[0]=0.0;
-    vq[1]=v[0];
-    vq[2]=v[1];
-    vq[3]=v[2];
-    // rotate quaternion vector
-    rc_quaternion_rotate_array(vq, q);
-    // populate v with result
-    v[0]=vq[1];
-    v[1]=vq[2];
-    v[2]=vq[3];
-    return 0;
-}
-
-
-
 int rc_quaternion_to_rotation_matrix(rc_vector_t q, rc_matrix_t* R)
 {
-    double s,xs,ys,zs,wx,wy,wz,xx,xy,xz,yy,yz,zz;
+    rc_mat3_t tmp;
 
     // sanity checks
     if(unlikely(!q.initialized)){
@@ -453,24 +257,37 @@ int rc_quaternion_to_rotation_matrix(rc_vector_t q, rc_matrix_t* R)
         fprintf(stderr, "ERROR in rc_quaternion_to_rotation_matrix, expected vector of length 4\n");
         return -1;
     }
-    if(unlikely(rc_matrix_alloc(R,3,3))){
+    rc_quaternion_to_rotation_mat3(q.d, &tmp);
+    if(unlikely(rc_mat3_to_matrix(tmp, R))){
         fprintf(stderr, "ERROR in rc_quaternion_to_rotation_matrix, failed to alloc matrix\n");
         return -1;
     }
+    return 0;
+}
+
+
+int rc_quaternion_to_rotation_mat3(double q[4], rc_mat3_t* R)
+{
+    double s,xs,ys,zs,wx,wy,wz,xx,xy,xz,yy,yz,zz;
+
+    if(unlikely(q==NULL||R==NULL)){
+        fprintf(stderr,"ERROR: in rc_quaternion_to_rotation_mat3, received NULL pointer\n");
+        return -1;
+    }
 
     // algorithm courtesy of "Advanced Animation and Rendering Techniques, theory
     // and practice" by Alan and Mark Watt.
-    s = 2.0/(q.d[0]*q.d[0] + q.d[1]*q.d[1] + q.d[2]*q.d[2] + q.d[3]*q.d[3]);
+    s = 2.0/(q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3]);
 
     // compute intermediate variables which will be used multiple times
-    xs=q.d[1]*s; ys=q.d[2]*s; zs=q.d[3]*s;
-    wx=q.d[0]*xs; wy=q.d[0]*ys; wz=q.d[0]*zs;
-    xx=q.d[1]*xs; xy=q.d[1]*ys; xz=q.d[1]*zs;
-    yy=q.d[2]*ys; yz=q.d[2]*zs; zz=q.d[3]*zs;
+    xs=q[1]*s; ys=q[2]*s; zs=q[3]*s;
+    wx=q[0]*xs; wy=q[0]*ys; wz=q[0]*zs;
+    xx=q[1]*xs; xy=q[1]*ys; xz=q[1]*zs;
+    yy=q[2]*ys; yz=q[2]*zs; zz=q[3]*zs;
 
     R->d[0][0] = 1.0 - (yy + zz);
-    R->d[0][1] = xy + wz;;
-    R->d[0][2] = xz - wy;;
+    R->d[0][1] = xy + wz;
+    R->d[0][2] = xz - wy;
 
     R->d[1][0] = xy - wz;
     R->d[1][1] = 1.0 - (xx + zz);
@@ -484,11 +301,9 @@ int rc_quaternion_to_rotation_matrix(rc_vector_t q, rc_matrix_t* R)
 }
 
 
-
 int rc_rotation_to_quaternion(rc_matrix_t R, rc_vector_t* q)
 {
-    double t,s;
-    double trace = R.d[0][0] + R.d[1][1] + R.d[2][2];
+    rc_mat3_t tmp;
 
     // sanity checks
     if(unlikely(!R.initialized)){
@@ -503,15 +318,18 @@ int rc_rotation_to_quaternion(rc_matrix_t R, rc_vector_t* q)
         fprintf(stderr, "ERROR in rc_rotation_to_quaternion, failed to alloc vector q\n");
         return -1;
     }
+    rc_mat3_from_matrix(R, &tmp);
+    return rc_rotation_mat3_to_quaternion(tmp, q->d);
+}
 
-    // NEEDS CHECKING
-    if(trace > 0.0){
-        s = sqrt(trace + 1.0);
-        q->d[0] = 0.5 * s;
-        s = 0.5 / s;
-        q->d[1] = (R.d[1][2] - R.d[2][1]) * s;
-        q->d[2] = (R.d[2][0] - R.d[0][2]) * s;
-        q->d[3] = (R.d[0][1] - R.d[1][0]) * s;
+
+int rc_rotation_mat3_to_quaternion(rc_mat3_t R, double q[4])
+{
+    double t,s;
+
+    if(unlikely(q==NULL)){
+        fprintf(stderr,"ERROR: in rc_rotation_mat3_to_quaternion, received NULL pointer\n");
+        return -1;
     }
 
     // algorithm courtesy of Mike Day
@@ -520,33 +338,33 @@ int rc_rotation_to_quaternion(rc_matrix_t R, rc_vector_t* q)
         if(R.d[0][0] >R.d[1][1]){
             t= 1 + R.d[0][0] - R.d[1][1] - R.d[2][2];
             s = (0.5 / sqrt(t));
-            q->d[0] = (R.d[1][2] - R.d[2][1]) * s;
-            q->d[1] = t*s;
-            q->d[2] = (R.d[0][1] + R.d[1][0]) * s;
-            q->d[3] = (R.d[2][0] + R.d[0][2]) * s;
+            q[0] = (R.d[1][2] - R.d[2][1]) * s;
+            q[1] = t*s;
+            q[2] = (R.d[0][1] + R.d[1][0]) * s;
+            q[3] = (R.d[2][0] + R.d[0][2]) * s;
         }else{
             t= 1 - R.d[0][0] + R.d[1][1] - R.d[2][2];
             s = (0.5 / sqrt(t));
-            q->d[0] = (R.d[2][0] - R.d[0][2]) * s;
-            q->d[1] = (R.d[0][1] + R.d[1][0]) * s;
-            q->d[2] = t*s;
-            q->d[3] = (R.d[1][2] + R.d[2][1]) * s;
+            q[0] = (R.d[2][0] - R.d[0][2]) * s;
+            q[1] = (R.d[0][1] + R.d[1][0]) * s;
+            q[2] = t*s;
+            q[3] = (R.d[1][2] + R.d[2][1]) * s;
         }
     }else{
         if(R.d[0][0] < -R.d[1][1]){
             t= 1 - R.d[0][0] - R.d[1][1] + R.d[2][2];
             s = (0.5 / sqrt(t));
-            q->d[0] = (R.d[0][1] - R.d[1][0]) * s;
-            q->d[1] = (R.d[2][0] + R.d[0][2]) * s;
-            q->d[2] = (R.d[1][2] + R.d[2][1]) * s;
-            q->d[3] = t*s;
+            q[0] = (R.d[0][1] - R.d[1][0]) * s;
+            q[1] = (R.d[2][0] + R.d[0][2]) * s;
+            q[2] = (R.d[1][2] + R.d[2][1]) * s;
+            q[3] = t*s;
         }else{
             t= 1 + R.d[0][0] + R.d[1][1] + R.d[2][2];
             s = (0.5 / sqrt(t));
-            q->d[0] = t*s;
-            q->d[1] = (R.d[1][2] - R.d[2][1]) * s;
-            q->d[2] = (R.d[2][0] - R.d[0][2]) * s;
-            q->d[3] = (R.d[0][1] - R.d[1][0]) * s;
+            q[0] = t*s;
+            q[1] = (R.d[1][2] - R.d[2][1]) * s;
+            q[2] = (R.d[2][0] - R.d[0][2]) * s;
+            q[3] = (R.d[0][1] - R.d[1][0]) * s;
         }
     }
     return 0;
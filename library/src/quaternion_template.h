@@ -0,0 +1,204 @@
+/**
+ * @file       quaternion_template.h
+ *
+ * @brief      Quaternion array functions shared by the double and float APIs,
+ *             see precision.h. Included by quaternion.c and single_precision.c.
+ *
+ * Arrays are assumed to contain the quaternion components in the order [Wijk]
+ */
+
+REAL QUAT_FN(norm_array)(REAL q[4])
+{
+    REAL sum = RL(0.0);
+    int i;
+    if(unlikely(q==NULL)){
+        fprintf(stderr, "ERROR in %s, received NULL pointer\n", __func__);
+        return RL(-1.0);
+    }
+    for(i=0;i<4;i++) sum+=q[i]*q[i];
+    return SQRT(sum);
+}
+
+
+int QUAT_FN(normalize_array)(REAL q[4])
+{
+    int i;
+    REAL len;
+    REAL sum=RL(0.0);
+    for(i=0;i<4;i++) sum+=q[i]*q[i];
+    len = SQRT(sum);
+
+    // can't check if length is below a constant value as q may be filled
+    // with extremely small but valid doubles
+    if(unlikely(FABS(len) < (REAL)zero_tolerance)){
+        fprintf(stderr, "ERROR in quaternion has 0 length\n");
+        return -1;
+    }
+    for(i=0;i<4;i++) q[i]=q[i]/len;
+    return 0;
+}
+
+
+int QUAT_FN(to_tb_array)(REAL q[4], REAL tb[3])
+{
+    if(unlikely(q==NULL||tb==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    tb[1] = ASIN(RL(2.0)*(q[0]*q[2] - q[1]*q[3]));
+    tb[0] = ATAN2(RL(2.0)*(q[2]*q[3] + q[0]*q[1]),
+        RL(1.0) - RL(2.0)*(q[1]*q[1] + q[2]*q[2]));
+    tb[2] = ATAN2(RL(2.0)*(q[1]*q[2] + q[0]*q[3]),
+        RL(1.0) - RL(2.0)*(q[2]*q[2] + q[3]*q[3]));
+    return 0;
+}
+
+
+int QUAT_FN(from_tb_array)(REAL tb[3], REAL q[4])
+{
+    if(unlikely(q==NULL||q==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+
+    REAL tbt[3];
+    tbt[0]=tb[0]/RL(2.0);
+    tbt[1]=tb[1]/RL(2.0);
+    tbt[2]=tb[2]/RL(2.0);
+    REAL cosX2 = COS(tbt[0]);
+    REAL sinX2 = SIN(tbt[0]);
+    REAL cosY2 = COS(tbt[1]);
+    REAL sinY2 = SIN(tbt[1]);
+    REAL cosZ2 = COS(tbt[2]);
+    REAL sinZ2 = SIN(tbt[2]);
+    q[0] = cosX2*cosY2*cosZ2 + sinX2*sinY2*sinZ2;
+    q[1] = sinX2*cosY2*cosZ2 - cosX2*sinY2*sinZ2;
+    q[2] = cosX2*sinY2*cosZ2 + sinX2*cosY2*sinZ2;
+    q[3] = cosX2*cosY2*sinZ2 - sinX2*sinY2*cosZ2;
+    QUAT_FN(normalize_array)(q);
+    return 0;
+}
+
+
+int QUAT_FN(conjugate_array)(REAL q[4], REAL c[4])
+{
+    if(unlikely(q==NULL||c==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    c[0] =  q[0];
+    c[1] = -q[1];
+    c[2] = -q[2];
+    c[3] = -q[3];
+    return 0;
+}
+
+
+int QUAT_FN(conjugate_array_inplace)(REAL q[4])
+{
+    if(unlikely(q==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    q[1] = -q[1];
+    q[2] = -q[2];
+    q[3] = -q[3];
+    return 0;
+}
+
+
+int QUAT_FN(multiply_array)(REAL a[4], REAL b[4], REAL c[4])
+{
+    if(unlikely(a==NULL||b==NULL||c==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+
+    c[0] = (b[0] * a[0]) - (b[1] * a[1]) - (b[2] * a[2]) - (b[3] * a[3]);
+    c[1] = (b[0] * a[1]) + (b[1] * a[0]) + (b[2] * a[3]) - (b[3] * a[2]);
+    c[2] = (b[0] * a[2]) + (b[2] * a[0]) + (b[3] * a[1]) - (b[1] * a[3]);
+    c[3] = (b[0] * a[3]) + (b[3] * a[0]) + (b[1] * a[2]) - (b[2] * a[1]);
+
+    return 0;
+}
+
+
+int QUAT_FN(left_multiply_inplace_array)(REAL a[4], REAL b[4])
+{
+    if(unlikely(a==NULL||b==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+
+    REAL tmp[4];
+    tmp[0] = b[0];
+    tmp[1] = b[1];
+    tmp[2] = b[2];
+    tmp[3] = b[3];
+
+    b[0] = (tmp[0] * a[0]) - (tmp[1] * a[1]) - (tmp[2] * a[2]) - (tmp[3] * a[3]);
+    b[1] = (tmp[0] * a[1]) + (tmp[1] * a[0]) + (tmp[2] * a[3]) - (tmp[3] * a[2]);
+    b[2] = (tmp[0] * a[2]) + (tmp[2] * a[0]) + (tmp[3] * a[1]) - (tmp[1] * a[3]);
+    b[3] = (tmp[0] * a[3]) + (tmp[3] * a[0]) + (tmp[1] * a[2]) - (tmp[2] * a[1]);
+
+    return 0;
+}
+
+
+int QUAT_FN(right_multiply_inplace_array)(REAL a[4], REAL b[4])
+{
+    if(unlikely(a==NULL||b==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+
+    REAL tmp[4];
+    tmp[0] = a[0];
+    tmp[1] = a[1];
+    tmp[2] = a[2];
+    tmp[3] = a[3];
+
+    return QUAT_FN(multiply_array)(tmp, b, a);
+}
+
+
+int QUAT_FN(rotate_array)(REAL p[4], REAL q[4])
+{
+    REAL conj[4], tmp[4];
+    if(unlikely(p==NULL||q==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    // make a conjugate of q
+    conj[0]= q[0];
+    conj[1]=-q[1];
+    conj[2]=-q[2];
+    conj[3]=-q[3];
+    // multiply tmp=pq*
+    QUAT_FN(multiply_array)(p,conj,tmp);
+    // multiply p'=q*tmp
+    QUAT_FN(multiply_array)(q,tmp,p);
+    return 0;
+}
+
+
+int QUAT_FN(rotate_vector_array)(REAL v[3], REAL q[4])
+{
+    REAL vq[4];
+    if(unlikely(v==NULL||q==NULL)){
+        fprintf(stderr,"ERROR: in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    // duplicate v into a quaternion with 0 real part
+    vq[0]=RL(0.0);
+    vq[1]=v[0];
+    vq[2]=v[1];
+    vq[3]=v[2];
+    // rotate quaternion vector
+    QUAT_FN(rotate_array)(vq, q);
+    // populate v with result
+    v[0]=vq[1];
+    v[1]=vq[2];
+    v[2]=vq[3];
+    return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * @file       ring_buffer_template.h
+ *
+ * @brief      Ring buffer functions shared by the double and float APIs, see
+ *             precision.h. Included by ring_buffer.c and single_precision.c.
+ */
+
+RINGBUF RINGBUF_FN(empty)(void)
+{
+    RINGBUF out = RINGBUF_INIT;
+    return out;
+}
+
+
+int RINGBUF_FN(alloc)(RINGBUF* buf, int size)
+{
+    // sanity checks
+    if(unlikely(buf==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    if(unlikely(size<2)){
+        fprintf(stderr,"ERROR in %s, size must be >=2\n", __func__);
+        return -1;
+    }
+    // if it's already allocated, nothing to do
+    if(buf->initialized && buf->size==size && buf->d!=NULL) return 0;
+    // make sure it's zero'd out
+    buf->size = 0;
+    buf->index = 0;
+    buf->initialized = 0;
+    // free memory and allocate fresh
+    free(buf->d);
+    buf->d = (REAL*)calloc(size,sizeof(REAL));
+    if(buf->d==NULL){
+        fprintf(stderr,"ERROR in %s, failed to allocate memory\n", __func__);
+        return -1;
+    }
+    // write out other details
+    buf->size = size;
+    buf->initialized = 1;
+    return 0;
+}
+
+
+int RINGBUF_FN(free)(RINGBUF* buf)
+{
+    RINGBUF new = RINGBUF_INIT;
+    if(unlikely(buf==NULL)){
+        fprintf(stderr, "ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    if(buf->initialized) free(buf->d);
+    *buf = new;
+    return 0;
+}
+
+
+int RINGBUF_FN(reset)(RINGBUF* buf)
+{
+    // sanity checks
+    if(unlikely(buf==NULL)){
+        fprintf(stderr, "ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    if(unlikely(!buf->initialized)){
+        fprintf(stderr,"ERROR %s, ringbuf uninitialized\n", __func__);
+        return -1;
+    }
+    // wipe the data and index
+    memset(buf->d,0,buf->size*sizeof(REAL));
+    buf->index=0;
+    return 0;
+}
+
+
+int RINGBUF_FN(insert)(RINGBUF* buf, REAL val)
+{
+    int new_index;
+    // sanity checks
+    if(unlikely(buf==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    if(unlikely(!buf->initialized)){
+        fprintf(stderr,"ERROR in %s, ringbuf uninitialized\n", __func__);
+        return -1;
+    }
+    // increment index and check for loop-around
+    new_index=buf->index+1;
+    if(new_index>=buf->size) new_index=0;
+    // write out new value
+    buf->d[new_index]=val;
+    buf->index=new_index;
+    return 0;
+}
+
+
+REAL RINGBUF_FN(get_value)(RINGBUF* buf, int pos)
+{
+    int return_index;
+    // sanity checks
+    if(unlikely(buf==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", __func__);
+        return RL(-1.0);
+    }
+    if(unlikely(pos<0 || pos>buf->size-1)){
+        fprintf(stderr,"ERROR in %s, position out of bounds\n", __func__);
+        return RL(-1.0);
+    }
+    if(unlikely(!buf->initialized)){
+        fprintf(stderr,"ERROR in %s, ringbuf uninitialized\n", __func__);
+        return RL(-1.0);
+    }
+    // check for looparound
+    return_index=buf->index-pos;
+    if(return_index<0) return_index+=buf->size;
+    return buf->d[return_index];
+}
+
+
+REAL RINGBUF_FN(std_dev)(RINGBUF buf)
+{
+    int i;
+    REAL mean, mean_sqr, diff;
+    // sanity checks
+    if(unlikely(!buf.initialized)){
+        fprintf(stderr,"ERROR in %s, ringbuf not initialized yet\n", __func__);
+        return RL(-1.0);
+    }
+    // shortcut if buffer is of length 1
+    if(buf.size == 1) return RL(0.0);
+    // calculate mean
+    mean = RL(0.0);
+    for(i=0;i<buf.size;i++) mean+=buf.d[i];
+    mean = mean/(REAL)buf.size;
+    // calculate mean square
+    mean_sqr = RL(0.0);
+    for(i=0;i<buf.size;i++){
+        diff = buf.d[i]-mean;
+        mean_sqr += diff*diff;
+    }
+    return SQRT(mean_sqr/(REAL)(buf.size-1));
+}
@@ -0,0 +1,265 @@
+/**
+ * @file       rls.c
+ *
+ * @brief      see rls.h
+ *
+ * R is stored as an ordinary row-major matrix so every rotation runs along
+ * two contiguous rows: a new row is rotated into row k of R to zero its k'th
+ * element, for k=0..n. The last diagonal element collects the norm of the
+ * residual. Removing a row is the same sweep with hyperbolic rotations,
+ * which subtract the row instead of adding it.
+ */
+
+#include <stdio.h>
+#include <string.h> // for memset, memcpy
+#include <math.h>
+
+#include <rc_math/rls.h>
+#include "algebra_common.h"
+
+
+rc_rls_t rc_rls_empty(void)
+{
+    rc_rls_t out = RC_RLS_INITIALIZER;
+    return out;
+}
+
+
+int rc_rls_alloc(rc_rls_t* rls, int n, double lambda, int window)
+{
+    // sanity checks
+    if(unlikely(rls==NULL)){
+        fprintf(stderr,"ERROR in rc_rls_alloc, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(n<1)){
+        fprintf(stderr,"ERROR in rc_rls_alloc, n must be >=1\n");
+        return -1;
+    }
+    if(unlikely(!(lambda>0.0 && lambda<=1.0))){
+        fprintf(stderr,"ERROR in rc_rls_alloc, lambda must be in (0,1]\n");
+        return -1;
+    }
+    if(unlikely(window<0)){
+        fprintf(stderr,"ERROR in rc_rls_alloc, window must be >=0\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_alloc(&rls->R, n+1, n+1) ||
+                rc_vector_alloc(&rls->tmp, n+1) ||
+                (window>0 && rc_matrix_alloc(&rls->rows, window, n+1)))){
+        fprintf(stderr,"ERROR in rc_rls_alloc, failed to allocate memory\n");
+        rc_rls_free(rls);
+        return -1;
+    }
+    if(window==0) rc_matrix_free(&rls->rows);
+    rls->n = n;
+    rls->lambda = lambda;
+    rls->window = window;
+    rls->initialized = 1;
+    return rc_rls_reset(rls);
+}
+
+
+int rc_rls_free(rc_rls_t* rls)
+{
+    rc_rls_t new = RC_RLS_INITIALIZER;
+    if(unlikely(rls==NULL)){
+        fprintf(stderr,"ERROR in rc_rls_free, received NULL pointer\n");
+        return -1;
+    }
+    rc_matrix_free(&rls->R);
+    rc_matrix_free(&rls->rows);
+    rc_vector_free(&rls->tmp);
+    *rls = new;
+    return 0;
+}
+
+
+int rc_rls_reset(rc_rls_t* rls)
+{
+    int i;
+    if(unlikely(rls==NULL)){
+        fprintf(stderr,"ERROR in rc_rls_reset, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!rls->initialized)){
+        fprintf(stderr,"ERROR in rc_rls_reset, rls not initialized\n");
+        return -1;
+    }
+    for(i=0;i<rls->R.rows;i++) memset(rls->R.d[i], 0, rls->R.cols*sizeof(double));
+    rls->head = 0;
+    rls->count = 0;
+    rls->step = 0;
+    return 0;
+}
+
+
+/*
+ * Folds the row z into R with plane rotations. z is used as scratch. A zero
+ * diagonal element of R, as at the start, is simply replaced.
+ */
+static void __rls_update(rc_matrix_t R, double* z)
+{
+    int i,k,N;
+    double h,c,s,t;
+    N = R.rows;
+    for(k=0;k<N;k++){
+        if(z[k]==0.0) continue;
+        h = hypot(R.d[k][k], z[k]);
+        c = R.d[k][k]/h;
+        s = z[k]/h;
+        R.d[k][k] = h;
+        for(i=k+1;i<N;i++){
+            t = R.d[k][i];
+            R.d[k][i] = c*t + s*z[i];
+            z[i] = c*z[i] - s*t;
+        }
+    }
+    return;
+}
+
+
+/*
+ * Removes the row z from R with hyperbolic rotations, the same sweep as
+ * __rls_update run backwards. z is used as scratch. Returns -1, leaving R
+ * unusable, if a diagonal element of the leading n x n block would lose too
+ * much of its size to be trusted. The residual element is allowed to go to
+ * zero since an exact fit is fine.
+ */
+static int __rls_downdate(rc_matrix_t R, double* z)
+{
+    int i,k,n;
+    double r2,c,s;
+    n = R.rows-1;
+    for(k=0;k<n;k++){
+        if(z[k]==0.0) continue;
+        r2 = (R.d[k][k]-z[k])*(R.d[k][k]+z[k]);
+        if(unlikely(!(r2>zero_tolerance*R.d[k][k]*R.d[k][k]))) return -1;
+        c = sqrt(r2)/R.d[k][k];
+        s = z[k]/R.d[k][k];
+        R.d[k][k] = sqrt(r2);
+        for(i=k+1;i<=n;i++){
+            R.d[k][i] = (R.d[k][i] - s*z[i])/c;
+            z[i] = c*z[i] - s*R.d[k][i];
+        }
+    }
+    r2 = (R.d[n][n]-z[n])*(R.d[n][n]+z[n]);
+    R.d[n][n] = (r2>0.0) ? sqrt(r2) : 0.0;
+    return 0;
+}
+
+
+// scales R by sqrt(lambda) before a new row goes in, older rows then weigh
+// lambda^k after k more rows
+static void __rls_forget(rc_rls_t* rls)
+{
+    int k;
+    double s;
+    if(rls->lambda==1.0) return;
+    s = sqrt(rls->lambda);
+    for(k=0;k<rls->R.rows;k++) __vectorized_scale(s, &rls->R.d[k][k], rls->R.cols-k);
+    return;
+}
+
+
+// refactors R from scratch out of the rows stored in the window
+static void __rls_rebuild(rc_rls_t* rls)
+{
+    int i,j;
+    for(i=0;i<rls->R.rows;i++) memset(rls->R.d[i], 0, rls->R.cols*sizeof(double));
+    for(i=0;i<rls->count;i++){
+        j = (rls->head+i)%rls->window;
+        __rls_forget(rls);
+        memcpy(rls->tmp.d, rls->rows.d[j], (rls->n+1)*sizeof(double));
+        __rls_update(rls->R, rls->tmp.d);
+    }
+    return;
+}
+
+
+int rc_rls_add_row(rc_rls_t* rls, rc_vector_t a, double b)
+{
+    int k;
+    double s;
+    // sanity checks
+    if(unlikely(rls==NULL)){
+        fprintf(stderr,"ERROR in rc_rls_add_row, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!rls->initialized || !a.initialized)){
+        fprintf(stderr,"ERROR in rc_rls_add_row, rls or vector not initialized\n");
+        return -1;
+    }
+    if(unlikely(a.len!=rls->n)){
+        fprintf(stderr,"ERROR in rc_rls_add_row, dimension mismatch\n");
+        return -1;
+    }
+
+    if(rls->window>0){
+        // drop the oldest row, which has been scaled by sqrt(lambda) once for
+        // every row added after it
+        if(rls->count==rls->window){
+            s = pow(rls->lambda, 0.5*(rls->window-1));
+            for(k=0;k<=rls->n;k++) rls->tmp.d[k] = s*rls->rows.d[rls->head][k];
+            rls->head = (rls->head+1)%rls->window;
+            rls->count--;
+            if(__rls_downdate(rls->R, rls->tmp.d)) __rls_rebuild(rls);
+        }
+        k = (rls->head+rls->count)%rls->window;
+        memcpy(rls->rows.d[k], a.d, rls->n*sizeof(double));
+        rls->rows.d[k][rls->n] = b;
+        rls->count++;
+    }
+
+    __rls_forget(rls);
+    memcpy(rls->tmp.d, a.d, rls->n*sizeof(double));
+    rls->tmp.d[rls->n] = b;
+    __rls_update(rls->R, rls->tmp.d);
+    rls->step++;
+    return 0;
+}
+
+
+int rc_rls_solve(rc_rls_t rls, rc_vector_t* x)
+{
+    int i,n;
+    double rmax;
+    // sanity checks
+    if(unlikely(x==NULL)){
+        fprintf(stderr,"ERROR in rc_rls_solve, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(!rls.initialized)){
+        fprintf(stderr,"ERROR in rc_rls_solve, rls not initialized\n");
+        return -1;
+    }
+    n = rls.n;
+    rmax = 0.0;
+    for(i=0;i<n;i++) rmax = fmax(rmax, fabs(rls.R.d[i][i]));
+    for(i=0;i<n;i++){
+        if(unlikely(!(fabs(rls.R.d[i][i])>zero_tolerance*rmax))){
+            fprintf(stderr,"ERROR in rc_rls_solve, not enough independent rows yet\n");
+            return -1;
+        }
+    }
+    if(unlikely(rc_vector_alloc(x,n))){
+        fprintf(stderr,"ERROR in rc_rls_solve, failed to allocate x\n");
+        return -1;
+    }
+    // back substitution R*x = last column of R
+    for(i=n-1;i>=0;i--){
+        x->d[i] = rls.R.d[i][n] - __vectorized_mult_accumulate(&rls.R.d[i][i+1], &x->d[i+1], n-i-1);
+        x->d[i] /= rls.R.d[i][i];
+    }
+    return 0;
+}
+
+
+double rc_rls_residual(rc_rls_t rls)
+{
+    if(unlikely(!rls.initialized)){
+        fprintf(stderr,"ERROR in rc_rls_residual, rls not initialized\n");
+        return -1.0;
+    }
+    return fabs(rls.R.d[rls.n][rls.n]);
+}
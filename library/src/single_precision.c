@@ -0,0 +1,127 @@
+/**
+ * @file       single_precision.c
+ *
+ * @brief      Builds the float API in rc_math/single_precision.h from the same
+ *             *_template.h sources as the double API, see precision.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // for malloc,calloc,free
+#include <string.h> // for memcpy, memset
+#include <math.h>
+
+#define RC_SINGLE_PRECISION
+#include "algebra_common.h"
+#include "precision.h"
+
+#define GEMM_MICRO  __kernels.gemm_microf
+
+#include "vector_template.h"
+#include "gemm_template.h"
+#include "matrix_template.h"
+#include "algebra_template.h"
+#include "quaternion_template.h"
+#include "ring_buffer_template.h"
+#include "filter_template.h"
+
+
+int rc_vectorf_from_vector(rc_vectorf_t* out, rc_vector_t v)
+{
+    int i;
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in rc_vectorf_from_vector, vector uninitialized\n");
+        return -1;
+    }
+    if(unlikely(rc_vectorf_alloc(out,v.len))){
+        fprintf(stderr,"ERROR in rc_vectorf_from_vector, failed to allocate vector\n");
+        return -1;
+    }
+    for(i=0;i<v.len;i++) out->d[i] = (float)v.d[i];
+    return 0;
+}
+
+
+int rc_vector_from_vectorf(rc_vector_t* out, rc_vectorf_t v)
+{
+    int i;
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in rc_vector_from_vectorf, vector uninitialized\n");
+        return -1;
+    }
+    if(unlikely(rc_vector_alloc(out,v.len))){
+        fprintf(stderr,"ERROR in rc_vector_from_vectorf, failed to allocate vector\n");
+        return -1;
+    }
+    for(i=0;i<v.len;i++) out->d[i] = (double)v.d[i];
+    return 0;
+}
+
+
+int rc_matrixf_from_matrix(rc_matrixf_t* out, rc_matrix_t A)
+{
+    int i,j;
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrixf_from_matrix, matrix uninitialized\n");
+        return -1;
+    }
+    if(unlikely(rc_matrixf_alloc(out,A.rows,A.cols))){
+        fprintf(stderr,"ERROR in rc_matrixf_from_matrix, failed to allocate matrix\n");
+        return -1;
+    }
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) out->d[i][j] = (float)A.d[i][j];
+    }
+    return 0;
+}
+
+
+int rc_matrix_from_matrixf(rc_matrix_t* out, rc_matrixf_t A)
+{
+    int i,j;
+    if(unlikely(A.initialized!=1)){
+        fprintf(stderr,"ERROR in rc_matrix_from_matrixf, matrix uninitialized\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_alloc(out,A.rows,A.cols))){
+        fprintf(stderr,"ERROR in rc_matrix_from_matrixf, failed to allocate matrix\n");
+        return -1;
+    }
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) out->d[i][j] = (double)A.d[i][j];
+    }
+    return 0;
+}
+
+
+int rc_filterf_from_filter(rc_filterf_t* f, rc_filter_t design)
+{
+    rc_vectorf_t num = RC_VECTORF_INITIALIZER;
+    rc_vectorf_t den = RC_VECTORF_INITIALIZER;
+    int ret;
+
+    if(unlikely(!design.initialized)){
+        fprintf(stderr,"ERROR in rc_filterf_from_filter, filter uninitialized\n");
+        return -1;
+    }
+    if(unlikely(rc_vectorf_from_vector(&num,design.num) ||
+                rc_vectorf_from_vector(&den,design.den))){
+        fprintf(stderr,"ERROR in rc_filterf_from_filter, failed to convert coefficients\n");
+        rc_vectorf_free(&num);
+        rc_vectorf_free(&den);
+        return -1;
+    }
+    ret = rc_filterf_alloc(f, num, den, (float)design.dt);
+    rc_vectorf_free(&num);
+    rc_vectorf_free(&den);
+    if(unlikely(ret)){
+        fprintf(stderr,"ERROR in rc_filterf_from_filter, failed to allocate filter\n");
+        return -1;
+    }
+    f->gain     = (float)design.gain;
+    f->sat_en   = design.sat_en;
+    f->sat_min  = (float)design.sat_min;
+    f->sat_max  = (float)design.sat_max;
+    f->ss_en    = design.ss_en;
+    f->ss_steps = (float)design.ss_steps;
+    return 0;
+}
@@ -0,0 +1,414 @@
+/**
+ * @file       sparse.c
+ *
+ * @brief      see sparse.h
+ *
+ * CSR and CSC share one code path. Each format is a list of "major" lines,
+ * rows for CSR and columns for CSC, holding (minor index, value) pairs. A
+ * product with op(S) reads S either along its stored lines (gather) or
+ * scatters each line into the output, depending on whether the stored lines
+ * are rows or columns of op(S).
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // for malloc, calloc, free
+#include <string.h> // for memset, memcpy
+
+#include <rc_math/sparse.h>
+#include "algebra_common.h"
+
+// number of stored lines, rows for CSR and columns for CSC
+#define MAJOR(S) ((S).format==RC_SPARSE_CSR ? (S).rows : (S).cols)
+
+// true if the stored lines of S are the rows of op(S)
+#define ROWWISE(S,ts) (((S).format==RC_SPARSE_CSR) != ((ts)!=0))
+
+
+/*
+ * Fills S from n (major, minor, value) triplets: (row, col) for CSR and
+ * (col, row) for CSC. A counting sort groups them by major index, then each
+ * line is sorted by minor index and duplicates are summed. Lines are usually
+ * short or already in order so an insertion sort is used.
+ */
+static int __build(rc_sparse_t* S, int rows, int cols, int format, int n,
+                const int* major, const int* minor, const double* val)
+{
+    int r, k, m, w, begin, end, nmaj, nmin, tmp_i;
+    double tmp_v;
+    int* next;
+
+    nmaj = format==RC_SPARSE_CSR ? rows : cols;
+    nmin = format==RC_SPARSE_CSR ? cols : rows;
+    for(k=0;k<n;k++){
+        if(unlikely(major[k]<0 || major[k]>=nmaj || minor[k]<0 || minor[k]>=nmin)){
+            fprintf(stderr,"ERROR in rc_sparse_from_triplets, entry %d out of bounds\n", k);
+            return -1;
+        }
+    }
+
+    rc_sparse_free(S);
+    S->ptr = (int*)calloc(nmaj+1, sizeof(int));
+    S->idx = (int*)malloc((n>0 ? n : 1)*sizeof(int));
+    S->val = (double*)malloc((n>0 ? n : 1)*sizeof(double));
+    next = (int*)malloc(nmaj*sizeof(int));
+    if(unlikely(S->ptr==NULL || S->idx==NULL || S->val==NULL || next==NULL)){
+        perror("ERROR in rc_sparse_from_triplets");
+        free(S->ptr);
+        free(S->idx);
+        free(S->val);
+        free(next);
+        *S = rc_sparse_empty();
+        return -1;
+    }
+
+    // counting sort by major index
+    for(k=0;k<n;k++) S->ptr[major[k]+1]++;
+    for(r=0;r<nmaj;r++) S->ptr[r+1] += S->ptr[r];
+    memcpy(next, S->ptr, nmaj*sizeof(int));
+    for(k=0;k<n;k++){
+        w = next[major[k]]++;
+        S->idx[w] = minor[k];
+        S->val[w] = val[k];
+    }
+    free(next);
+
+    // sort each line and merge duplicates, compacting as we go
+    w = 0;
+    for(r=0;r<nmaj;r++){
+        begin = S->ptr[r];
+        end = S->ptr[r+1];
+        for(k=begin+1;k<end;k++){
+            tmp_i = S->idx[k];
+            tmp_v = S->val[k];
+            for(m=k;m>begin && S->idx[m-1]>tmp_i;m--){
+                S->idx[m] = S->idx[m-1];
+                S->val[m] = S->val[m-1];
+            }
+            S->idx[m] = tmp_i;
+            S->val[m] = tmp_v;
+        }
+        S->ptr[r] = w;
+        for(k=begin;k<end;k++){
+            if(w>S->ptr[r] && S->idx[w-1]==S->idx[k]) S->val[w-1] += S->val[k];
+            else{
+                S->idx[w] = S->idx[k];
+                S->val[w] = S->val[k];
+                w++;
+            }
+        }
+    }
+    S->ptr[nmaj] = w;
+
+    S->rows = rows;
+    S->cols = cols;
+    S->nnz = w;
+    S->format = format;
+    S->initialized = 1;
+    return 0;
+}
+
+
+rc_sparse_t rc_sparse_empty(void)
+{
+    rc_sparse_t out = RC_SPARSE_INITIALIZER;
+    return out;
+}
+
+
+int rc_sparse_free(rc_sparse_t* S)
+{
+    rc_sparse_t new = RC_SPARSE_INITIALIZER;
+    if(unlikely(S==NULL)){
+        fprintf(stderr,"ERROR in rc_sparse_free, received NULL pointer\n");
+        return -1;
+    }
+    if(S->initialized){
+        free(S->ptr);
+        free(S->idx);
+        free(S->val);
+    }
+    *S = new;
+    return 0;
+}
+
+
+int rc_sparse_from_triplets(rc_sparse_t* S, int rows, int cols, int n, const int* i,
+                                const int* j, const double* val, int format)
+{
+    // sanity checks
+    if(unlikely(S==NULL || (n>0 && (i==NULL || j==NULL || val==NULL)))){
+        fprintf(stderr,"ERROR in rc_sparse_from_triplets, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(rows<1 || cols<1 || n<0)){
+        fprintf(stderr,"ERROR in rc_sparse_from_triplets, rows and cols must be >=1 and n >=0\n");
+        return -1;
+    }
+    if(unlikely(format!=RC_SPARSE_CSR && format!=RC_SPARSE_CSC)){
+        fprintf(stderr,"ERROR in rc_sparse_from_triplets, invalid format\n");
+        return -1;
+    }
+    if(format==RC_SPARSE_CSR) return __build(S, rows, cols, format, n, i, j, val);
+    return __build(S, rows, cols, format, n, j, i, val);
+}
+
+
+int rc_sparse_from_matrix(rc_matrix_t A, int format, rc_sparse_t* S)
+{
+    int i, j, n, ret;
+    int* ti;
+    int* tj;
+    double* tv;
+
+    // sanity checks
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_sparse_from_matrix, A not initialized\n");
+        return -1;
+    }
+    if(unlikely(S==NULL)){
+        fprintf(stderr,"ERROR in rc_sparse_from_matrix, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(format!=RC_SPARSE_CSR && format!=RC_SPARSE_CSC)){
+        fprintf(stderr,"ERROR in rc_sparse_from_matrix, invalid format\n");
+        return -1;
+    }
+
+    n = 0;
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++) if(A.d[i][j]!=0.0) n++;
+    }
+    ti = (int*)malloc((n>0 ? n : 1)*sizeof(int));
+    tj = (int*)malloc((n>0 ? n : 1)*sizeof(int));
+    tv = (double*)malloc((n>0 ? n : 1)*sizeof(double));
+    if(unlikely(ti==NULL || tj==NULL || tv==NULL)){
+        perror("ERROR in rc_sparse_from_matrix");
+        free(ti);
+        free(tj);
+        free(tv);
+        return -1;
+    }
+    n = 0;
+    for(i=0;i<A.rows;i++){
+        for(j=0;j<A.cols;j++){
+            if(A.d[i][j]==0.0) continue;
+            ti[n] = i;
+            tj[n] = j;
+            tv[n] = A.d[i][j];
+            n++;
+        }
+    }
+    ret = rc_sparse_from_triplets(S, A.rows, A.cols, n, ti, tj, tv, format);
+    free(ti);
+    free(tj);
+    free(tv);
+    return ret;
+}
+
+
+int rc_sparse_to_matrix(rc_sparse_t S, rc_matrix_t* A)
+{
+    int r, k;
+    if(unlikely(!S.initialized)){
+        fprintf(stderr,"ERROR in rc_sparse_to_matrix, S not initialized\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_zeros(A, S.rows, S.cols))){
+        fprintf(stderr,"ERROR in rc_sparse_to_matrix, failed to allocate A\n");
+        return -1;
+    }
+    for(r=0;r<MAJOR(S);r++){
+        for(k=S.ptr[r];k<S.ptr[r+1];k++){
+            if(S.format==RC_SPARSE_CSR) A->d[r][S.idx[k]] = S.val[k];
+            else A->d[S.idx[k]][r] = S.val[k];
+        }
+    }
+    return 0;
+}
+
+
+int rc_sparse_convert(rc_sparse_t S, int format, rc_sparse_t* out)
+{
+    int r, k, ret;
+    int* maj;
+
+    // sanity checks
+    if(unlikely(!S.initialized)){
+        fprintf(stderr,"ERROR in rc_sparse_convert, S not initialized\n");
+        return -1;
+    }
+    if(unlikely(out==NULL)){
+        fprintf(stderr,"ERROR in rc_sparse_convert, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(out->initialized && out->val==S.val)){
+        fprintf(stderr,"ERROR in rc_sparse_convert, out must not be S\n");
+        return -1;
+    }
+    if(unlikely(format!=RC_SPARSE_CSR && format!=RC_SPARSE_CSC)){
+        fprintf(stderr,"ERROR in rc_sparse_convert, invalid format\n");
+        return -1;
+    }
+
+    // expand the compressed major index back to one entry per nonzero
+    maj = (int*)malloc((S.nnz>0 ? S.nnz : 1)*sizeof(int));
+    if(unlikely(maj==NULL)){
+        perror("ERROR in rc_sparse_convert");
+        return -1;
+    }
+    for(r=0;r<MAJOR(S);r++){
+        for(k=S.ptr[r];k<S.ptr[r+1];k++) maj[k] = r;
+    }
+    // walking the old lines in order leaves every new line already sorted
+    if(format==S.format) ret = __build(out, S.rows, S.cols, format, S.nnz, maj, S.idx, S.val);
+    else ret = __build(out, S.rows, S.cols, format, S.nnz, S.idx, maj, S.val);
+    free(maj);
+    return ret;
+}
+
+
+int rc_sparse_print(rc_sparse_t S)
+{
+    int r, k;
+    if(unlikely(!S.initialized)){
+        fprintf(stderr,"ERROR in rc_sparse_print, S not initialized\n");
+        return -1;
+    }
+    printf("%dx%d %s with %d nonzeros\n", S.rows, S.cols,
+                        S.format==RC_SPARSE_CSR ? "CSR" : "CSC", S.nnz);
+    for(r=0;r<MAJOR(S);r++){
+        for(k=S.ptr[r];k<S.ptr[r+1];k++){
+            if(S.format==RC_SPARSE_CSR) printf("(%d,%d) %7.4f\n", r, S.idx[k], S.val[k]);
+            else printf("(%d,%d) %7.4f\n", S.idx[k], r, S.val[k]);
+        }
+    }
+    return 0;
+}
+
+
+int rc_sparse_times_col_vec_trans(rc_sparse_t S, int ts, rc_vector_t v, rc_vector_t* c)
+{
+    int r, k;
+    double sum;
+
+    // sanity checks
+    if(unlikely(!S.initialized || !v.initialized)){
+        fprintf(stderr,"ERROR in rc_sparse_times_col_vec, matrix or vector uninitialized\n");
+        return -1;
+    }
+    if(unlikely(v.len!=(ts ? S.rows : S.cols))){
+        fprintf(stderr,"ERROR in rc_sparse_times_col_vec, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(c->d==v.d)){
+        fprintf(stderr,"ERROR in rc_sparse_times_col_vec, c must not be v\n");
+        return -1;
+    }
+    if(unlikely(rc_vector_alloc(c, ts ? S.cols : S.rows))){
+        fprintf(stderr,"ERROR in rc_sparse_times_col_vec, failed to allocate c\n");
+        return -1;
+    }
+    // stored lines are rows of op(S), each output is a sparse dot product
+    if(ROWWISE(S,ts)){
+        for(r=0;r<MAJOR(S);r++){
+            sum = 0.0;
+            for(k=S.ptr[r];k<S.ptr[r+1];k++) sum += S.val[k]*v.d[S.idx[k]];
+            c->d[r] = sum;
+        }
+        return 0;
+    }
+    // stored lines are columns of op(S), scatter each scaled by one of v
+    memset(c->d, 0, c->len*sizeof(double));
+    for(r=0;r<MAJOR(S);r++){
+        for(k=S.ptr[r];k<S.ptr[r+1];k++) c->d[S.idx[k]] += S.val[k]*v.d[r];
+    }
+    return 0;
+}
+
+
+int rc_sparse_times_col_vec(rc_sparse_t S, rc_vector_t v, rc_vector_t* c)
+{
+    return rc_sparse_times_col_vec_trans(S, 0, v, c);
+}
+
+
+int rc_sparse_multiply_dense(rc_sparse_t S, int ts, rc_matrix_t B, rc_matrix_t* C)
+{
+    int r, k, m;
+
+    // sanity checks
+    if(unlikely(!S.initialized || !B.initialized)){
+        fprintf(stderr,"ERROR in rc_sparse_multiply_dense, matrix not initialized\n");
+        return -1;
+    }
+    if(unlikely(B.rows!=(ts ? S.rows : S.cols))){
+        fprintf(stderr,"ERROR in rc_sparse_multiply_dense, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(C->d==B.d)){
+        fprintf(stderr,"ERROR in rc_sparse_multiply_dense, C must not be B\n");
+        return -1;
+    }
+    m = ts ? S.cols : S.rows;
+    if(unlikely(rc_matrix_zeros(C, m, B.cols))){
+        fprintf(stderr,"ERROR in rc_sparse_multiply_dense, can't allocate memory for C\n");
+        return -1;
+    }
+    // row r of op(S)*B is a sum of rows of B, either gathered per row of C or
+    // scattered from each row of B
+    for(r=0;r<MAJOR(S);r++){
+        for(k=S.ptr[r];k<S.ptr[r+1];k++){
+            if(ROWWISE(S,ts)) __vectorized_axpy(S.val[k], B.d[S.idx[k]], C->d[r], B.cols);
+            else __vectorized_axpy(S.val[k], B.d[r], C->d[S.idx[k]], B.cols);
+        }
+    }
+    return 0;
+}
+
+
+int rc_sparse_dense_multiply(rc_matrix_t A, rc_sparse_t S, int ts, rc_matrix_t* C)
+{
+    int i, r, k, n;
+    double a, sum;
+    double* Ci;
+
+    // sanity checks
+    if(unlikely(!S.initialized || !A.initialized)){
+        fprintf(stderr,"ERROR in rc_sparse_dense_multiply, matrix not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.cols!=(ts ? S.cols : S.rows))){
+        fprintf(stderr,"ERROR in rc_sparse_dense_multiply, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(C->d==A.d)){
+        fprintf(stderr,"ERROR in rc_sparse_dense_multiply, C must not be A\n");
+        return -1;
+    }
+    n = ts ? S.rows : S.cols;
+    if(unlikely(rc_matrix_alloc(C, A.rows, n))){
+        fprintf(stderr,"ERROR in rc_sparse_dense_multiply, can't allocate memory for C\n");
+        return -1;
+    }
+    for(i=0;i<A.rows;i++){
+        Ci = C->d[i];
+        // stored lines are rows of op(S), scale each by one element of A
+        if(ROWWISE(S,ts)){
+            memset(Ci, 0, n*sizeof(double));
+            for(r=0;r<MAJOR(S);r++){
+                a = A.d[i][r];
+                if(a==0.0) continue;
+                for(k=S.ptr[r];k<S.ptr[r+1];k++) Ci[S.idx[k]] += a*S.val[k];
+            }
+        }
+        // stored lines are columns of op(S), each element is a sparse dot
+        else{
+            for(r=0;r<MAJOR(S);r++){
+                sum = 0.0;
+                for(k=S.ptr[r];k<S.ptr[r+1];k++) sum += A.d[i][S.idx[k]]*S.val[k];
+                Ci[r] = sum;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,456 @@
+/**
+ * @file       symmetric.c
+ *
+ * @brief      see symmetric.h
+ *
+ * Every packed row i is a contiguous run of n-i doubles starting at the
+ * diagonal, so the kernels here work a row at a time with the same vectorized
+ * dot and axpy helpers as the full matrix code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // for malloc, free
+#include <string.h> // for memset, memcpy
+#include <math.h>
+
+#include <rc_math/symmetric.h>
+#include "algebra_common.h"
+
+// start of packed row i of an n x n matrix
+#define ROW(S,i) (&(S).d[RC_SYMMETRIC_INDEX((S).n,i,i)])
+
+
+rc_symmetric_t rc_symmetric_empty(void)
+{
+    rc_symmetric_t out = RC_SYMMETRIC_INITIALIZER;
+    return out;
+}
+
+
+int rc_symmetric_alloc(rc_symmetric_t* S, int n)
+{
+    // sanity checks
+    if(unlikely(n<1)){
+        fprintf(stderr,"ERROR in rc_symmetric_alloc, n must be >=1\n");
+        return -1;
+    }
+    if(unlikely(S==NULL)){
+        fprintf(stderr,"ERROR in rc_symmetric_alloc, received NULL pointer\n");
+        return -1;
+    }
+    // if S is already allocated and of the right size, nothing to do!
+    if(S->initialized==1 && n==S->n) return 0;
+    // free any old memory
+    rc_symmetric_free(S);
+    S->d = (double*)malloc(RC_SYMMETRIC_SIZE((size_t)n)*sizeof(double));
+    if(unlikely(S->d==NULL)){
+        perror("ERROR in rc_symmetric_alloc");
+        fprintf(stderr, "tried allocating a %dx%d symmetric matrix\n", n,n);
+        return -1;
+    }
+    S->n = n;
+    S->initialized = 1;
+    return 0;
+}
+
+
+int rc_symmetric_zeros(rc_symmetric_t* S, int n)
+{
+    if(unlikely(rc_symmetric_alloc(S,n))){
+        fprintf(stderr,"ERROR in rc_symmetric_zeros, failed to allocate matrix\n");
+        return -1;
+    }
+    memset(S->d, 0, RC_SYMMETRIC_SIZE((size_t)n)*sizeof(double));
+    return 0;
+}
+
+
+int rc_symmetric_identity(rc_symmetric_t* S, int n)
+{
+    int i;
+    if(unlikely(rc_symmetric_zeros(S,n))){
+        fprintf(stderr,"ERROR in rc_symmetric_identity, failed to allocate matrix\n");
+        return -1;
+    }
+    for(i=0;i<n;i++) RC_SYMMETRIC_AT(*S,i,i) = 1.0;
+    return 0;
+}
+
+
+int rc_symmetric_free(rc_symmetric_t* S)
+{
+    rc_symmetric_t new = RC_SYMMETRIC_INITIALIZER;
+    if(unlikely(S==NULL)){
+        fprintf(stderr,"ERROR in rc_symmetric_free, received NULL pointer\n");
+        return -1;
+    }
+    if(S->initialized) free(S->d);
+    *S = new;
+    return 0;
+}
+
+
+int rc_symmetric_duplicate(rc_symmetric_t A, rc_symmetric_t* B)
+{
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_duplicate, A not initialized\n");
+        return -1;
+    }
+    if(unlikely(rc_symmetric_alloc(B,A.n))){
+        fprintf(stderr,"ERROR in rc_symmetric_duplicate, failed to allocate B\n");
+        return -1;
+    }
+    if(B->d!=A.d) memcpy(B->d, A.d, RC_SYMMETRIC_SIZE((size_t)A.n)*sizeof(double));
+    return 0;
+}
+
+
+int rc_symmetric_from_matrix(rc_matrix_t A, rc_symmetric_t* S)
+{
+    int i,j;
+    double* out;
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_from_matrix, A not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.rows!=A.cols)){
+        fprintf(stderr,"ERROR in rc_symmetric_from_matrix, A must be square\n");
+        return -1;
+    }
+    if(unlikely(rc_symmetric_alloc(S,A.rows))){
+        fprintf(stderr,"ERROR in rc_symmetric_from_matrix, failed to allocate S\n");
+        return -1;
+    }
+    out = S->d;
+    for(i=0;i<A.rows;i++){
+        *out++ = A.d[i][i];
+        for(j=i+1;j<A.cols;j++) *out++ = (A.d[i][j]+A.d[j][i])/2.0;
+    }
+    return 0;
+}
+
+
+int rc_symmetric_to_matrix(rc_symmetric_t S, rc_matrix_t* A)
+{
+    int i,j;
+    double* in;
+    if(unlikely(!S.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_to_matrix, S not initialized\n");
+        return -1;
+    }
+    if(unlikely(rc_matrix_alloc(A,S.n,S.n))){
+        fprintf(stderr,"ERROR in rc_symmetric_to_matrix, failed to allocate A\n");
+        return -1;
+    }
+    in = S.d;
+    for(i=0;i<S.n;i++){
+        for(j=i;j<S.n;j++){
+            A->d[i][j] = *in;
+            A->d[j][i] = *in;
+            in++;
+        }
+    }
+    return 0;
+}
+
+
+double rc_symmetric_get(rc_symmetric_t S, int i, int j)
+{
+    if(unlikely(!S.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_get, S not initialized\n");
+        return 0.0;
+    }
+    if(unlikely(i<0 || j<0 || i>=S.n || j>=S.n)){
+        fprintf(stderr,"ERROR in rc_symmetric_get, index out of bounds\n");
+        return 0.0;
+    }
+    if(i>j) return RC_SYMMETRIC_AT(S,j,i);
+    return RC_SYMMETRIC_AT(S,i,j);
+}
+
+
+int rc_symmetric_set(rc_symmetric_t* S, int i, int j, double val)
+{
+    if(unlikely(S==NULL || !S->initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_set, S not initialized\n");
+        return -1;
+    }
+    if(unlikely(i<0 || j<0 || i>=S->n || j>=S->n)){
+        fprintf(stderr,"ERROR in rc_symmetric_set, index out of bounds\n");
+        return -1;
+    }
+    if(i>j) RC_SYMMETRIC_AT(*S,j,i) = val;
+    else    RC_SYMMETRIC_AT(*S,i,j) = val;
+    return 0;
+}
+
+
+int rc_symmetric_print(rc_symmetric_t S)
+{
+    int i,j;
+    if(unlikely(!S.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_print, S not initialized\n");
+        return -1;
+    }
+    for(i=0;i<S.n;i++){
+        for(j=0;j<S.n;j++){
+            if(j<i) printf("%7.4f  ",RC_SYMMETRIC_AT(S,j,i));
+            else    printf("%7.4f  ",RC_SYMMETRIC_AT(S,i,j));
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+
+int rc_symmetric_add(rc_symmetric_t A, rc_symmetric_t B, rc_symmetric_t* C)
+{
+    int i;
+    if(unlikely(!A.initialized || !B.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_add, matrix not initialized\n");
+        return -1;
+    }
+    if(unlikely(A.n!=B.n)){
+        fprintf(stderr,"ERROR in rc_symmetric_add, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(rc_symmetric_alloc(C,A.n))){
+        fprintf(stderr,"ERROR in rc_symmetric_add, failed to allocate C\n");
+        return -1;
+    }
+    for(i=0;i<RC_SYMMETRIC_SIZE(A.n);i++) C->d[i] = A.d[i]+B.d[i];
+    return 0;
+}
+
+
+int rc_symmetric_add_inplace(rc_symmetric_t* A, rc_symmetric_t B)
+{
+    if(unlikely(A==NULL || !A->initialized || !B.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_add_inplace, matrix not initialized\n");
+        return -1;
+    }
+    if(unlikely(A->n!=B.n)){
+        fprintf(stderr,"ERROR in rc_symmetric_add_inplace, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(A->d==B.d)){
+        __vectorized_scale(2.0, A->d, RC_SYMMETRIC_SIZE(A->n));
+        return 0;
+    }
+    __vectorized_axpy(1.0, B.d, A->d, RC_SYMMETRIC_SIZE(A->n));
+    return 0;
+}
+
+
+int rc_symmetric_times_scalar(rc_symmetric_t* S, double s)
+{
+    if(unlikely(S==NULL || !S->initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_times_scalar, S not initialized\n");
+        return -1;
+    }
+    __vectorized_scale(s, S->d, RC_SYMMETRIC_SIZE(S->n));
+    return 0;
+}
+
+
+int rc_symmetric_times_col_vec(rc_symmetric_t S, rc_vector_t v, rc_vector_t* c)
+{
+    int i,len;
+    double* row;
+    if(unlikely(!S.initialized || !v.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_times_col_vec, matrix or vector uninitialized\n");
+        return -1;
+    }
+    if(unlikely(S.n!=v.len)){
+        fprintf(stderr,"ERROR in rc_symmetric_times_col_vec, dimension mismatch\n");
+        return -1;
+    }
+    if(unlikely(c->initialized && c->d==v.d)){
+        fprintf(stderr,"ERROR in rc_symmetric_times_col_vec, c must not be v\n");
+        return -1;
+    }
+    if(unlikely(rc_vector_zeros(c,S.n))){
+        fprintf(stderr,"ERROR in rc_symmetric_times_col_vec, failed to allocate c\n");
+        return -1;
+    }
+    // row i covers (i,i..n-1). The part right of the diagonal contributes to
+    // c[i] as a row and, mirrored, to c[i+1..n-1] as column i.
+    for(i=0;i<S.n;i++){
+        row = ROW(S,i);
+        len = S.n-i-1;
+        c->d[i] += row[0]*v.d[i];
+        if(len==0) break;
+        c->d[i] += __vectorized_mult_accumulate(&row[1], &v.d[i+1], len);
+        __vectorized_axpy(v.d[i], &row[1], &c->d[i+1], len);
+    }
+    return 0;
+}
+
+
+// columns of P unpacked at a time, and rows of out per second gemm
+#define SANDWICH_PANEL  128
+
+// out = A*P*A^T (+Q) without unpacking all of P. T = A*P is built a panel of
+// columns at a time, expanding just those columns of P from the packed rows
+// so the blocked gemm can be used. Rows of out then come a panel at a time
+// from gemm of rows of T with rows of A, from the diagonal right, and are
+// packed as they go.
+static int __sandwich(rc_matrix_t A, rc_symmetric_t P, rc_symmetric_t* Q, rc_symmetric_t* out, const char* name)
+{
+    int i,j,k,r,len,cols,rows,panel;
+    double *T, *B, *c, *o, *q;
+    if(unlikely(!A.initialized || !P.initialized || (Q!=NULL && !Q->initialized))){
+        fprintf(stderr,"ERROR in %s, matrix not initialized\n", name);
+        return -1;
+    }
+    if(unlikely(A.cols!=P.n)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", name);
+        return -1;
+    }
+    if(unlikely(Q!=NULL && Q->n!=A.rows)){
+        fprintf(stderr,"ERROR in %s, Q must have as many rows as A\n", name);
+        return -1;
+    }
+    if(unlikely(out->initialized && out->d==P.d)){
+        fprintf(stderr,"ERROR in %s, out must not be P\n", name);
+        return -1;
+    }
+
+    int m = A.rows;
+    int n = A.cols;
+    // out may be Q, it is already the right size so this leaves it alone
+    if(unlikely(rc_symmetric_alloc(out,m))){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for out\n", name);
+        return -1;
+    }
+    // T plus one buffer shared by the panel of P and the panel of out
+    panel = (m>n) ? m : n;
+    if(panel>SANDWICH_PANEL) panel = SANDWICH_PANEL;
+    T = (double*)malloc(((size_t)m*n + (size_t)panel*((m>n)?m:n))*sizeof(double));
+    if(unlikely(T==NULL)){
+        fprintf(stderr,"ERROR in %s, can't allocate memory for A*P\n", name);
+        return -1;
+    }
+    B = &T[(size_t)m*n];
+
+    // T = A*P one panel of columns j..j+cols-1 at a time
+    for(j=0;j<n;j+=panel){
+        cols = (n-j<panel) ? n-j : panel;
+        for(k=0;k<n;k++){
+            for(r=0;r<cols;r++){
+                B[(k*cols)+r] = (k<=j+r) ? P.d[RC_SYMMETRIC_INDEX(n,k,j+r)]
+                                         : P.d[RC_SYMMETRIC_INDEX(n,j+r,k)];
+            }
+        }
+        if(unlikely(__gemm(0, 0, m, cols, n, 1.0, A.d[0], A.stride, B, cols, 0.0, &T[j], n))){
+            fprintf(stderr,"ERROR in %s, gemm failed\n", name);
+            free(T);
+            return -1;
+        }
+    }
+
+    // rows i..i+rows-1 of T*A^T from column i right
+    for(i=0;i<m;i+=panel){
+        rows = (m-i<panel) ? m-i : panel;
+        if(unlikely(__gemm(0, 1, rows, m-i, n, 1.0, &T[(size_t)i*n], n, A.d[i], A.stride,
+                                                            0.0, B, m-i))){
+            fprintf(stderr,"ERROR in %s, gemm failed\n", name);
+            free(T);
+            return -1;
+        }
+        // pack, adding Q. out may be Q since each element of Q is read just
+        // before the same element of out is written.
+        for(r=0;r<rows;r++){
+            c = &B[(r*(m-i))+r];
+            o = ROW(*out,i+r);
+            len = m-i-r;
+            if(Q!=NULL){
+                q = ROW(*Q,i+r);
+                for(k=0;k<len;k++) o[k] = c[k] + q[k];
+            }
+            else memcpy(o, c, len*sizeof(double));
+        }
+    }
+    free(T);
+    return 0;
+}
+
+
+int rc_symmetric_sandwich(rc_matrix_t A, rc_symmetric_t P, rc_symmetric_t* out)
+{
+    return __sandwich(A, P, NULL, out, "rc_symmetric_sandwich");
+}
+
+
+int rc_symmetric_sandwich_add(rc_matrix_t A, rc_symmetric_t P, rc_symmetric_t Q, rc_symmetric_t* out)
+{
+    return __sandwich(A, P, &Q, out, "rc_symmetric_sandwich_add");
+}
+
+
+int rc_symmetric_cholesky(rc_symmetric_t A, rc_symmetric_t* U)
+{
+    int i,k,n;
+    double *rk, *ri, r;
+    if(unlikely(!A.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_cholesky, A not initialized\n");
+        return -1;
+    }
+    if(unlikely(rc_symmetric_duplicate(A,U))){
+        fprintf(stderr,"ERROR in rc_symmetric_cholesky, failed to allocate U\n");
+        return -1;
+    }
+    n = U->n;
+    // right-looking: finish row k of U, then subtract its outer product from
+    // the trailing rows. Every update is an axpy along a packed row.
+    for(k=0;k<n;k++){
+        rk = ROW(*U,k);
+        if(unlikely(rk[0]<=zero_tolerance)){
+            fprintf(stderr,"ERROR in rc_symmetric_cholesky, matrix is not positive definite\n");
+            return -1;
+        }
+        r = sqrt(rk[0]);
+        rk[0] = r;
+        __vectorized_scale(1.0/r, &rk[1], n-k-1);
+        for(i=k+1;i<n;i++){
+            ri = ROW(*U,i);
+            __vectorized_axpy(-rk[i-k], &rk[i-k], ri, n-i);
+        }
+    }
+    return 0;
+}
+
+
+int rc_symmetric_cholesky_solve(rc_symmetric_t U, rc_vector_t b, rc_vector_t* x)
+{
+    int i,n;
+    double* row;
+    if(unlikely(!U.initialized || !b.initialized)){
+        fprintf(stderr,"ERROR in rc_symmetric_cholesky_solve, matrix or vector uninitialized\n");
+        return -1;
+    }
+    if(unlikely(U.n!=b.len)){
+        fprintf(stderr,"ERROR in rc_symmetric_cholesky_solve, dimension mismatch\n");
+        return -1;
+    }
+    // solve in place in x, which already holds b if the caller passed b
+    if(!(x->initialized && x->d==b.d) && unlikely(rc_vector_duplicate(b,x))){
+        fprintf(stderr,"ERROR in rc_symmetric_cholesky_solve, failed to allocate x\n");
+        return -1;
+    }
+    n = U.n;
+    // forward substitution U^T*y = b, row i of U is column i of U^T so each
+    // solved entry is pushed down into the rest of the right hand side
+    for(i=0;i<n;i++){
+        row = ROW(U,i);
+        x->d[i] /= row[0];
+        __vectorized_axpy(-x->d[i], &row[1], &x->d[i+1], n-i-1);
+    }
+    // back substitution U*x = y
+    for(i=n-1;i>=0;i--){
+        row = ROW(U,i);
+        x->d[i] -= __vectorized_mult_accumulate(&row[1], &x->d[i+1], n-i-1);
+        x->d[i] /= row[0];
+    }
+    return 0;
+}
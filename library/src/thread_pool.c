@@ -0,0 +1,174 @@
+/**
+ * @file       thread_pool.c
+ *
+ * @brief      see thread_pool.h
+ *
+ * Work is handed out as a job: a function and a number of tasks. Workers and
+ * the calling thread claim task indices from a shared counter until none are
+ * left, so uneven tasks balance themselves. A job generation counter wakes
+ * the workers and a pending counter tells the caller when all of them have
+ * finished.
+ */
+
+#define _GNU_SOURCE // for sysconf _SC_NPROCESSORS_ONLN
+
+#include <stdio.h>
+#include <stdlib.h> // for malloc, free
+#include <unistd.h> // for sysconf
+#include <pthread.h>
+
+#include <rc_math/thread_pool.h>
+#include "algebra_common.h"
+
+static pthread_mutex_t  lock        = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t  run_lock    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t   start_cond  = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t   done_cond   = PTHREAD_COND_INITIALIZER;
+
+static pthread_t*       workers     = NULL;
+static int              nthreads    = 1;    // including the caller
+static int              generation  = 0;
+static int              start_gen   = 0;    // generation when workers started
+static int              stopping    = 0;
+static int              pending     = 0;    // workers still busy with the job
+
+static __pool_task_t    job_fn      = NULL;
+static void*            job_arg     = NULL;
+static int              job_tasks   = 0;
+static int              next_task   = 0;
+
+// set on any thread currently running tasks so nested calls run serially
+static __thread int     in_pool     = 0;
+
+
+// claim and run tasks of the current job until there are none left
+static void __run_tasks(void)
+{
+    int t;
+    in_pool = 1;
+    while((t=__atomic_fetch_add(&next_task, 1, __ATOMIC_RELAXED)) < job_tasks){
+        job_fn(job_arg, t);
+    }
+    in_pool = 0;
+    return;
+}
+
+
+static void* __worker(void* ptr)
+{
+    int seen;
+    (void)ptr;
+
+    // start from the generation at init, not the current one, in case a job
+    // was already posted before this thread got to run
+    pthread_mutex_lock(&lock);
+    seen = start_gen;
+    while(1){
+        while(generation==seen && !stopping) pthread_cond_wait(&start_cond, &lock);
+        if(stopping) break;
+        seen = generation;
+        pthread_mutex_unlock(&lock);
+        __run_tasks();
+        pthread_mutex_lock(&lock);
+        pending--;
+        if(pending==0) pthread_cond_signal(&done_cond);
+    }
+    pthread_mutex_unlock(&lock);
+    return NULL;
+}
+
+
+int rc_thread_pool_init(int threads)
+{
+    int i;
+    if(unlikely(threads<0)){
+        fprintf(stderr,"ERROR in rc_thread_pool_init, threads must be >=0\n");
+        return -1;
+    }
+    if(threads==0){
+        threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+        if(threads<1) threads=1;
+    }
+    // restart with the new size if already running
+    rc_thread_pool_cleanup();
+    if(threads==1) return 0;
+
+    workers = (pthread_t*)malloc((threads-1)*sizeof(pthread_t));
+    if(unlikely(workers==NULL)){
+        perror("ERROR in rc_thread_pool_init");
+        return -1;
+    }
+    stopping = 0;
+    start_gen = generation;
+    for(i=0;i<threads-1;i++){
+        if(unlikely(pthread_create(&workers[i], NULL, __worker, NULL))){
+            fprintf(stderr,"ERROR in rc_thread_pool_init, failed to start thread %d\n", i);
+            // keep the ones that did start so cleanup can join them
+            nthreads = i+1;
+            rc_thread_pool_cleanup();
+            return -1;
+        }
+    }
+    nthreads = threads;
+    return 0;
+}
+
+
+int rc_thread_pool_cleanup(void)
+{
+    int i;
+    if(nthreads<=1) return 0;
+    pthread_mutex_lock(&lock);
+    stopping = 1;
+    pthread_cond_broadcast(&start_cond);
+    pthread_mutex_unlock(&lock);
+    for(i=0;i<nthreads-1;i++) pthread_join(workers[i], NULL);
+    free(workers);
+    workers = NULL;
+    nthreads = 1;
+    stopping = 0;
+    return 0;
+}
+
+
+int rc_thread_pool_get_threads(void)
+{
+    return nthreads;
+}
+
+
+int __pool_threads(void)
+{
+    // a thread already working on a job only ever runs serially
+    if(in_pool) return 1;
+    return nthreads;
+}
+
+
+void __pool_run(__pool_task_t fn, void* arg, int ntasks)
+{
+    int i;
+    // run on this thread if there is no pool, we are already inside a job, or
+    // another thread is using the pool right now
+    if(ntasks<2 || nthreads<2 || in_pool || pthread_mutex_trylock(&run_lock)){
+        for(i=0;i<ntasks;i++) fn(arg,i);
+        return;
+    }
+    pthread_mutex_lock(&lock);
+    job_fn      = fn;
+    job_arg     = arg;
+    job_tasks   = ntasks;
+    next_task   = 0;
+    pending     = nthreads-1;
+    generation++;
+    pthread_cond_broadcast(&start_cond);
+    pthread_mutex_unlock(&lock);
+
+    __run_tasks();
+
+    pthread_mutex_lock(&lock);
+    while(pending>0) pthread_cond_wait(&done_cond, &lock);
+    pthread_mutex_unlock(&lock);
+    pthread_mutex_unlock(&run_lock);
+    return;
+}
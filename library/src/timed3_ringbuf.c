@@ -655,6 +655,21 @@ static inline void _quaternion_left_multiply_inplace(double* a, double* b)
 int rc_timed3_ringbuf_integrate_gyro_3d(rc_timed3_ringbuf_t* buf, \
 							int64_t t_start, int64_t t_end, rc_matrix_t* out)
 {
+	rc_mat3_t R;
+	int ret = rc_timed3_ringbuf_integrate_gyro_mat3(buf, t_start, t_end, &R);
+	if(ret==-1) return -1;
+
+	if(rc_mat3_to_matrix(R, out)){
+		fprintf(stderr,"ERROR in %s, failed to allocate output matrix\n", __FUNCTION__);
+		return -1;
+	}
+	return ret;
+}
+
+
+int rc_timed3_ringbuf_integrate_gyro_mat3(rc_timed3_ringbuf_t* buf, \
+							int64_t t_start, int64_t t_end, rc_mat3_t* out)
+{
 
 	// sanity checks
 	if(unlikely(buf==NULL)){
@@ -669,10 +684,7 @@ int rc_timed3_ringbuf_integrate_gyro_3d(rc_timed3_ringbuf_t* buf, \
 		fprintf(stderr,"ERROR in %s, t_start must be older than t_end\n", __FUNCTION__);
 		return -1;
 	}
-	if(rc_matrix_identity(out, 3)){
-		fprintf(stderr,"ERROR in %s, failed to allocate output matrix\n", __FUNCTION__);
-		return -1;
-	}
+	*out = rc_mat3_identity();
 
 	pthread_mutex_lock(&buf->mutex);
 
@@ -736,12 +748,12 @@ int rc_timed3_ringbuf_integrate_gyro_3d(rc_timed3_ringbuf_t* buf, \
 	}
 
 	// output final rotation matrix for that period
-	RC_VECTOR_ON_STACK(v, 4);
-	v.d[0] = q[0];
-	v.d[1] = -q[1];
-	v.d[2] = -q[2];
-	v.d[3] = -q[3];
-	rc_quaternion_to_rotation_matrix(v, out);
+	double v[4];
+	v[0] = q[0];
+	v[1] = -q[1];
+	v[2] = -q[2];
+	v[3] = -q[3];
+	rc_quaternion_to_rotation_mat3(v, out);
 
 	pthread_mutex_unlock(&buf->mutex);
 
@@ -25,90 +25,10 @@
 #include <rc_math/other.h>
 #include <rc_math/vector.h>
 #include "algebra_common.h"
+#include "precision.h"
 
-
-int rc_vector_alloc(rc_vector_t* v, int length)
-{
-    // sanity checks
-    if(unlikely(length<1)){
-        fprintf(stderr,"ERROR in rc_vector_alloc, length must be >=1\n");
-        return -1;
-    }
-    if(unlikely(v==NULL)){
-        fprintf(stderr,"ERROR in rc_vector_alloc, received NULL pointer\n");
-        return -1;
-    }
-    // if v is already allocated and of the right size, nothing to do!
-    if(v->initialized && v->len==length) return 0;
-    // free any old memory
-    rc_vector_free(v);
-    // allocate contiguous memory for the vector
-    v->d = (double*)malloc(length*sizeof(double));
-    if(unlikely(v->d==NULL)){
-        fprintf(stderr,"ERROR in rc_vector_alloc, not enough memory\n");
-        return -1;
-    }
-    v->len = length;
-    v->initialized = 1;
-    return 0;
-}
-
-int rc_vector_free(rc_vector_t* v)
-{
-    rc_vector_t new = RC_VECTOR_INITIALIZER;
-    if(unlikely(v==NULL)){
-        fprintf(stderr,"ERROR rc_vector_free, received NULL pointer\n");
-        return -1;
-    }
-    // free memory
-    if(v->initialized)free(v->d);
-    // zero out the struct
-    *v = new;
-    return 0;
-}
-
-
-rc_vector_t rc_vector_empty(void)
-{
-    rc_vector_t out = RC_VECTOR_INITIALIZER;
-    return out;
-}
-
-
-int rc_vector_zeros(rc_vector_t* v, int length)
-{
-    if(unlikely(length<1)){
-        fprintf(stderr,"ERROR in rc_vector_zeros, length must be >=1\n");
-        return -1;
-    }
-    if(unlikely(v==NULL)){
-        fprintf(stderr,"ERROR in rc_vector_zeros, received NULL pointer\n");
-        return -1;
-    }
-    // free any old memory
-    rc_vector_free(v);
-    // allocate contiguous zeroed-out memory for the vector
-    v->d = (double*)calloc(length,sizeof(double));
-    if(unlikely(v->d==NULL)){
-        fprintf(stderr,"ERROR in rc_vector_zeros, not enough memory\n");
-        return -1;
-    }
-    v->len = length;
-    v->initialized = 1;
-    return 0;
-}
-
-
-int rc_vector_ones(rc_vector_t* v, int length)
-{
-    int i;
-    if(unlikely(rc_vector_alloc(v, length))){
-        fprintf(stderr,"ERROR in rc_vector_ones, failed to allocate vector\n");
-        return -1;
-    }
-    for(i=0;i<length;i++) v->d[i] = 1.0f;
-    return 0;
-}
+// functions shared with the float API, see single_precision.c
+#include "vector_template.h"
 
 
 int rc_vector_random(rc_vector_t* v, int length)
@@ -136,118 +56,6 @@ int rc_vector_fibonnaci(rc_vector_t* v, int length)
 }
 
 
-int rc_vector_from_array(rc_vector_t* v, double* ptr, int length)
-{
-    // sanity check pointer
-    if(unlikely(ptr==NULL)){
-        fprintf(stderr,"ERROR in rc_vector_from_array, received NULL pointer\n");
-        return -1;
-    }
-    // make sure there is enough space in v
-    if(unlikely(rc_vector_alloc(v, length))){
-        fprintf(stderr,"ERROR in rc_vector_from_array, failed to allocate vector\n");
-        return -1;
-    }
-    // copy memory over
-    memcpy(v->d, ptr, length*sizeof(double));
-    return 0;
-}
-
-
-int rc_vector_duplicate(rc_vector_t a, rc_vector_t* b)
-{
-    // sanity check
-    if(unlikely(!a.initialized)){
-        fprintf(stderr,"ERROR in rc_duplicate_vector, a not initialized\n");
-        return -1;
-    }
-    // make sure there is enough space in b
-    if(unlikely(rc_vector_alloc(b, a.len))){
-        fprintf(stderr,"ERROR in rc_duplicate_vector, failed to allocate vector\n");
-        return -1;
-    }
-    // copy memory over
-    memcpy(b->d, a.d, a.len*sizeof(double));
-    return 0;
-}
-
-
-int rc_vector_print(rc_vector_t v)
-{
-    int i;
-    if(unlikely(!v.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_print, vector not initialized yet\n");
-        return -1;
-    }
-    for(i=0;i<v.len;i++) printf("%7.4f  ",v.d[i]);
-    printf("\n");
-    return 0;
-}
-
-int rc_vector_print_sci(rc_vector_t v)
-{
-    int i;
-    if(unlikely(!v.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_print_sci, vector not initialized yet\n");
-        return -1;
-    }
-    for(i=0;i<v.len;i++) printf("%11.4e  ",v.d[i]);
-    printf("\n");
-    return 0;
-}
-
-int rc_vector_zero_out(rc_vector_t* v)
-{
-    int i;
-    if(unlikely(v->initialized!=1)){
-        fprintf(stderr,"ERROR in rc_vector_zero_out,vector not initialized yet\n");
-        return -1;
-    }
-    for(i=0;i<v->len;i++)   v->d[i]=0.0;
-    return 0;
-}
-
-int rc_vector_times_scalar(rc_vector_t* v, double s)
-{
-    int i;
-    if(unlikely(!v->initialized)){
-        fprintf(stderr,"ERROR in rc_vector_times_scalar, vector uninitialized\n");
-        return -1;
-    }
-    for(i=0;i<(v->len);i++) v->d[i] *= s;
-    return 0;
-}
-
-
-double rc_vector_norm(rc_vector_t v, double p)
-{
-    double norm = 0.0f;
-    int i;
-    if(unlikely(!v.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_norm, vector not initialized yet\n");
-        return -1;
-    }
-    if(unlikely(p<=0.0)){
-        fprintf(stderr,"ERROR in rc_vector_norm, p must be a positive real value\n");
-        return -1;
-    }
-    // shortcut for 1-norm
-    if(p<1.001 && p>0.999){
-        for(i=0;i<v.len;i++) norm+=fabs(v.d[i]);
-        return norm;
-    }
-    // shortcut for 2-norm
-    if(p<2.001 && p>1.999){
-        for(i=0;i<v.len;i++) norm+=v.d[i]*v.d[i];
-        return sqrt(norm);
-    }
-    // generic norm formula, rarely used.
-    for(i=0;i<v.len;i++) norm+=pow(fabs(v.d[i]),p);
-    // take the pth root
-    return pow(norm,(1.0/p));
-}
-
-
 int rc_vector_max(rc_vector_t v)
 {
     int i;
@@ -288,25 +96,14 @@ int rc_vector_min(rc_vector_t v)
 
 double rc_vector_std_dev(rc_vector_t v)
 {
-    int i;
-    double mean, mean_sqr, diff;
+    rc_vector_stats_t s;
     if(unlikely(!v.initialized)){
         fprintf(stderr,"ERROR in rc_vector_std_dev, vector not initialized yet\n");
         return -1.0f;
     }
-    // shortcut for length 1
-    if(v.len == 1) return 0.0;
-    // calculate mean
-    mean = 0.0;
-    for(i=0;i<v.len;i++) mean+=v.d[i];
-    mean = mean/(double)v.len;
-    // calculate mean square
-    mean_sqr = 0.0;
-    for(i=0;i<v.len;i++){
-        diff = v.d[i]-mean;
-        mean_sqr += diff*diff;
-    }
-    return sqrt(mean_sqr/(double)(v.len-1));
+    // one pass instead of a mean pass and a deviation pass
+    if(unlikely(rc_vector_stats(v, RC_VECTOR_STATS_STD_DEV, &s))) return -1.0f;
+    return s.std_dev;
 }
 
 
@@ -324,123 +121,124 @@ double rc_vector_mean(rc_vector_t v)
 }
 
 
-int rc_vector_projection(rc_vector_t v, rc_vector_t e, rc_vector_t* p)
-{
-    int i;
-    double factor;
-    // sanity checks
-    if(unlikely(!v.initialized || !e.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_projection, received uninitialized vector\n");
-        return -1;
-    }
-    if(unlikely(v.len!=e.len)){
-        fprintf(stderr,"ERROR in rc_vector_projection, vectors not of same length\n");
-        return -1;
-    }
-    if(unlikely(rc_vector_alloc(p,v.len))){
-        fprintf(stderr,"ERROR in rc_vector_projection, failed to allocate p\n");
-        return -1;
-    }
-    factor = rc_vector_dot_product(v,e)/rc_vector_dot_product(e,e);
-    for(i=0;i<v.len;i++) p->d[i]=factor*e.d[i];
-    return 0;
-}
-
+// elements per block of rc_vector_stats, small enough to stay in L1 so the
+// index search at the end is cheap
+#define STATS_BLOCK 512
 
-double rc_vector_dot_product(rc_vector_t v1, rc_vector_t v2)
+int rc_vector_stats(rc_vector_t v, int flags, rc_vector_stats_t* s)
 {
-    if(unlikely(!v1.initialized || !v2.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_dot_product, vector uninitialized\n");
-        return -1.0;
-    }
-    if(unlikely(v1.len != v2.len)){
-        fprintf(stderr,"ERROR in rc_vector_dot_product, dimension mismatch\n");
-        return -1.0;
-    }
-    return __vectorized_mult_accumulate(v1.d,v2.d,v1.len);
-}
-
+    int i, nb;
+    int n = 0;          // elements merged so far
+    int max_block = 0;  // start of the block holding the first max
+    int min_block = 0;
+    double mean, m2, shift, bmean, bm2, delta;
+    double sq = 0.0;
+    double abs = 0.0;
+    __stats_acc_t acc;
+    const int moments = flags & (RC_VECTOR_STATS_MEAN|RC_VECTOR_STATS_STD_DEV);
+    rc_vector_stats_t out = {
+        .max_index = -1,
+        .min_index = -1};
 
-int rc_vector_cross_product(rc_vector_t v1, rc_vector_t v2, rc_vector_t* p)
-{
     // sanity checks
-    if(unlikely(!v1.initialized || !v2.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_cross_product, vector not initialized yet.\n");
+    if(unlikely(s==NULL)){
+        fprintf(stderr,"ERROR in rc_vector_stats, received NULL pointer\n");
         return -1;
     }
-    if(unlikely(v1.len!=3 || v2.len!=3)){
-        fprintf(stderr,"ERROR in rc_vector_cross_product, vector must have length 3\n");
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in rc_vector_stats, vector not initialized yet\n");
         return -1;
     }
-    if(unlikely(rc_vector_alloc(p,3))){
-        fprintf(stderr,"ERROR in rc_vector_cross_product, failed to allocate p\n");
+    if(unlikely(flags<=0 || (flags & ~RC_VECTOR_STATS_ALL))){
+        fprintf(stderr,"ERROR in rc_vector_stats, invalid flags\n");
         return -1;
     }
-    p->d[0] = (v1.d[1]*v2.d[2]) - (v1.d[2]*v2.d[1]);
-    p->d[1] = (v1.d[2]*v2.d[0]) - (v1.d[0]*v2.d[2]);
-    p->d[2] = (v1.d[0]*v2.d[1]) - (v1.d[1]*v2.d[0]);
-    return 0;
-}
-
 
-int rc_vector_sum(rc_vector_t v1, rc_vector_t v2, rc_vector_t* s)
-{
-    int i;
-    // sanity checks
-    if(unlikely(!v1.initialized || !v2.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_sum, received uninitialized vector\n");
-        return -1;
+    mean = 0.0;
+    m2 = 0.0;
+    shift = v.d[0];
+    out.max = v.d[0];
+    out.min = v.d[0];
+    for(i=0;i<v.len;i+=STATS_BLOCK){
+        nb = v.len-i < STATS_BLOCK ? v.len-i : STATS_BLOCK;
+        __vectorized_stats(&v.d[i], nb, shift, flags, &acc);
+        if(moments){
+            // block mean and sum of squared deviations from it, accurate
+            // because the shift is already close to the mean
+            bmean = acc.sum/nb;
+            bm2 = acc.sumsq-acc.sum*bmean;
+            if(bm2<0.0) bm2 = 0.0;
+            bmean += shift;
+            // merge with the blocks before, Chan et al.
+            delta = bmean-mean;
+            mean += delta*nb/(double)(n+nb);
+            m2 += bm2 + delta*delta*((double)n*nb/(double)(n+nb));
+            shift = mean;
+        }
+        sq += acc.sq;
+        abs += acc.abs;
+        // strict comparisons keep the first block holding each extreme
+        if(acc.max>out.max){
+            out.max = acc.max;
+            max_block = i;
+        }
+        if(acc.min<out.min){
+            out.min = acc.min;
+            min_block = i;
+        }
+        n += nb;
     }
-    if(unlikely(v1.len!=v2.len)){
-        fprintf(stderr,"ERROR in rc_vector_sum, vectors not of same length\n");
-        return -1;
+
+    if(moments){
+        out.mean = mean;
+        if(flags & RC_VECTOR_STATS_STD_DEV && v.len>1){
+            out.std_dev = sqrt(m2/(double)(v.len-1));
+        }
     }
-    if(unlikely(rc_vector_alloc(s,v1.len))){
-        fprintf(stderr,"ERROR in rc_vector_sum, failed to allocate s\n");
-        return -1;
+    if(flags & RC_VECTOR_STATS_NORM){
+        out.norm1 = abs;
+        out.norm2 = sqrt(sq);
     }
-    for(i=0;i<v1.len;i++) s->d[i]=v1.d[i]+v2.d[i];
-    return 0;
-}
-
-
-int rc_vector_sum_inplace(rc_vector_t* v1, rc_vector_t v2)
-{
-    int i;
-    // sanity checks
-    if(unlikely(!v1->initialized || !v2.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_sum_inplace, received uninitialized vector\n");
-        return -1;
+    // find the first occurrence within the block that held each extreme
+    if(flags & RC_VECTOR_STATS_MAX){
+        for(i=max_block;i<v.len-1 && v.d[i]!=out.max;i++);
+        out.max_index = i;
     }
-    if(unlikely(v1->len!=v2.len)){
-        fprintf(stderr,"ERROR in rc_vector_sum_inplace, vectors not of same length\n");
-        return -1;
+    else out.max = 0.0;
+    if(flags & RC_VECTOR_STATS_MIN){
+        for(i=min_block;i<v.len-1 && v.d[i]!=out.min;i++);
+        out.min_index = i;
     }
-    for(i=0;i<v1->len;i++) v1->d[i]+=v2.d[i];
+    else out.min = 0.0;
+
+    *s = out;
     return 0;
 }
 
 
-int rc_vector_subtract(rc_vector_t v1, rc_vector_t v2, rc_vector_t* s)
+int rc_vector_projection(rc_vector_t v, rc_vector_t e, rc_vector_t* p)
 {
     int i;
+    double factor;
     // sanity checks
-    if(unlikely(!v1.initialized || !v2.initialized)){
-        fprintf(stderr,"ERROR in rc_vector_substract, received uninitialized vector\n");
+    if(unlikely(!v.initialized || !e.initialized)){
+        fprintf(stderr,"ERROR in rc_vector_projection, received uninitialized vector\n");
         return -1;
     }
-    if(unlikely(v1.len!=v2.len)){
-        fprintf(stderr,"ERROR in rc_vector_substract, vectors not of same length\n");
+    if(unlikely(v.len!=e.len)){
+        fprintf(stderr,"ERROR in rc_vector_projection, vectors not of same length\n");
         return -1;
     }
-    if(unlikely(rc_vector_alloc(s,v1.len))){
-        fprintf(stderr,"ERROR in rc_vector_substract, failed to allocate s\n");
+    if(unlikely(rc_vector_alloc(p,v.len))){
+        fprintf(stderr,"ERROR in rc_vector_projection, failed to allocate p\n");
         return -1;
     }
-    for(i=0;i<v1.len;i++) s->d[i]=v1.d[i]-v2.d[i];
+    factor = rc_vector_dot_product(v,e)/rc_vector_dot_product(e,e);
+    for(i=0;i<v.len;i++) p->d[i]=factor*e.d[i];
     return 0;
 }
 
+
 int rc_vector_lin_interpolate(rc_vector_t v1, rc_vector_t v2, double t, rc_vector_t* out)
 {
     if(unlikely(!v1.initialized || !v2.initialized)){
@@ -0,0 +1,282 @@
+/**
+ * @file       vector_template.h
+ *
+ * @brief      Vector functions shared by the double and float APIs, see
+ *             precision.h. Included by vector.c and single_precision.c.
+ */
+
+int VECTOR_FN(alloc)(VEC* v, int length)
+{
+    // sanity checks
+    if(unlikely(length<1)){
+        fprintf(stderr,"ERROR in %s, length must be >=1\n", __func__);
+        return -1;
+    }
+    if(unlikely(v==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    // if v is already allocated and of the right size, nothing to do!
+    if(v->initialized && v->len==length) return 0;
+    // free any old memory
+    VECTOR_FN(free)(v);
+    // allocate contiguous memory for the vector starting on a cache line
+    if(unlikely(posix_memalign((void**)&v->d, RC_MATRIX_ALIGN, length*sizeof(REAL)))){
+        fprintf(stderr,"ERROR in %s, not enough memory\n", __func__);
+        v->d = NULL;
+        return -1;
+    }
+    v->len = length;
+    v->initialized = 1;
+    return 0;
+}
+
+int VECTOR_FN(free)(VEC* v)
+{
+    VEC new = VEC_INIT;
+    if(unlikely(v==NULL)){
+        fprintf(stderr,"ERROR %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    // free memory
+    if(v->initialized)free(v->d);
+    // zero out the struct
+    *v = new;
+    return 0;
+}
+
+
+VEC VECTOR_FN(empty)(void)
+{
+    VEC out = VEC_INIT;
+    return out;
+}
+
+
+int VECTOR_FN(zeros)(VEC* v, int length)
+{
+    if(unlikely(VECTOR_FN(alloc)(v, length))){
+        fprintf(stderr,"ERROR in %s, failed to allocate vector\n", __func__);
+        return -1;
+    }
+    memset(v->d, 0, length*sizeof(REAL));
+    return 0;
+}
+
+
+int VECTOR_FN(ones)(VEC* v, int length)
+{
+    int i;
+    if(unlikely(VECTOR_FN(alloc)(v, length))){
+        fprintf(stderr,"ERROR in %s, failed to allocate vector\n", __func__);
+        return -1;
+    }
+    for(i=0;i<length;i++) v->d[i] = RL(1.0);
+    return 0;
+}
+
+
+int VECTOR_FN(from_array)(VEC* v, REAL* ptr, int length)
+{
+    // sanity check pointer
+    if(unlikely(ptr==NULL)){
+        fprintf(stderr,"ERROR in %s, received NULL pointer\n", __func__);
+        return -1;
+    }
+    // make sure there is enough space in v
+    if(unlikely(VECTOR_FN(alloc)(v, length))){
+        fprintf(stderr,"ERROR in %s, failed to allocate vector\n", __func__);
+        return -1;
+    }
+    // copy memory over
+    memcpy(v->d, ptr, length*sizeof(REAL));
+    return 0;
+}
+
+
+int VECTOR_FN(duplicate)(VEC a, VEC* b)
+{
+    // sanity check
+    if(unlikely(!a.initialized)){
+        fprintf(stderr,"ERROR in %s, a not initialized\n", __func__);
+        return -1;
+    }
+    // make sure there is enough space in b
+    if(unlikely(VECTOR_FN(alloc)(b, a.len))){
+        fprintf(stderr,"ERROR in %s, failed to allocate vector\n", __func__);
+        return -1;
+    }
+    // copy memory over
+    memcpy(b->d, a.d, a.len*sizeof(REAL));
+    return 0;
+}
+
+
+int VECTOR_FN(print)(VEC v)
+{
+    int i;
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in %s, vector not initialized yet\n", __func__);
+        return -1;
+    }
+    for(i=0;i<v.len;i++) printf("%7.4f  ",(double)v.d[i]);
+    printf("\n");
+    return 0;
+}
+
+int VECTOR_FN(print_sci)(VEC v)
+{
+    int i;
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in %s, vector not initialized yet\n", __func__);
+        return -1;
+    }
+    for(i=0;i<v.len;i++) printf("%11.4e  ",(double)v.d[i]);
+    printf("\n");
+    return 0;
+}
+
+int VECTOR_FN(zero_out)(VEC* v)
+{
+    int i;
+    if(unlikely(v->initialized!=1)){
+        fprintf(stderr,"ERROR in %s,vector not initialized yet\n", __func__);
+        return -1;
+    }
+    for(i=0;i<v->len;i++)   v->d[i]=RL(0.0);
+    return 0;
+}
+
+int VECTOR_FN(times_scalar)(VEC* v, REAL s)
+{
+    if(unlikely(!v->initialized)){
+        fprintf(stderr,"ERROR in %s, vector uninitialized\n", __func__);
+        return -1;
+    }
+    PREC(__vectorized_scale)(s, v->d, v->len);
+    return 0;
+}
+
+
+REAL VECTOR_FN(norm)(VEC v, REAL p)
+{
+    REAL norm = RL(0.0);
+    int i;
+    if(unlikely(!v.initialized)){
+        fprintf(stderr,"ERROR in %s, vector not initialized yet\n", __func__);
+        return -1;
+    }
+    if(unlikely(p<=RL(0.0))){
+        fprintf(stderr,"ERROR in %s, p must be a positive real value\n", __func__);
+        return -1;
+    }
+    // shortcut for 1-norm
+    if(p<RL(1.001) && p>RL(0.999)){
+        for(i=0;i<v.len;i++) norm+=FABS(v.d[i]);
+        return norm;
+    }
+    // shortcut for 2-norm
+    if(p<RL(2.001) && p>RL(1.999)){
+        for(i=0;i<v.len;i++) norm+=v.d[i]*v.d[i];
+        return SQRT(norm);
+    }
+    // generic norm formula, rarely used.
+    for(i=0;i<v.len;i++) norm+=POW(FABS(v.d[i]),p);
+    // take the pth root
+    return POW(norm,(RL(1.0)/p));
+}
+
+
+REAL VECTOR_FN(dot_product)(VEC v1, VEC v2)
+{
+    if(unlikely(!v1.initialized || !v2.initialized)){
+        fprintf(stderr,"ERROR in %s, vector uninitialized\n", __func__);
+        return RL(-1.0);
+    }
+    if(unlikely(v1.len != v2.len)){
+        fprintf(stderr,"ERROR in %s, dimension mismatch\n", __func__);
+        return RL(-1.0);
+    }
+    return PREC(__vectorized_mult_accumulate)(v1.d,v2.d,v1.len);
+}
+
+
+int VECTOR_FN(cross_product)(VEC v1, VEC v2, VEC* p)
+{
+    // sanity checks
+    if(unlikely(!v1.initialized || !v2.initialized)){
+        fprintf(stderr,"ERROR in %s, vector not initialized yet.\n", __func__);
+        return -1;
+    }
+    if(unlikely(v1.len!=3 || v2.len!=3)){
+        fprintf(stderr,"ERROR in %s, vector must have length 3\n", __func__);
+        return -1;
+    }
+    if(unlikely(VECTOR_FN(alloc)(p,3))){
+        fprintf(stderr,"ERROR in %s, failed to allocate p\n", __func__);
+        return -1;
+    }
+    p->d[0] = (v1.d[1]*v2.d[2]) - (v1.d[2]*v2.d[1]);
+    p->d[1] = (v1.d[2]*v2.d[0]) - (v1.d[0]*v2.d[2]);
+    p->d[2] = (v1.d[0]*v2.d[1]) - (v1.d[1]*v2.d[0]);
+    return 0;
+}
+
+
+int VECTOR_FN(sum)(VEC v1, VEC v2, VEC* s)
+{
+    int i;
+    // sanity checks
+    if(unlikely(!v1.initialized || !v2.initialized)){
+        fprintf(stderr,"ERROR in %s, received uninitialized vector\n", __func__);
+        return -1;
+    }
+    if(unlikely(v1.len!=v2.len)){
+        fprintf(stderr,"ERROR in %s, vectors not of same length\n", __func__);
+        return -1;
+    }
+    if(unlikely(VECTOR_FN(alloc)(s,v1.len))){
+        fprintf(stderr,"ERROR in %s, failed to allocate s\n", __func__);
+        return -1;
+    }
+    for(i=0;i<v1.len;i++) s->d[i]=v1.d[i]+v2.d[i];
+    return 0;
+}
+
+
+int VECTOR_FN(sum_inplace)(VEC* v1, VEC v2)
+{
+    int i;
+    // sanity checks
+    if(unlikely(!v1->initialized || !v2.initialized)){
+        fprintf(stderr,"ERROR in %s, received uninitialized vector\n", __func__);
+        return -1;
+    }
+    if(unlikely(v1->len!=v2.len)){
+        fprintf(stderr,"ERROR in %s, vectors not of same length\n", __func__);
+        return -1;
+    }
+    for(i=0;i<v1->len;i++) v1->d[i]+=v2.d[i];
+    return 0;
+}
+
+
+int VECTOR_FN(subtract)(VEC v1, VEC v2, VEC* s)
+{
+    int i;
+    // sanity checks
+    if(unlikely(!v1.initialized || !v2.initialized)){
+        fprintf(stderr,"ERROR in %s, received uninitialized vector\n", __func__);
+        return -1;
+    }
+    if(unlikely(v1.len!=v2.len)){
+        fprintf(stderr,"ERROR in %s, vectors not of same length\n", __func__);
+        return -1;
+    }
+    if(unlikely(VECTOR_FN(alloc)(s,v1.len))){
+        fprintf(stderr,"ERROR in %s, failed to allocate s\n", __func__);
+        return -1;
+    }
+    for(i=0;i<v1.len;i++) s->d[i]=v1.d[i]-v2.d[i];
+    return 0;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file       workspace.c
+ *
+ * @brief      see workspace.h
+ *
+ * A workspace is a simple bump allocator. Internal functions take memory from
+ * the top with __ws_push and give it back by restoring the 'used' counter they
+ * saw on entry, so nested calls behave like a stack.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> // for posix_memalign, free
+
+#include <rc_math/workspace.h>
+#include "algebra_common.h"
+
+
+rc_workspace_t rc_workspace_empty(void)
+{
+    rc_workspace_t out = RC_WORKSPACE_INITIALIZER;
+    return out;
+}
+
+
+int rc_workspace_alloc(rc_workspace_t* ws, size_t bytes)
+{
+    void* ptr;
+    // sanity checks
+    if(unlikely(ws==NULL)){
+        fprintf(stderr,"ERROR in rc_workspace_alloc, received NULL pointer\n");
+        return -1;
+    }
+    if(unlikely(bytes<1)){
+        fprintf(stderr,"ERROR in rc_workspace_alloc, bytes must be >=1\n");
+        return -1;
+    }
+    // if it's already big enough just hand all of it out again
+    if(ws->initialized==1 && ws->size>=bytes){
+        ws->used = 0;
+        return 0;
+    }
+    rc_workspace_free(ws);
+    // round up so the end of the last block is also aligned
+    bytes = __ws_round(bytes);
+    if(unlikely(posix_memalign(&ptr, WS_ALIGN, bytes))){
+        fprintf(stderr,"ERROR in rc_workspace_alloc, failed to allocate %zu bytes\n", bytes);
+        return -1;
+    }
+    ws->d = ptr;
+    ws->size = bytes;
+    ws->used = 0;
+    ws->initialized = 1;
+    return 0;
+}
+
+
+int rc_workspace_free(rc_workspace_t* ws)
+{
+    rc_workspace_t new = RC_WORKSPACE_INITIALIZER;
+    if(unlikely(ws==NULL)){
+        fprintf(stderr,"ERROR in rc_workspace_free, received NULL pointer\n");
+        return -1;
+    }
+    if(ws->initialized) free(ws->d);
+    *ws = new;
+    return 0;
+}
+
+
+int rc_workspace_reset(rc_workspace_t* ws)
+{
+    if(unlikely(ws==NULL)){
+        fprintf(stderr,"ERROR in rc_workspace_reset, received NULL pointer\n");
+        return -1;
+    }
+    ws->used = 0;
+    return 0;
+}
+
+
+void* __ws_push(rc_workspace_t* ws, size_t bytes)
+{
+    void* ptr;
+    if(unlikely(ws==NULL || ws->initialized!=1)){
+        fprintf(stderr,"ERROR, workspace not initialized\n");
+        return NULL;
+    }
+    bytes = __ws_round(bytes);
+    if(unlikely(ws->used+bytes > ws->size)){
+        fprintf(stderr,"ERROR, workspace too small, need %zu more bytes\n",
+                                            ws->used+bytes-ws->size);
+        return NULL;
+    }
+    ptr = (char*)ws->d + ws->used;
+    ws->used += bytes;
+    return ptr;
+}
+
+
+int __ws_matrix(rc_workspace_t* ws, rc_matrix_t* A, int rows, int cols)
+{
+    int i;
+    double* ptr;
+    A->d = __ws_push(ws, rows*sizeof(double*));
+    ptr = __ws_push(ws, rows*cols*sizeof(double));
+    if(unlikely(A->d==NULL || ptr==NULL)) return -1;
+    for(i=0;i<rows;i++) A->d[i] = &ptr[i*cols];
+    A->rows = rows;
+    A->cols = cols;
+    A->stride = cols;
+    A->initialized = 1;
+    return 0;
+}
+
+
+int __ws_vector(rc_workspace_t* ws, rc_vector_t* v, int len)
+{
+    v->d = __ws_push(ws, len*sizeof(double));
+    if(unlikely(v->d==NULL)) return -1;
+    v->len = len;
+    v->initialized = 1;
+    return 0;
+}
+
+
+int __ws_matrixf(rc_workspace_t* ws, rc_matrixf_t* A, int rows, int cols)
+{
+    int i;
+    float* ptr;
+    A->d = __ws_push(ws, rows*sizeof(float*));
+    ptr = __ws_push(ws, rows*cols*sizeof(float));
+    if(unlikely(A->d==NULL || ptr==NULL)) return -1;
+    for(i=0;i<rows;i++) A->d[i] = &ptr[i*cols];
+    A->rows = rows;
+    A->cols = cols;
+    A->stride = cols;
+    A->initialized = 1;
+    return 0;
+}
+
+
+int __ws_vectorf(rc_workspace_t* ws, rc_vectorf_t* v, int len)
+{
+    v->d = __ws_push(ws, len*sizeof(float));
+    if(unlikely(v->d==NULL)) return -1;
+    v->len = len;
+    v->initialized = 1;
+    return 0;
+}